@@ -0,0 +1,39 @@
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<size_t> allocations(0);
+    std::atomic<AllocationHook> allocationHook(nullptr);
+} // anonymous namespace
+
+#ifdef TERMESH_COUNT_ALLOCATIONS
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (AllocationHook hook = allocationHook.load(std::memory_order_relaxed)) hook(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+bool allocationCounting() { return true; }
+#else
+bool allocationCounting() { return false; }
+#endif
+
+size_t heapAllocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+AllocationHook setAllocationHook(AllocationHook hook) {
+    return allocationHook.exchange(hook);
+}
@@ -0,0 +1,156 @@
+#include "animation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "font.h"
+#include "gif.h"
+#include "rasterizer.h"
+#include "renderer.h"
+#include "thread_pool.h"
+
+namespace {
+    const uint8_t PALETTE[ANIMATION_COLORS][3] = {
+        {0x00, 0x00, 0x00},
+        {0x60, 0x60, 0x60},
+        {0xB0, 0xB0, 0xB0},
+        {0xFF, 0xFF, 0xFF},
+    };
+
+    // Palette index per character: shade levels split evenly over the three
+    // glyph colours, anything else (e.g. slice contours) drawn brightest
+    struct ColorTable {
+        uint8_t color[256];
+
+        ColorTable() {
+            std::memset(color, ANIMATION_COLORS - 1, sizeof(color));
+            for (int i = 1; i < SHADE_LEVELS; i++) {
+                color[(uint8_t)SHADE_CHARS[i]] = (uint8_t)(1 + (i - 1) * (ANIMATION_COLORS - 1) / (SHADE_LEVELS - 1));
+            }
+        }
+    };
+
+    const ColorTable colors;
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // anonymous namespace
+
+CellRect changedCells(const std::vector<std::string>& previous,
+                      const std::vector<std::string>& frame) {
+    CellRect rect{-1, -1, -1, -1};
+    for (int y = 0; y < (int)frame.size(); y++) {
+        const std::string& a = previous[y];
+        const std::string& b = frame[y];
+        int first = 0;
+        int last = (int)b.size() - 1;
+        while (first <= last && a[first] == b[first]) first++;
+        if (first > last) continue;
+        while (a[last] == b[last]) last--;
+
+        if (rect.top < 0) {
+            rect = {first, y, last, y};
+        } else {
+            rect.left = std::min(rect.left, first);
+            rect.right = std::max(rect.right, last);
+            rect.bottom = y;
+        }
+    }
+    if (rect.top < 0) rect = {0, 0, 0, 0};
+    return rect;
+}
+
+void drawGlyphs(const std::vector<std::string>& frame, const CellRect& rect,
+                std::vector<uint8_t>& pixels) {
+    int cols = rect.right - rect.left + 1;
+    int rows = rect.bottom - rect.top + 1;
+    int pitch = cols * FONT_CELL_WIDTH;
+    pixels.assign((size_t)pitch * rows * FONT_CELL_HEIGHT, 0);
+
+    for (int cy = 0; cy < rows; cy++) {
+        const std::string& line = frame[rect.top + cy];
+        uint8_t* cellRow = pixels.data() + (size_t)cy * FONT_CELL_HEIGHT * pitch;
+        for (int cx = 0; cx < cols; cx++) {
+            char c = line[rect.left + cx];
+            if (c == ' ') continue;
+
+            const uint8_t* glyph = fontGlyph(c);
+            uint8_t color = colors.color[(uint8_t)c];
+            uint8_t* cell = cellRow + cx * FONT_CELL_WIDTH;
+            for (int gy = 0; gy < FONT_GLYPH_HEIGHT; gy++) {
+                uint8_t* out = cell + (size_t)(FONT_GLYPH_TOP + gy) * pitch;
+                for (int gx = 0; gx < FONT_GLYPH_WIDTH; gx++) {
+                    if (glyph[gy] & (1 << (FONT_GLYPH_WIDTH - 1 - gx))) out[gx] = color;
+                }
+            }
+        }
+    }
+}
+
+bool exportAnimationGif(const std::vector<Triangle>& model, const Vec3& lightDir,
+                        const std::string& filename, const AnimationOptions& options,
+                        AnimationStats* stats) {
+    const int count = std::max(1, options.frames);
+    ThreadPool pool(options.threads);
+
+    // Step the angles exactly like the live loop so the export matches it
+    std::vector<Mat3> rotations;
+    rotations.reserve(count);
+    float angleX = 0.0f, angleY = 0.0f, angleZ = 0.0f;
+    for (int i = 0; i < count; i++) {
+        rotations.push_back(rotationX(angleX) * rotationY(angleY) * rotationZ(angleZ));
+        angleX += options.rotationSpeed;
+        angleY += options.rotationSpeed * 1.3f;
+        angleZ += options.rotationSpeed * 0.7f;
+    }
+
+    // Pass 1: rasterize every frame, one z-buffer per worker
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<std::string>> frames(count,
+        std::vector<std::string>(options.rows, std::string(options.cols, ' ')));
+    std::vector<std::vector<float>> zbuffers(pool.size(),
+        std::vector<float>((size_t)options.cols * options.rows));
+    pool.parallelFor(count, [&](size_t i, int worker) {
+        clearBuffers(frames[i], zbuffers[worker]);
+        renderFrame(frames[i], zbuffers[worker], model, rotations[i], lightDir);
+    });
+    double renderSeconds = secondsSince(start);
+
+    // Pass 2: draw and compress each frame's changed cells. Only the character
+    // frames are kept whole; pixels exist per worker, one frame at a time.
+    start = std::chrono::steady_clock::now();
+    std::vector<std::vector<uint8_t>> encoded(count);
+    std::vector<std::vector<uint8_t>> pixels(pool.size());
+    pool.parallelFor(count, [&](size_t i, int worker) {
+        CellRect rect = i == 0 ? CellRect{0, 0, options.cols - 1, options.rows - 1}
+                               : changedCells(frames[i - 1], frames[i]);
+        drawGlyphs(frames[i], rect, pixels[worker]);
+        gifFrame(encoded[i], rect.left * FONT_CELL_WIDTH, rect.top * FONT_CELL_HEIGHT,
+                 (rect.right - rect.left + 1) * FONT_CELL_WIDTH,
+                 (rect.bottom - rect.top + 1) * FONT_CELL_HEIGHT,
+                 pixels[worker].data(), ANIMATION_CODE_SIZE, options.delayCs);
+    });
+
+    const int width = options.cols * FONT_CELL_WIDTH;
+    const int height = options.rows * FONT_CELL_HEIGHT;
+    std::vector<uint8_t> gif;
+    gifHeader(gif, width, height, PALETTE, ANIMATION_COLORS);
+    for (const auto& frame : encoded) gif.insert(gif.end(), frame.begin(), frame.end());
+    gif.push_back(GIF_TRAILER);
+    double encodeSeconds = secondsSince(start);
+
+    if (stats) {
+        stats->threads = pool.size();
+        stats->width = width;
+        stats->height = height;
+        stats->renderSeconds = renderSeconds;
+        stats->encodeSeconds = encodeSeconds;
+        stats->bytes = gif.size();
+    }
+
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(gif.data(), 1, gif.size(), file) == gif.size();
+    return std::fclose(file) == 0 && written;
+}
@@ -0,0 +1,52 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t blockBytes) : blockBytes(std::max<size_t>(blockBytes, 64)) {}
+
+void* FrameArena::allocate(size_t bytes, size_t align) {
+    // Try the current block, then any later ones left from a bigger frame
+    while (current < blocks.size()) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t start = ((base + offset + align - 1) & ~(uintptr_t)(align - 1)) - base;
+        if (start + bytes <= block.size) {
+            offset = start + bytes;
+            usedBytes += bytes;
+            return block.data.get() + start;
+        }
+        if (current + 1 == blocks.size()) break;
+        current++;
+        offset = 0;
+    }
+
+    addBlock(bytes + align);
+    current = blocks.size() - 1;
+    offset = 0;
+    return allocate(bytes, align);
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    // Grow geometrically so a large frame needs few blocks
+    size_t size = std::max({blockBytes, minBytes, capacity()});
+    blocks.push_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    memory.set(capacity());
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        // One block that holds the whole of the last frame
+        size_t total = capacity();
+        blocks.clear();
+        blocks.push_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[total]), total});
+    }
+    current = 0;
+    offset = 0;
+    usedBytes = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
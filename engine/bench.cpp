@@ -0,0 +1,326 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include "model.h"
+#include "projection.h"
+#include "quality.h"
+#include "rasterizer.h"
+#include "render_context.h"
+#include "terminal.h"
+
+const char* const BENCH_STAGE_NAMES[BENCH_STAGE_COUNT] = {
+    "load", "normalize", "transform_cull", "rasterize", "output", "end_to_end",
+};
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Orientation of run `run` of a sample: the turntable's, one frame per run
+    Camera cameraFor(int run) {
+        return Camera{0.3f + run * 0.02f, 0.5f + run * 0.026f, run * 0.014f};
+    }
+
+    /**
+     * @brief Times `timed` after an untimed `setup`, BENCH_SAMPLE_RUNS runs
+     *        per sample, and adds the summary of the samples after the
+     *        warmup ones to the report.
+     */
+    template <typename Setup, typename Timed>
+    void measure(BenchReport& report, const std::string& model, size_t triangles, int cols, int rows,
+                 BenchStage stage, Setup setup, Timed timed) {
+        std::vector<double> samples;
+        samples.reserve(report.repetitions);
+        for (int sample = 0; sample < report.warmup + report.repetitions; sample++) {
+            Clock::duration total = Clock::duration::zero();
+            for (int run = 0; run < BENCH_SAMPLE_RUNS; run++) {
+                setup(run);
+                Clock::time_point start = Clock::now();
+                timed(run);
+                total += Clock::now() - start;
+            }
+            double ms = std::chrono::duration<double, std::milli>(total).count() / BENCH_SAMPLE_RUNS;
+            if (sample >= report.warmup) samples.push_back(ms);
+        }
+
+        BenchResult result;
+        result.model = model;
+        result.triangles = triangles;
+        result.cols = cols;
+        result.rows = rows;
+        result.stage = stage;
+        summarizeSamples(samples, result);
+        report.results.push_back(result);
+    }
+
+    // Timings of one model's render stages at one frame size
+    void benchResolution(BenchReport& report, const std::string& name, const MeshRef& mesh,
+                         const BenchResolution& size, int output) {
+        const std::vector<Triangle>& model = *mesh;
+        const size_t triangles = model.size();
+        const int cols = size.cols, rows = size.rows;
+        const Vec3 lightDir = defaultLightDir();
+        const ProjectionParams params = projectionFor(cols, rows);
+
+        RenderScratch scratch;
+        auto geometry = [&](int run) {
+            scratch.arena.reset();
+            scratch.triangles = scratch.arena.allocate<RenderScratch::ScreenTriangle>(triangles);
+            scratch.count = projectTriangles(model.data(), model.data() + triangles,
+                                             cameraFor(run).rotation(), lightDir, params,
+                                             scratch.triangles);
+        };
+        std::vector<std::string> buffer(rows, std::string(cols, ' '));
+        std::vector<float> zbuffer((size_t)cols * rows);
+        auto raster = [&](int) {
+            clearBuffers(buffer, zbuffer);
+            for (size_t i = 0; i < scratch.count; i++) {
+                const RenderScratch::ScreenTriangle& screen = scratch.triangles[i];
+                rasterizeTriangle(buffer, zbuffer, screen.projected, screen.intensities);
+            }
+        };
+
+        measure(report, name, triangles, cols, rows, BENCH_GEOMETRY, [](int) {}, geometry);
+        measure(report, name, triangles, cols, rows, BENCH_RASTER, geometry, raster);
+
+        // Each run presents the next frame of the turntable, so the terminal
+        // sees the changes of a real animation
+        TerminalOutput terminal(cols, rows, output);
+        measure(report, name, triangles, cols, rows, BENCH_OUTPUT,
+                [&](int run) {
+                    geometry(run);
+                    raster(run);
+                },
+                [&](int) { terminal.present(buffer); });
+
+        TerminalOutput frameOutput(cols, rows, output);
+        RenderContext context(cols, rows);
+        context.setMesh(mesh);
+        context.setSink(&frameOutput);
+        measure(report, name, triangles, cols, rows, BENCH_FRAME,
+                [&](int run) { context.camera = cameraFor(run); },
+                [&](int) {
+                    context.render();
+                    context.present();
+                });
+    }
+
+    // Appends `text` as a JSON string
+    void appendJsonString(std::string& out, const std::string& text) {
+        out += '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    // Value of "key": "..." on a line written by benchJson()
+    bool jsonString(const std::string& line, const char* key, std::string& value) {
+        std::string pattern = std::string("\"") + key + "\": \"";
+        size_t at = line.find(pattern);
+        if (at == std::string::npos) return false;
+        value.clear();
+        for (size_t i = at + pattern.size(); i < line.size(); i++) {
+            char c = line[i];
+            if (c == '"') return true;
+            if (c == '\\' && i + 1 < line.size()) {
+                c = line[++i];
+                if (c == 'u' && i + 4 < line.size()) {
+                    c = (char)std::strtol(line.substr(i + 1, 4).c_str(), nullptr, 16);
+                    i += 4;
+                }
+            }
+            value += c;
+        }
+        return false;
+    }
+
+    // Value of "key": <number> on a line written by benchJson()
+    bool jsonNumber(const std::string& line, const char* key, double& value) {
+        std::string pattern = std::string("\"") + key + "\": ";
+        size_t at = line.find(pattern);
+        if (at == std::string::npos) return false;
+        const char* start = line.c_str() + at + pattern.size();
+        char* end;
+        value = std::strtod(start, &end);
+        return end != start;
+    }
+} // anonymous namespace
+
+void summarizeSamples(std::vector<double>& samplesMs, BenchResult& result) {
+    if (samplesMs.empty()) return;
+    std::sort(samplesMs.begin(), samplesMs.end());
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)std::ceil(p * samplesMs.size());
+        return samplesMs[std::max<size_t>(rank, 1) - 1];
+    };
+    result.medianMs = percentile(0.50);
+    result.p90Ms = percentile(0.90);
+    result.p99Ms = percentile(0.99);
+    result.minMs = samplesMs.front();
+    result.maxMs = samplesMs.back();
+    double sum = 0.0;
+    for (double ms : samplesMs) sum += ms;
+    result.meanMs = sum / samplesMs.size();
+}
+
+bool pinToCpu(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+BenchReport runBenchmarks(const BenchOptions& options) {
+    BenchReport report;
+    report.warmup = std::max(0, options.warmup);
+    report.repetitions = std::max(1, options.repetitions);
+    report.cpu = options.cpu >= 0 && pinToCpu(options.cpu) ? options.cpu : -1;
+
+    int output = ::open("/dev/null", O_WRONLY);
+    for (const std::string& path : options.models) {
+        std::vector<Triangle> raw;
+        if (!readSTL(path, raw) || raw.empty()) {
+            report.failures.push_back(path);
+            continue;
+        }
+        const size_t slash = path.find_last_of('/');
+        const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        const size_t triangles = raw.size();
+
+        std::vector<Triangle> loaded;
+        measure(report, name, triangles, 0, 0, BENCH_LOAD, [](int) {},
+                [&](int) { readSTL(path, loaded); });
+
+        // Each run normalizes a fresh copy of the file's coordinates
+        std::vector<Triangle> model;
+        float scale;
+        measure(report, name, triangles, 0, 0, BENCH_NORMALIZE, [&](int) { model = raw; },
+                [&](int) { normalizeModel(model, scale); });
+
+        MeshRef mesh = std::make_shared<const std::vector<Triangle>>(std::move(model));
+        for (const BenchResolution& size : options.resolutions) {
+            if (size.cols > 0 && size.rows > 0) benchResolution(report, name, mesh, size, output);
+        }
+    }
+    if (output >= 0) ::close(output);
+    return report;
+}
+
+std::string benchJson(const BenchReport& report) {
+    char line[512];
+    std::snprintf(line, sizeof(line), "{\n  \"cpu\": %d,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n",
+                  report.cpu, report.warmup, report.repetitions);
+    std::string out = line;
+
+    out += "  \"failures\": [";
+    for (size_t i = 0; i < report.failures.size(); i++) {
+        if (i > 0) out += ", ";
+        appendJsonString(out, report.failures[i]);
+    }
+    out += "],\n  \"results\": [\n";
+
+    for (size_t i = 0; i < report.results.size(); i++) {
+        const BenchResult& r = report.results[i];
+        out += "    {\"model\": ";
+        appendJsonString(out, r.model);
+        std::snprintf(line, sizeof(line),
+                      ", \"triangles\": %zu, \"cols\": %d, \"rows\": %d, \"stage\": \"%s\", "
+                      "\"median_ms\": %.6f, \"p90_ms\": %.6f, \"p99_ms\": %.6f, \"min_ms\": %.6f, "
+                      "\"max_ms\": %.6f, \"mean_ms\": %.6f, \"triangles_per_second\": %.0f}%s\n",
+                      r.triangles, r.cols, r.rows, BENCH_STAGE_NAMES[r.stage], r.medianMs, r.p90Ms,
+                      r.p99Ms, r.minMs, r.maxMs, r.meanMs, r.trianglesPerSecond(),
+                      i + 1 < report.results.size() ? "," : "");
+        out += line;
+    }
+    out += "  ]\n}\n";
+    return out;
+}
+
+bool saveBenchJson(const std::string& path, const BenchReport& report) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::string json = benchJson(report);
+    bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool loadBenchJson(const std::string& path, std::vector<BenchResult>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    results.clear();
+
+    // One result per line, as benchJson() writes them
+    std::string line;
+    char chunk[1024];
+    bool ok = true;
+    while (ok && std::fgets(chunk, sizeof(chunk), file)) {
+        line += chunk;
+        if (line.back() != '\n' && !std::feof(file)) continue;
+
+        std::string stage;
+        if (jsonString(line, "stage", stage)) {
+            BenchResult result;
+            double triangles = 0, cols = 0, rows = 0;
+            const char* const* name = std::find_if(BENCH_STAGE_NAMES, BENCH_STAGE_NAMES + BENCH_STAGE_COUNT,
+                                                   [&](const char* n) { return stage == n; });
+            ok = name != BENCH_STAGE_NAMES + BENCH_STAGE_COUNT &&
+                 jsonString(line, "model", result.model) && jsonNumber(line, "triangles", triangles) &&
+                 jsonNumber(line, "cols", cols) && jsonNumber(line, "rows", rows) &&
+                 jsonNumber(line, "median_ms", result.medianMs) && jsonNumber(line, "p90_ms", result.p90Ms) &&
+                 jsonNumber(line, "p99_ms", result.p99Ms) && jsonNumber(line, "min_ms", result.minMs) &&
+                 jsonNumber(line, "max_ms", result.maxMs) && jsonNumber(line, "mean_ms", result.meanMs);
+            result.stage = (BenchStage)(name - BENCH_STAGE_NAMES);
+            result.triangles = (size_t)triangles;
+            result.cols = (int)cols;
+            result.rows = (int)rows;
+            if (ok) results.push_back(result);
+        }
+        line.clear();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+std::vector<BenchComparison> compareBench(const std::vector<BenchResult>& current,
+                                          const std::vector<BenchResult>& baseline) {
+    std::vector<BenchComparison> comparisons;
+    for (const BenchResult& result : current) {
+        BenchComparison comparison;
+        comparison.current = result;
+        for (const BenchResult& before : baseline) {
+            if (before.model == result.model && before.cols == result.cols && before.rows == result.rows &&
+                before.stage == result.stage) {
+                comparison.baseline = before;
+                comparison.compared = true;
+                break;
+            }
+        }
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
@@ -0,0 +1,67 @@
+#include "canvas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr int CELL_PIXELS = FONT_CELL_WIDTH * FONT_CELL_HEIGHT;
+} // anonymous namespace
+
+CanvasBuffer::CanvasBuffer(int cols, int rows)
+    : cols(cols), rows(rows),
+      pixels((size_t)cols * FONT_CELL_WIDTH * rows * FONT_CELL_HEIGHT, CANVAS_BACKGROUND),
+      tiles((size_t)256 * CELL_PIXELS, CANVAS_BACKGROUND) {
+    for (int c = 0; c < 256; c++) {
+        const uint8_t* glyph = fontGlyph((char)c);
+        uint32_t* tile = tiles.data() + (size_t)c * CELL_PIXELS;
+        for (int gy = 0; gy < FONT_GLYPH_HEIGHT; gy++) {
+            uint32_t* out = tile + (FONT_GLYPH_TOP + gy) * FONT_CELL_WIDTH;
+            for (int gx = 0; gx < FONT_GLYPH_WIDTH; gx++) {
+                if (glyph[gy] & (1 << (FONT_GLYPH_WIDTH - 1 - gx))) out[gx] = CANVAS_FOREGROUND;
+            }
+        }
+    }
+}
+
+PixelRect CanvasBuffer::blit(const DisplayBuffer& display) {
+    int left = cols, right = -1, top = rows, bottom = -1;
+    for (const auto& span : display.dirty()) {
+        if (span.row >= rows) break;
+        int last = std::min(span.last, cols - 1);
+        if (span.first > last) continue;
+
+        blitCells(display, span.row, span.first, last);
+        left = std::min(left, span.first);
+        right = std::max(right, last);
+        top = std::min(top, span.row);
+        bottom = std::max(bottom, span.row);
+    }
+
+    if (right < 0) return {0, 0, 0, 0};
+    return {left * FONT_CELL_WIDTH, top * FONT_CELL_HEIGHT,
+            (right - left + 1) * FONT_CELL_WIDTH, (bottom - top + 1) * FONT_CELL_HEIGHT};
+}
+
+PixelRect CanvasBuffer::blitAll(const DisplayBuffer& display) {
+    int height = std::min(rows, display.height());
+    int width = std::min(cols, display.width());
+    for (int y = 0; y < height; y++) {
+        blitCells(display, y, 0, width - 1);
+    }
+    return {0, 0, width * FONT_CELL_WIDTH, height * FONT_CELL_HEIGHT};
+}
+
+void CanvasBuffer::blitCells(const DisplayBuffer& display, int row, int first, int last) {
+    const char* glyphs = display.row(row);
+    const int pitch = width();
+    uint32_t* cellRow = pixels.data() + (size_t)row * FONT_CELL_HEIGHT * pitch;
+
+    for (int x = first; x <= last; x++) {
+        const uint32_t* tile = tiles.data() + (size_t)(uint8_t)glyphs[x] * CELL_PIXELS;
+        uint32_t* out = cellRow + x * FONT_CELL_WIDTH;
+        for (int py = 0; py < FONT_CELL_HEIGHT; py++) {
+            std::memcpy(out + (size_t)py * pitch, tile + py * FONT_CELL_WIDTH,
+                        FONT_CELL_WIDTH * sizeof(uint32_t));
+        }
+    }
+    blitted += last - first + 1;
+}
@@ -0,0 +1,39 @@
+#include "display.h"
+#include <algorithm>
+#include <cstring>
+
+DisplayBuffer::DisplayBuffer(int width, int height)
+    : cols(width), rows(height), glyphs((size_t)height * (width + 1), ' ') {
+    for (int y = 0; y < rows; y++) {
+        glyphs[(size_t)y * stride() + cols] = '\n';
+    }
+    spans.reserve(rows);
+}
+
+size_t DisplayBuffer::update(const std::vector<std::string>& buffer) {
+    spans.clear();
+    stats.frames++;
+
+    int height = std::min(rows, (int)buffer.size());
+    for (int y = 0; y < height; y++) {
+        char* stored = glyphs.data() + (size_t)y * stride();
+        const std::string& line = buffer[y];
+        int width = std::min(cols, (int)line.size());
+
+        int first = 0;
+        int last = width - 1;
+        if (!forceFull) {
+            // Narrow to the changed span from both ends
+            while (first < width && stored[first] == line[first]) first++;
+            if (first == width) continue;
+            while (last > first && stored[last] == line[last]) last--;
+        }
+
+        std::memcpy(stored + first, line.data() + first, last - first + 1);
+        spans.push_back({y, first, last});
+    }
+
+    forceFull = false;
+    if (spans.empty()) stats.skipped++;
+    return spans.size();
+}
@@ -0,0 +1,193 @@
+#include "frame_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "rasterizer.h"
+#include "renderer.h"
+
+namespace {
+    // Shepperd's method: pick the largest of w, x, y, z to divide by
+    void toQuaternion(const Mat3& r, float q[4]) {
+        const float (*m)[3] = r.m;
+        float trace = m[0][0] + m[1][1] + m[2][2];
+        if (trace > 0.0f) {
+            float s = std::sqrt(trace + 1.0f) * 2.0f;
+            q[0] = 0.25f * s;
+            q[1] = (m[2][1] - m[1][2]) / s;
+            q[2] = (m[0][2] - m[2][0]) / s;
+            q[3] = (m[1][0] - m[0][1]) / s;
+        } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+            float s = std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+            q[0] = (m[2][1] - m[1][2]) / s;
+            q[1] = 0.25f * s;
+            q[2] = (m[0][1] + m[1][0]) / s;
+            q[3] = (m[0][2] + m[2][0]) / s;
+        } else if (m[1][1] > m[2][2]) {
+            float s = std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+            q[0] = (m[0][2] - m[2][0]) / s;
+            q[1] = (m[0][1] + m[1][0]) / s;
+            q[2] = 0.25f * s;
+            q[3] = (m[1][2] + m[2][1]) / s;
+        } else {
+            float s = std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+            q[0] = (m[1][0] - m[0][1]) / s;
+            q[1] = (m[0][2] + m[2][0]) / s;
+            q[2] = (m[1][2] + m[2][1]) / s;
+            q[3] = 0.25f * s;
+        }
+    }
+
+    size_t frameBytes(int width, int height) {
+        return (size_t)width * height;
+    }
+} // anonymous namespace
+
+FrameCache::FrameCache(size_t capacityBytes, int resolution)
+    : capacityBytes(capacityBytes), binsPerUnit(std::max(1, resolution)) {}
+
+uint64_t FrameCache::orientationKey(const Mat3& rotation, int resolution) {
+    float q[4];
+    toQuaternion(rotation, q);
+
+    // q and -q are the same rotation: make the first non-zero component positive
+    float sign = 1.0f;
+    for (float c : q) {
+        if (c != 0.0f) {
+            sign = c < 0.0f ? -1.0f : 1.0f;
+            break;
+        }
+    }
+
+    uint64_t key = 0;
+    for (float c : q) {
+        long bin = std::lround(sign * c * resolution);
+        key = (key << 16) | (uint16_t)(int16_t)bin;
+    }
+    return key;
+}
+
+bool FrameCache::lookup(uint64_t key, std::vector<std::string>& buffer) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        stats.misses++;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    const Entry& entry = entries.front();
+    if ((int)buffer.size() != entry.height) buffer.resize(entry.height);
+    for (int y = 0; y < entry.height; y++) {
+        buffer[y].assign(entry.glyphs.data() + (size_t)y * entry.width, entry.width);
+    }
+    stats.hits++;
+    return true;
+}
+
+void FrameCache::store(uint64_t key, const std::vector<std::string>& buffer) {
+    int height = (int)buffer.size();
+    int width = height > 0 ? (int)buffer[0].size() : 0;
+    size_t size = frameBytes(width, height);
+    if (size > capacityBytes) return;
+
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        used -= existing->second->glyphs.size();
+        entries.erase(existing->second);
+        index.erase(existing);
+    }
+
+    while (used + size > capacityBytes && !entries.empty()) {
+        used -= entries.back().glyphs.size();
+        index.erase(entries.back().key);
+        entries.pop_back();
+        stats.evictions++;
+    }
+
+    entries.push_front({key, width, height, std::vector<char>(size, ' ')});
+    Entry& entry = entries.front();
+    for (int y = 0; y < height; y++) {
+        std::memcpy(entry.glyphs.data() + (size_t)y * width, buffer[y].data(),
+                    std::min((size_t)width, buffer[y].size()));
+    }
+    index[key] = entries.begin();
+    used += size;
+    memory.set(used);
+    stats.stored++;
+}
+
+void FrameCache::clear() {
+    entries.clear();
+    index.clear();
+    used = 0;
+    memory.set(0);
+}
+
+void TurntablePrecompute::restart(float x, float y, float z, float step) {
+    angleX = x;
+    angleY = y;
+    angleZ = z;
+    speed = step;
+    ahead = 0;
+    generation++;
+}
+
+void TurntablePrecompute::resize(int width, int height) {
+    cols = width;
+    rows = height;
+    buffer.clear();
+    zbuffer.clear();
+}
+
+int TurntablePrecompute::run(const std::vector<Triangle>& model, const Vec3& lightDir,
+                             FrameCache& cache, double budgetSeconds, int maxAhead) {
+    if (model.empty()) return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    int rendered = 0;
+    Step step;
+    while (nextStep(cache, step, maxAhead)) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetSeconds) break;
+        renderStep(model, lightDir, step);
+        finishStep(step, cache);
+        if (step.render) rendered++;
+    }
+    return rendered;
+}
+
+bool TurntablePrecompute::nextStep(const FrameCache& cache, Step& step, int maxAhead) const {
+    // Keep the lookahead well inside the cap so upcoming frames are never the
+    // least recently used ones when the cache evicts
+    size_t capacityFrames = cache.capacity() / frameBytes(cols, rows);
+    if (ahead >= std::min(maxAhead, (int)(capacityFrames / 4))) return false;
+
+    step.rotation = rotationX(angleX) * rotationY(angleY) * rotationZ(angleZ);
+    step.key = cache.keyFor(step.rotation);
+    step.render = !cache.contains(step.key);
+    step.generation = generation;
+    return true;
+}
+
+void TurntablePrecompute::renderStep(const std::vector<Triangle>& model, const Vec3& lightDir,
+                                     const Step& step) {
+    if (!step.render) return;
+    if (buffer.empty()) {
+        buffer.resize(rows, std::string(cols, ' '));
+        zbuffer.resize((size_t)cols * rows);
+    }
+    clearBuffers(buffer, zbuffer);
+    renderFrame(buffer, zbuffer, model, step.rotation, lightDir);
+}
+
+bool TurntablePrecompute::finishStep(const Step& step, FrameCache& cache) {
+    if (step.generation != generation) return false;
+    if (step.render) cache.store(step.key, buffer);
+
+    // Same stepping as renderStep() in main.cpp
+    angleX += speed;
+    angleY += speed * 1.3f;
+    angleZ += speed * 0.7f;
+    ahead++;
+    return true;
+}
@@ -0,0 +1,298 @@
+#include "framestream.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr char MAGIC[4] = {'T', 'M', 'F', 'S'};
+    constexpr size_t HEADER_SIZE = 20;
+    constexpr size_t FRAME_COUNT_OFFSET = 12;
+    constexpr size_t INDEX_OFFSET_OFFSET = 16;
+    constexpr size_t FRAME_HEADER_SIZE = 5;
+
+    constexpr uint8_t OP_LITERAL = 0x00;
+    constexpr uint8_t OP_RUN = 0x40;
+    constexpr uint8_t OP_KEEP = 0x80;
+    constexpr uint8_t OP_SKIP_ROWS = 0xC0;
+    constexpr uint8_t OP_MASK = 0xC0;
+    constexpr int MAX_OP_LENGTH = 64;
+
+    // Shorter runs of a repeated glyph are cheaper as literals
+    constexpr int MIN_RUN = 3;
+
+    void putU16(std::vector<uint8_t>& out, uint16_t v) {
+        out.push_back((uint8_t)(v & 0xFF));
+        out.push_back((uint8_t)(v >> 8));
+    }
+
+    void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+    }
+
+    void patchU32(std::vector<uint8_t>& out, size_t at, uint32_t v) {
+        for (int i = 0; i < 4; i++) out[at + i] = (uint8_t)(v >> (8 * i));
+    }
+
+    uint16_t readU16(const std::vector<uint8_t>& in, size_t at) {
+        return (uint16_t)(in[at] | (in[at + 1] << 8));
+    }
+
+    uint32_t readU32(const std::vector<uint8_t>& in, size_t at) {
+        return (uint32_t)in[at] | ((uint32_t)in[at + 1] << 8) |
+               ((uint32_t)in[at + 2] << 16) | ((uint32_t)in[at + 3] << 24);
+    }
+
+    void putSkip(std::vector<uint8_t>& out, int& skip) {
+        while (skip > 0) {
+            int n = std::min(skip, MAX_OP_LENGTH);
+            out.push_back((uint8_t)(OP_SKIP_ROWS | (n - 1)));
+            skip -= n;
+        }
+    }
+
+    // Sizes a buffer to the stream dimensions, keeping it if it already fits
+    void fitBuffer(std::vector<std::string>& buffer, int width, int height) {
+        if ((int)buffer.size() != height) buffer.resize(height);
+        for (auto& line : buffer) {
+            if ((int)line.size() != width) line.assign(width, ' ');
+        }
+    }
+} // anonymous namespace
+
+FrameStreamRecorder::FrameStreamRecorder(int width, int height, int fps, int keyframeInterval)
+    : cols(width), rows(height), keyframeInterval(std::max(1, keyframeInterval)),
+      previous((size_t)width * height, ' ') {
+    bytes.insert(bytes.end(), MAGIC, MAGIC + 4);
+    putU16(bytes, FRAME_STREAM_VERSION);
+    putU16(bytes, (uint16_t)width);
+    putU16(bytes, (uint16_t)height);
+    putU16(bytes, (uint16_t)fps);
+    putU32(bytes, 0); // Frame count, set by finish()
+    putU32(bytes, 0); // Index offset, set by finish()
+}
+
+void FrameStreamRecorder::addFrame(const std::vector<std::string>& frame) {
+    if (finished) return;
+
+    bool keyframe = frameCount % keyframeInterval == 0;
+    if (keyframe) {
+        keyframeIndex.push_back((uint32_t)frameCount);
+        keyframeIndex.push_back((uint32_t)bytes.size());
+    }
+
+    bytes.push_back(keyframe ? 'K' : 'D');
+    size_t sizeAt = bytes.size();
+    putU32(bytes, 0);
+    size_t payloadStart = bytes.size();
+
+    std::string padded;
+    int skip = 0;
+    for (int y = 0; y < rows; y++) {
+        const char* row;
+        if (y < (int)frame.size() && (int)frame[y].size() == cols) {
+            row = frame[y].data();
+        } else {
+            // Short or missing rows are padded with blanks
+            padded.assign(cols, ' ');
+            if (y < (int)frame.size()) {
+                padded.replace(0, std::min((int)frame[y].size(), cols), frame[y], 0, cols);
+            }
+            row = padded.data();
+        }
+
+        char* prev = previous.data() + (size_t)y * cols;
+        if (!keyframe && std::memcmp(row, prev, cols) == 0) {
+            skip++;
+            continue;
+        }
+
+        putSkip(bytes, skip);
+        encodeRow(row, prev, !keyframe);
+        std::memcpy(prev, row, cols);
+    }
+    putSkip(bytes, skip);
+
+    patchU32(bytes, sizeAt, (uint32_t)(bytes.size() - payloadStart));
+    frameCount++;
+}
+
+void FrameStreamRecorder::encodeRow(const char* row, const char* prev, bool delta) {
+    int x = 0;
+    while (x < cols) {
+        if (delta && row[x] == prev[x]) {
+            int n = 1;
+            while (x + n < cols && n < MAX_OP_LENGTH && row[x + n] == prev[x + n]) n++;
+            bytes.push_back((uint8_t)(OP_KEEP | (n - 1)));
+            x += n;
+            continue;
+        }
+
+        int run = 1;
+        while (x + run < cols && run < MAX_OP_LENGTH && row[x + run] == row[x]) run++;
+        if (run >= MIN_RUN) {
+            bytes.push_back((uint8_t)(OP_RUN | (run - 1)));
+            bytes.push_back((uint8_t)row[x]);
+            x += run;
+            continue;
+        }
+
+        // Literal up to the next keepable cell or worthwhile run
+        int start = x;
+        int n = 0;
+        while (x < cols && n < MAX_OP_LENGTH) {
+            if (delta && row[x] == prev[x]) break;
+            if (n > 0 && x + 2 < cols && row[x] == row[x + 1] && row[x] == row[x + 2]) break;
+            x++;
+            n++;
+        }
+        bytes.push_back((uint8_t)(OP_LITERAL | (n - 1)));
+        bytes.insert(bytes.end(), row + start, row + start + n);
+    }
+}
+
+const std::vector<uint8_t>& FrameStreamRecorder::finish() {
+    if (finished) return bytes;
+    finished = true;
+
+    uint32_t indexOffset = (uint32_t)bytes.size();
+    putU32(bytes, (uint32_t)(keyframeIndex.size() / 2));
+    for (uint32_t v : keyframeIndex) putU32(bytes, v);
+
+    patchU32(bytes, FRAME_COUNT_OFFSET, (uint32_t)frameCount);
+    patchU32(bytes, INDEX_OFFSET_OFFSET, indexOffset);
+    return bytes;
+}
+
+bool FrameStreamRecorder::save(const std::string& filename) {
+    finish();
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool FrameStreamPlayer::load(std::vector<uint8_t> data) {
+    bytes = std::move(data);
+    frameCount = 0;
+    keyframeFrames.clear();
+    keyframeOffsets.clear();
+
+    if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0 ||
+        readU16(bytes, 4) != FRAME_STREAM_VERSION) {
+        return false;
+    }
+
+    cols = readU16(bytes, 6);
+    rows = readU16(bytes, 8);
+    framesPerSecond = readU16(bytes, 10);
+    uint32_t count = readU32(bytes, FRAME_COUNT_OFFSET);
+    uint32_t indexOffset = readU32(bytes, INDEX_OFFSET_OFFSET);
+
+    if (indexOffset < HEADER_SIZE || (size_t)indexOffset + 4 > bytes.size()) return false;
+    uint32_t keyframes = readU32(bytes, indexOffset);
+    if ((size_t)indexOffset + 4 + (size_t)keyframes * 8 > bytes.size()) return false;
+    if (count > 0 && keyframes == 0) return false;
+
+    for (uint32_t i = 0; i < keyframes; i++) {
+        uint32_t frame = readU32(bytes, indexOffset + 4 + i * 8);
+        uint32_t at = readU32(bytes, indexOffset + 8 + i * 8);
+        if (frame >= count || at < HEADER_SIZE || at >= indexOffset) return false;
+        keyframeFrames.push_back(frame);
+        keyframeOffsets.push_back(at);
+    }
+    if (count > 0 && keyframeFrames[0] != 0) return false;
+
+    // Frame data ends where the index starts
+    bytes.resize(indexOffset);
+    frameCount = (int)count;
+    current = 0;
+    offset = keyframeOffsets.empty() ? HEADER_SIZE : keyframeOffsets[0];
+    return true;
+}
+
+bool FrameStreamPlayer::loadFile(const std::string& filename) {
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    std::vector<uint8_t> data;
+    uint8_t chunk[64 * 1024];
+    size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    std::fclose(file);
+    return load(std::move(data));
+}
+
+bool FrameStreamPlayer::next(std::vector<std::string>& buffer) {
+    if (frameCount == 0) return false;
+    if (current >= frameCount) {
+        // Loop back to the start
+        current = 0;
+        offset = keyframeOffsets[0];
+    }
+    fitBuffer(buffer, cols, rows);
+    return decodeFrame(buffer);
+}
+
+bool FrameStreamPlayer::seek(int frame, std::vector<std::string>& buffer) {
+    if (frame < 0 || frame >= frameCount) return false;
+
+    auto it = std::upper_bound(keyframeFrames.begin(), keyframeFrames.end(), (uint32_t)frame);
+    size_t key = (size_t)(it - keyframeFrames.begin()) - 1;
+    current = (int)keyframeFrames[key];
+    offset = keyframeOffsets[key];
+
+    fitBuffer(buffer, cols, rows);
+    while (current < frame) {
+        if (!decodeFrame(buffer)) return false;
+    }
+    return true;
+}
+
+bool FrameStreamPlayer::decodeFrame(std::vector<std::string>& buffer) {
+    if (offset + FRAME_HEADER_SIZE > bytes.size()) return false;
+    uint8_t type = bytes[offset];
+    if (type != 'K' && type != 'D') return false;
+    size_t p = offset + FRAME_HEADER_SIZE;
+    size_t end = p + readU32(bytes, offset + 1);
+    if (end > bytes.size()) return false;
+
+    int y = 0;
+    while (p < end && y < rows) {
+        if ((bytes[p] & OP_MASK) == OP_SKIP_ROWS) {
+            y += (bytes[p++] & 0x3F) + 1;
+            continue;
+        }
+
+        std::string& line = buffer[y];
+        int x = 0;
+        while (x < cols) {
+            if (p >= end) return false;
+            uint8_t op = bytes[p++];
+            int n = (op & 0x3F) + 1;
+            if (x + n > cols) return false;
+
+            switch (op & OP_MASK) {
+                case OP_LITERAL:
+                    if (p + n > end) return false;
+                    std::memcpy(&line[x], &bytes[p], n);
+                    p += n;
+                    break;
+                case OP_RUN:
+                    if (p >= end) return false;
+                    std::memset(&line[x], bytes[p++], n);
+                    break;
+                case OP_KEEP:
+                    break;
+                default:
+                    return false;
+            }
+            x += n;
+        }
+        y++;
+    }
+
+    offset = end;
+    current++;
+    return true;
+}
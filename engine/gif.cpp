@@ -0,0 +1,146 @@
+#include "gif.h"
+#include <algorithm>
+
+namespace {
+    constexpr int MAX_CODES = 1 << GIF_MAX_CODE_BITS;
+    constexpr size_t MAX_SUB_BLOCK = 255;
+
+    void putU16(std::vector<uint8_t>& out, int v) {
+        out.push_back((uint8_t)(v & 0xFF));
+        out.push_back((uint8_t)((v >> 8) & 0xFF));
+    }
+
+    // Packs variable-width codes least significant bit first
+    struct BitWriter {
+        std::vector<uint8_t>& out;
+        uint32_t bits = 0;
+        int used = 0;
+
+        void put(int code, int width) {
+            bits |= (uint32_t)code << used;
+            used += width;
+            while (used >= 8) {
+                out.push_back((uint8_t)(bits & 0xFF));
+                bits >>= 8;
+                used -= 8;
+            }
+        }
+
+        void flush() {
+            if (used > 0) out.push_back((uint8_t)(bits & 0xFF));
+            bits = 0;
+            used = 0;
+        }
+    };
+} // anonymous namespace
+
+void lzwEncode(const uint8_t* pixels, size_t count, int minCodeSize, std::vector<uint8_t>& out) {
+    const int alphabet = 1 << minCodeSize;
+    const int clearCode = alphabet;
+    const int endCode = alphabet + 1;
+
+    // Child code of (prefix, symbol), or -1; indexed prefix * alphabet + symbol
+    std::vector<int16_t> table((size_t)MAX_CODES * alphabet, -1);
+    int nextCode = endCode + 1;
+    int codeSize = minCodeSize + 1;
+
+    BitWriter writer{out};
+    writer.put(clearCode, codeSize);
+    if (count == 0) {
+        writer.put(endCode, codeSize);
+        writer.flush();
+        return;
+    }
+
+    int prefix = pixels[0];
+    for (size_t i = 1; i < count; i++) {
+        int symbol = pixels[i];
+        int16_t& child = table[(size_t)prefix * alphabet + symbol];
+        if (child >= 0) {
+            prefix = child;
+            continue;
+        }
+
+        writer.put(prefix, codeSize);
+        if (nextCode < MAX_CODES) {
+            child = (int16_t)nextCode++;
+            // The decoder adds its entry one code later, so widen once the
+            // code just added no longer fits
+            if (nextCode > (1 << codeSize) && codeSize < GIF_MAX_CODE_BITS) codeSize++;
+        } else {
+            // Table full: start over rather than coding with a stale dictionary
+            writer.put(clearCode, codeSize);
+            std::fill(table.begin(), table.end(), -1);
+            nextCode = endCode + 1;
+            codeSize = minCodeSize + 1;
+        }
+        prefix = symbol;
+    }
+
+    writer.put(prefix, codeSize);
+    writer.put(endCode, codeSize);
+    writer.flush();
+}
+
+void gifHeader(std::vector<uint8_t>& out, int width, int height,
+               const uint8_t (*palette)[3], int colors) {
+    colors = std::min(colors, 256);
+    int bits = 2;
+    while ((1 << bits) < colors) bits++;
+
+    static const char signature[] = "GIF89a";
+    out.insert(out.end(), signature, signature + 6);
+    putU16(out, width);
+    putU16(out, height);
+    out.push_back((uint8_t)(0x80 | ((bits - 1) << 4) | (bits - 1))); // Global palette
+    out.push_back(0);   // Background colour index
+    out.push_back(0);   // Square pixels
+
+    for (int i = 0; i < (1 << bits); i++) {
+        for (int c = 0; c < 3; c++) {
+            out.push_back(i < colors ? palette[i][c] : 0);
+        }
+    }
+
+    // NETSCAPE2.0 application extension: loop forever
+    static const char app[] = "NETSCAPE2.0";
+    out.push_back(0x21);
+    out.push_back(0xFF);
+    out.push_back(11);
+    out.insert(out.end(), app, app + 11);
+    out.push_back(3);
+    out.push_back(1);
+    putU16(out, 0);
+    out.push_back(0);
+}
+
+void gifFrame(std::vector<uint8_t>& out, int left, int top, int width, int height,
+              const uint8_t* pixels, int minCodeSize, int delayCs) {
+    // Graphic control extension: keep this frame when drawing the next one
+    out.push_back(0x21);
+    out.push_back(0xF9);
+    out.push_back(4);
+    out.push_back(1 << 2);
+    putU16(out, delayCs);
+    out.push_back(0);   // No transparent colour
+    out.push_back(0);
+
+    // Image descriptor, no local palette
+    out.push_back(0x2C);
+    putU16(out, left);
+    putU16(out, top);
+    putU16(out, width);
+    putU16(out, height);
+    out.push_back(0);
+
+    std::vector<uint8_t> data;
+    lzwEncode(pixels, (size_t)width * height, minCodeSize, data);
+
+    out.push_back((uint8_t)minCodeSize);
+    for (size_t at = 0; at < data.size(); at += MAX_SUB_BLOCK) {
+        size_t n = std::min(MAX_SUB_BLOCK, data.size() - at);
+        out.push_back((uint8_t)n);
+        out.insert(out.end(), data.begin() + at, data.begin() + at + n);
+    }
+    out.push_back(0);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @file alloc_counter.h
+ * @brief Debug hook that counts heap allocations, to prove code paths that
+ *        should not allocate really do not.
+ *
+ * Counting replaces the global operator new, so it is only compiled in with
+ * TERMESH_COUNT_ALLOCATIONS, which the test build defines. Elsewhere the
+ * counter stays at 0 and the hook is never called.
+ */
+
+// Called with the size of every heap allocation, on the allocating thread
+using AllocationHook = void (*)(size_t bytes);
+
+// Whether this build counts allocations
+bool allocationCounting();
+
+// operator new calls by every thread since the process started
+size_t heapAllocations();
+
+// Installs a hook (null removes it), e.g. to break on the allocation that
+// broke an allocation-free loop. Returns the previous hook.
+AllocationHook setAllocationHook(AllocationHook hook);
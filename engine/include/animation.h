@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "math3d.h"
+#include "model.h"
+#include "rasterizer.h"
+
+/**
+ * @file animation.h
+ * @brief Headless export of the rotation animation as an animated GIF.
+ */
+
+// Colours of the exported frames: background, then dim, mid and bright glyphs
+constexpr int ANIMATION_COLORS = 4;
+constexpr int ANIMATION_CODE_SIZE = 2;
+
+struct AnimationOptions {
+    int frames = 120;
+    int threads = 0;                // 0 = one per hardware thread
+    int delayCs = 3;                // Per frame, in hundredths of a second
+    float rotationSpeed = 0.02f;    // Same stepping as the live renderer
+    int cols = SCREEN_WIDTH;        // Frame size in character cells
+    int rows = SCREEN_HEIGHT;
+};
+
+struct AnimationStats {
+    int threads = 0;
+    int width = 0, height = 0;      // Image size in pixels
+    double renderSeconds = 0.0;     // Rasterizing the character frames
+    double encodeSeconds = 0.0;     // Drawing glyphs and compressing
+    size_t bytes = 0;               // Size of the GIF
+};
+
+// Cell rectangle of a frame, inclusive
+struct CellRect {
+    int left, top, right, bottom;
+};
+
+/**
+ * @brief Finds the cells that differ between two frames of the same size.
+ * @return The bounding rectangle, or cell (0, 0) when nothing changed so the
+ *         frame still has something to carry its delay.
+ */
+CellRect changedCells(const std::vector<std::string>& previous,
+                      const std::vector<std::string>& frame);
+
+/**
+ * @brief Draws a rectangle of cells with the bitmap font as palette indices.
+ *
+ * Glyphs are coloured by their place in SHADE_CHARS, so the export keeps the
+ * shading. Cells are FONT_CELL_WIDTH x FONT_CELL_HEIGHT pixels.
+ *
+ * @param pixels Resized to the rectangle's pixel size and filled row by row.
+ */
+void drawGlyphs(const std::vector<std::string>& frame, const CellRect& rect,
+                std::vector<uint8_t>& pixels);
+
+/**
+ * @brief Renders the rotation animation and writes it as a looping GIF.
+ *
+ * Frames are rasterized in parallel, then each frame is drawn and compressed
+ * in parallel, cropped to the cells that changed since the frame before.
+ *
+ * @param stats Optional timing and size report.
+ * @return False if the file cannot be written.
+ */
+bool exportAnimationGif(const std::vector<Triangle>& model, const Vec3& lightDir,
+                        const std::string& filename, const AnimationOptions& options,
+                        AnimationStats* stats = nullptr);
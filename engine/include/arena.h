@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "memory_stats.h"
+
+/**
+ * @file arena.h
+ * @brief Bump allocator for data that lives for one frame.
+ */
+
+// Size of an arena's first block, and the least it grows by
+constexpr size_t ARENA_BLOCK_BYTES = 64 * 1024;
+
+/**
+ * @brief Hands out memory by bumping an offset and takes it all back at once
+ *        with reset().
+ *
+ * Blocks are kept across resets. When a frame needed more than one block,
+ * the next reset merges them into a single block of the combined size, so
+ * once the arena has seen its largest frame, later frames allocate nothing
+ * from the heap. Objects placed in the arena are never destroyed: use it
+ * for trivially destructible types. Not synchronized.
+ */
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockBytes = ARENA_BLOCK_BYTES);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // `bytes` of uninitialized memory aligned to `align` (a power of two)
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    // Uninitialized room for `count` objects of type T
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Releases everything allocated since the last reset
+    void reset();
+
+    size_t used() const { return usedBytes; }          // Bytes handed out since the last reset
+    size_t capacity() const;                           // Bytes held in blocks
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t minBytes);
+
+    size_t blockBytes;
+    std::vector<Block> blocks;
+    size_t current = 0;     // Block being bumped
+    size_t offset = 0;      // Next free byte in it
+    size_t usedBytes = 0;
+    MemoryAccount memory{MEMORY_RENDER_SCRATCH};    // capacity()
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file bench.h
+ * @brief Per-stage benchmark of the engine over a set of models and frame
+ *        sizes, with JSON results that later runs are compared against.
+ */
+
+// What is timed: each stage of a frame on its own, then whole frames
+enum BenchStage {
+    BENCH_LOAD,             // Reading and parsing the STL file
+    BENCH_NORMALIZE,        // Centring and scaling the mesh
+    BENCH_GEOMETRY,         // Transform, cull, project and light
+    BENCH_RASTER,           // Clear and rasterize the projected triangles
+    BENCH_OUTPUT,           // Encode and write the frame to a terminal
+    BENCH_FRAME,            // RenderContext::render() and present(), end to end
+    BENCH_STAGE_COUNT
+};
+
+// Names used in the JSON results, in BenchStage order
+extern const char* const BENCH_STAGE_NAMES[BENCH_STAGE_COUNT];
+
+// Runs averaged into one timing sample: short stages are timed over many
+// runs, and every sample sees the same frames
+constexpr int BENCH_SAMPLE_RUNS = 24;
+
+// Slowdown against the baseline, in percent, reported as a regression
+constexpr double BENCH_REGRESSION_PERCENT = 10.0;
+
+// A frame size the render stages are timed at, in character cells
+struct BenchResolution {
+    int cols, rows;
+};
+
+struct BenchOptions {
+    std::vector<std::string> models;
+    std::vector<BenchResolution> resolutions = {{80, 24}, {240, 80}, {480, 160}};
+    int warmup = 2;                 // Samples of each measurement thrown away first
+    int repetitions = 10;           // Samples kept
+    int cpu = 0;                    // Core to pin the run to; -1 leaves it unpinned
+};
+
+// Timings of one stage of one model, in milliseconds. Load and normalize do
+// not depend on the frame size and are measured at 0x0.
+struct BenchResult {
+    std::string model;              // File name, without the directory
+    size_t triangles = 0;
+    int cols = 0, rows = 0;
+    BenchStage stage = BENCH_LOAD;
+    double medianMs = 0.0, p90Ms = 0.0, p99Ms = 0.0;
+    double minMs = 0.0, maxMs = 0.0, meanMs = 0.0;
+
+    double trianglesPerSecond() const { return medianMs > 0.0 ? triangles / (medianMs / 1000.0) : 0.0; }
+};
+
+struct BenchReport {
+    int cpu = -1;                   // Core the run was pinned to, -1 if it was not
+    int warmup = 0, repetitions = 0;
+    std::vector<BenchResult> results;
+    std::vector<std::string> failures;      // Models that could not be read
+};
+
+/**
+ * @brief Times every stage of every model at every resolution.
+ *
+ * Each measurement takes `warmup` samples that are thrown away, then
+ * `repetitions` that are kept. A sample is the mean time of
+ * BENCH_SAMPLE_RUNS runs. Run i of a sample turns the camera to the same
+ * orientation in every stage, sample and suite run, so results compare
+ * between runs. Output is written to /dev/null.
+ */
+BenchReport runBenchmarks(const BenchOptions& options);
+
+// Fills the timings of `result` from its samples (nearest-rank percentiles)
+void summarizeSamples(std::vector<double>& samplesMs, BenchResult& result);
+
+// Keeps the calling thread on one core; false where that is not possible
+bool pinToCpu(int cpu);
+
+// The report as JSON, one result object per line
+std::string benchJson(const BenchReport& report);
+bool saveBenchJson(const std::string& path, const BenchReport& report);
+
+// Reads the results of a file written by saveBenchJson(); false if it cannot
+bool loadBenchJson(const std::string& path, std::vector<BenchResult>& results);
+
+// A measurement beside the same one (model, size and stage) in a baseline
+struct BenchComparison {
+    BenchResult current;
+    BenchResult baseline;
+    bool compared = false;          // False if the baseline lacks the measurement
+
+    // Relative change of the median, e.g. 0.1 for 10% slower
+    double change() const {
+        return compared && baseline.medianMs > 0.0 ? current.medianMs / baseline.medianMs - 1.0 : 0.0;
+    }
+
+    // More than BENCH_REGRESSION_PERCENT slower, and slower in every sample
+    // than in any baseline sample, so noise alone does not count
+    bool slower() const {
+        return change() * 100.0 > BENCH_REGRESSION_PERCENT && current.minMs > baseline.maxMs;
+    }
+};
+
+std::vector<BenchComparison> compareBench(const std::vector<BenchResult>& current,
+                                          const std::vector<BenchResult>& baseline);
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "display.h"
+#include "font.h"
+
+/**
+ * @file canvas.h
+ * @brief RGBA pixel output that draws the frame with the embedded bitmap font,
+ *        so the page can present it with putImageData instead of laying out text.
+ */
+
+// Packs a colour so its bytes sit in memory as R, G, B, A (little-endian,
+// which covers WASM and the native targets)
+constexpr uint32_t canvasColor(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | 0xFF000000u;
+}
+
+// Same colours as the text display
+constexpr uint32_t CANVAS_FOREGROUND = canvasColor(0xFF, 0xFF, 0xFF);
+constexpr uint32_t CANVAS_BACKGROUND = canvasColor(0x00, 0x00, 0x00);
+
+// Pixel rectangle; empty when width or height is 0
+struct PixelRect {
+    int x, y, width, height;
+};
+
+/**
+ * @brief Pixel copy of a DisplayBuffer, one FONT_CELL_WIDTH x FONT_CELL_HEIGHT
+ *        cell per glyph.
+ *
+ * Every glyph is pre-drawn into an RGBA tile once, so blitting a cell is a
+ * row copy per pixel line. Only the cells the display reports as dirty are
+ * redrawn.
+ */
+class CanvasBuffer {
+public:
+    CanvasBuffer(int cols = SCREEN_WIDTH, int rows = SCREEN_HEIGHT);
+
+    /**
+     * @brief Redraws the cells changed by the display's last update().
+     * @param display Display holding the new frame and its dirty spans.
+     * @return The pixels that changed, for a dirty-rect putImageData.
+     */
+    PixelRect blit(const DisplayBuffer& display);
+
+    // Redraws every cell, e.g. after the canvas element was recreated
+    PixelRect blitAll(const DisplayBuffer& display);
+
+    // RGBA pixels, width() * 4 bytes per row. Allocated once, so the pointer
+    // stays valid for the lifetime of the CanvasBuffer.
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(pixels.data()); }
+
+    int width() const { return cols * FONT_CELL_WIDTH; }
+    int height() const { return rows * FONT_CELL_HEIGHT; }
+
+    // Cells redrawn since construction
+    size_t cellsBlitted() const { return blitted; }
+
+private:
+    void blitCells(const DisplayBuffer& display, int row, int first, int last);
+
+    int cols, rows;
+    std::vector<uint32_t> pixels;
+    std::vector<uint32_t> tiles;    // One cell of pixels per character code
+    size_t blitted = 0;
+};
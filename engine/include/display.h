@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <string>
+#include "rasterizer.h"
+
+/**
+ * @file display.h
+ * @brief Tracks what is on screen so only changed rows are sent to the output.
+ */
+
+// Changed columns of one row, inclusive
+struct DirtySpan {
+    int row;
+    int first;
+    int last;
+};
+
+// Counters for the traffic between the engine and the output
+struct DisplayStats {
+    size_t frames = 0;         // Frames submitted
+    size_t skipped = 0;        // Frames identical to the previous one
+    size_t rowsSent = 0;       // Rows shipped to the output
+    size_t bytesSent = 0;      // Bytes shipped to the output
+};
+
+/**
+ * @brief Copy of the frame currently on screen, diffed against each new frame.
+ *
+ * Rows are stored back to back, each terminated by '\n'.
+ */
+class DisplayBuffer {
+public:
+    DisplayBuffer(int width = SCREEN_WIDTH, int height = SCREEN_HEIGHT);
+
+    /**
+     * @brief Diffs a rendered frame against the stored one and takes it over.
+     * @param buffer The rendered character buffer.
+     * @return Number of rows that changed.
+     */
+    size_t update(const std::vector<std::string>& buffer);
+
+    /**
+     * @brief Forces the next update to report every row as changed,
+     *        e.g. after the output was cleared by someone else.
+     */
+    void invalidate() { forceFull = true; }
+
+    // Rows changed by the last update, in ascending row order
+    const std::vector<DirtySpan>& dirty() const { return spans; }
+
+    // Start of a stored row (width() glyphs followed by '\n')
+    const char* row(int y) const { return glyphs.data() + (size_t)y * stride(); }
+
+    // The whole stored frame. Allocated once, so the pointer stays valid for
+    // the lifetime of the DisplayBuffer and can be read in place.
+    const char* data() const { return glyphs.data(); }
+
+    int width() const { return cols; }
+    int height() const { return rows; }
+    int stride() const { return cols + 1; }
+
+    DisplayStats stats;
+
+private:
+    int cols, rows;
+    std::vector<char> glyphs;
+    std::vector<DirtySpan> spans;
+    bool forceFull = true;
+};
+
+/**
+ * @brief Where finished frames go: the page, a terminal, or anything else
+ *        that wants them. Each RenderContext presents into its own sink, so
+ *        no output is wired into the renderer.
+ */
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    /**
+     * @brief Shows a finished frame. Runs on the thread that presents it.
+     * @param frame The rendered character buffer.
+     * @return Bytes handed to the output (0 if the frame was unchanged).
+     */
+    virtual size_t present(const std::vector<std::string>& frame) = 0;
+};
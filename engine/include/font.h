@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @file font.h
+ * @brief Embedded 5x7 bitmap font for drawing framebuffer glyphs as pixels.
+ */
+
+// Glyph bitmap size and the pixel cell each character occupies
+constexpr int FONT_GLYPH_WIDTH = 5;
+constexpr int FONT_GLYPH_HEIGHT = 7;
+constexpr int FONT_CELL_WIDTH = 6;
+constexpr int FONT_CELL_HEIGHT = 10;
+
+// Pixel row of the cell where the glyph starts; the rest of the cell is spacing
+constexpr int FONT_GLYPH_TOP = 1;
+
+// Printable ASCII range covered by the font; other characters draw blank
+constexpr char FONT_FIRST_CHAR = ' ';
+constexpr char FONT_LAST_CHAR = '~';
+
+/**
+ * @brief Returns the rows of a glyph, top to bottom.
+ *
+ * Each of the FONT_GLYPH_HEIGHT bytes holds one row, with bit 4 as the
+ * leftmost pixel and bit 0 as the rightmost.
+ *
+ * @param c The character.
+ * @return Pointer to FONT_GLYPH_HEIGHT row masks.
+ */
+const uint8_t* fontGlyph(char c);
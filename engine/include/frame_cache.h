@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include "math3d.h"
+#include "memory_stats.h"
+#include "model.h"
+#include "rasterizer.h"
+
+/**
+ * @file frame_cache.h
+ * @brief Rendered frames keyed by quantized orientation, plus an idle-time
+ *        pass that renders the upcoming frames of the animation ahead of time.
+ */
+
+// Quaternion components are rounded to 1/FRAME_CACHE_RESOLUTION, about 0.9
+// degrees of rotation per bin at 128
+constexpr int FRAME_CACHE_RESOLUTION = 128;
+
+// Default memory cap, about 1300 full-screen frames
+constexpr size_t FRAME_CACHE_CAPACITY = 24u << 20;
+
+// Most frames the precompute pass renders ahead of the playhead
+constexpr int FRAME_CACHE_LOOKAHEAD = 600;
+
+struct FrameCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t stored = 0;
+    size_t evictions = 0;
+};
+
+/**
+ * @brief Least-recently-used cache of character frames under a memory cap.
+ *
+ * Frames are stored packed (width * height glyphs) and copied back into the
+ * caller's buffer on a hit. Keys come from orientationKey(), so every
+ * orientation inside a bin shares one frame.
+ */
+class FrameCache {
+public:
+    explicit FrameCache(size_t capacityBytes = FRAME_CACHE_CAPACITY,
+                        int resolution = FRAME_CACHE_RESOLUTION);
+
+    /**
+     * @brief Key of the bin a rotation falls into: its unit quaternion, with
+     *        the sign fixed so q and -q agree, rounded per component.
+     */
+    static uint64_t orientationKey(const Mat3& rotation, int resolution);
+
+    uint64_t keyFor(const Mat3& rotation) const { return orientationKey(rotation, binsPerUnit); }
+
+    /**
+     * @brief Copies a cached frame into the buffer and marks it recently used.
+     * @param buffer Resized to the frame if needed.
+     * @return False on a miss; the buffer is left untouched.
+     */
+    bool lookup(uint64_t key, std::vector<std::string>& buffer);
+
+    bool contains(uint64_t key) const { return index.count(key) != 0; }
+
+    /**
+     * @brief Stores a frame, evicting the least recently used ones to stay
+     *        under the cap. Frames larger than the whole cap are not stored.
+     */
+    void store(uint64_t key, const std::vector<std::string>& buffer);
+
+    // Drops every frame, e.g. when the model changes
+    void clear();
+
+    size_t frames() const { return entries.size(); }
+    size_t bytes() const { return used; }
+    size_t capacity() const { return capacityBytes; }
+
+    FrameCacheStats stats;
+
+private:
+    struct Entry {
+        uint64_t key;
+        int width, height;
+        std::vector<char> glyphs;
+    };
+
+    size_t capacityBytes;
+    int binsPerUnit;
+    size_t used = 0;
+    MemoryAccount memory{MEMORY_CACHES};   // Follows `used`
+    std::list<Entry> entries;   // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+
+/**
+ * @brief Renders the frames the rotation animation is about to show into a
+ *        FrameCache during idle time, so playback becomes lookups.
+ *
+ * The lookahead steps the angles with the same float additions as the live
+ * loop, so its orientations land in exactly the bins playback will ask for.
+ */
+class TurntablePrecompute {
+public:
+    /**
+     * @brief Starts the lookahead from the orientation about to be shown,
+     *        e.g. after a model change or a jump in orientation.
+     */
+    void restart(float angleX, float angleY, float angleZ, float speed);
+
+    // The live loop showed one frame: the lookahead window moves with it
+    void advance() { if (ahead > 0) ahead--; }
+
+    /**
+     * @brief Renders uncached upcoming orientations until the time budget is
+     *        spent or the lookahead is full.
+     * @param maxAhead Frames to keep ready ahead of the playhead.
+     * @return Number of frames rendered.
+     */
+    int run(const std::vector<Triangle>& model, const Vec3& lightDir, FrameCache& cache,
+            double budgetSeconds, int maxAhead = FRAME_CACHE_LOOKAHEAD);
+
+    // One frame of run(), split so a caller can render it without holding
+    // the lock that guards the cache and the lookahead
+    struct Step {
+        Mat3 rotation;
+        uint64_t key = 0;
+        bool render = false;        // Not in the cache yet
+        unsigned generation = 0;    // restart() calls before it was taken
+    };
+
+    // The next orientation to visit; false once the lookahead is full
+    bool nextStep(const FrameCache& cache, Step& step, int maxAhead = FRAME_CACHE_LOOKAHEAD) const;
+
+    // Renders the step's frame if it needs one; touches no shared state but
+    // the lookahead's own buffers, which only resize() changes
+    void renderStep(const std::vector<Triangle>& model, const Vec3& lightDir, const Step& step);
+
+    /**
+     * @brief Stores the step's frame and moves the lookahead on.
+     * @return False, storing nothing, if restart() came since nextStep().
+     */
+    bool finishStep(const Step& step, FrameCache& cache);
+
+    int framesAhead() const { return ahead; }
+
+    // Size of the frames rendered ahead; must match the frames looked up
+    void resize(int width, int height);
+
+private:
+    float angleX = 0.0f, angleY = 0.0f, angleZ = 0.0f;  // Next orientation to visit
+    int cols = SCREEN_WIDTH, rows = SCREEN_HEIGHT;
+    float speed = 0.0f;
+    int ahead = 0;
+    unsigned generation = 0;
+    std::vector<std::string> buffer;
+    std::vector<float> zbuffer;
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+/**
+ * @file framestream.h
+ * @brief Compact recording format for rendered frames, played back without
+ *        running the rasterizer.
+ *
+ * Layout (little-endian):
+ *   header   "TMFS", u16 version, u16 width, u16 height, u16 fps,
+ *            u32 frame count, u32 index offset
+ *   frames   u8 type ('K' keyframe / 'D' delta), u32 payload size, payload
+ *   index    u32 keyframe count, then (u32 frame, u32 offset) per keyframe
+ *
+ * A payload walks the rows top to bottom. At the start of a row, a byte with
+ * tag 11 skips 1-64 unchanged rows (deltas only). Otherwise the row is a list
+ * of cell ops, each a tag in the top two bits and a length of 1-64 below:
+ *   00 literal  the next `length` bytes are glyphs
+ *   01 run      the next byte is repeated `length` times
+ *   10 keep     `length` cells are unchanged (deltas only)
+ */
+
+constexpr uint16_t FRAME_STREAM_VERSION = 1;
+
+// Frames between keyframes, i.e. the worst-case decode work for a seek
+constexpr int FRAME_STREAM_KEYFRAME_INTERVAL = 30;
+
+/**
+ * @brief Encodes frames into a frame stream held in memory.
+ */
+class FrameStreamRecorder {
+public:
+    FrameStreamRecorder(int width, int height, int fps,
+                        int keyframeInterval = FRAME_STREAM_KEYFRAME_INTERVAL);
+
+    /**
+     * @brief Appends a frame, delta-encoded against the previous one.
+     * @param frame Character buffer of height rows of width glyphs.
+     */
+    void addFrame(const std::vector<std::string>& frame);
+
+    /**
+     * @brief Appends the keyframe index and completes the header.
+     *        No frames can be added afterwards.
+     * @return The finished stream.
+     */
+    const std::vector<uint8_t>& finish();
+
+    /**
+     * @brief Finishes the stream and writes it to a file.
+     * @return False if the file cannot be written.
+     */
+    bool save(const std::string& filename);
+
+    int frames() const { return frameCount; }
+    size_t size() const { return bytes.size(); }
+
+private:
+    void encodeRow(const char* row, const char* previous, bool delta);
+
+    int cols, rows, keyframeInterval;
+    int frameCount = 0;
+    bool finished = false;
+    std::vector<uint8_t> bytes;
+    std::vector<char> previous;          // Last frame, rows back to back
+    std::vector<uint32_t> keyframeIndex; // Frame number and offset pairs
+};
+
+/**
+ * @brief Decodes a frame stream straight into a character buffer.
+ */
+class FrameStreamPlayer {
+public:
+    /**
+     * @brief Takes over an encoded stream and validates its header and index.
+     * @return False if the data is not a complete frame stream.
+     */
+    bool load(std::vector<uint8_t> data);
+
+    /**
+     * @brief Reads a frame stream file.
+     * @return False if the file cannot be read or is not a frame stream.
+     */
+    bool loadFile(const std::string& filename);
+
+    /**
+     * @brief Decodes the next frame into the buffer, wrapping at the end.
+     *
+     * The buffer must still hold the previously decoded frame, since deltas
+     * only touch the cells that changed.
+     *
+     * @param buffer Character buffer, resized on first use.
+     * @return False if the stream is empty or corrupt.
+     */
+    bool next(std::vector<std::string>& buffer);
+
+    /**
+     * @brief Positions the player so that next() returns the given frame,
+     *        decoding forward from the closest preceding keyframe.
+     * @return False if the frame is out of range or the stream is corrupt.
+     */
+    bool seek(int frame, std::vector<std::string>& buffer);
+
+    int width() const { return cols; }
+    int height() const { return rows; }
+    int fps() const { return framesPerSecond; }
+    int frames() const { return frameCount; }
+    int position() const { return current; }
+
+private:
+    bool decodeFrame(std::vector<std::string>& buffer);
+
+    std::vector<uint8_t> bytes;
+    int cols = 0, rows = 0, framesPerSecond = 0, frameCount = 0;
+    std::vector<uint32_t> keyframeFrames;
+    std::vector<uint32_t> keyframeOffsets;
+    int current = 0;        // Frame that next() decodes
+    size_t offset = 0;      // Byte offset of that frame
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file gif.h
+ * @brief Minimal animated GIF89a writer for indexed-colour frames.
+ *
+ * A file is gifHeader(), then any number of gifFrame() blocks, then
+ * GIF_TRAILER. Frames are self-contained, so they can be encoded on separate
+ * threads and concatenated in order afterwards.
+ */
+
+// Largest LZW code in a GIF stream
+constexpr int GIF_MAX_CODE_BITS = 12;
+
+// Byte that ends a GIF file
+constexpr uint8_t GIF_TRAILER = 0x3B;
+
+/**
+ * @brief LZW-compresses indexed pixels as GIF image data, without the
+ *        sub-block framing.
+ * @param pixels Palette indices, each below 1 << minCodeSize.
+ * @param count Number of pixels.
+ * @param minCodeSize Bits per pixel index (2-8).
+ * @param out Receives the packed codes, least significant bit first.
+ */
+void lzwEncode(const uint8_t* pixels, size_t count, int minCodeSize, std::vector<uint8_t>& out);
+
+/**
+ * @brief Appends the GIF signature, screen descriptor, global palette and a
+ *        loop-forever extension.
+ * @param palette RGB triples; padded with black to a power of two of at least 4.
+ * @param colors Number of palette entries (at most 256).
+ */
+void gifHeader(std::vector<uint8_t>& out, int width, int height,
+               const uint8_t (*palette)[3], int colors);
+
+/**
+ * @brief Appends one frame covering a rectangle of the canvas.
+ *
+ * Pixels outside the rectangle keep the previous frame's contents, so a frame
+ * only needs to cover what changed.
+ *
+ * @param pixels width * height palette indices, row by row.
+ * @param minCodeSize Bits per pixel index, matching the palette size.
+ * @param delayCs Time to show the frame, in hundredths of a second.
+ */
+void gifFrame(std::vector<uint8_t>& out, int left, int top, int width, int height,
+              const uint8_t* pixels, int minCodeSize, int delayCs);
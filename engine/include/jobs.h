@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file jobs.h
+ * @brief Work-stealing job system for splitting single frames across cores.
+ */
+
+// Counters since the job system started
+struct JobStats {
+    size_t executed = 0;    // Jobs run, by workers and by waiting callers
+    size_t stolen = 0;      // Jobs taken from another worker's queue
+};
+
+/**
+ * @brief Runs small jobs on a fixed set of workers, each with its own queue.
+ *
+ * A job spawned from a worker goes to that worker's queue, which it drains
+ * newest first while idle workers steal the oldest jobs from the other end,
+ * so fan-outs spread across the cores without a shared queue to contend on.
+ * Jobs spawned from other threads go to a shared queue. Threads waiting on
+ * a group run queued jobs while there are any, so waits can nest inside
+ * jobs, and otherwise sleep until the group's last job finishes.
+ */
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // Jobs counted together so they can be waited for
+    class Group {
+    public:
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<size_t> pending{0};
+    };
+
+    /**
+     * @param threads Number of workers; 0 uses one per hardware thread but
+     *        one, since the waiting thread runs jobs too (so none on a
+     *        single core, where waiting threads run everything).
+     */
+    explicit JobSystem(int threads = 0);
+
+    // Finishes queued jobs, then joins the workers
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues `job` as part of `group`; may be called from inside a job
+    void run(Group& group, Job job);
+
+    // Returns once every job in `group`, and every job they added to it, has run
+    void wait(Group& group);
+
+    // Runs one queued job on the calling thread; false if there was none
+    bool runPending();
+
+    /**
+     * @brief Calls fn(begin, end) over [0, count) in ranges of at most
+     *        `grain` and returns once all calls have finished.
+     *
+     * A template, so `fn` is never wrapped in a std::function; each job
+     * captures two words, which std::function keeps inline. Queuing the
+     * jobs does not allocate.
+     */
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, const Fn& fn) {
+        grain = std::max<size_t>(1, grain);
+        auto range = [&fn, count, grain](size_t begin) { fn(begin, std::min(count, begin + grain)); };
+        Group group;
+        for (size_t begin = 0; begin < count; begin += grain) {
+            run(group, [&range, begin] { range(begin); });
+        }
+        wait(group);
+    }
+
+    int size() const { return workerCount; }
+
+    JobStats stats() const;
+
+private:
+    struct Entry {
+        Job job;
+        Group* group = nullptr;
+    };
+    // One worker's jobs, a ring that grows when full and never shrinks, so
+    // a warm queue does not allocate. The mutex is only contended while
+    // stealing.
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Entry> ring;
+        size_t head = 0;        // Oldest entry
+        size_t count = 0;
+
+        void pushBack(Entry entry);
+        Entry popBack();
+        Entry popFront();
+    };
+
+    void workerLoop(int worker);
+    bool take(int worker, Entry& entry);
+    void execute(Entry& entry);
+    int currentWorker() const;
+
+    int workerCount;                             // Fixed before any worker starts
+    std::vector<std::unique_ptr<Queue>> queues;  // One per worker, then the shared queue
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable jobReady;
+    std::condition_variable groupDone;           // A group finished, or jobs were queued
+    bool stopping = false;
+    std::atomic<size_t> executed{0};
+    std::atomic<size_t> stolen{0};
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file log.h
+ * @brief printf-style logging that keeps iostreams out of the engine.
+ *
+ * Native builds write to stdout and stderr. WASM builds hand each line to
+ * the page's print and printErr hooks (the JS console by default) without
+ * going through the C stdio buffers.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TERMESH_PRINTF_FORMAT __attribute__((format(printf, 1, 2)))
+#else
+#define TERMESH_PRINTF_FORMAT
+#endif
+
+// Longest line logged; longer messages are cut off
+constexpr int LOG_LINE_MAX = 512;
+
+// Progress and results, one line (the newline is added)
+void logInfo(const char* format, ...) TERMESH_PRINTF_FORMAT;
+
+// Errors and diagnostics, one line (the newline is added)
+void logError(const char* format, ...) TERMESH_PRINTF_FORMAT;
@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file memory_stats.h
+ * @brief Bytes held per subsystem, with peaks, the process heap size, and a
+ *        pre-load estimate that keeps a model out of a memory budget it
+ *        would not fit in.
+ *
+ * Owners account what they hold through a MemoryAccount member, set where
+ * their buffers change size, so accounting costs nothing per allocation.
+ */
+
+// What accounted memory is for
+enum MemoryTag {
+    MEMORY_MESH,            // The loaded model
+    MEMORY_ACCELERATION,    // Slice indexes and LOD levels
+    MEMORY_FRAMEBUFFERS,    // Frame and depth buffers
+    MEMORY_RENDER_SCRATCH,  // Frame arenas
+    MEMORY_PARSE_SCRATCH,   // File text, read blocks and stream buffers
+    MEMORY_CACHES,          // Frame and mesh caches
+    MEMORY_TAG_COUNT
+};
+
+extern const char* const MEMORY_TAG_NAMES[MEMORY_TAG_COUNT];
+
+// Floats termesh_memory_stats() returns: heap and budget, then the current
+// and peak of each tag
+constexpr int MEMORY_STAT_COUNT = 2 + 2 * MEMORY_TAG_COUNT;
+
+struct MemoryUsage {
+    size_t current = 0;
+    size_t peak = 0;        // Most held at once since the last resetMemoryPeaks()
+};
+
+// Bytes a tag holds now and at most
+MemoryUsage memoryUsage(MemoryTag tag);
+
+// Bytes every tag holds now
+size_t accountedBytes();
+
+// Starts each peak again from the current bytes
+void resetMemoryPeaks();
+
+/**
+ * @brief Bytes of memory one owner holds under a tag.
+ *
+ * set() moves the tag's total by the change. A copy accounts its bytes
+ * again, as the buffers it stands for are copied too; a move hands them
+ * over. Safe to use from any thread; a single account is not synchronized.
+ */
+class MemoryAccount {
+public:
+    explicit MemoryAccount(MemoryTag tag) : tag(tag) {}
+    MemoryAccount(const MemoryAccount& other) : tag(other.tag) { set(other.held); }
+    MemoryAccount(MemoryAccount&& other) noexcept : tag(other.tag), held(other.held) { other.held = 0; }
+    MemoryAccount& operator=(const MemoryAccount& other);
+    MemoryAccount& operator=(MemoryAccount&& other) noexcept;
+    ~MemoryAccount() { set(0); }
+
+    void set(size_t bytes);
+    size_t bytes() const { return held; }
+
+private:
+    MemoryTag tag;
+    size_t held = 0;
+};
+
+// Heap bytes of a vector, counting its unused capacity
+template <typename T>
+size_t vectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Heap bytes of a frame: its rows and their characters
+size_t frameMemoryBytes(const std::vector<std::string>& frame);
+
+/**
+ * @brief Memory the process has taken from the system: the WASM heap in the
+ *        browser (which never shrinks), the resident set natively on Linux,
+ *        0 where neither is known.
+ */
+size_t processMemoryBytes();
+
+// ASCII facets are assumed this short, so their count is not underestimated
+constexpr size_t ASCII_FACET_MIN_BYTES = 128;
+
+/**
+ * @brief What loading a file of a given size takes: the mesh, the scratch
+ *        held while it is parsed, and the structures that may be built from
+ *        it (LOD levels, slice index, screen-space triangles).
+ */
+struct LoadEstimate {
+    size_t triangles = 0;
+    size_t meshBytes = 0;
+    size_t scratchBytes = 0;
+    size_t derivedBytes = 0;
+
+    // The peak: scratch is freed before anything is derived from the mesh
+    size_t total() const { return meshBytes + std::max(scratchBytes, derivedBytes); }
+};
+
+/**
+ * @brief Estimates a load from the file's size alone.
+ * @param ascii ASCII files are read whole and parsed with no known count.
+ * @param streamed A streamed load keeps unnormalized triangles beside the
+ *        preview until it finishes.
+ */
+LoadEstimate estimateLoad(size_t fileBytes, bool ascii, bool streamed = false);
+
+/**
+ * @brief Whether a load fits in `budgetBytes` beside the framebuffers and
+ *        caches held now; the rest of the previous model is freed first.
+ *        Logs the shortfall when it does not. A budget of 0 admits
+ *        everything.
+ */
+bool fitsMemoryBudget(const LoadEstimate& estimate, size_t budgetBytes);
+
+/**
+ * @brief Checks a model file against the budget before it is read.
+ * @return False if it would not fit; a file that cannot be examined is left
+ *         for the loader to report.
+ */
+bool modelFitsMemoryBudget(const std::string& path, size_t budgetBytes);
+
+// One line per tag with current and peak MiB, then the process heap
+std::vector<std::string> memoryReport();
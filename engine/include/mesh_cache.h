@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "memory_stats.h"
+#include "render_context.h"
+
+/**
+ * @file mesh_cache.h
+ * @brief Parsed, normalized models kept in memory between requests.
+ */
+
+// Default memory cap of the meshes a server keeps parsed
+constexpr size_t MESH_CACHE_CAPACITY = 256u << 20;
+
+struct MeshCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t stored = 0;
+    size_t evictions = 0;
+};
+
+/**
+ * @brief Least-recently-used cache of meshes under a memory cap.
+ *
+ * Meshes are shared, never copied: an evicted mesh stays alive for as long
+ * as a render still holds it. Not synchronized; guard it with a lock when
+ * several threads use it.
+ */
+class MeshCache {
+public:
+    explicit MeshCache(size_t capacityBytes = MESH_CACHE_CAPACITY);
+
+    // Memory a mesh is charged for
+    static size_t meshBytes(const std::vector<Triangle>& mesh) { return mesh.size() * sizeof(Triangle); }
+
+    // The mesh stored under `key`, marked recently used; null on a miss
+    MeshRef lookup(const std::string& key);
+
+    /**
+     * @brief Stores a mesh, evicting the least recently used ones to stay
+     *        under the cap. Meshes larger than the whole cap are not stored.
+     */
+    void store(const std::string& key, MeshRef mesh);
+
+    void clear();
+
+    size_t meshes() const { return entries.size(); }
+    size_t bytes() const { return used; }
+    size_t capacity() const { return capacityBytes; }
+
+    MeshCacheStats stats;
+
+private:
+    struct Entry {
+        std::string key;
+        MeshRef mesh;
+        size_t bytes;
+    };
+
+    size_t capacityBytes;
+    size_t used = 0;
+    MemoryAccount memory{MEMORY_CACHES};   // Follows `used`
+    std::list<Entry> entries;   // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+};
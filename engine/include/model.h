@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <cstdint>
 #include "math3d.h"
 
 // Triangle structure
@@ -9,6 +11,28 @@ struct Triangle {
     Vec3 normal;
 };
 
+// Binary STL layout: 80-byte header and uint32 count, then 50-byte records
+constexpr size_t STL_HEADER_SIZE = 84;
+constexpr size_t STL_RECORD_SIZE = 50;
+
+// Records decoded per read when loading a binary file
+constexpr size_t STL_RECORDS_PER_READ = 4096;
+
+// Whether an STL file is ASCII: it starts with "solid" and its size is not the
+// one its binary triangle count gives (binary headers may start with "solid"
+// too). `header` holds the first `headerBytes` bytes of the file; a
+// `fileBytes` of 0 means the size is unknown and the prefix decides.
+bool isAsciiStl(const uint8_t* header, size_t headerBytes, size_t fileBytes);
+
+// Parse `count` consecutive binary STL records starting at `data`
+void parseStlRecords(const uint8_t* data, size_t count, std::vector<Triangle>& out);
+
+// Parse `size` bytes of ASCII STL text, appending every complete facet to `out`
+void parseAsciiStl(const char* text, size_t size, std::vector<Triangle>& out);
+
+// Read an STL file into `triangles` without logging; false if it cannot be opened
+bool readSTL(const std::string& filename, std::vector<Triangle>& triangles);
+
 // Load STL file (supports both ASCII and binary formats)
 std::vector<Triangle> loadSTL(const std::string& filename);
 
@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "math3d.h"
+#include "model.h"
+#include "render_context.h"
+
+/**
+ * @file multiview.h
+ * @brief Several views of one model side by side in one frame, sharing the
+ *        per-triangle work that does not depend on the view.
+ */
+
+// Quarter turn, for cameras that look down a model axis
+constexpr float HALF_PI = 1.57079633f;
+
+enum class ViewProjection { Perspective, Orthographic };
+
+// One view of the model in a rectangle of the multi-view's frame
+struct Viewport {
+    int x = 0, y = 0;               // Top-left cell in the frame
+    int cols = 0, rows = 0;
+    Camera camera;
+    // Orthographic views are drawn at the scale a perspective view has at
+    // the model's centre
+    ViewProjection projection = ViewProjection::Perspective;
+    // Lit by the multi-view's fixedLightDir, which stays with the model,
+    // instead of lightDir, which turns with the camera
+    bool fixedLight = false;
+    Vec3 lightDir = defaultLightDir();
+};
+
+/**
+ * @brief Renders a model into several viewports of one frame.
+ *
+ * Each frame starts with one pass over the mesh for the work every view
+ * shares: face normals for culling, unit shading normals, and the shading
+ * under the fixed light. Each viewport then culls with one dot product
+ * before transforming anything, lights with one more, and views that look
+ * straight down a model axis orthographically skip the rotation and the
+ * perspective divide altogether. Scratch memory is kept between frames, so
+ * steady-state frames do not allocate. Not synchronized.
+ */
+class MultiView {
+public:
+    explicit MultiView(int width = SCREEN_WIDTH, int height = SCREEN_HEIGHT);
+
+    // Changes the frame size; the frame is cleared
+    void resize(int width, int height);
+    int width() const { return cols; }
+    int height() const { return rows; }
+
+    // Drawn in order; cells outside every viewport stay blank
+    std::vector<Viewport> viewports;
+
+    // Light of the fixedLight viewports, in model space
+    Vec3 fixedLightDir = defaultLightDir();
+
+    void render(const std::vector<Triangle>& model);
+
+    // The rendered frame, height() rows of width() characters
+    const std::vector<std::string>& frame() const { return buffer; }
+
+private:
+    struct ViewBuffers {
+        std::vector<std::string> buffer;
+        std::vector<float> zbuffer;
+    };
+
+    void trackMemory();
+
+    int cols, rows;
+    std::vector<std::string> buffer;
+    std::vector<ViewBuffers> views;     // One per viewport
+    FrameArena arena;                   // The shared pass, reset every frame
+    MemoryAccount memory{MEMORY_FRAMEBUFFERS};
+};
+
+/**
+ * @brief A 2x2 grid of the usual engineering views, a blank cell apart:
+ *        three-quarter perspective, then orthographic front, side and top.
+ */
+std::vector<Viewport> axisViewports(int width, int height);
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "jobs.h"
+#include "quality.h"
+#include "render_context.h"
+
+/**
+ * @file pipeline.h
+ * @brief Frames split into jobs across cores, and consecutive frames
+ *        overlapped stage by stage.
+ */
+
+// Triangles per geometry job
+constexpr size_t GEOMETRY_CHUNK_TRIANGLES = 2048;
+// Frame rows per raster job
+constexpr int RASTER_BAND_ROWS = 8;
+
+/**
+ * @brief Renders a frame on `jobs`: geometry in chunks of triangles, then
+ *        rasterization in bands of rows, each band on one thread.
+ *
+ * Bands keep triangles in model order, so the frame is the same as
+ * clearBuffers() followed by renderFrame(). Clears the buffers itself.
+ *
+ * @param sampleStep Block sampling as in rasterizeTriangle(); the frame is
+ *        the same as renderFrameTimed()'s at that step.
+ * @param timings If set, receives the wall time of the geometry and raster
+ *        stages across all threads; clearing is part of each raster band.
+ */
+void renderFrameParallel(JobSystem& jobs,
+                         std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                         const std::vector<Triangle>& model, const Mat3& rotation,
+                         const Vec3& lightDir, ParallelScratch& scratch,
+                         int sampleStep = 1, StageTimings* timings = nullptr);
+
+// Stages a frame goes through in a FramePipeline
+enum PipelineStage {
+    STAGE_GEOMETRY,
+    STAGE_RASTER,
+    STAGE_OUTPUT,
+    PIPELINE_STAGE_COUNT
+};
+
+// Throughput of a FramePipeline and where its threads spent their time
+struct PipelineStats {
+    size_t frames = 0;                              // Frames presented
+    double wallSeconds = 0.0;                       // First submit to last present
+    double busySeconds[PIPELINE_STAGE_COUNT] = {};  // Summed over threads
+    int threads = 0;                                // Threads that run jobs
+    size_t stolen = 0;                              // Jobs stolen by idle workers
+
+    double fps() const { return wallSeconds > 0.0 ? frames / wallSeconds : 0.0; }
+
+    // Share of all threads' time spent in `stage`, from 0 to 1
+    double utilisation(PipelineStage stage) const {
+        return wallSeconds > 0.0 && threads > 0 ? busySeconds[stage] / (wallSeconds * threads) : 0.0;
+    }
+};
+
+/**
+ * @brief Renders a stream of frames with up to `maxInFlight` of them in
+ *        flight at once, so one frame's geometry overlaps the previous
+ *        frame's rasterization and output.
+ *
+ * Each frame is split into jobs as in renderFrameParallel(). Frames are
+ * presented strictly in submission order, one at a time, by whichever thread
+ * finishes the job that completes them. Use from one submitting thread.
+ * Drives the --benchmark turntable; live loops render through RenderContext
+ * one paced frame at a time, where overlap would only add latency.
+ */
+class FramePipeline {
+public:
+    FramePipeline(JobSystem& jobs, int width, int height, int maxInFlight = 2);
+
+    // Flushes: every submitted frame is presented first
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    /**
+     * @brief Queues a frame of `mesh` seen from `camera`, to be presented to
+     *        `sink` (not owned; null just renders).
+     *
+     * Blocks, running queued jobs meanwhile, while `maxInFlight` frames are
+     * unfinished. `sink` must outlive the frame's presentation.
+     */
+    void submit(MeshRef mesh, const Camera& camera, const Vec3& lightDir, FrameSink* sink);
+
+    // Returns once every submitted frame has been presented
+    void flush();
+
+    int maxInFlight() const { return (int)slots.size(); }
+
+    // Frames submitted but not yet presented
+    int inFlight() const { return (int)(submitted - presented.load()); }
+
+    // Most frames that were ever in flight at once
+    int peakInFlight() const { return peak; }
+
+    PipelineStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        FramePipeline* pipeline = nullptr;
+        ProjectionParams params;
+        size_t sequence = 0;
+        size_t chunks = 0;
+        MeshRef mesh;
+        Mat3 rotation;
+        Vec3 lightDir;
+        FrameSink* sink = nullptr;
+        std::vector<std::string> buffer;
+        std::vector<float> zbuffer;
+        ParallelScratch scratch;
+        std::atomic<size_t> geometryLeft{0};
+        std::atomic<int> rasterLeft{0};
+        bool rasterized = false;     // Guarded by presentMutex
+        JobSystem::Group group;
+    };
+
+    Frame& slot(size_t sequence) { return *slots[sequence % slots.size()]; }
+    void runGeometry(Frame& frame, size_t chunk);
+    void startRaster(Frame& frame);
+    void runRaster(Frame& frame, int band);
+    void presentReady();
+    void addBusy(PipelineStage stage, Clock::time_point start);
+
+    JobSystem& jobs;
+    int cols, rows;
+    MeshRef emptyMesh;
+    std::vector<std::unique_ptr<Frame>> slots;
+    size_t submitted = 0;
+    std::atomic<size_t> presented{0};
+    int peak = 0;
+    mutable std::mutex presentMutex;
+    Clock::time_point firstSubmit, lastPresent;
+    std::atomic<int64_t> busyNanos[PIPELINE_STAGE_COUNT];
+    size_t stolenAtStart = 0;
+};
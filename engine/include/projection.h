@@ -14,6 +14,14 @@ struct ProjectionParams {
     float scaleFactor = 0.8f;
 };
 
+// Projection onto a character buffer of the given size
+inline ProjectionParams projectionFor(int width, int height) {
+    ProjectionParams params;
+    params.screenWidth = (float)width;
+    params.screenHeight = (float)height;
+    return params;
+}
+
 /**
  * @brief Projects a 3D point to 2D screen coordinates using perspective projection.
  * @param v The 3D point to project.
@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "math3d.h"
+#include "model.h"
+#include "projection.h"
+#include "arena.h"
+#include "memory_stats.h"
+
+/**
+ * @file quality.h
+ * @brief Quality knobs for the live renderer and a governor that picks them
+ *        to hold a frame-time budget.
+ */
+
+// Quality knobs, one combination per level
+struct QualitySettings {
+    int lod;            // LodChain level, 0 = the full mesh
+    int sampleStep;     // One shaded sample per sampleStep x sampleStep cells
+};
+
+// Levels from full quality to cheapest. Each step removes a fraction of the
+// work, never half or more, so stepping back up rarely overshoots the budget.
+constexpr QualitySettings QUALITY_LEVELS[] = {
+    {0, 1},
+    {1, 1},
+    {1, 2},
+    {2, 2},
+    {3, 2},
+    {3, 3},
+};
+constexpr int QUALITY_LEVEL_COUNT = sizeof(QUALITY_LEVELS) / sizeof(QUALITY_LEVELS[0]);
+
+// Vertex clustering cell size per LOD level, in normalized model units (the
+// model spans 30); level 0 is the original mesh
+constexpr float LOD_CELL_SIZES[] = {0.0f, 0.5f, 1.0f, 2.0f};
+constexpr int LOD_LEVEL_COUNT = sizeof(LOD_CELL_SIZES) / sizeof(LOD_CELL_SIZES[0]);
+
+// Hysteresis: drop a level after this many frames in a row over budget, go
+// back up after this many frames under QUALITY_UPGRADE_RATIO of it
+constexpr int QUALITY_DOWNGRADE_FRAMES = 3;
+constexpr int QUALITY_UPGRADE_FRAMES = 30;
+constexpr double QUALITY_UPGRADE_RATIO = 0.5;
+
+// Weight of the newest frame in the smoothed frame time
+constexpr double QUALITY_SMOOTHING = 0.2;
+
+// Seconds spent in each stage of one frame
+struct StageTimings {
+    double clear = 0.0;
+    double geometry = 0.0;      // Transform, cull, project, light
+    double raster = 0.0;
+    double total() const { return clear + geometry + raster; }
+};
+
+/**
+ * @brief Simplifies a mesh by vertex clustering: vertices snap to the mean of
+ *        their grid cell and triangles that collapse are dropped.
+ * @param cellSize Grid cell size in model units; 0 returns the mesh unchanged.
+ */
+std::vector<Triangle> decimateModel(const std::vector<Triangle>& model, float cellSize);
+
+/**
+ * @brief Decimated copies of a model, one per LOD level above 0.
+ */
+class LodChain {
+public:
+    void build(const std::vector<Triangle>& model);
+    void clear() {
+        levels.clear();
+        memory.set(0);
+    }
+    bool empty() const { return levels.empty(); }
+
+    // The mesh for a LOD level; level 0 (or an unbuilt chain) is `full`
+    const std::vector<Triangle>& select(const std::vector<Triangle>& full, int lod) const;
+
+private:
+    std::vector<std::vector<Triangle>> levels;  // LOD 1 upwards
+    MemoryAccount memory{MEMORY_ACCELERATION};
+};
+
+// Screen-space triangles between the geometry and raster stages, in an
+// arena reset every frame
+struct RenderScratch {
+    struct ScreenTriangle {
+        Vec3 projected[3];
+        float intensities[3];
+    };
+    FrameArena arena;
+    ScreenTriangle* triangles = nullptr;
+    size_t count = 0;
+};
+
+// Screen-space triangles of a parallel render (see pipeline.h), in an arena
+// reset every frame. Chunk c owns GEOMETRY_CHUNK_TRIANGLES slots from
+// triangles + c * GEOMETRY_CHUNK_TRIANGLES, of which counts[c] are filled.
+struct ParallelScratch {
+    FrameArena arena;
+    RenderScratch::ScreenTriangle* triangles = nullptr;
+    size_t* counts = nullptr;
+};
+
+/**
+ * @brief The geometry stage on its own: transforms, culls, projects and
+ *        lights the triangles [begin, end), writing the visible ones to
+ *        `out` in model order.
+ * @param out Room for end - begin triangles.
+ * @return Number of triangles written.
+ */
+size_t projectTriangles(const Triangle* begin, const Triangle* end,
+                        const Mat3& rotation, const Vec3& lightDir,
+                        const ProjectionParams& params, RenderScratch::ScreenTriangle* out);
+
+/**
+ * @brief Clears the buffers and renders a frame at the given quality,
+ *        timing each stage.
+ *
+ * At full quality the output matches clearBuffers() followed by renderFrame().
+ */
+void renderFrameTimed(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                      const std::vector<Triangle>& model, const Mat3& rotation,
+                      const Vec3& lightDir, const QualitySettings& quality,
+                      RenderScratch& scratch, StageTimings& timings);
+
+/**
+ * @brief Picks the quality level that keeps frame times under a budget.
+ *
+ * Frame times are smoothed, and the asymmetric thresholds and frame counts
+ * leave a dead band between them so the level does not oscillate.
+ */
+class AdaptiveQuality {
+public:
+    explicit AdaptiveQuality(double budgetSeconds = 1.0 / 30.0);
+
+    // A new budget starts again from full quality
+    void setBudget(double budgetSeconds);
+    double budget() const { return budgetSeconds; }
+
+    /**
+     * @brief Feeds the render time of one frame.
+     * @return True if the level changed.
+     */
+    bool update(double frameSeconds);
+
+    int level() const { return current; }
+    const QualitySettings& settings() const { return QUALITY_LEVELS[current]; }
+
+    // Smoothed frame time at the current level
+    double averageSeconds() const { return average; }
+
+private:
+    void changeLevel(int level);
+
+    double budgetSeconds;
+    int current = 0;
+    double average = 0.0;
+    bool measured = false;
+    int framesOver = 0;
+    int framesUnder = 0;
+};
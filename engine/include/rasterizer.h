@@ -8,7 +8,8 @@
  * @brief Triangle rasterization utilities.
  */
 
-// Screen dimensions
+// Default screen dimensions. Frames may be any size: the rasterizer and
+// renderers take it from the character buffer they draw into.
 constexpr int SCREEN_WIDTH = 240;
 constexpr int SCREEN_HEIGHT = 80;
 
@@ -16,17 +17,44 @@ constexpr int SCREEN_HEIGHT = 80;
 constexpr const char* SHADE_CHARS = " .:-=+*#%@";
 constexpr int SHADE_LEVELS = 10;
 
+// Size of a character buffer; the depth buffer holds width * height floats
+inline int frameWidth(const std::vector<std::string>& buffer) {
+    return buffer.empty() ? 0 : (int)buffer[0].size();
+}
+
+inline int frameHeight(const std::vector<std::string>& buffer) {
+    return (int)buffer.size();
+}
+
 /**
  * @brief Rasterizes a triangle into the frame buffer using barycentric interpolation.
- * @param buffer Character buffer (SCREEN_HEIGHT rows of SCREEN_WIDTH characters).
+ * @param buffer Character buffer (rows of equal width).
  * @param zbuffer Depth buffer for z-testing.
  * @param projected Array of 3 projected vertices (x, y, z).
  * @param intensities Array of 3 lighting intensities (one per vertex).
+ * @param sampleStep Shades one sample, at the block centre, per
+ *        sampleStep x sampleStep block of cells and fills the block with it
+ *        (1 = every cell).
  */
 void rasterizeTriangle(std::vector<std::string>& buffer, 
                       std::vector<float>& zbuffer,
                       const Vec3 projected[3], 
-                      const float intensities[3]);
+                      const float intensities[3],
+                      int sampleStep = 1);
+
+/**
+ * @brief rasterizeTriangle() restricted to the rows [firstRow, endRow), so
+ *        disjoint bands of one frame can be rasterized on different threads.
+ *
+ * Rasterizing every band gives the same frame as rasterizeTriangle().
+ */
+void rasterizeTriangleRows(std::vector<std::string>& buffer,
+                           std::vector<float>& zbuffer,
+                           const Vec3 projected[3],
+                           const float intensities[3],
+                           int sampleStep,
+                           int firstRow,
+                           int endRow);
 
 /**
  * @brief Clears the screen and z-buffers.
@@ -35,3 +63,7 @@ void rasterizeTriangle(std::vector<std::string>& buffer,
  */
 void clearBuffers(std::vector<std::string>& buffer, std::vector<float>& zbuffer);
 
+// clearBuffers() for the rows [firstRow, endRow) only
+void clearRows(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+               int firstRow, int endRow);
+
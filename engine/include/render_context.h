@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "math3d.h"
+#include "model.h"
+#include "display.h"
+#include "memory_stats.h"
+#include "quality.h"
+#include "render_stats.h"
+#include "slicer.h"
+
+class JobSystem;
+
+/**
+ * @file render_context.h
+ * @brief Everything one view of a model needs to render, in one object, so
+ *        any number of renders can coexist in a process.
+ */
+
+// A model shared between contexts. It is only ever read while rendering.
+using MeshRef = std::shared_ptr<const std::vector<Triangle>>;
+
+// Light direction the viewer starts with
+inline Vec3 defaultLightDir() {
+    return Vec3(0.5f, -0.7f, -0.5f).normalize();
+}
+
+// Orientation of the model in view
+struct Camera {
+    float angleX = 0.0f, angleY = 0.0f, angleZ = 0.0f;
+
+    Mat3 rotation() const { return rotationX(angleX) * rotationY(angleY) * rotationZ(angleZ); }
+};
+
+/**
+ * @brief A view of a model: mesh reference, camera, light, frame and depth
+ *        buffers, scratch memory and the sink that frames are presented to.
+ *
+ * The engine keeps no mutable global state, so different contexts may be
+ * used concurrently from different threads, including contexts that share
+ * one mesh. A single context is not synchronized: use it from one thread at
+ * a time, or guard it with a lock.
+ */
+class RenderContext {
+public:
+    explicit RenderContext(int width = SCREEN_WIDTH, int height = SCREEN_HEIGHT);
+
+    // Changes the frame size; the frame is cleared
+    void resize(int width, int height);
+    int width() const { return cols; }
+    int height() const { return rows; }
+
+    // The model to render (null for none). Shared, never copied.
+    void setMesh(MeshRef model);
+    const std::vector<Triangle>& mesh() const { return model ? *model : empty; }
+    bool hasMesh() const { return model && !model->empty(); }
+
+    Camera camera;
+    Vec3 lightDir = defaultLightDir();
+
+    // Where present() sends frames. Not owned; null keeps frames in frame().
+    void setSink(FrameSink* output) { out = output; }
+    FrameSink* sink() const { return out; }
+
+    // Splits renders across `jobs`, at any quality (not owned; null renders
+    // on the calling thread). The frame is the same either way.
+    void setJobs(JobSystem* jobs) { jobSystem = jobs; }
+    JobSystem* jobs() const { return jobSystem; }
+
+    // Renders the mesh from the camera at full quality
+    void render();
+
+    /**
+     * @brief Renders at reduced quality, timing each stage (see timings()).
+     *        With jobs the stages are timed across all threads, so the
+     *        times are what the frame took, not the work it took.
+     * @param lod The mesh or one of its decimated levels.
+     */
+    void render(const std::vector<Triangle>& lod, const QualitySettings& quality);
+
+    // Cross-section of the mesh at `position` along the index's axis
+    void renderSlice(const SliceIndex& index, float position, bool capped);
+
+    /**
+     * @brief Sends the frame to the sink.
+     * @return Bytes the sink handed to its output (0 without a sink).
+     */
+    size_t present();
+
+    // The rendered frame, height() rows of width() characters. Writable so
+    // frames from elsewhere (a cache, a recording) can be presented.
+    std::vector<std::string>& frame() { return buffer; }
+    const std::vector<std::string>& frame() const { return buffer; }
+
+    // Stage times of the last reduced-quality render
+    const StageTimings& timings() const { return stageTimings; }
+
+    /**
+     * @brief Counters and times of the last render() and present().
+     *
+     * All zero unless the engine is built with TERMESH_STATS. A render with
+     * jobs counts the work of every thread while it runs, so contexts that
+     * share the job system's workers should not render at the same time.
+     */
+    const FrameStats& stats() const { return frameStats; }
+
+    // Draws stats() into the top rows of each frame render() produces
+    bool statsOverlay = false;
+
+private:
+    int cols, rows;
+    MeshRef model;
+    FrameSink* out = nullptr;
+    JobSystem* jobSystem = nullptr;
+    std::vector<std::string> buffer;
+    std::vector<float> zbuffer;
+    MemoryAccount memory{MEMORY_FRAMEBUFFERS};     // buffer and zbuffer
+    RenderScratch scratch;
+    ParallelScratch parallelScratch;
+    SliceScratch sliceScratch;
+    StageTimings stageTimings;
+    FrameStats frameStats;
+
+    // Fills frameStats from the counts since `before`
+    void endStats(const RenderCounters& before, bool parallel, double seconds);
+
+    static const std::vector<Triangle> empty;
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "mesh_cache.h"
+#include "render_context.h"
+#include "thread_pool.h"
+
+/**
+ * @file render_server.h
+ * @brief Long-running render daemon on a UNIX socket, its client, and a
+ *        load generator for measuring it.
+ *
+ * Protocol, one request at a time per connection. A request is one line:
+ *
+ *     RENDER <angleX> <angleY> <angleZ> <cols>x<rows> <mode> PATH <path>
+ *     RENDER <angleX> <angleY> <angleZ> <cols>x<rows> <mode> BYTES <n>
+ *
+ * where mode is shaded, slice or cap; BYTES is followed by the n bytes of
+ * an STL file. The reply is `OK <cols> <rows>` and the frame's rows, each
+ * on its own line, or `ERR <message>`. A malformed request is answered
+ * with ERR and ends the connection. `STATS` replies with one line of
+ * counters.
+ */
+
+// Largest frame and inline model a request may ask for
+constexpr int SERVER_MAX_CELLS = 1 << 20;
+constexpr size_t SERVER_MAX_MODEL_BYTES = 256u << 20;
+
+enum class RenderMode { Shaded, Slice, Cap };
+
+struct RenderRequest {
+    std::string path;               // Model file on the server's filesystem
+    std::vector<uint8_t> bytes;     // Or the STL file itself, when not empty
+    Camera camera;
+    int cols = SCREEN_WIDTH;
+    int rows = SCREEN_HEIGHT;
+    RenderMode mode = RenderMode::Shaded;
+};
+
+struct ServerOptions {
+    int threads = 0;                // Render workers; 0 = one per hardware thread
+    size_t cacheBytes = MESH_CACHE_CAPACITY;
+};
+
+struct ServerStats {
+    size_t requests = 0;            // Answered, including errors
+    size_t errors = 0;
+    size_t batches = 0;             // Groups of requests for one model served together
+    size_t largestBatch = 0;
+    size_t loads = 0;               // Models parsed
+    size_t meshes = 0;              // In the cache now
+    size_t cacheBytes = 0;
+    MeshCacheStats cache;
+};
+
+/**
+ * @brief Serves render requests on a UNIX socket.
+ *
+ * Each connection has a thread that reads its requests. Requests are queued
+ * by model; a model's whole queue goes to one worker, which takes the mesh
+ * from the cache or parses it once, then renders every request in the batch
+ * with its own RenderContext. Requests for one model that arrive while it
+ * is being served wait for the next batch on the same worker, so a model is
+ * never parsed twice at once.
+ */
+class RenderServer {
+public:
+    explicit RenderServer(const ServerOptions& options = ServerOptions());
+
+    // Stops, closes every connection and removes the socket
+    ~RenderServer();
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    // Binds and listens on `socketPath`, replacing a stale socket; false on error
+    bool listen(const std::string& socketPath);
+
+    // Accepts connections until stop()
+    void run();
+
+    // Makes run() return soon; safe from any thread and from signal handlers
+    void stop() { stopping = true; }
+
+    ServerStats stats() const;
+
+private:
+    struct Pending;
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void serveConnection(Connection& connection);
+    std::string handle(RenderRequest& request);
+    void serveModel(const std::string& key, int worker);
+    MeshRef meshFor(const std::string& key, const RenderRequest& request, std::string& error);
+    void reapConnections(bool all);
+
+    ServerOptions options;
+    std::string socketPath;
+    int listenFd = -1;
+    std::atomic<bool> stopping{false};
+    std::list<std::unique_ptr<Connection>> connections;
+
+    // Requests waiting per model key, and the keys a worker has been given
+    std::mutex queueMutex;
+    std::unordered_map<std::string, std::vector<Pending*>> waiting;
+    std::unordered_set<std::string> scheduled;
+
+    mutable std::mutex statsMutex;      // Guards cache and counters
+    MeshCache cache;
+    ServerStats counters;
+
+    std::vector<std::unique_ptr<RenderContext>> contexts;   // One per worker
+    std::unique_ptr<ThreadPool> pool;   // Last, so workers stop before the rest goes
+};
+
+/**
+ * @brief A connection to a RenderServer.
+ */
+class RenderClient {
+public:
+    RenderClient() = default;
+    ~RenderClient();
+
+    RenderClient(const RenderClient&) = delete;
+    RenderClient& operator=(const RenderClient&) = delete;
+
+    bool connect(const std::string& socketPath);
+
+    /**
+     * @brief Sends a request and waits for the frame.
+     * @param error Receives the server's message, or why the exchange failed.
+     */
+    bool render(const RenderRequest& request, std::vector<std::string>& frame, std::string& error);
+
+    // The server's counters line
+    bool stats(std::string& line);
+
+private:
+    bool readLine(std::string& line);
+
+    int fd = -1;
+    std::string buffer;     // Received, not yet consumed
+};
+
+struct LoadOptions {
+    std::string socketPath;
+    std::vector<std::string> models;    // Cycled through, request by request
+    int connections = 8;                // Concurrent clients
+    int requests = 1000;                // In total
+    int cols = SCREEN_WIDTH;
+    int rows = SCREEN_HEIGHT;
+    RenderMode mode = RenderMode::Shaded;
+    bool sendBytes = false;             // Send the files instead of their paths
+};
+
+struct LoadStats {
+    size_t requests = 0;                // Answered with a frame
+    size_t failures = 0;
+    double seconds = 0.0;
+    double p50Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+    std::string firstError;
+
+    double requestsPerSecond() const { return seconds > 0.0 ? requests / seconds : 0.0; }
+};
+
+/**
+ * @brief Sends `requests` requests over `connections` connections, each
+ *        waiting for its reply before the next, and measures the latency.
+ */
+LoadStats runLoadGenerator(const LoadOptions& options);
+
+// Header line of a request, without the trailing newline
+std::string encodeRequest(const RenderRequest& request);
+
+/**
+ * @brief Parses a request line.
+ * @param byteCount Receives the number of model bytes that follow (0 for PATH).
+ * @return False with `error` set if the line is malformed.
+ */
+bool parseRequest(const std::string& line, RenderRequest& request, size_t& byteCount, std::string& error);
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "quality.h"
+
+/**
+ * @file render_stats.h
+ * @brief Per-frame counters of where rendering work goes: triangles culled,
+ *        clipped or drawn, cells tested and depth results, with a text
+ *        overlay for the top rows of a frame.
+ *
+ * The counters are compiled in only when TERMESH_STATS is defined
+ * (`make STATS=1`). Without it every TERMESH_STAT() is empty, the engine
+ * counts nothing and the queries return zeros.
+ */
+
+// What is counted, in the order a triangle meets the stages
+enum RenderCounter {
+    COUNTER_SUBMITTED,          // Triangles given to the geometry stage
+    COUNTER_CULLED,             // Facing away from the viewer
+    COUNTER_CLIPPED,            // Front-facing, but wholly off the frame
+    COUNTER_DEGENERATE,         // On the frame with (almost) no screen area
+    COUNTER_RASTERIZED,         // Reached the cell loops
+    COUNTER_CELLS_TESTED,       // Coverage tests: bounding-box cells, or block samples
+    COUNTER_DEPTH_PASSES,       // Covered cells written, in front of what was there
+    COUNTER_DEPTH_FAILS,        // Covered cells behind what was there
+    RENDER_COUNTER_COUNT
+};
+
+// Short names for the overlay and logs, in RenderCounter order
+extern const char* const RENDER_COUNTER_NAMES[RENDER_COUNTER_COUNT];
+
+// Rows drawStatsOverlay() writes
+constexpr int STATS_OVERLAY_ROWS = 3;
+
+struct RenderCounters {
+    uint64_t values[RENDER_COUNTER_COUNT] = {};
+
+    uint64_t& operator[](RenderCounter counter) { return values[counter]; }
+    uint64_t operator[](RenderCounter counter) const { return values[counter]; }
+
+    // Counts since `earlier`, a snapshot of the same totals
+    RenderCounters operator-(const RenderCounters& earlier) const {
+        RenderCounters delta;
+        for (int i = 0; i < RENDER_COUNTER_COUNT; i++) delta.values[i] = values[i] - earlier.values[i];
+        return delta;
+    }
+};
+
+// What one frame cost
+struct FrameStats {
+    RenderCounters counters;
+    uint64_t cellsCovered = 0;      // Cells holding geometry once the frame is done
+    StageTimings timings;           // Stages of a serial render; zero for a parallel one
+    double frameSeconds = 0.0;      // The whole render
+    double outputSeconds = 0.0;     // The last present(), which follows the render
+
+    // Cells written per covered cell: 1 when nothing is drawn over
+    double overdraw() const {
+        return cellsCovered ? (double)counters[COUNTER_DEPTH_PASSES] / cellsCovered : 0.0;
+    }
+};
+
+// True if the engine was built with TERMESH_STATS
+bool statsCounting();
+
+// Adds to a counter of the calling thread. Use TERMESH_STAT(), which
+// disappears from builds without TERMESH_STATS.
+void addRenderCounter(RenderCounter counter, uint64_t count);
+
+#ifdef TERMESH_STATS
+#define TERMESH_STAT(counter, count) addRenderCounter(counter, count)
+#else
+#define TERMESH_STAT(counter, count) ((void)0)
+#endif
+
+// Totals counted by the calling thread since it started
+RenderCounters threadRenderCounters();
+
+// Totals of every thread since the process started. Counts of a thread that
+// is still rendering may be part way through a frame.
+RenderCounters allRenderCounters();
+
+// Covered cells of a depth buffer (those drawn since it was cleared)
+uint64_t coveredCells(const std::vector<float>& zbuffer);
+
+// The stats as STATS_OVERLAY_ROWS lines of text
+std::vector<std::string> statsLines(const FrameStats& stats);
+
+// Writes statsLines() over the start of the top rows of a frame, cut to its
+// width; a frame with fewer rows gets fewer lines
+void drawStatsOverlay(std::vector<std::string>& frame, const FrameStats& stats);
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file render_thread.h
+ * @brief Rendering off the presenting thread: a worker that produces frames
+ *        at its own pace and a double-buffered hand-off to the presenter.
+ */
+
+/**
+ * @brief Hands finished frames from the render thread to the presenter.
+ *
+ * The render thread draws into its own back buffer and publish() copies the
+ * result into the shared front buffer. The presenter swaps the front buffer
+ * out with acquire(), so it always shows the most recently completed frame
+ * and never one that is half drawn. Frames published faster than they are
+ * acquired are dropped, never queued.
+ */
+class FrameExchange {
+public:
+    // Render thread: makes `frame` the latest completed frame
+    void publish(const std::vector<std::string>& frame);
+
+    /**
+     * @brief Presenter: takes the latest frame if one was published since the
+     *        last call.
+     * @param frame Swapped with the front buffer, so no copy is made.
+     * @return False if nothing new was published; `frame` is untouched.
+     */
+    bool acquire(std::vector<std::string>& frame);
+
+    // A published frame is waiting for acquire()
+    bool pending() const;
+
+    size_t published() const;
+    size_t acquired() const;
+    size_t dropped() const;     // Published but replaced before acquire()
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::string> front;
+    bool fresh = false;
+    size_t publishCount = 0;
+    size_t acquireCount = 0;
+    size_t dropCount = 0;
+};
+
+/**
+ * @brief Runs a render step on its own thread at a fixed frame rate.
+ *
+ * The step renders and publishes one frame if there is anything to render and
+ * returns whether it did. While it has work the thread calls it once per
+ * frame period; once it reports nothing to do the thread sleeps until wake().
+ */
+class RenderThread {
+public:
+    using Step = std::function<bool()>;
+    // Given the seconds left before the next frame is due
+    using Idle = std::function<void(double)>;
+
+    /**
+     * @param fps Frames per second while the step has work; 0 or less runs
+     *        it back to back.
+     * @param idle Called between paced frames with the time to spare (may
+     *        be null).
+     */
+    RenderThread(Step step, int fps, Idle idle = nullptr);
+
+    // Stops and joins the thread
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Something changed: call the step again even if it was idle
+    void wake();
+
+    void setFps(int fps);
+
+    // Frames the step rendered
+    size_t frames() const { return frameCount.load(); }
+
+    /**
+     * @brief The last step had nothing to do and no wake() has come since.
+     *
+     * Everything the thread rendered before going idle has been published,
+     * so a presenter that sees idle() and no pending frame can stop polling
+     * until it next calls wake().
+     */
+    bool idle();
+
+private:
+    void run();
+
+    Step step;
+    Idle idleWork;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::atomic<int> framesPerSecond;
+    std::atomic<size_t> frameCount{0};
+    bool sleeping = false;
+    bool woken = false;
+    bool stopping = false;
+};
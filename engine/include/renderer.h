@@ -1,9 +1,12 @@
 #pragma once
+#include <functional>
 #include <vector>
 #include <string>
 #include "math3d.h"
 #include "model.h"
 #include "rasterizer.h"
+#include "display.h"
+#include "canvas.h"
 
 /**
  * @file renderer.h
@@ -25,8 +28,49 @@ void renderFrame(std::vector<std::string>& buffer,
                 const Vec3& lightDir);
 
 /**
- * @brief Prints the character buffer. In WASM builds, this updates the display element.
- * @param buffer The character buffer to print.
+ * @brief Text output. Only rows that differ from the previous frame are
+ *        handed on, and unchanged frames are skipped entirely.
+ *
+ * The presenter reads the changed rows in place from the display's glyph
+ * buffer, so nothing is copied or allocated per frame.
  */
-void printBuffer(const std::vector<std::string>& buffer);
+class TextSink : public FrameSink {
+public:
+    // Receives the display after each changed frame; dirty() lists the rows
+    using Presenter = std::function<void(const DisplayBuffer&)>;
 
+    TextSink(int width, int height, Presenter presenter);
+
+    size_t present(const std::vector<std::string>& frame) override;
+
+    // What is currently on screen
+    DisplayBuffer& display() { return screen; }
+
+private:
+    DisplayBuffer screen;
+    Presenter presenter;
+};
+
+/**
+ * @brief Pixel output: the frame drawn with the bitmap font.
+ *
+ * Like TextSink, unchanged frames are skipped and only dirty cells are
+ * redrawn, so the cost does not depend on the browser's text layout.
+ */
+class CanvasSink : public FrameSink {
+public:
+    // Receives the pixels after each changed frame and the rectangle that changed
+    using Presenter = std::function<void(const CanvasBuffer&, const PixelRect&)>;
+
+    CanvasSink(int cols, int rows, Presenter presenter);
+
+    size_t present(const std::vector<std::string>& frame) override;
+
+    DisplayBuffer& display() { return screen; }
+    const CanvasBuffer& canvas() const { return pixels; }
+
+private:
+    DisplayBuffer screen;
+    CanvasBuffer pixels;
+    Presenter presenter;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @file scheduler.h
+ * @brief Decides when a frame actually needs rendering, so a static view
+ *        costs nothing between changes.
+ */
+
+// Reasons the frame on screen is out of date
+enum DirtyFlags : unsigned {
+    DIRTY_NONE = 0,
+    DIRTY_ORIENTATION = 1 << 0,
+    DIRTY_MODEL = 1 << 1,
+    DIRTY_SIZE = 1 << 2,        // Output replaced or resized
+    DIRTY_LIGHT = 1 << 3,
+    DIRTY_MODE = 1 << 4,        // Render mode changed
+};
+
+struct SchedulerStats {
+    size_t ticks = 0;           // Times the host asked
+    size_t rendered = 0;        // Frames rendered
+    size_t suspensions = 0;     // Times the scheduler went idle
+};
+
+/**
+ * @brief Render-on-demand frame scheduler.
+ *
+ * Frames are produced only while something is dirty or an animation (auto
+ * rotation, stream playback) is running, and never while the output is
+ * hidden. Once wantsTicks() is false the host should stop its tick source,
+ * and restart it when invalidate(), setAnimating() or setVisible() make
+ * wantsTicks() true again.
+ */
+class FrameScheduler {
+public:
+    // Marks the frame out of date for the given DirtyFlags
+    void invalidate(unsigned reasons) { dirty |= reasons; }
+
+    // Animations produce a new frame on every tick
+    void setAnimating(bool on) { animating = on; }
+
+    // Hidden outputs are never rendered; changes made meanwhile stay dirty
+    void setVisible(bool on) { visible = on; }
+
+    /**
+     * @brief Called by the host's tick source.
+     * @return True if a frame should be rendered now; call rendered() after.
+     */
+    bool tick();
+
+    /**
+     * @brief The state the frame asked for by tick() is drawn from has been
+     *        read. Changes invalidated from now on stay dirty through
+     *        rendered(), so a frame drawn outside the host's lock is followed
+     *        by another that shows them.
+     */
+    void captured();
+
+    // The frame asked for by tick() is on screen
+    void rendered();
+
+    // True while ticking would do anything
+    bool wantsTicks() const { return visible && (animating || dirty != DIRTY_NONE); }
+
+    unsigned dirtyFlags() const { return dirty; }
+    bool isAnimating() const { return animating; }
+    bool isVisible() const { return visible; }
+
+    SchedulerStats stats;
+
+private:
+    unsigned dirty = DIRTY_MODEL;   // Nothing has been drawn yet
+    bool animating = false;
+    bool visible = true;
+    bool capturing = false;         // Between captured() and rendered()
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include "math3d.h"
+#include "lighting.h"
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+/**
+ * @file simd.h
+ * @brief Per-triangle kernels of the render loop, with WebAssembly SIMD
+ *        versions used when the module is built with -msimd128.
+ *
+ * Each SIMD version performs the same float operations in the same order as
+ * its scalar twin (WebAssembly has no fused multiply-add), so SIMD and scalar
+ * builds render bit-identical frames.
+ */
+
+#ifdef __wasm_simd128__
+constexpr bool SIMD_ENABLED = true;
+#else
+constexpr bool SIMD_ENABLED = false;
+#endif
+
+/**
+ * @brief Rotates the three vertices of a triangle, like `rotation * v`.
+ */
+inline void transformTriangle(const Mat3& rotation, const Vec3 in[3], Vec3 out[3]) {
+#ifdef __wasm_simd128__
+    const float (*m)[3] = rotation.m;
+    v128_t col0 = wasm_f32x4_make(m[0][0], m[1][0], m[2][0], 0.0f);
+    v128_t col1 = wasm_f32x4_make(m[0][1], m[1][1], m[2][1], 0.0f);
+    v128_t col2 = wasm_f32x4_make(m[0][2], m[1][2], m[2][2], 0.0f);
+    for (int i = 0; i < 3; i++) {
+        v128_t r = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(col0, wasm_f32x4_splat(in[i].x)),
+                                                 wasm_f32x4_mul(col1, wasm_f32x4_splat(in[i].y))),
+                                  wasm_f32x4_mul(col2, wasm_f32x4_splat(in[i].z)));
+        out[i] = Vec3(wasm_f32x4_extract_lane(r, 0), wasm_f32x4_extract_lane(r, 1),
+                      wasm_f32x4_extract_lane(r, 2));
+    }
+#else
+    for (int i = 0; i < 3; i++) {
+        out[i] = rotation * in[i];
+    }
+#endif
+}
+
+/**
+ * @brief Lambertian intensity at three vertices, like calculateLighting()
+ *        with its default ambient and diffuse terms.
+ */
+inline void lightTriangle(const Vec3 normals[3], const Vec3& lightDir, float out[3],
+                          float ambientIntensity = 0.2f, float diffuseIntensity = 0.8f) {
+#ifdef __wasm_simd128__
+    v128_t nx = wasm_f32x4_make(normals[0].x, normals[1].x, normals[2].x, 0.0f);
+    v128_t ny = wasm_f32x4_make(normals[0].y, normals[1].y, normals[2].y, 0.0f);
+    v128_t nz = wasm_f32x4_make(normals[0].z, normals[1].z, normals[2].z, 0.0f);
+    v128_t dot = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(nx, wasm_f32x4_splat(lightDir.x)),
+                                               wasm_f32x4_mul(ny, wasm_f32x4_splat(lightDir.y))),
+                                wasm_f32x4_mul(nz, wasm_f32x4_splat(lightDir.z)));
+    // pmax(0, d) is (0 < d ? d : 0), exactly std::max(0.0f, d) in calculateLighting()
+    v128_t diffuse = wasm_f32x4_pmax(wasm_f32x4_splat(0.0f), dot);
+    v128_t intensity = wasm_f32x4_add(wasm_f32x4_mul(diffuse, wasm_f32x4_splat(diffuseIntensity)),
+                                      wasm_f32x4_splat(ambientIntensity));
+    out[0] = wasm_f32x4_extract_lane(intensity, 0);
+    out[1] = wasm_f32x4_extract_lane(intensity, 1);
+    out[2] = wasm_f32x4_extract_lane(intensity, 2);
+#else
+    for (int i = 0; i < 3; i++) {
+        out[i] = calculateLighting(normals[i], lightDir, ambientIntensity, diffuseIntensity);
+    }
+#endif
+}
+
+/**
+ * @brief Sets `count` floats to `value`, e.g. to clear a depth buffer.
+ */
+inline void fillFloats(float* data, size_t count, float value) {
+    size_t i = 0;
+#ifdef __wasm_simd128__
+    v128_t splat = wasm_f32x4_splat(value);
+    for (; i + 4 <= count; i += 4) {
+        wasm_v128_store(data + i, splat);
+    }
+#endif
+    for (; i < count; i++) {
+        data[i] = value;
+    }
+}
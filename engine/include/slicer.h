@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "math3d.h"
+#include "memory_stats.h"
+#include "model.h"
+
+/**
+ * @file slicer.h
+ * @brief Cross-section slicing of a mesh by an axis-aligned plane.
+ */
+
+// Axis the slicing plane is perpendicular to (model space)
+enum class SliceAxis { X = 0, Y = 1, Z = 2 };
+
+// Glyph used to draw the intersection contour
+constexpr char SLICE_CONTOUR_CHAR = 'O';
+
+/**
+ * @brief Interval index over the extent of each triangle along the slice axis.
+ *
+ * A centered interval tree flattened into arrays. Each node keeps the triangles
+ * that straddle its center twice: sorted by ascending minimum and by descending
+ * maximum, so a stabbing query only reads the triangles that actually intersect
+ * the plane plus O(log n) nodes. Built once per model.
+ */
+class SliceIndex {
+public:
+    /**
+     * @brief Builds the index for a mesh.
+     * @param triangles The mesh (already normalized).
+     * @param axis Axis the slicing plane is perpendicular to.
+     */
+    void build(const std::vector<Triangle>& triangles, SliceAxis axis);
+
+    /**
+     * @brief Collects the triangles whose extent contains the given position.
+     * @param position Plane position along the slice axis.
+     * @param out Receives triangle indices (cleared first).
+     */
+    void query(float position, std::vector<uint32_t>& out) const;
+
+    /**
+     * @brief Number of triangles lying entirely below a position.
+     *
+     * Those triangles are `below()[0 .. countBelow(position))`.
+     */
+    size_t countBelow(float position) const;
+
+    // Triangle indices sorted by ascending maximum extent
+    const std::vector<uint32_t>& below() const { return byHigh; }
+
+    SliceAxis axis() const { return sliceAxis; }
+    float minExtent() const { return rangeMin; }
+    float maxExtent() const { return rangeMax; }
+    size_t size() const { return low.size(); }
+    bool empty() const { return low.empty(); }
+
+private:
+    struct Node {
+        float center;
+        uint32_t begin, end;  // Range in nodeByMin / nodeByMax
+        int32_t left, right;  // Child nodes, -1 if none
+    };
+
+    int32_t buildNode(std::vector<uint32_t>& ids);
+
+    SliceAxis sliceAxis = SliceAxis::Z;
+    float rangeMin = 0.0f, rangeMax = 0.0f;
+    std::vector<float> low, high;       // Per-triangle extent along the axis
+    std::vector<Node> nodes;
+    std::vector<uint32_t> nodeByMin;    // Per node: ascending minimum
+    std::vector<uint32_t> nodeByMax;    // Per node: descending maximum
+    std::vector<uint32_t> byHigh;       // All triangles, ascending maximum
+    MemoryAccount memory{MEMORY_ACCELERATION};
+};
+
+// Intersection of one triangle with the slicing plane (model space)
+struct SliceSegment {
+    Vec3 a, b;
+};
+
+/**
+ * @brief Computes the contour of the mesh at a plane position.
+ * @param triangles The mesh the index was built from.
+ * @param index Slice index for the mesh.
+ * @param position Plane position along the index axis.
+ * @param candidates Scratch list for the index query.
+ * @param segments Receives the contour segments (cleared first).
+ */
+void sliceMesh(const std::vector<Triangle>& triangles, const SliceIndex& index,
+               float position, std::vector<uint32_t>& candidates,
+               std::vector<SliceSegment>& segments);
+
+// Per-frame scratch memory for renderSlice, reused across frames
+struct SliceScratch {
+    std::vector<uint32_t> candidates;
+    std::vector<SliceSegment> segments;
+    std::vector<uint8_t> parity;    // Cap stencil (odd = inside the section)
+    std::vector<float> capDepth;    // Cap depth per covered pixel
+};
+
+/**
+ * @brief Renders a cross-section of the model.
+ *
+ * Without capping only the contour is drawn. With capping the half of the model
+ * below the plane is rendered, the cut face is filled and the contour outlines it.
+ *
+ * @param buffer Character buffer for output (cleared by the caller).
+ * @param zbuffer Depth buffer for z-testing.
+ * @param model The triangle mesh to render.
+ * @param index Slice index for the mesh.
+ * @param rotation Rotation matrix to apply to the model.
+ * @param lightDir Light direction vector (should be normalized).
+ * @param position Plane position along the index axis.
+ * @param capped Whether to render the capped half-model.
+ * @param scratch Scratch memory reused across frames.
+ */
+void renderSlice(std::vector<std::string>& buffer,
+                 std::vector<float>& zbuffer,
+                 const std::vector<Triangle>& model,
+                 const SliceIndex& index,
+                 const Mat3& rotation,
+                 const Vec3& lightDir,
+                 float position,
+                 bool capped,
+                 SliceScratch& scratch);
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "memory_stats.h"
+#include "model.h"
+
+/**
+ * @file stl_stream.h
+ * @brief Incremental STL ingestion: parse a model from byte chunks as they
+ *        arrive so a preview can be drawn before the download completes.
+ */
+
+/**
+ * @brief Parses an STL model from a sequence of arbitrarily sized chunks.
+ *
+ * Binary files are decoded record by record: every complete 50-byte record in
+ * the bytes seen so far is appended to the model, and a record split across
+ * chunks waits in a small carry buffer for the rest of its bytes. The model is
+ * kept normalized with a provisional fit taken from the bounds seen so far;
+ * when later triangles grow those bounds noticeably every triangle is refitted
+ * from the raw coordinates. finish() applies the exact normalizeModel() fit,
+ * so the final model is identical to loadSTL() followed by normalizeModel().
+ *
+ * ASCII files have no fixed record size, so they are buffered whole and
+ * parsed by finish(); no preview is produced for them.
+ */
+class StlStream {
+public:
+    /**
+     * @brief Starts a new stream, discarding any previous state.
+     * @param totalBytes Size of the whole file if known, else 0. Only a hint,
+     *        never grounds to reject a stream: a binary file whose header
+     *        happens to start with "solid" is recognised as binary when its
+     *        size matches the record count, up front if this is that size
+     *        and otherwise by finish() from the bytes received.
+     * @param budgetBytes Memory budget the model must fit in (0 = none; see
+     *        fitsMemoryBudget()). Checked as soon as the header gives the
+     *        triangle count, and for ASCII text as it arrives; a stream
+     *        over budget fails.
+     */
+    void begin(size_t totalBytes = 0, size_t budgetBytes = 0);
+
+    /**
+     * @brief Consumes the next chunk, appending complete triangles to `model`.
+     * @return False if the input cannot be an STL file.
+     */
+    bool feed(const uint8_t* data, size_t size, std::vector<Triangle>& model);
+
+    /**
+     * @brief Ends the stream and replaces `model` with the final, exactly
+     *        normalized triangles.
+     * @param scale Receives the normalization scale, as from normalizeModel().
+     * @return False if the stream was truncated or held no triangles.
+     */
+    bool finish(std::vector<Triangle>& model, float& scale);
+
+    // Triangle count promised by the binary header (0 until it is read)
+    size_t expectedTriangles() const { return expected; }
+    size_t bytesReceived() const { return received; }
+    size_t totalBytes() const { return total; }     // As given to begin()
+    bool ascii() const { return isAscii; }
+
+    // Times the preview was refitted to grown bounds
+    size_t refits() const { return refitCount; }
+
+private:
+    bool consume(const uint8_t* data, size_t size, std::vector<Triangle>& model);
+    void append(const uint8_t* records, size_t count, std::vector<Triangle>& model);
+    void fit();
+    bool fitsBudget(size_t fileBytes, bool ascii);
+    void trackScratch();
+
+    std::vector<uint8_t> pending;   // Header, partial record, or ASCII text
+    std::vector<Triangle> raw;      // Unnormalized triangles, kept for refits
+    size_t total = 0;
+    size_t memoryBudget = 0;
+    size_t received = 0;
+    size_t expected = 0;
+    bool headerDone = false;
+    bool isAscii = false;
+    bool failed = false;
+
+    // Running bounds and the provisional fit applied to the preview
+    Vec3 minBounds;
+    Vec3 maxBounds;
+    Vec3 center;
+    float fitScale = 1.0f;
+    float fittedDim = 0.0f;
+    size_t refitCount = 0;
+
+    // pending and raw, as parse scratch
+    MemoryAccount scratch{MEMORY_PARSE_SCRATCH};
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <string>
+#include "display.h"
+
+/**
+ * @file terminal.h
+ * @brief ANSI terminal output that only redraws the cells that changed.
+ */
+
+// A cursor move costs about 8 bytes, so shorter unchanged gaps inside a row
+// are rewritten instead of jumped over
+constexpr int TERMINAL_MAX_GAP = 8;
+
+/**
+ * @brief Appends the ANSI sequences that turn the terminal contents `front`
+ *        into the frame `back`, positioning the cursor only where needed.
+ * @param front What is currently on the terminal.
+ * @param back The new frame (same size as front).
+ * @param out Receives the escape sequences and glyphs.
+ * @return Number of glyphs written.
+ */
+size_t encodeTerminalPatch(const DisplayBuffer& front,
+                           const std::vector<std::string>& back,
+                           std::string& out);
+
+/**
+ * @brief Queries the size of the terminal attached to a file descriptor.
+ * @return False if the descriptor is not a terminal.
+ */
+bool terminalSize(int fd, int& width, int& height);
+
+/**
+ * @brief Double-buffered terminal output.
+ *
+ * The rendered frame is the back buffer and a DisplayBuffer mirrors what the
+ * terminal shows. Each present() diffs the two, encodes only the changed cells
+ * and sends them with a single write(). Frames larger than the terminal are
+ * resampled to fit.
+ */
+class TerminalOutput : public FrameSink {
+public:
+    TerminalOutput(int width, int height, int fd = 1);
+    ~TerminalOutput() override;
+
+    TerminalOutput(const TerminalOutput&) = delete;
+    TerminalOutput& operator=(const TerminalOutput&) = delete;
+
+    /**
+     * @brief Brings the terminal up to date with a rendered frame.
+     * @param buffer The rendered character buffer.
+     * @return Bytes written to the terminal.
+     */
+    size_t present(const std::vector<std::string>& buffer) override;
+
+    size_t frames() const { return frameCount; }
+    size_t bytesWritten() const { return byteCount; }
+
+private:
+    const std::vector<std::string>& fit(const std::vector<std::string>& buffer);
+    void writeAll(const std::string& data);
+
+    int fd;
+    int cols, rows;
+    DisplayBuffer front;
+    std::vector<std::string> scaled;   // Frame resampled to the terminal size
+    std::string out;                    // Escape sequences for one frame
+    bool started = false;
+    size_t frameCount = 0;
+    size_t byteCount = 0;
+};
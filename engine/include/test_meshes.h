@@ -0,0 +1,109 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "model.h"
+#include "render_context.h"
+
+/**
+ * @file test_meshes.h
+ * @brief Meshes and binary STL files shared by the tests.
+ */
+
+// A single triangle facing the camera
+inline std::vector<Triangle> makeTriangle() {
+    Triangle t;
+    t.vertices[0] = Vec3(-0.5f, -0.5f, 0.0f);
+    t.vertices[1] = Vec3(0.0f, 0.5f, 0.0f);
+    t.vertices[2] = Vec3(0.5f, -0.5f, 0.0f);
+    t.normal = Vec3(0.0f, 0.0f, -1.0f);
+    return {t};
+}
+
+// Closed cube of 12 triangles from -scale to scale on each axis, two per face
+inline std::vector<Triangle> makeCube(float scale = 1.0f) {
+    const Vec3 c[8] = {{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+                       {-1, -1, 1},  {1, -1, 1},  {1, 1, 1},  {-1, 1, 1}};
+    const int faces[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4},
+                             {2, 3, 7, 6}, {1, 2, 6, 5}, {0, 4, 7, 3}};
+    std::vector<Triangle> cube;
+    for (const auto& f : faces) {
+        for (int half = 0; half < 2; half++) {
+            Triangle tri;
+            tri.vertices[0] = c[f[0]] * scale;
+            tri.vertices[1] = c[f[half + 1]] * scale;
+            tri.vertices[2] = c[f[half + 2]] * scale;
+            tri.normal = (tri.vertices[1] - tri.vertices[0]).cross(tri.vertices[2] - tri.vertices[0]).normalize();
+            cube.push_back(tri);
+        }
+    }
+    return cube;
+}
+
+// Unit UV sphere of 2 * stacks * slices triangles, normals pointing out
+inline std::vector<Triangle> makeSphere(int stacks, int slices) {
+    const float PI = 3.14159265f;
+    auto point = [&](int stack, int slice) {
+        float theta = PI * stack / stacks, phi = 2 * PI * slice / slices;
+        return Vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+    std::vector<Triangle> sphere;
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            Vec3 quad[4] = {point(i, j), point(i + 1, j), point(i + 1, j + 1), point(i, j + 1)};
+            for (int half = 0; half < 2; half++) {
+                Triangle tri;
+                tri.vertices[0] = quad[0];
+                tri.vertices[1] = quad[half + 1];
+                tri.vertices[2] = quad[half + 2];
+                tri.normal = (tri.vertices[0] + tri.vertices[1] + tri.vertices[2]).normalize();
+                sphere.push_back(tri);
+            }
+        }
+    }
+    return sphere;
+}
+
+// `model` normalized the way loaded models are
+inline std::vector<Triangle> normalized(std::vector<Triangle> model) {
+    float scale;
+    normalizeModel(model, scale);
+    return model;
+}
+
+// `model` normalized and shared, ready for RenderContext::setMesh()
+inline MeshRef normalizedMesh(std::vector<Triangle> model) {
+    return std::make_shared<const std::vector<Triangle>>(normalized(std::move(model)));
+}
+
+// `copies` of `model` one after another as a binary STL file's bytes
+inline std::vector<uint8_t> stlBytes(const std::vector<Triangle>& model, int copies = 1) {
+    std::vector<uint8_t> bytes(STL_HEADER_SIZE, 0);
+    uint32_t count = (uint32_t)(model.size() * copies);
+    std::memcpy(bytes.data() + 80, &count, sizeof(count));
+    bytes.reserve(STL_HEADER_SIZE + count * STL_RECORD_SIZE);
+    for (int copy = 0; copy < copies; copy++) {
+        for (const auto& tri : model) {
+            uint8_t record[STL_RECORD_SIZE] = {};
+            std::memcpy(record, &tri.normal, 12);
+            for (int v = 0; v < 3; v++) std::memcpy(record + 12 + v * 12, &tri.vertices[v], 12);
+            bytes.insert(bytes.end(), record, record + STL_RECORD_SIZE);
+        }
+    }
+    return bytes;
+}
+
+inline void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+}
+
+inline void writeStl(const std::string& path, const std::vector<Triangle>& model, int copies = 1) {
+    writeFile(path, stlBytes(model, copies));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file thread_pool.h
+ * @brief Fixed set of worker threads for batch jobs such as animation export.
+ */
+
+/**
+ * @brief Runs submitted tasks on a fixed number of threads.
+ *
+ * Tasks receive the index of the worker running them, so callers can keep
+ * per-worker scratch buffers (z-buffers, encoder tables) without locking.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+    /**
+     * @param threads Number of workers; 0 uses one per hardware thread.
+     */
+    explicit ThreadPool(int threads = 0);
+
+    // Finishes queued tasks, then joins the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    /**
+     * @brief Calls fn(index, worker) for every index in [0, count) across the
+     *        workers and returns once all calls have finished.
+     *
+     * Indices are handed out one at a time, so uneven work balances itself.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t index, int worker)>& fn);
+
+    int size() const { return (int)workers.size(); }
+
+private:
+    void workerLoop(int worker);
+
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    size_t active = 0;          // Tasks currently running
+    bool stopping = false;
+};
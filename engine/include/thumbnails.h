@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "rasterizer.h"
+
+/**
+ * @file thumbnails.h
+ * @brief Batch rendering of still text previews for many STL files.
+ */
+
+// A fixed orientation previews are rendered from
+struct ThumbnailView {
+    const char* name;               // Appended to the output file name
+    float angleX, angleY, angleZ;
+};
+
+// Three-quarter view first, then the axis views
+constexpr int THUMBNAIL_VIEW_COUNT = 4;
+extern const ThumbnailView THUMBNAIL_VIEWS[THUMBNAIL_VIEW_COUNT];
+
+// Default cap on the memory of models loaded at once
+constexpr size_t THUMBNAIL_MEMORY_BYTES = 256u << 20;
+
+struct ThumbnailOptions {
+    std::string outputDir = ".";
+    int views = 1;                  // The first `views` of THUMBNAIL_VIEWS
+    int threads = 0;                // 0 = one per hardware thread
+    size_t memoryBytes = THUMBNAIL_MEMORY_BYTES;
+    int cols = SCREEN_WIDTH;        // Frame size in character cells
+    int rows = SCREEN_HEIGHT;
+};
+
+// A file the batch skipped, and why
+struct ThumbnailFailure {
+    std::string path;
+    std::string reason;
+};
+
+struct ThumbnailStats {
+    size_t models = 0;              // Models rendered
+    size_t triangles = 0;           // In the rendered models
+    size_t files = 0;               // Text files written
+    int threads = 0;
+    double seconds = 0.0;           // Whole batch, wall clock
+    double loadSeconds = 0.0;       // Reading and normalizing, summed over threads
+    double renderSeconds = 0.0;     // Rendering and writing, summed over threads
+    size_t peakBytes = 0;           // Most model memory reserved at once
+    std::vector<ThumbnailFailure> failures;   // In input order
+
+    double modelsPerSecond() const { return seconds > 0.0 ? models / seconds : 0.0; }
+    double trianglesPerSecond() const { return seconds > 0.0 ? triangles / seconds : 0.0; }
+};
+
+/**
+ * @brief Expands command-line inputs into a list of STL files.
+ *
+ * A directory adds its .stl files (any case), sorted; `@FILE` adds the paths
+ * listed in FILE, one per line; anything else is taken as a file. Inputs
+ * that cannot be read are added to `failures`.
+ */
+void collectStlFiles(const std::vector<std::string>& inputs, std::vector<std::string>& paths,
+                     std::vector<ThumbnailFailure>& failures);
+
+// Output file of `path` for view `view`: the file's stem, plus the view's
+// name when there is more than one view, then ".txt"
+std::string thumbnailName(const std::string& path, int view, int views);
+
+/**
+ * @brief Loads, normalizes and renders every file in `paths` to text files
+ *        in `options.outputDir`, several files at once on a thread pool.
+ *
+ * A model reserves twice its file size against `options.memoryBytes` before
+ * it is read, enough for the file's bytes and the triangles decoded from
+ * them, so a batch of large models never holds more than the budget; a
+ * model larger than the budget is loaded on its own. Files that cannot be
+ * read, hold no triangles or cannot be written are reported in the stats'
+ * failures and the batch carries on.
+ */
+ThumbnailStats renderThumbnails(const std::vector<std::string>& paths, const ThumbnailOptions& options);
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file trace.h
+ * @brief Timed spans of loading, rendering and output, exported as Chrome
+ *        trace-event JSON for chrome://tracing or Perfetto.
+ *
+ * Each thread records into its own fixed ring, so recording takes no lock
+ * and allocates nothing after a thread's first span. While tracing is off a
+ * span costs one relaxed load.
+ */
+
+// Spans each thread keeps; older ones are overwritten
+constexpr size_t TRACE_RING_EVENTS = 8192;
+
+// Rings of exited threads kept for export, newest first
+constexpr int TRACE_RETIRED_THREADS = 16;
+
+extern std::atomic<bool> traceEnabled;
+
+// True while spans are recorded
+inline bool tracing() {
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+// Starts or stops recording. Recorded spans stay until clearTrace().
+void setTracing(bool on);
+
+// Drops every recorded span
+void clearTrace();
+
+// Nanoseconds on the trace clock; never 0
+uint64_t traceNow();
+
+// Records a finished span of the calling thread. `name` must outlive the
+// trace (a string literal).
+void recordTraceSpan(const char* name, uint64_t start, uint64_t end);
+
+// Names the calling thread in exported traces (a string literal)
+void setTraceThreadName(const char* name);
+
+// Records its lifetime as a span if tracing was on when it started
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(tracing() ? traceNow() : 0) {}
+    ~TraceScope() {
+        if (start) recordTraceSpan(name, start, traceNow());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define TERMESH_TRACE_CONCAT_(a, b) a##b
+#define TERMESH_TRACE_CONCAT(a, b) TERMESH_TRACE_CONCAT_(a, b)
+
+// Times the rest of the enclosing block as a span called `name`
+#define TERMESH_TRACE_SCOPE(name) TraceScope TERMESH_TRACE_CONCAT(traceScope, __LINE__)(name)
+
+/**
+ * @brief The recorded spans as Chrome trace-event JSON: one complete ("X")
+ *        event per span, in microseconds, plus thread names.
+ *
+ * Safe while other threads record: a span being overwritten is left out.
+ */
+std::string traceJson();
+
+bool saveTrace(const std::string& path);
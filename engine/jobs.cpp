@@ -0,0 +1,152 @@
+#include "jobs.h"
+#include <algorithm>
+#include "trace.h"
+
+namespace {
+    // The job system and worker index of the calling thread, if it is a worker
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local int currentIndex = -1;
+} // anonymous namespace
+
+void JobSystem::Queue::pushBack(Entry entry) {
+    if (count == ring.size()) {
+        // Unroll into a ring twice the size, oldest entry first
+        std::vector<Entry> grown(std::max<size_t>(16, ring.size() * 2));
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+        ring = std::move(grown);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = std::move(entry);
+    count++;
+}
+
+JobSystem::Entry JobSystem::Queue::popBack() {
+    count--;
+    return std::move(ring[(head + count) % ring.size()]);
+}
+
+JobSystem::Entry JobSystem::Queue::popFront() {
+    Entry entry = std::move(ring[head]);
+    head = (head + 1) % ring.size();
+    count--;
+    return entry;
+}
+
+JobSystem::JobSystem(int threads) {
+    if (threads <= 0) {
+        threads = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+    workerCount = threads;
+    for (int i = 0; i <= threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    workers.reserve(threads);
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+int JobSystem::currentWorker() const {
+    return currentSystem == this ? currentIndex : -1;
+}
+
+void JobSystem::run(Group& group, Job job) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    int worker = currentWorker();
+    Queue& queue = *queues[worker >= 0 ? worker : workerCount];
+    // Counted first so take() never sees more jobs than `queued`
+    queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pushBack(Entry{std::move(job), &group});
+    }
+    // Taking the lock orders this against a worker or waiter about to sleep
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    jobReady.notify_one();
+    groupDone.notify_all();
+}
+
+bool JobSystem::take(int worker, Entry& entry) {
+    const int shared = workerCount;
+    const int count = (int)queues.size();
+    // Own queue newest first, then the shared queue, then steal oldest first
+    int start = worker >= 0 ? worker : shared;
+    for (int i = 0; i < count; i++) {
+        int index = (start + i) % count;
+        Queue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count == 0) continue;
+
+        if (index == worker) {
+            entry = queue.popBack();
+        } else {
+            entry = queue.popFront();
+            if (index != shared) stolen++;
+        }
+        queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::execute(Entry& entry) {
+    entry.job();
+    entry.job = nullptr;
+    executed++;
+    if (entry.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // The group is done and may be gone: wake its waiters without it
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        groupDone.notify_all();
+    }
+}
+
+bool JobSystem::runPending() {
+    Entry entry;
+    if (!take(currentWorker(), entry)) return false;
+    execute(entry);
+    return true;
+}
+
+void JobSystem::wait(Group& group) {
+    while (!group.done()) {
+        if (runPending()) continue;
+        // The group's last jobs are running elsewhere: sleep until the last
+        // one finishes, or until there are new jobs to help with
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        groupDone.wait(lock, [&] { return group.done() || queued.load() > 0; });
+    }
+}
+
+JobStats JobSystem::stats() const {
+    JobStats result;
+    result.executed = executed.load();
+    result.stolen = stolen.load();
+    return result;
+}
+
+void JobSystem::workerLoop(int worker) {
+    setTraceThreadName("job worker");
+    currentSystem = this;
+    currentIndex = worker;
+    while (true) {
+        Entry entry;
+        if (take(worker, entry)) {
+            execute(entry);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobReady.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return; // Stopping and drained
+    }
+}
@@ -0,0 +1,40 @@
+#include "log.h"
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/console.h>
+#endif
+
+namespace {
+    void writeLine(bool error, const char* format, va_list args) {
+        char line[LOG_LINE_MAX];
+        std::vsnprintf(line, sizeof(line), format, args);
+#ifdef __EMSCRIPTEN__
+        if (error) {
+            emscripten_err(line);
+        } else {
+            emscripten_out(line);
+        }
+#else
+        std::FILE* out = error ? stderr : stdout;
+        std::fputs(line, out);
+        std::fputc('\n', out);
+        std::fflush(out);
+#endif
+    }
+} // anonymous namespace
+
+void logInfo(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    writeLine(false, format, args);
+    va_end(args);
+}
+
+void logError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    writeLine(true, format, args);
+    va_end(args);
+}
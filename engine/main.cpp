@@ -1,83 +1,1551 @@
 // main.cpp
-#include <iostream>
 #include <vector>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <mutex>
 
-// NEW: Include for Emscripten
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#else
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include "terminal.h"
+#include "animation.h"
+#include "thumbnails.h"
+#include "render_server.h"
+#endif
 
 #include "math3d.h"
 #include "model.h"
 #include "renderer.h"
+#include "slicer.h"
+#include "framestream.h"
+#include "frame_cache.h"
+#include "scheduler.h"
+#include "quality.h"
+#include "render_thread.h"
+#include "simd.h"
+#include "stl_stream.h"
+#include "render_context.h"
+#include "jobs.h"
+#include "pipeline.h"
+#include "multiview.h"
+#include "memory_stats.h"
+#include "trace.h"
+#include "log.h"
+
+// Frames for the slicing plane to cross the model once
+constexpr float SLICE_SWEEP_FRAMES = 120.0f;
+
+// Floats returned by termesh_quality_stats()
+constexpr int QUALITY_STAT_COUNT = 6;
+
+// Idle time per browser frame spent rendering ahead into the frame cache
+constexpr double PRECOMPUTE_BUDGET_SECONDS = 0.008;
 
 // NEW: Store all our persistent state in one place.
 struct GlobalState {
-    std::vector<Triangle> triangles;
-    Vec3 lightDir;
+    // What is rendered: mesh, camera, light, frame and scratch buffers, and
+    // the sink frames are presented to
+    RenderContext view;
+    // The loaded model, shared with the view; a streaming load appends to it
+    std::shared_ptr<std::vector<Triangle>> model = std::make_shared<std::vector<Triangle>>();
+    MemoryAccount modelMemory{MEMORY_MESH};
+    // Most memory a model may bring in, estimated before it is read
+    // (0 = no limit; see memory_stats.h)
+    size_t memoryBudget = 0;
+    // Workers the view splits full-quality frames across (null renders on
+    // the calling thread)
+    std::unique_ptr<JobSystem> jobs;
+    // Three-quarter and axis views side by side instead of the one view
+    // (null for one view)
+    std::unique_ptr<MultiView> multiView;
     
-    // Animation variables
-    float angleX = 0.0f, angleY = 0.0f, angleZ = 0.0f;
+    // Auto-rotation step per frame
     const float rotationSpeed = 0.02f;
-    
-    // Buffers
-    std::vector<std::string> buffer;
-    std::vector<float> zbuffer;
+
+#ifdef __EMSCRIPTEN__
+    // Page outputs: text rows, or canvas pixels while canvasOutput is set
+    std::unique_ptr<TextSink> textOutput;
+    std::unique_ptr<CanvasSink> canvasOutput;
+#endif
+
+    // Cross-section mode: the plane sweeps back and forth through the model
+    bool sliceMode = false;
+    bool sliceCapped = false;
+    SliceAxis sliceAxis = SliceAxis::Z;
+    SliceIndex sliceIndex;
+    float slicePosition = 0.0f;
+    float sliceStep = 0.0f;
+
+    // Frame streams: record what is rendered, or play a recording back
+    // instead of rasterizing
+    std::unique_ptr<FrameStreamRecorder> recorder;
+    FrameStreamPlayer player;
+    bool playing = false;
+
+    // Frames by orientation, filled ahead of playback in idle time
+    // (null when disabled)
+    std::unique_ptr<FrameCache> frameCache;
+    TurntablePrecompute precompute;
+
+    // Render on demand: frames are drawn only when the view changed or an
+    // animation (auto-rotation, playback) is running
+    FrameScheduler scheduler;
+    int loopFps = 30;
+    bool loopActive = false;
+
+    // Adaptive quality: live renders drop detail to hold a frame-time budget
+    bool adaptive = false;
+    AdaptiveQuality quality;
+    LodChain lods;
+
+    // Progressive loading: the model fills in while its bytes arrive, with
+    // a provisional fit until the stream ends
+    StlStream stream;
+    std::vector<uint8_t> streamChunk;   // The page copies each chunk here
+    MemoryAccount streamChunkMemory{MEMORY_PARSE_SCRATCH};
+    bool streaming = false;
+
+#ifdef TERMESH_THREADS
+    // Held by the render thread for the whole of each frame, and by the
+    // exported functions that change the model or what is built from it
+    // (taken before `mutex`)
+    std::mutex renderMutex;
+#endif
+    // Held by every exported function, which run on the browser thread, and
+    // by the render thread only while it reads the state for a frame and
+    // writes the result back (threads build only)
+    std::mutex mutex;
+    size_t framesPresented = 0;
+#ifdef TERMESH_THREADS
+    // The render thread draws into its own view from a copy of the camera,
+    // light and quality and publishes the frame; the browser thread swaps the
+    // latest frame into `presented` and shows that
+    RenderContext workerView;
+    StageTimings workerTimings;     // Of the last reduced-quality frame
+    FrameExchange frames;
+    std::unique_ptr<RenderThread> renderThread;
+    std::vector<std::string> presented;
+#endif
+};
+
+#ifdef TERMESH_THREADS
+using StateLock = std::lock_guard<std::mutex>;
+
+// Keeps the render thread out while the model, its slice index, its LOD
+// levels or the view layout change under it
+struct ModelLock {
+    explicit ModelLock(GlobalState* state) : render(state->renderMutex), lock(state->mutex) {}
+    std::lock_guard<std::mutex> render;
+    std::lock_guard<std::mutex> lock;
+};
+#else
+// Single-threaded builds have nothing to lock against
+struct StateLock {
+    explicit StateLock(std::mutex&) {}
+};
+
+struct ModelLock {
+    explicit ModelLock(GlobalState*) {}
 };
+#endif
+
+#ifdef __EMSCRIPTEN__
+// Hands the frame to the page without copying it. `data` points at the
+// persistent glyph buffer (rows `stride` bytes apart, each ending in '\n') and
+// `spans` at the DirtySpan records of the rows that changed. The presenter
+// installed by src/display.js decodes those rows straight from the heap.
+EM_JS(void, present_frame, (const char* data, int stride, int width, int height, const int* spans, int count), {
+    if (Module.presentFrame) {
+        Module.presentFrame(HEAPU8, HEAP32, data, stride, width, height, spans, count);
+    }
+});
+
+// Hands over the RGBA canvas pixels (width * height * 4 bytes at `pixels`) and
+// the rectangle that changed. src/display.js puts that rectangle on the page
+// with putImageData over a view of the heap.
+EM_JS(void, present_canvas, (const uint8_t* pixels, int width, int height, int x, int y, int w, int h), {
+    if (Module.presentCanvas) {
+        Module.presentCanvas(HEAPU8, pixels, width, height, x, y, w, h);
+    }
+});
+
+namespace {
+    void presentText(const DisplayBuffer& display) {
+        static_assert(sizeof(DirtySpan) == 3 * sizeof(int), "JS reads spans as int triples");
+        const auto& spans = display.dirty();
+        present_frame(display.data(), display.stride(), display.width(), display.height(),
+                      reinterpret_cast<const int*>(spans.data()), (int)spans.size());
+    }
+
+    void presentPixels(const CanvasBuffer& canvas, const PixelRect& changed) {
+        present_canvas(canvas.data(), canvas.width(), canvas.height(),
+                       changed.x, changed.y, changed.width, changed.height);
+    }
+} // anonymous namespace
+
+// What the page shows, through whichever output is selected
+DisplayBuffer& screen(GlobalState* state) {
+    return state->canvasOutput ? state->canvasOutput->display() : state->textOutput->display();
+}
+
+// Presents as canvas pixels or text rows, at the view's size
+void setOutput(GlobalState* state, bool canvas) {
+    const int width = state->view.width(), height = state->view.height();
+    const DisplayBuffer* text = state->textOutput ? &state->textOutput->display() : nullptr;
+    if (!text || text->width() != width || text->height() != height) {
+        state->textOutput.reset(new TextSink(width, height, presentText));
+        state->canvasOutput.reset();
+    }
+    if (!canvas) {
+        state->canvasOutput.reset();
+    } else if (!state->canvasOutput) {
+        state->canvasOutput.reset(new CanvasSink(width, height, presentPixels));
+    }
+    state->view.setSink(canvas ? static_cast<FrameSink*>(state->canvasOutput.get())
+                               : state->textOutput.get());
+    // The new output starts out empty
+    screen(state).invalidate();
+}
+
+// State of the running renderer, for the exported functions below
+static GlobalState* activeState = nullptr;
+
+// Zero-copy view of the frame on screen: height rows of width glyphs, each
+// followed by '\n', stride bytes apart. The buffer is allocated once, but
+// views over it must be recreated when the WASM heap grows.
+extern "C" {
+EMSCRIPTEN_KEEPALIVE const char* termesh_frame_data() {
+    return activeState ? screen(activeState).data() : nullptr;
+}
+
+EMSCRIPTEN_KEEPALIVE int termesh_frame_stride() {
+    return activeState ? screen(activeState).stride() : 0;
+}
+
+EMSCRIPTEN_KEEPALIVE int termesh_frame_width() {
+    return activeState ? screen(activeState).width() : 0;
+}
+
+EMSCRIPTEN_KEEPALIVE int termesh_frame_height() {
+    return activeState ? screen(activeState).height() : 0;
+}
+}
+#endif
+
+// Renders the current orientation into the view's frame
+void renderView(GlobalState* state) {
+    RenderContext& view = state->view;
+    
+    // Render the frame; a model still streaming in has no slice index yet
+    if (state->sliceMode && !state->streaming) {
+        view.renderSlice(state->sliceIndex, state->slicePosition, state->sliceCapped);
+        return;
+    }
+
+    // The three-quarter view turns with the camera; the axis views stay put
+    if (state->multiView) {
+        MultiView& multi = *state->multiView;
+        multi.viewports[0].camera = view.camera;
+        multi.render(view.mesh());
+        for (int y = 0; y < view.height(); y++) {
+            view.frame()[y].assign(multi.frame()[y]);
+        }
+        return;
+    }
+
+    // A warm cache turns the frame into a lookup and a copy. Frames of a
+    // partly loaded model are never cached.
+    FrameCache* cache = state->streaming ? nullptr : state->frameCache.get();
+    uint64_t key = 0;
+    if (cache) {
+        key = cache->keyFor(view.camera.rotation());
+        if (cache->lookup(key, view.frame())) return;
+    }
+
+    bool fullQuality = true;
+    if (state->adaptive) {
+        const QualitySettings& quality = state->quality.settings();
+        fullQuality = state->quality.level() == 0;
+        view.render(state->lods.select(view.mesh(), quality.lod), quality);
+        state->quality.update(view.timings().total());
+    } else {
+        view.render();
+    }
+
+    // Reduced-quality frames are not kept; idle precompute fills the cache
+    // at full quality
+    if (cache && fullQuality) {
+        cache->store(key, view.frame());
+    }
+}
+
+// Turns the camera by one frame of auto-rotation
+void advanceCamera(Camera& camera, float speed) {
+    camera.angleX += speed;
+    camera.angleY += speed * 1.3f;
+    camera.angleZ += speed * 0.7f;
+}
+
+// Moves the animation on by one frame
+void advanceAnimation(GlobalState* state) {
+    if (state->sliceMode) {
+        // Bounce the plane between the ends of the model
+        state->slicePosition += state->sliceStep;
+        if (state->slicePosition > state->sliceIndex.maxExtent() ||
+            state->slicePosition < state->sliceIndex.minExtent()) {
+            state->sliceStep = -state->sliceStep;
+            state->slicePosition += 2 * state->sliceStep;
+        }
+    } else if (state->frameCache) {
+        state->precompute.advance();
+    }
+    
+    advanceCamera(state->view.camera, state->rotationSpeed);
+}
+
+// Renders the current frame into the view and advances the animation
+void renderStep(GlobalState* state) {
+    // Recordings decode straight into the buffer, which still holds the
+    // previous frame for the deltas to patch
+    if (state->playing) {
+        state->player.next(state->view.frame());
+        return;
+    }
+    
+    renderView(state);
+    
+    if (state->recorder) {
+        state->recorder->addFrame(state->view.frame());
+    }
+    
+    advanceAnimation(state);
+}
+
+// Spends idle time rendering the upcoming frames of the animation
+void precomputeIdle(GlobalState* state, double budgetSeconds) {
+    if (!state->frameCache || state->sliceMode || state->playing || state->streaming ||
+        budgetSeconds <= 0.0) return;
+    state->precompute.run(state->view.mesh(), state->view.lightDir, *state->frameCache, budgetSeconds);
+}
+
+#ifdef __EMSCRIPTEN__
+// Sends a frame to the page through the selected output
+void present(GlobalState* state, const std::vector<std::string>& frame) {
+    TERMESH_TRACE_SCOPE("present");
+    state->view.sink()->present(frame);
+    state->framesPresented++;
+}
+
+// Renders the frame the scheduler asked for into the view
+void renderScheduled(GlobalState* state) {
+    TERMESH_TRACE_SCOPE("renderScheduled");
+    if (state->scheduler.isAnimating()) {
+        renderStep(state);
+    } else if (!state->playing) {
+        // A paused recording keeps the frame it stopped on
+        renderView(state);
+    }
+}
+
+#ifdef TERMESH_THREADS
+// Render thread: renders and publishes the next frame if the scheduler wants
+// one. Returns false when there is nothing to do. The state lock is held only
+// to copy what the frame is drawn from and to store the result, so the
+// browser thread can turn the view or read stats while the frame renders;
+// `renderMutex` keeps the model and what is built from it in place meanwhile.
+bool renderOnWorker(GlobalState* state) {
+    std::lock_guard<std::mutex> renderLock(state->renderMutex);
+    RenderContext& view = state->workerView;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (!state->view.hasMesh() && !state->playing) return false;
+    if (!state->scheduler.tick()) return false;
+
+    // Recordings decode straight into the presented view's frame; a paused
+    // recording keeps the frame it stopped on
+    if (state->playing) {
+        if (state->scheduler.isAnimating()) state->player.next(state->view.frame());
+        state->frames.publish(state->view.frame());
+        state->scheduler.rendered();
+        return true;
+    }
+
+    TERMESH_TRACE_SCOPE("renderOnWorker");
+    const RenderContext& source = state->view;
+    if (view.width() != source.width() || view.height() != source.height()) {
+        view.resize(source.width(), source.height());
+    }
+    view.setMesh(state->model);
+    view.camera = source.camera;
+    view.lightDir = source.lightDir;
+    const bool slice = state->sliceMode && !state->streaming;
+    const float slicePosition = state->slicePosition;
+    const bool sliceCapped = state->sliceCapped;
+    const bool adaptive = state->adaptive;
+    const QualitySettings quality = state->quality.settings();
+    const bool fullQuality = !adaptive || state->quality.level() == 0;
+
+    // A warm cache turns the frame into a lookup and a copy. Frames of a
+    // partly loaded model are never cached.
+    FrameCache* cache = slice || state->multiView || state->streaming ? nullptr : state->frameCache.get();
+    uint64_t key = 0;
+    bool hit = false;
+    if (cache) {
+        key = cache->keyFor(view.camera.rotation());
+        hit = cache->lookup(key, view.frame());
+    }
+    state->scheduler.captured();
+    lock.unlock();
+
+    // A model still streaming in has no slice index yet; the three-quarter
+    // view turns with the camera while the axis views stay put
+    if (slice) {
+        view.renderSlice(state->sliceIndex, slicePosition, sliceCapped);
+    } else if (state->multiView) {
+        MultiView& multi = *state->multiView;
+        multi.viewports[0].camera = view.camera;
+        multi.render(view.mesh());
+        for (int y = 0; y < view.height(); y++) {
+            view.frame()[y].assign(multi.frame()[y]);
+        }
+    } else if (adaptive && !hit) {
+        view.render(state->lods.select(view.mesh(), quality.lod), quality);
+    } else if (!hit) {
+        view.render();
+    }
+
+    lock.lock();
+    if (adaptive && !slice && !state->multiView && !hit) {
+        state->quality.update(view.timings().total());
+        state->workerTimings = view.timings();
+    }
+    // A frame lit or shaped the old way is not kept once that has changed
+    if (cache && fullQuality && !hit && !(state->scheduler.dirtyFlags() & ~DIRTY_ORIENTATION)) {
+        cache->store(key, view.frame());
+    }
+    if (state->recorder) state->recorder->addFrame(view.frame());
+    state->frames.publish(view.frame());
+    if (state->scheduler.isAnimating()) advanceAnimation(state);
+    state->scheduler.rendered();
+    // Lets a replaced model be freed while the thread sleeps
+    view.setMesh(nullptr);
+    return true;
+}
+
+// Render thread, between paced frames: renders ahead into the frame cache
+// for at most `seconds`. Like renderOnWorker() it holds the state lock only
+// to pick the next orientation and to store its frame; a restart of the
+// lookahead meanwhile (a turn, a new light) drops the frame.
+void precomputeOnWorker(GlobalState* state, double seconds) {
+    using Clock = std::chrono::steady_clock;
+    const double budget = std::min(seconds - 0.002, PRECOMPUTE_BUDGET_SECONDS);
+    const Clock::time_point start = Clock::now();
+    std::lock_guard<std::mutex> renderLock(state->renderMutex);
+    TurntablePrecompute& precompute = state->precompute;
+    while (std::chrono::duration<double>(Clock::now() - start).count() < budget) {
+        TurntablePrecompute::Step step;
+        MeshRef mesh;
+        Vec3 lightDir;
+        {
+            StateLock lock(state->mutex);
+            if (!state->frameCache || !state->scheduler.isAnimating() || !state->scheduler.isVisible() ||
+                state->sliceMode || state->playing || state->streaming || !state->view.hasMesh()) {
+                return;
+            }
+            if (!precompute.nextStep(*state->frameCache, step)) return;
+            mesh = state->model;
+            lightDir = state->view.lightDir;
+        }
+        precompute.renderStep(*mesh, lightDir, step);
+        StateLock lock(state->mutex);
+        precompute.finishStep(step, *state->frameCache);
+    }
+}
 
-// This becomes our new "main loop"
+// Called by the browser once per frame. It only presents what the render
+// thread has finished, so a heavy model never blocks the page.
 void main_loop(void* arg) {
+    TERMESH_TRACE_SCOPE("main_loop");
     GlobalState* state = static_cast<GlobalState*>(arg);
+    // Read before acquiring: whatever the thread rendered before going idle
+    // is already published
+    bool idle = state->renderThread->idle();
+    if (state->frames.acquire(state->presented)) {
+        present(state, state->presented);
+    }
+
+    // Nothing left to show: stop the browser callback until the next change
+    if (idle && !state->frames.pending()) {
+        emscripten_cancel_main_loop();
+        state->loopActive = false;
+    }
+}
+
+// Hands new work to the render thread and makes sure its frames get shown
+void wake(GlobalState* state) {
+    state->renderThread->wake();
+    if (state->loopActive) return;
+    emscripten_set_main_loop_arg(main_loop, state, state->loopFps, 0);
+    state->loopActive = true;
+}
+#else
+// Called by the browser once per frame while the scheduler wants ticks
+void main_loop(void* arg) {
+    TERMESH_TRACE_SCOPE("main_loop");
+    GlobalState* state = static_cast<GlobalState*>(arg);
+    if (state->scheduler.tick()) {
+        renderScheduled(state);
+        present(state, state->view.frame());
+        state->scheduler.rendered();
+    }
+
+    // Nothing left to draw: stop the browser callback until the next change
+    if (!state->scheduler.wantsTicks()) {
+        emscripten_cancel_main_loop();
+        state->loopActive = false;
+        return;
+    }
+    if (state->scheduler.isAnimating()) {
+        precomputeIdle(state, PRECOMPUTE_BUDGET_SECONDS);
+    }
+}
+
+// Restarts the browser callback if the scheduler has work for it
+void wake(GlobalState* state) {
+    if (state->loopActive || !state->scheduler.wantsTicks()) return;
+    emscripten_set_main_loop_arg(main_loop, state, state->loopFps, 0);
+    state->loopActive = true;
+}
+#endif
+
+// Cancels the browser callback; wake() brings it back
+void suspend(GlobalState* state) {
+    if (!state->loopActive) return;
+    emscripten_cancel_main_loop();
+    state->loopActive = false;
+}
+#else
+namespace {
+    volatile std::sig_atomic_t running = 1;
+
+    void stopRunning(int) {
+        running = 0;
+    }
+
+    // Renders at a fixed frame rate into the terminal until interrupted
+    // or until `frames` frames have been shown (0 = forever)
+    void runTerminal(GlobalState* state, int fps, long frames) {
+        int width = state->view.width(), height = state->view.height();
+        int termWidth, termHeight;
+        if (terminalSize(STDOUT_FILENO, termWidth, termHeight)) {
+            // Keep the last line free so the terminal never scrolls
+            width = std::min(width, termWidth);
+            height = std::min(height, termHeight - 1);
+        }
+
+        std::signal(SIGINT, stopRunning);
+        std::signal(SIGTERM, stopRunning);
+
+        TerminalOutput terminal(width, height, STDOUT_FILENO);
+        state->view.setSink(&terminal);
+        const long period = 1000000000L / fps;
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+
+        for (long frame = 0; running && (frames == 0 || frame < frames); frame++) {
+            renderStep(state);
+            state->view.present();
+
+            // Absolute deadlines so render time does not drift the frame rate
+            next.tv_nsec += period;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+
+            // Render ahead until shortly before the next frame is due
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double idle = (double)(next.tv_sec - now.tv_sec) + (next.tv_nsec - now.tv_nsec) * 1e-9;
+            precomputeIdle(state, idle - 0.002);
+
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+
+        state->view.setSink(nullptr);
+        size_t shown = std::max<size_t>(1, terminal.frames());
+        logError("\n%zu frames, %zu bytes/frame written", terminal.frames(), terminal.bytesWritten() / shown);
+        if (state->frameCache) {
+            const FrameCacheStats& stats = state->frameCache->stats;
+            logError("frame cache: %zu hits, %zu misses, %zu frames (%zu KiB)", stats.hits, stats.misses,
+                     state->frameCache->frames(), state->frameCache->bytes() / 1024);
+        }
+        if (state->adaptive) {
+            const StageTimings& t = state->view.timings();
+            logError("quality: level %d, %g ms/frame (budget %g ms; last frame clear %g, geometry %g, raster %g ms)",
+                     state->quality.level(), state->quality.averageSeconds() * 1000,
+                     state->quality.budget() * 1000, t.clear * 1000, t.geometry * 1000, t.raster * 1000);
+        }
+    }
+
+    // Renders `frames` turntable frames headless, first one at a time on this
+    // thread, then through the frame pipeline, and reports both
+    void runBenchmark(GlobalState* state, long frames, int inFlight) {
+        const int width = state->view.width(), height = state->view.height();
+        const Camera start = state->view.camera;
+        using Clock = std::chrono::steady_clock;
+
+        RenderContext serial(width, height);
+        serial.setMesh(state->model);
+        serial.camera = start;
+        Clock::time_point begin = Clock::now();
+        for (long frame = 0; frame < frames; frame++) {
+            serial.render();
+            advanceCamera(serial.camera, state->rotationSpeed);
+        }
+        double serialSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        logError("serial: %ld frames (%dx%d, %zu triangles) in %d ms, %d fps", frames, width, height,
+                 state->model->size(), (int)(serialSeconds * 1000), (int)(frames / serialSeconds));
+
+        // The four views of --multiview, each the size of the frame: one
+        // multi-view frame against a render per view
+        MultiView multi(2 * width + 1, 2 * height + 1);
+        multi.viewports = axisViewports(multi.width(), multi.height());
+        begin = Clock::now();
+        for (long frame = 0; frame < frames; frame++) {
+            multi.render(*state->model);
+            advanceCamera(multi.viewports[0].camera, state->rotationSpeed);
+        }
+        double multiSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        std::vector<Viewport> views = axisViewports(multi.width(), multi.height());
+        begin = Clock::now();
+        for (long frame = 0; frame < frames; frame++) {
+            for (const Viewport& viewport : views) {
+                serial.camera = viewport.camera;
+                serial.render();
+            }
+            advanceCamera(views[0].camera, state->rotationSpeed);
+        }
+        double separateSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        logError("multiview: 4 views in %.2f ms/frame, %.2fx one view (4 renders: %.2f ms/frame)",
+                 multiSeconds * 1000 / frames, multiSeconds * 4 / separateSeconds,
+                 separateSeconds * 1000 / frames);
+
+        if (!state->jobs) {
+            logError("pipelined: skipped, no worker threads (one core, or --threads 1)");
+            return;
+        }
+        PipelineStats stats;
+        int peak;
+        {
+            FramePipeline pipeline(*state->jobs, width, height, inFlight);
+            Camera camera = start;
+            for (long frame = 0; frame < frames; frame++) {
+                pipeline.submit(state->model, camera, state->view.lightDir, nullptr);
+                advanceCamera(camera, state->rotationSpeed);
+            }
+            pipeline.flush();
+            stats = pipeline.stats();
+            peak = pipeline.peakInFlight();
+        }
+        double busy = 0.0;
+        for (int stage = 0; stage < PIPELINE_STAGE_COUNT; stage++) {
+            busy += stats.utilisation((PipelineStage)stage);
+        }
+        logError("pipelined: %zu frames in %d ms, %d fps (%.2fx) on %d threads, %d frames in flight",
+                 stats.frames, (int)(stats.wallSeconds * 1000), (int)stats.fps(),
+                 serialSeconds / stats.wallSeconds, stats.threads, peak);
+        logError("utilisation: geometry %d%%, raster %d%%, output %d%%, idle %d%%; %zu jobs stolen",
+                 (int)(stats.utilisation(STAGE_GEOMETRY) * 100), (int)(stats.utilisation(STAGE_RASTER) * 100),
+                 (int)(stats.utilisation(STAGE_OUTPUT) * 100), (int)(std::max(0.0, 1.0 - busy) * 100),
+                 stats.stolen);
+    }
+
+    // Renders previews of every model in `inputs` and reports throughput and
+    // each file that failed; 0 if every model was rendered
+    int runThumbnails(const std::vector<std::string>& inputs, const ThumbnailOptions& options) {
+        std::vector<std::string> paths;
+        std::vector<ThumbnailFailure> failures;
+        collectStlFiles(inputs, paths, failures);
+        if (paths.empty() && failures.empty()) {
+            logError("Usage: stl_renderer --thumbnails DIR [--views N] [--memory-mb N] (model.stl | dir | @list)...");
+            return 1;
+        }
+
+        ThumbnailStats stats = renderThumbnails(paths, options);
+        failures.insert(failures.end(), stats.failures.begin(), stats.failures.end());
+        for (const auto& failure : failures) {
+            logError("%s: %s", failure.path.c_str(), failure.reason.c_str());
+        }
+        logError("thumbnails: %zu of %zu models (%zu triangles) to %zu files in %s in %d ms on %d threads",
+                 stats.models, paths.size(), stats.triangles, stats.files, options.outputDir.c_str(),
+                 (int)(stats.seconds * 1000), stats.threads);
+        logError("throughput: %.1f models/s, %.0f triangles/s; load %d ms, render %d ms over all threads; "
+                 "peak %zu KiB of models in memory; %zu failed",
+                 stats.modelsPerSecond(), stats.trianglesPerSecond(), (int)(stats.loadSeconds * 1000),
+                 (int)(stats.renderSeconds * 1000), stats.peakBytes / 1024, failures.size());
+        return failures.empty() ? 0 : 1;
+    }
+
+    RenderServer* activeServer = nullptr;
+
+    void stopServing(int) {
+        if (activeServer) activeServer->stop();
+    }
+
+    // Serves render requests on `socketPath` until interrupted
+    int runServer(const std::string& socketPath, const ServerOptions& options) {
+        RenderServer server(options);
+        if (!server.listen(socketPath)) return 1;
+        activeServer = &server;
+        std::signal(SIGINT, stopServing);
+        std::signal(SIGTERM, stopServing);
+        logError("Serving on %s (mesh cache %zu MiB)", socketPath.c_str(), options.cacheBytes >> 20);
+        server.run();
+        activeServer = nullptr;
+
+        ServerStats stats = server.stats();
+        logError("served %zu requests (%zu errors) in %zu batches, largest %zu; %zu models parsed, "
+                 "mesh cache %zu hits, %zu misses, %zu evictions",
+                 stats.requests, stats.errors, stats.batches, stats.largestBatch, stats.loads,
+                 stats.cache.hits, stats.cache.misses, stats.cache.evictions);
+        return 0;
+    }
+
+    // Measures a running server with the models in `inputs`
+    int runLoad(const std::vector<std::string>& inputs, LoadOptions options) {
+        std::vector<ThumbnailFailure> unreadable;
+        collectStlFiles(inputs, options.models, unreadable);
+        if (options.models.empty()) {
+            logError("Usage: stl_renderer --load SOCKET [--connections N] [--requests N] [--send-bytes] "
+                     "(model.stl | dir | @list)...");
+            return 1;
+        }
+
+        LoadStats stats = runLoadGenerator(options);
+        logError("load: %zu requests (%zu failed) over %d connections in %d ms: %.0f requests/s, "
+                 "p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                 stats.requests, stats.failures, options.connections, (int)(stats.seconds * 1000),
+                 stats.requestsPerSecond(), stats.p50Ms, stats.p99Ms, stats.maxMs);
+        if (stats.failures > 0) logError("first failure: %s", stats.firstError.c_str());
+
+        RenderClient client;
+        std::string line;
+        if (client.connect(options.socketPath) && client.stats(line)) logError("server: %s", line.c_str());
+        return stats.failures == 0 ? 0 : 1;
+    }
+
+    // Current and peak memory of each subsystem, at the end of a run
+    // (--memory-report)
+    void logMemoryReport() {
+        for (const std::string& line : memoryReport()) logError("memory: %s", line.c_str());
+    }
+
+    // Records the run and writes it as a Chrome trace when main() returns
+    // (--trace FILE)
+    struct TraceWriter {
+        const char* path = nullptr;
+
+        void start(const char* file) {
+            path = file;
+            setTracing(true);
+        }
+
+        ~TraceWriter() {
+            if (!path) return;
+            setTracing(false);
+            if (saveTrace(path)) {
+                logError("Trace written to %s (open in chrome://tracing or ui.perfetto.dev)", path);
+            } else {
+                logError("Failed to write trace %s", path);
+            }
+        }
+    };
+} // anonymous namespace
+#endif
+
+// Indexes triangle extents once so each slice only visits the triangles it cuts
+void prepareSlicing(GlobalState* state) {
+    if (!state->sliceMode || !state->view.hasMesh()) return;
+    state->sliceIndex.build(state->view.mesh(), state->sliceAxis);
+    state->slicePosition = state->sliceIndex.minExtent();
+    state->sliceStep = (state->sliceIndex.maxExtent() - state->sliceIndex.minExtent()) / SLICE_SWEEP_FRAMES;
+}
+
+// Builds the decimated meshes adaptive quality falls back to
+void prepareQuality(GlobalState* state) {
+    if (state->adaptive && state->view.hasMesh()) {
+        state->lods.build(state->view.mesh());
+    } else {
+        state->lods.clear();
+    }
+}
+
+// Prepares a freshly loaded, normalized model for rendering
+void prepareModel(GlobalState* state) {
+    prepareSlicing(state);
+    prepareQuality(state);
     
-    // Clear buffers
-    clearBuffers(state->buffer, state->zbuffer);
-    
-    // Create rotation matrix
-    Mat3 rotation = rotationX(state->angleX) * rotationY(state->angleY) * rotationZ(state->angleZ);
+    // Light direction
+    state->view.lightDir = defaultLightDir();
     
-    // Render the frame
-    renderFrame(state->buffer, state->zbuffer, state->triangles, rotation, state->lightDir);
+    // Cached frames belong to the previous model
+    if (state->frameCache) {
+        const Camera& camera = state->view.camera;
+        state->frameCache->clear();
+        state->precompute.restart(camera.angleX, camera.angleY, camera.angleZ, state->rotationSpeed);
+    }
+}
+
+// Accounts the model's current size
+void trackModel(GlobalState* state) {
+    state->modelMemory.set(vectorBytes(*state->model));
+}
+
+// Replaces the model the view renders
+void replaceModel(GlobalState* state, std::vector<Triangle> triangles) {
+    state->model = std::make_shared<std::vector<Triangle>>(std::move(triangles));
+    state->view.setMesh(state->model);
+    trackModel(state);
+}
+
+// Renders frames of width x height cells from now on
+void resizeView(GlobalState* state, int width, int height) {
+    if (width == state->view.width() && height == state->view.height()) return;
+    state->view.resize(width, height);
+    state->precompute.resize(width, height);
+    if (state->multiView) {
+        state->multiView->resize(width, height);
+        state->multiView->viewports = axisViewports(width, height);
+    }
+    // Cached frames have the old size
+    if (state->frameCache) state->frameCache->clear();
+#ifdef __EMSCRIPTEN__
+    if (state->textOutput) setOutput(state, state->canvasOutput != nullptr);
+#endif
+}
+
+// Loads, normalizes and prepares a model for rendering
+bool loadModel(GlobalState* state, const char* filename) {
+    state->streaming = false;
+    // Free what was built for the current model before parsing the next
+    replaceModel(state, {});
+    state->lods.clear();
+    state->sliceIndex = SliceIndex();
+    replaceModel(state, loadSTL(filename));
+    if (!state->view.hasMesh()) {
+        logError("Failed to load model or model is empty.");
+        return false;
+    }
     
-    // Print the result (this function will be modified next)
-    printBuffer(state->buffer);
+    // Normalize model
+    float modelScale;
+    normalizeModel(*state->model, modelScale);
     
-    // Update rotation angles
-    state->angleX += state->rotationSpeed;
-    state->angleY += state->rotationSpeed * 1.3f;
-    state->angleZ += state->rotationSpeed * 0.7f;
+    prepareModel(state);
+    return true;
+}
+
+#ifdef __EMSCRIPTEN__
+// Engine API for the page. main() creates the engine once; models are then
+// swapped in and out without reloading the module, reusing its buffers.
+// In the threads build these run on the browser thread and take the state
+// lock; those that change the model, its slice index or LOD levels, or the
+// frame size take ModelLock, which waits for the frame being rendered.
+namespace {
+    void setView(GlobalState* state, float angleX, float angleY, float angleZ) {
+        state->view.camera = Camera{angleX, angleY, angleZ};
+        state->precompute.restart(angleX, angleY, angleZ, state->rotationSpeed);
+        state->scheduler.invalidate(DIRTY_ORIENTATION);
+        wake(state);
+    }
+
+    void setAutoRotate(GlobalState* state, bool on) {
+        if (on && !state->scheduler.isAnimating()) {
+            const Camera& camera = state->view.camera;
+            state->precompute.restart(camera.angleX, camera.angleY, camera.angleZ,
+                                      state->rotationSpeed);
+        }
+        state->scheduler.setAnimating(on);
+        wake(state);
+    }
+} // anonymous namespace
+
+extern "C" {
+// Loads an STL file from the virtual filesystem and shows it from the start
+// of the animation. Returns 0 if the file is not a usable model, or -1,
+// keeping the current model, if it would not fit in the memory budget.
+EMSCRIPTEN_KEEPALIVE int termesh_load_model(const char* path) {
+    TERMESH_TRACE_SCOPE("termesh_load_model");
+    if (!activeState) return 0;
+    ModelLock lock(activeState);
+    if (!modelFitsMemoryBudget(path, activeState->memoryBudget)) return -1;
+    activeState->playing = false;
+    activeState->view.camera = Camera();
+    // The page may have drawn status text over the previous frame
+    screen(activeState).invalidate();
+    if (!loadModel(activeState, path)) return 0;
+    activeState->scheduler.invalidate(DIRTY_MODEL);
+    wake(activeState);
+    return 1;
+}
+
+// Starts loading a model from chunks as they download. `totalBytes` is the
+// file size if known (0 otherwise). Frames show the triangles received so
+// far, so the first one appears as soon as the first chunk is parsed.
+// Returns 0, keeping the current model, if a file of that size would not
+// fit in the memory budget.
+EMSCRIPTEN_KEEPALIVE int termesh_stream_begin(int totalBytes) {
+    if (!activeState) return 0;
+    ModelLock lock(activeState);
+    size_t total = totalBytes > 0 ? (size_t)totalBytes : 0;
+    // Estimated as binary until the header shows an ASCII file
+    if (!fitsMemoryBudget(estimateLoad(total, false, true), activeState->memoryBudget)) return 0;
+    activeState->playing = false;
+    activeState->view.camera = Camera();
+    screen(activeState).invalidate();
+    replaceModel(activeState, {});
+    activeState->lods.clear();
+    activeState->sliceIndex = SliceIndex();
+    activeState->view.lightDir = defaultLightDir();
+    activeState->stream.begin(total, activeState->memoryBudget);
+    activeState->streaming = true;
+    activeState->scheduler.invalidate(DIRTY_MODEL);
+    wake(activeState);
+    return 1;
 }
 
+// Staging buffer for the next chunk of `size` bytes. The page copies the
+// chunk here and calls termesh_stream_chunk(); views over it must be
+// recreated after the call, since the heap may grow.
+EMSCRIPTEN_KEEPALIVE uint8_t* termesh_stream_buffer(int size) {
+    if (!activeState || size <= 0) return nullptr;
+    StateLock lock(activeState->mutex);
+    if (activeState->streamChunk.size() < (size_t)size) {
+        activeState->streamChunk.resize(size);
+        activeState->streamChunkMemory.set(vectorBytes(activeState->streamChunk));
+    }
+    return activeState->streamChunk.data();
+}
+
+// Parses the `size` bytes in the staging buffer. Returns the number of
+// triangles loaded so far, or -1 if the data is not an STL file or the
+// model it announces would not fit in the memory budget.
+EMSCRIPTEN_KEEPALIVE int termesh_stream_chunk(int size) {
+    TERMESH_TRACE_SCOPE("termesh_stream_chunk");
+    if (!activeState) return -1;
+    ModelLock lock(activeState);
+    if (!activeState->streaming) return -1;
+    size_t bytes = std::min((size_t)std::max(size, 0), activeState->streamChunk.size());
+    std::vector<Triangle>& model = *activeState->model;
+    size_t before = model.size();
+    if (!activeState->stream.feed(activeState->streamChunk.data(), bytes, model)) {
+        // Not STL, or over the memory budget: drop what was buffered
+        activeState->streaming = false;
+        activeState->stream = StlStream();
+        return -1;
+    }
+    trackModel(activeState);
+    if (model.size() != before) {
+        activeState->scheduler.invalidate(DIRTY_MODEL);
+        wake(activeState);
+    }
+    return (int)model.size();
+}
+
+// Ends the stream: applies the final fit and prepares slicing, quality
+// levels and the cache as termesh_load_model() does. Returns 0 if the
+// stream was truncated or empty.
+EMSCRIPTEN_KEEPALIVE int termesh_stream_end() {
+    TERMESH_TRACE_SCOPE("termesh_stream_end");
+    if (!activeState) return 0;
+    ModelLock lock(activeState);
+    if (!activeState->streaming) return 0;
+    activeState->streaming = false;
+    activeState->streamChunk = std::vector<uint8_t>();
+    activeState->streamChunkMemory.set(0);
+    float modelScale;
+    bool finished = activeState->stream.finish(*activeState->model, modelScale);
+    if (!finished) activeState->model->clear();
+    trackModel(activeState);
+    if (!finished) return 0;
+    prepareModel(activeState);
+    activeState->scheduler.invalidate(DIRTY_MODEL);
+    wake(activeState);
+    return 1;
+}
+
+// Replaces the model with a recorded frame stream. Returns 0 on a bad file.
+EMSCRIPTEN_KEEPALIVE int termesh_play(const char* path) {
+    TERMESH_TRACE_SCOPE("termesh_play");
+    if (!activeState) return 0;
+    ModelLock lock(activeState);
+    if (!activeState->player.loadFile(path)) return 0;
+    activeState->playing = true;
+    activeState->streaming = false;
+    resizeView(activeState, activeState->player.width(), activeState->player.height());
+    screen(activeState).invalidate();
+    replaceModel(activeState, {});
+    if (activeState->frameCache) activeState->frameCache->clear();
+    activeState->scheduler.invalidate(DIRTY_MODEL);
+    wake(activeState);
+    return 1;
+}
+
+// Stops rendering and drops the model; buffers are kept for the next one
+EMSCRIPTEN_KEEPALIVE void termesh_unload_model() {
+    if (!activeState) return;
+    ModelLock lock(activeState);
+    suspend(activeState);
+    replaceModel(activeState, {});
+    activeState->playing = false;
+    activeState->streaming = false;
+    if (activeState->frameCache) activeState->frameCache->clear();
+}
+
+// Sets the orientation shown by the next frame
+EMSCRIPTEN_KEEPALIVE void termesh_set_view(float angleX, float angleY, float angleZ) {
+    TERMESH_TRACE_SCOPE("termesh_set_view");
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    setView(activeState, angleX, angleY, angleZ);
+}
+
+// Turns the view by the given angles, e.g. from a pointer drag
+EMSCRIPTEN_KEEPALIVE void termesh_rotate_view(float deltaX, float deltaY, float deltaZ) {
+    TERMESH_TRACE_SCOPE("termesh_rotate_view");
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    const Camera& camera = activeState->view.camera;
+    setView(activeState, camera.angleX + deltaX, camera.angleY + deltaY, camera.angleZ + deltaZ);
+}
+
+// Points the light along (x, y, z); cached frames were lit the old way
+EMSCRIPTEN_KEEPALIVE void termesh_set_light(float x, float y, float z) {
+    if (!activeState) return;
+    Vec3 direction(x, y, z);
+    if (direction.length() == 0.0f) return;
+    StateLock lock(activeState->mutex);
+    activeState->view.lightDir = direction.normalize();
+    if (activeState->frameCache) {
+        const Camera& camera = activeState->view.camera;
+        activeState->frameCache->clear();
+        activeState->precompute.restart(camera.angleX, camera.angleY, camera.angleZ,
+                                        activeState->rotationSpeed);
+    }
+    activeState->scheduler.invalidate(DIRTY_LIGHT);
+    wake(activeState);
+}
+
+// Auto-rotation (or playback of a recording) renders a frame every tick;
+// without it frames are drawn only when something changes
+EMSCRIPTEN_KEEPALIVE void termesh_set_auto_rotate(int on) {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    setAutoRotate(activeState, on != 0);
+}
+
+// Hidden pages render nothing; changes made meanwhile are drawn on return
+EMSCRIPTEN_KEEPALIVE void termesh_set_visible(int visible) {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    activeState->scheduler.setVisible(visible != 0);
+    if (visible) {
+        wake(activeState);
+    } else {
+        suspend(activeState);
+    }
+}
+
+// 0 = solid, 1 = cross-section contour, 2 = capped cross-section
+EMSCRIPTEN_KEEPALIVE void termesh_set_render_mode(int mode) {
+    if (!activeState) return;
+    ModelLock lock(activeState);
+    activeState->sliceMode = mode != 0;
+    activeState->sliceCapped = mode == 2;
+    prepareSlicing(activeState);
+    activeState->scheduler.invalidate(DIRTY_MODE);
+    wake(activeState);
+}
+
+// Presents frames as canvas pixels (1) or text rows (0)
+EMSCRIPTEN_KEEPALIVE void termesh_set_output(int canvas) {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    setOutput(activeState, canvas != 0);
+    activeState->scheduler.invalidate(DIRTY_SIZE);
+    wake(activeState);
+}
+
+// Renders frames of `cols` x `rows` character cells from now on
+EMSCRIPTEN_KEEPALIVE void termesh_set_size(int cols, int rows) {
+    TERMESH_TRACE_SCOPE("termesh_set_size");
+    if (!activeState || cols <= 0 || rows <= 0) return;
+    ModelLock lock(activeState);
+    // A recording keeps the size it was recorded at
+    if (activeState->playing) return;
+    resizeView(activeState, cols, rows);
+    activeState->scheduler.invalidate(DIRTY_SIZE);
+    wake(activeState);
+}
+
+// Renders and presents the current view once, without advancing the animation
+EMSCRIPTEN_KEEPALIVE void termesh_render_frame() {
+    TERMESH_TRACE_SCOPE("termesh_render_frame");
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+#ifdef TERMESH_THREADS
+    // The render thread draws it; the next browser frame shows it
+    activeState->scheduler.invalidate(DIRTY_ORIENTATION);
+    wake(activeState);
+#else
+    if (activeState->playing) {
+        activeState->player.next(activeState->view.frame());
+    } else if (activeState->view.hasMesh()) {
+        renderView(activeState);
+    }
+    present(activeState, activeState->view.frame());
+    activeState->scheduler.rendered();
+#endif
+}
+
+// Holds live renders to `budgetMs` per frame by lowering quality (0 = always
+// full quality)
+EMSCRIPTEN_KEEPALIVE void termesh_set_frame_budget(float budgetMs) {
+    if (!activeState) return;
+    ModelLock lock(activeState);
+    activeState->adaptive = budgetMs > 0.0f;
+    activeState->quality.setBudget(budgetMs / 1000.0);
+    prepareQuality(activeState);
+    activeState->scheduler.invalidate(DIRTY_MODE);
+    wake(activeState);
+}
+
+// Quality level and the last measured frame, as QUALITY_STAT_COUNT floats:
+// level, budget, smoothed frame time, then the clear, geometry and raster
+// stages of the last rendered frame (times in milliseconds)
+EMSCRIPTEN_KEEPALIVE const float* termesh_quality_stats() {
+    static float stats[QUALITY_STAT_COUNT];
+    if (!activeState) return stats;
+    StateLock lock(activeState->mutex);
+#ifdef TERMESH_THREADS
+    const StageTimings& t = activeState->workerTimings;
+#else
+    const StageTimings& t = activeState->view.timings();
+#endif
+    stats[0] = (float)activeState->quality.level();
+    stats[1] = (float)(activeState->quality.budget() * 1000);
+    stats[2] = (float)(activeState->quality.averageSeconds() * 1000);
+    stats[3] = (float)(t.clear * 1000);
+    stats[4] = (float)(t.geometry * 1000);
+    stats[5] = (float)(t.raster * 1000);
+    return stats;
+}
+
+// Frames rendered so far, on whichever thread renders them
+EMSCRIPTEN_KEEPALIVE int termesh_frames_rendered() {
+    if (!activeState) return 0;
+    StateLock lock(activeState->mutex);
+    return (int)activeState->scheduler.stats.rendered;
+}
+
+// Frames handed to the page so far
+EMSCRIPTEN_KEEPALIVE int termesh_frames_presented() {
+    return activeState ? (int)activeState->framesPresented : 0;
+}
+
+// 1 if frames are rendered off the browser thread
+EMSCRIPTEN_KEEPALIVE int termesh_threaded() {
+#ifdef TERMESH_THREADS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// 1 if the module was built with WebAssembly SIMD
+EMSCRIPTEN_KEEPALIVE int termesh_simd() {
+    return SIMD_ENABLED ? 1 : 0;
+}
+
+// Auto-rotates at `fps` frames per second (0 = every browser frame)
+EMSCRIPTEN_KEEPALIVE void termesh_start_loop(int fps) {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    // Restart so a new rate takes effect
+    suspend(activeState);
+    activeState->loopFps = fps > 0 ? fps : -1;
+#ifdef TERMESH_THREADS
+    activeState->renderThread->setFps(fps);
+#endif
+    setAutoRotate(activeState, true);
+}
+
+// Stops auto-rotation; interactive changes still render on demand
+EMSCRIPTEN_KEEPALIVE void termesh_stop_loop() {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    activeState->scheduler.setAnimating(false);
+    suspend(activeState);
+}
+
+// Starts recording trace spans (see trace.h), dropping any recorded before
+EMSCRIPTEN_KEEPALIVE void termesh_trace_start() {
+    clearTrace();
+    setTracing(true);
+}
+
+// Stops recording; the spans stay for termesh_trace_json()
+EMSCRIPTEN_KEEPALIVE void termesh_trace_stop() {
+    setTracing(false);
+}
+
+// The recorded spans as Chrome trace-event JSON, valid until the next call
+EMSCRIPTEN_KEEPALIVE const char* termesh_trace_json() {
+    static std::string json;
+    json = traceJson();
+    return json.c_str();
+}
+
+// Turns away models estimated to need more than `budgetMb` MiB beside the
+// frame buffers and caches (0 = no limit)
+EMSCRIPTEN_KEEPALIVE void termesh_set_memory_budget(float budgetMb) {
+    if (!activeState) return;
+    StateLock lock(activeState->mutex);
+    activeState->memoryBudget = budgetMb > 0.0f ? (size_t)(budgetMb * (1 << 20)) : 0;
+}
+
+// Memory in MiB, as MEMORY_STAT_COUNT floats: WASM heap, budget, then the
+// current and peak bytes of each MemoryTag in order
+EMSCRIPTEN_KEEPALIVE const float* termesh_memory_stats() {
+    static float stats[MEMORY_STAT_COUNT];
+    const float MIB = 1 << 20;
+    stats[0] = processMemoryBytes() / MIB;
+    stats[1] = activeState ? activeState->memoryBudget / MIB : 0.0f;
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        MemoryUsage usage = memoryUsage((MemoryTag)tag);
+        stats[2 + 2 * tag] = usage.current / MIB;
+        stats[3 + 2 * tag] = usage.peak / MIB;
+    }
+    return stats;
+}
+}
+#endif
+
 // main() is now just for initialization.
 int main(int argc, char* argv[]) {
-    // We'll use Emscripten's virtual filesystem.
-    // We expect the JS host to place the file at "/model.stl"
-    const char* filename = (argc > 1) ? argv[1] : "/model.stl";
+    // In the browser the model lives in Emscripten's virtual filesystem; the
+    // page either passes its path here or loads it later through the API
+    const char* filename = nullptr;
     
+#ifdef __EMSCRIPTEN__
+    // The engine outlives main() and is reused by every later call
+    if (activeState) {
+        logError("Engine already initialized");
+        return 1;
+    }
+#endif
     GlobalState* state = new GlobalState();
+    const char* playPath = nullptr;
+    size_t cacheBytes = FRAME_CACHE_CAPACITY;
+    int width = SCREEN_WIDTH, height = SCREEN_HEIGHT;
+    bool multiView = false;
+#ifdef __EMSCRIPTEN__
+    bool canvas = false;
+#else
+    int fps = 0;
+    long frames = 0;
+    const char* recordPath = nullptr;
+    const char* gifPath = nullptr;
+    int threads = 0;
+    bool benchmark = false;
+    int inFlight = 2;
+    bool memoryReportWanted = false;
+    const char* thumbnailDir = nullptr;
+    ThumbnailOptions thumbnailOptions;
+    std::vector<std::string> inputs;
+    const char* servePath = nullptr;
+    ServerOptions serverOptions;
+    LoadOptions loadOptions;
+    TraceWriter trace;
+#endif
+    setTraceThreadName("main");
     
-    // Load STL file
-    state->triangles = loadSTL(filename);
-    if (state->triangles.empty()) {
-        std::cerr << "Failed to load model or model is empty." << std::endl;
+    // Options: --slice (contour only), --cap (capped half-model), --slice-axis x|y|z,
+    // --play FILE (replay a frame stream instead of rendering),
+    // --cache-mb N (frame cache size, 0 disables),
+    // --budget-ms N (adaptive quality holding N ms per frame),
+    // --size WxH (frame size in character cells),
+    // --multiview (three-quarter, front, side and top views in one frame),
+    // --stats (render counters over the top rows; see render_stats.h),
+    // --memory-budget-mb N (refuse models estimated to need more)
+    // Web only: --canvas (bitmap-font pixels instead of text)
+    // Native only: --fps N, --frames N, --record FILE,
+    // --export-gif FILE (headless GIF of the animation),
+    // --threads N (render and export threads, 0 = all cores, 1 = no workers),
+    // --benchmark (headless frame rate and stage utilisation of --frames N
+    // frames), --in-flight N (frames the benchmark pipeline overlaps),
+    // --thumbnails DIR (previews of every model given, each a file, a
+    // directory or @list, as text files in DIR), --views N (orientations per
+    // preview), --memory-mb N (models the batch holds in memory at once),
+    // --serve SOCKET (render daemon on a UNIX socket), --mesh-cache-mb N
+    // (parsed models it keeps), --load SOCKET (load generator against a
+    // daemon, with the models given), --connections N, --requests N,
+    // --send-bytes (send the files rather than their paths), --trace FILE
+    // (Chrome trace of the run, written on exit), --memory-report (memory
+    // per subsystem and its peak, logged on exit)
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--slice") {
+            state->sliceMode = true;
+        } else if (arg == "--cap") {
+            state->sliceMode = true;
+            state->sliceCapped = true;
+        } else if (arg == "--slice-axis" && i + 1 < argc) {
+            std::string axis = argv[++i];
+            state->sliceAxis = axis == "x" ? SliceAxis::X : axis == "y" ? SliceAxis::Y : SliceAxis::Z;
+        } else if (arg == "--play" && i + 1 < argc) {
+            playPath = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            cacheBytes = (size_t)std::max(0, std::atoi(argv[++i])) << 20;
+        } else if (arg == "--budget-ms" && i + 1 < argc) {
+            double budgetMs = std::atof(argv[++i]);
+            state->adaptive = budgetMs > 0.0;
+            state->quality.setBudget(budgetMs / 1000.0);
+        } else if (arg == "--size" && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                width = w;
+                height = h;
+            } else {
+                logError("Ignoring --size %s (expected WxH)", argv[i]);
+            }
+        } else if (arg == "--multiview") {
+            multiView = true;
+        } else if (arg == "--stats") {
+            state->view.statsOverlay = true;
+        } else if (arg == "--memory-budget-mb" && i + 1 < argc) {
+            state->memoryBudget = (size_t)std::max(0, std::atoi(argv[++i])) << 20;
+#ifdef __EMSCRIPTEN__
+        } else if (arg == "--canvas") {
+            canvas = true;
+#else
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = std::max(0L, std::atol(argv[++i]));
+        } else if (arg == "--export-gif" && i + 1 < argc) {
+            gifPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--benchmark") {
+            benchmark = true;
+        } else if (arg == "--in-flight" && i + 1 < argc) {
+            inFlight = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--thumbnails" && i + 1 < argc) {
+            thumbnailDir = argv[++i];
+        } else if (arg == "--views" && i + 1 < argc) {
+            thumbnailOptions.views = std::max(1, std::min(THUMBNAIL_VIEW_COUNT, std::atoi(argv[++i])));
+        } else if (arg == "--memory-mb" && i + 1 < argc) {
+            thumbnailOptions.memoryBytes = (size_t)std::max(1, std::atoi(argv[++i])) << 20;
+        } else if (arg == "--serve" && i + 1 < argc) {
+            servePath = argv[++i];
+        } else if (arg == "--mesh-cache-mb" && i + 1 < argc) {
+            serverOptions.cacheBytes = (size_t)std::max(0, std::atoi(argv[++i])) << 20;
+        } else if (arg == "--load" && i + 1 < argc) {
+            loadOptions.socketPath = argv[++i];
+        } else if (arg == "--connections" && i + 1 < argc) {
+            loadOptions.connections = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--requests" && i + 1 < argc) {
+            loadOptions.requests = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--send-bytes") {
+            loadOptions.sendBytes = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace.start(argv[++i]);
+        } else if (arg == "--memory-report") {
+            memoryReportWanted = true;
+#endif
+        } else {
+            filename = argv[i];
+#ifndef __EMSCRIPTEN__
+            inputs.push_back(argv[i]);
+#endif
+        }
+    }
+    
+    if (playPath) {
+        if (!state->player.loadFile(playPath)) {
+            logError("Failed to load frame stream %s", playPath);
+            return 1;
+        }
+        state->playing = true;
+        logInfo("Playing %d frames from %s", state->player.frames(), playPath);
+    }
+    
+    if (state->view.statsOverlay && !statsCounting()) {
+        logError("--stats: this build counts nothing; rebuild with make STATS=1");
+    }
+
+    // Cached frames hold one view, and would show stale stats
+    if (cacheBytes > 0 && !multiView && !state->view.statsOverlay) {
+        state->frameCache.reset(new FrameCache(cacheBytes));
+    }
+    
+    // Recordings play back at the size they were recorded at
+    if (state->playing) {
+        width = state->player.width();
+        height = state->player.height();
+    }
+    resizeView(state, width, height);
+    if (multiView) {
+        state->multiView.reset(new MultiView(width, height));
+        state->multiView->viewports = axisViewports(width, height);
+    }
+    
+#ifdef __EMSCRIPTEN__
+    setOutput(state, canvas);
+    activeState = state;
+    // With nothing to show yet the page drives the engine through the API
+    bool start = filename || state->playing;
+    if (start) {
+        if (!state->playing &&
+            (!modelFitsMemoryBudget(filename, state->memoryBudget) || !loadModel(state, filename))) {
+            return 1;
+        }
+        logInfo("Starting renderer...");
+        state->scheduler.setAnimating(true);
+    }
+#ifdef TERMESH_THREADS
+    // Frames are split across the cores the render thread leaves free; the
+    // render thread works on its frames too
+    state->jobs.reset(new JobSystem());
+    if (state->jobs->size() > 0) {
+        state->workerView.setJobs(state->jobs.get());
+    } else {
+        state->jobs.reset();
+    }
+    state->workerView.statsOverlay = state->view.statsOverlay;
+    // Started once the model is in place; from here on the state lock guards it
+    state->renderThread.reset(new RenderThread([state] { return renderOnWorker(state); }, state->loopFps,
+                                               [state](double seconds) { precomputeOnWorker(state, seconds); }));
+#endif
+    
+    // Animate at 30 frames a second. main() returns straight away and the
+    // engine stays alive for the exported functions.
+    if (start) {
+        wake(state);
+    }
+#else
+    if (thumbnailDir) {
+        delete state;
+        thumbnailOptions.outputDir = thumbnailDir;
+        thumbnailOptions.threads = threads;
+        thumbnailOptions.cols = width;
+        thumbnailOptions.rows = height;
+        return runThumbnails(inputs, thumbnailOptions);
+    }
+    if (servePath) {
+        delete state;
+        serverOptions.threads = threads;
+        return runServer(servePath, serverOptions);
+    }
+    if (!loadOptions.socketPath.empty()) {
+        loadOptions.cols = width;
+        loadOptions.rows = height;
+        loadOptions.mode = state->sliceCapped ? RenderMode::Cap : state->sliceMode ? RenderMode::Slice
+                                                                                  : RenderMode::Shaded;
+        delete state;
+        return runLoad(inputs, loadOptions);
+    }
+
+    if (!filename && !state->playing) {
+        logError("Usage: stl_renderer model.stl [options]");
+        delete state;
         return 1;
     }
     
-    // Normalize model
-    float modelScale;
-    normalizeModel(state->triangles, modelScale);
+    // Load STL file
+    if (!state->playing &&
+        (!modelFitsMemoryBudget(filename, state->memoryBudget) || !loadModel(state, filename))) {
+        delete state;
+        return 1;
+    }
     
-    // Light direction
-    state->lightDir = Vec3(0.5f, -0.7f, -0.5f).normalize();
+    if (gifPath) {
+        if (state->playing) {
+            logError("--export-gif renders a model, not a frame stream");
+            delete state;
+            return 1;
+        }
+        AnimationOptions options;
+        options.frames = frames > 0 ? (int)frames : options.frames;
+        options.threads = threads;
+        AnimationStats stats;
+        options.cols = state->view.width();
+        options.rows = state->view.height();
+        if (!exportAnimationGif(state->view.mesh(), state->view.lightDir, gifPath, options, &stats)) {
+            logError("Failed to write %s", gifPath);
+            delete state;
+            return 1;
+        }
+        logError("Exported %d frames (%dx%d) to %s: %zu bytes, render %d ms, encode %d ms on %d threads",
+                 options.frames, stats.width, stats.height, gifPath, stats.bytes,
+                 (int)(stats.renderSeconds * 1000), (int)(stats.encodeSeconds * 1000), stats.threads);
+        if (memoryReportWanted) logMemoryReport();
+        delete state;
+        return 0;
+    }
     
-    // Initialize buffers
-    state->buffer.resize(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
-    state->zbuffer.resize(SCREEN_WIDTH * SCREEN_HEIGHT);
+    // The caller takes part in every frame, so N threads means N - 1 workers
+    if (threads != 1) {
+        state->jobs.reset(new JobSystem(threads > 1 ? threads - 1 : 0));
+        if (state->jobs->size() > 0) {
+            state->view.setJobs(state->jobs.get());
+        } else {
+            state->jobs.reset();
+        }
+    }
+
+    if (benchmark) {
+        if (state->playing) {
+            logError("--benchmark renders a model, not a frame stream");
+            delete state;
+            return 1;
+        }
+        runBenchmark(state, frames > 0 ? frames : 240, inFlight);
+        if (memoryReportWanted) logMemoryReport();
+        delete state;
+        return 0;
+    }
+
+    if (recordPath) {
+        state->recorder.reset(new FrameStreamRecorder(state->view.width(), state->view.height(), fps > 0 ? fps : 30));
+    }
+    if (fps == 0) {
+        fps = state->playing ? std::max(1, state->player.fps()) : 30;
+    }
     
-    std::cout << "Starting renderer..." << std::endl;
+    runTerminal(state, fps, frames);
     
-    // Tell Emscripten to call main_loop() forever.
-    // -1 = use browser's requestAnimationFrame()
-    // 1 = simulate infinite loop
-    emscripten_set_main_loop_arg(main_loop, state, 30, 1);    
+    if (state->recorder) {
+        if (!state->recorder->save(recordPath)) {
+            logError("Failed to write frame stream %s", recordPath);
+        } else {
+            logError("Recorded %d frames, %zu bytes to %s", state->recorder->frames(),
+                     state->recorder->size(), recordPath);
+        }
+    }
+    if (memoryReportWanted) logMemoryReport();
+    delete state;
+#endif
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,192 @@
+#include "memory_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "log.h"
+#include "model.h"
+#include "quality.h"
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+const char* const MEMORY_TAG_NAMES[MEMORY_TAG_COUNT] = {
+    "mesh", "acceleration", "framebuffers", "render scratch", "parse scratch", "caches",
+};
+
+namespace {
+    std::atomic<size_t> currentBytes[MEMORY_TAG_COUNT];
+    std::atomic<size_t> peakBytes[MEMORY_TAG_COUNT];
+
+    // normalizeModel() fits the longest side of a model to this many units
+    constexpr float MODEL_SPAN = 30.0f;
+
+    // Vertex clustering leaves about two triangles per grid cell the surface
+    // crosses; a surface crosses at most this many times the cells of the
+    // bounding cube's faces
+    constexpr size_t LOD_SURFACE_FACTOR = 4;
+
+    // Slice index: extents and the sorted order per triangle, each triangle
+    // in two node lists, and at worst a node per triangle
+    constexpr size_t SLICE_INDEX_BYTES_PER_TRIANGLE = 2 * sizeof(float) + 3 * sizeof(uint32_t) + 20;
+
+    double mib(size_t bytes) {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    // Most triangles the LOD levels of a model can hold between them
+    size_t lodTriangles(size_t triangles) {
+        size_t total = 0;
+        for (int lod = 1; lod < LOD_LEVEL_COUNT; lod++) {
+            size_t cells = (size_t)(MODEL_SPAN / LOD_CELL_SIZES[lod]);
+            total += std::min(triangles, LOD_SURFACE_FACTOR * 6 * cells * cells);
+        }
+        return total;
+    }
+} // anonymous namespace
+
+MemoryUsage memoryUsage(MemoryTag tag) {
+    MemoryUsage usage;
+    usage.current = currentBytes[tag].load(std::memory_order_relaxed);
+    usage.peak = peakBytes[tag].load(std::memory_order_relaxed);
+    return usage;
+}
+
+size_t accountedBytes() {
+    size_t total = 0;
+    for (const auto& bytes : currentBytes) total += bytes.load(std::memory_order_relaxed);
+    return total;
+}
+
+void resetMemoryPeaks() {
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        peakBytes[tag].store(currentBytes[tag].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+MemoryAccount& MemoryAccount::operator=(const MemoryAccount& other) {
+    if (this != &other) {
+        set(0);
+        tag = other.tag;
+        set(other.held);
+    }
+    return *this;
+}
+
+MemoryAccount& MemoryAccount::operator=(MemoryAccount&& other) noexcept {
+    if (this != &other) {
+        set(0);
+        tag = other.tag;
+        held = other.held;
+        other.held = 0;
+    }
+    return *this;
+}
+
+void MemoryAccount::set(size_t bytes) {
+    if (bytes == held) return;
+    size_t now;
+    if (bytes > held) {
+        now = currentBytes[tag].fetch_add(bytes - held, std::memory_order_relaxed) + (bytes - held);
+    } else {
+        now = currentBytes[tag].fetch_sub(held - bytes, std::memory_order_relaxed) - (held - bytes);
+    }
+    held = bytes;
+
+    size_t peak = peakBytes[tag].load(std::memory_order_relaxed);
+    while (now > peak && !peakBytes[tag].compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+size_t frameMemoryBytes(const std::vector<std::string>& frame) {
+    size_t bytes = vectorBytes(frame);
+    for (const std::string& line : frame) bytes += line.capacity();
+    return bytes;
+}
+
+size_t processMemoryBytes() {
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_heap_size();
+#elif defined(__linux__)
+    // Second field of statm: resident pages
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    unsigned long size = 0, resident = 0;
+    bool read = std::fscanf(statm, "%lu %lu", &size, &resident) == 2;
+    std::fclose(statm);
+    return read ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+LoadEstimate estimateLoad(size_t fileBytes, bool ascii, bool streamed) {
+    LoadEstimate estimate;
+    if (ascii) {
+        estimate.triangles = fileBytes / ASCII_FACET_MIN_BYTES;
+    } else {
+        estimate.triangles = fileBytes > STL_HEADER_SIZE ? (fileBytes - STL_HEADER_SIZE) / STL_RECORD_SIZE : 0;
+    }
+    estimate.meshBytes = estimate.triangles * sizeof(Triangle);
+
+    if (ascii) {
+        // The whole text, and a vector of unknown size growing by doubling:
+        // up to twice the mesh while the old copy is moved to the new one
+        estimate.scratchBytes = fileBytes + 2 * estimate.meshBytes;
+    } else if (streamed) {
+        // Unnormalized triangles kept beside the preview
+        estimate.scratchBytes = estimate.meshBytes + STL_RECORD_SIZE;
+    } else {
+        estimate.scratchBytes = std::min(fileBytes, STL_RECORDS_PER_READ * STL_RECORD_SIZE);
+    }
+
+    estimate.derivedBytes = lodTriangles(estimate.triangles) * sizeof(Triangle) +
+                            estimate.triangles * SLICE_INDEX_BYTES_PER_TRIANGLE +
+                            estimate.triangles * sizeof(RenderScratch::ScreenTriangle);
+    return estimate;
+}
+
+bool fitsMemoryBudget(const LoadEstimate& estimate, size_t budgetBytes) {
+    if (budgetBytes == 0) return true;
+    size_t kept = memoryUsage(MEMORY_FRAMEBUFFERS).current + memoryUsage(MEMORY_CACHES).current;
+    size_t needed = estimate.total() + kept;
+    if (needed <= budgetBytes) return true;
+    logError("Error: model of about %zu triangles needs %.1f MiB (mesh %.1f, scratch %.1f, derived %.1f, "
+             "buffers and caches %.1f), over the %.1f MiB memory budget",
+             estimate.triangles, mib(needed), mib(estimate.meshBytes), mib(estimate.scratchBytes),
+             mib(estimate.derivedBytes), mib(kept), mib(budgetBytes));
+    return false;
+}
+
+bool modelFitsMemoryBudget(const std::string& path, size_t budgetBytes) {
+    if (budgetBytes == 0) return true;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return true;
+    // Same test as readSTL()
+    uint8_t header[STL_HEADER_SIZE];
+    size_t headerBytes = std::fread(header, 1, STL_HEADER_SIZE, file);
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    if (size < 0) return true;
+    bool ascii = isAsciiStl(header, headerBytes, (size_t)size);
+    return fitsMemoryBudget(estimateLoad((size_t)size, ascii), budgetBytes);
+}
+
+std::vector<std::string> memoryReport() {
+    std::vector<std::string> lines;
+    char line[128];
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        MemoryUsage usage = memoryUsage((MemoryTag)tag);
+        std::snprintf(line, sizeof(line), "%-15s %9.2f MiB  peak %9.2f MiB", MEMORY_TAG_NAMES[tag],
+                      mib(usage.current), mib(usage.peak));
+        lines.push_back(line);
+    }
+    std::snprintf(line, sizeof(line), "%-15s %9.2f MiB", "process", mib(processMemoryBytes()));
+    lines.push_back(line);
+    return lines;
+}
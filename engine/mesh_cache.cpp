@@ -0,0 +1,47 @@
+#include "mesh_cache.h"
+
+MeshCache::MeshCache(size_t capacityBytes) : capacityBytes(capacityBytes) {}
+
+MeshRef MeshCache::lookup(const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    stats.hits++;
+    return entries.front().mesh;
+}
+
+void MeshCache::store(const std::string& key, MeshRef mesh) {
+    if (!mesh) return;
+    size_t size = meshBytes(*mesh);
+    if (size > capacityBytes) return;
+
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        used -= existing->second->bytes;
+        entries.erase(existing->second);
+        index.erase(existing);
+    }
+
+    while (used + size > capacityBytes && !entries.empty()) {
+        used -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        stats.evictions++;
+    }
+
+    entries.push_front({key, std::move(mesh), size});
+    index[key] = entries.begin();
+    used += size;
+    memory.set(used);
+    stats.stored++;
+}
+
+void MeshCache::clear() {
+    entries.clear();
+    index.clear();
+    used = 0;
+    memory.set(0);
+}
@@ -1,104 +1,182 @@
 #include "model.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
 #include <cstdint>  // <-- FIX: Added for uint16_t and uint32_t
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "log.h"
+#include "memory_stats.h"
+#include "trace.h"
 
 namespace {
-    // Read 32-bit float from binary file
-    float readFloat(std::ifstream& file) {
-        float val;
-        file.read(reinterpret_cast<char*>(&val), sizeof(float));
-        return val;
+    // Longest ASCII STL line parsed; the rest of a longer line is ignored
+    constexpr size_t ASCII_LINE_MAX = 256;
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    // Moves `cursor` past the next whitespace-separated token and returns
+    // its length (0 at the end of the line)
+    size_t nextToken(const char*& cursor, const char*& token) {
+        while (isSpace(*cursor)) cursor++;
+        token = cursor;
+        while (*cursor && !isSpace(*cursor)) cursor++;
+        return cursor - token;
+    }
+
+    // Reads three floats; a missing or malformed one reads as 0
+    void readVec3(const char*& cursor, Vec3& v) {
+        float* fields[3] = {&v.x, &v.y, &v.z};
+        for (float* field : fields) {
+            char* end;
+            *field = std::strtof(cursor, &end);
+            cursor = end;
+        }
+    }
+
+    // Reads the rest of an open file
+    std::vector<char> readAll(std::FILE* file) {
+        std::vector<char> bytes;
+        char chunk[64 * 1024];
+        size_t got;
+        while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            bytes.insert(bytes.end(), chunk, chunk + got);
+        }
+        return bytes;
     }
 
-    // Read 16-bit unsigned integer from binary file
-    uint16_t readUint16(std::ifstream& file) {
-        uint16_t val;
-        file.read(reinterpret_cast<char*>(&val), sizeof(uint16_t));
+    // Read a little-endian 32-bit float from an unaligned byte span
+    float readFloat(const uint8_t* data) {
+        float val;
+        std::memcpy(&val, data, sizeof(float));
         return val;
     }
 } // anonymous namespace
 
-// Load STL file (supports both ASCII and binary formats)
-std::vector<Triangle> loadSTL(const std::string& filename) {
-    std::vector<Triangle> triangles;
-    std::ifstream file(filename, std::ios::binary);
-    
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return triangles;
-    }
-    
-    // Check if file is ASCII or binary
-    char header[6];
-    file.read(header, 5);
-    header[5] = '\0';
-    file.seekg(0);
-    
-    if (std::string(header) == "solid") {
-        // ASCII STL format
-        std::string line, keyword;
+// Parse `count` consecutive binary STL records starting at `data`
+void parseStlRecords(const uint8_t* data, size_t count, std::vector<Triangle>& out) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* record = data + i * STL_RECORD_SIZE;
         Triangle tri;
-        int vertexIdx = 0;
-        
-        while (std::getline(file, line)) {
-            std::istringstream iss(line);
-            iss >> keyword;
-            
-            if (keyword == "facet") {
-                iss >> keyword; // "normal"
-                iss >> tri.normal.x >> tri.normal.y >> tri.normal.z;
-                vertexIdx = 0;
-            } else if (keyword == "vertex") {
-                iss >> tri.vertices[vertexIdx].x >> tri.vertices[vertexIdx].y >> tri.vertices[vertexIdx].z;
-                vertexIdx++;
-                if (vertexIdx == 3) {
-                    triangles.push_back(tri);
-                }
+
+        // Normal, three vertices, then a 2-byte attribute count we ignore
+        tri.normal = Vec3(readFloat(record), readFloat(record + 4), readFloat(record + 8));
+        for (int j = 0; j < 3; j++) {
+            const uint8_t* v = record + 12 + j * 12;
+            tri.vertices[j] = Vec3(readFloat(v), readFloat(v + 4), readFloat(v + 8));
+        }
+        out.push_back(tri);
+    }
+}
+
+// Parse `size` bytes of ASCII STL text, appending every complete facet to `out`
+void parseAsciiStl(const char* text, size_t size, std::vector<Triangle>& out) {
+    Triangle tri;
+    int vertexIdx = 0;
+    char line[ASCII_LINE_MAX + 1];
+
+    const char* end = text + size;
+    for (const char* start = text; start < end;) {
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', end - start));
+        const char* lineEnd = newline ? newline : end;
+        // A terminated copy, so strtof cannot run past the line
+        size_t length = std::min<size_t>(lineEnd - start, ASCII_LINE_MAX);
+        std::memcpy(line, start, length);
+        line[length] = '\0';
+        start = lineEnd + 1;
+
+        const char* cursor = line;
+        const char* keyword;
+        size_t keywordLength = nextToken(cursor, keyword);
+
+        if (keywordLength == 5 && std::memcmp(keyword, "facet", 5) == 0) {
+            nextToken(cursor, keyword); // "normal"
+            readVec3(cursor, tri.normal);
+            vertexIdx = 0;
+        } else if (keywordLength == 6 && std::memcmp(keyword, "vertex", 6) == 0 && vertexIdx < 3) {
+            readVec3(cursor, tri.vertices[vertexIdx]);
+            vertexIdx++;
+            if (vertexIdx == 3) {
+                out.push_back(tri);
             }
         }
+    }
+}
+
+bool isAsciiStl(const uint8_t* header, size_t headerBytes, size_t fileBytes) {
+    if (headerBytes < 5 || std::memcmp(header, "solid", 5) != 0) return false;
+    if (headerBytes < STL_HEADER_SIZE || fileBytes == 0) return true;
+    uint32_t count = 0;
+    std::memcpy(&count, header + 80, sizeof(uint32_t));
+    return fileBytes != STL_HEADER_SIZE + static_cast<size_t>(count) * STL_RECORD_SIZE;
+}
+
+// Read an STL file into `triangles` without logging; false if it cannot be opened
+bool readSTL(const std::string& filename, std::vector<Triangle>& triangles) {
+    TERMESH_TRACE_SCOPE("readSTL");
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    
+    // Check if file is ASCII or binary, by its header and size as StlStream does
+    uint8_t header[STL_HEADER_SIZE];
+    size_t headerBytes = std::fread(header, 1, STL_HEADER_SIZE, file);
+    std::fseek(file, 0, SEEK_END);
+    long fileSize = std::ftell(file);
+    bool ascii = isAsciiStl(header, headerBytes, fileSize > 0 ? (size_t)fileSize : 0);
+    MemoryAccount scratch(MEMORY_PARSE_SCRATCH);
+    
+    if (ascii) {
+        std::fseek(file, 0, SEEK_SET);
+        std::vector<char> text = readAll(file);
+        scratch.set(vectorBytes(text));
+        parseAsciiStl(text.data(), text.size(), triangles);
     } else {
         // Binary STL format
-        file.seekg(80); // Skip header
-        uint32_t numTriangles; // <-- This type needs <cstdint>
-        file.read(reinterpret_cast<char*>(&numTriangles), sizeof(uint32_t));
+        std::fseek(file, 80, SEEK_SET); // Skip header
+        uint32_t numTriangles = 0;
+        if (std::fread(&numTriangles, sizeof(uint32_t), 1, file) != 1) numTriangles = 0;
         
         // --- Optimization 4: Reserve memory ---
-        triangles.reserve(numTriangles);
+        // No more than the file can hold, so a corrupt count cannot reserve gigabytes
+        long position = std::ftell(file);
+        size_t fits = fileSize > position ? (size_t)(fileSize - position) / STL_RECORD_SIZE : 0;
+        triangles.reserve(std::min<size_t>(numTriangles, fits));
         
-        for (uint32_t i = 0; i < numTriangles; i++) {
-            Triangle tri;
-            
-            // Read normal
-            tri.normal.x = readFloat(file);
-            tri.normal.y = readFloat(file);
-            tri.normal.z = readFloat(file);
-            
-            // Read vertices
-            for (int j = 0; j < 3; j++) {
-                tri.vertices[j].x = readFloat(file);
-                tri.vertices[j].y = readFloat(file);
-                tri.vertices[j].z = readFloat(file);
-            }
-            
-            // Skip attribute byte count
-            readUint16(file); // <-- This function's return type needs <cstdint>
-            
-            triangles.push_back(tri);
+        // Decode whole blocks of records through the shared span parser
+        std::vector<uint8_t> block(STL_RECORDS_PER_READ * STL_RECORD_SIZE);
+        scratch.set(vectorBytes(block));
+        size_t remaining = numTriangles;
+        while (remaining > 0) {
+            size_t wanted = std::min(remaining, STL_RECORDS_PER_READ);
+            size_t records = std::fread(block.data(), STL_RECORD_SIZE, wanted, file);
+            parseStlRecords(block.data(), records, triangles);
+            remaining -= records;
+            if (records < wanted) break;
         }
     }
     
-    file.close();
-    std::cout << "Loaded " << triangles.size() << " triangles from " << filename << std::endl;
+    std::fclose(file);
+    return true;
+}
+
+// Load STL file (supports both ASCII and binary formats)
+std::vector<Triangle> loadSTL(const std::string& filename) {
+    TERMESH_TRACE_SCOPE("loadSTL");
+    std::vector<Triangle> triangles;
+    if (!readSTL(filename, triangles)) {
+        logError("Error: Cannot open file %s", filename.c_str());
+        return triangles;
+    }
+    logInfo("Loaded %zu triangles from %s", triangles.size(), filename.c_str());
     return triangles;
 }
 
 // Calculate bounding box and center model
 void normalizeModel(std::vector<Triangle>& triangles, float& scale) {
     if (triangles.empty()) return;
+    TERMESH_TRACE_SCOPE("normalizeModel");
     
     Vec3 minBounds(1e10f, 1e10f, 1e10f);
     Vec3 maxBounds(-1e10f, -1e10f, -1e10f);
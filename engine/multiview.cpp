@@ -0,0 +1,225 @@
+#include "multiview.h"
+#include <algorithm>
+#include <cmath>
+#include "lighting.h"
+#include "projection.h"
+#include "rasterizer.h"
+#include "render_stats.h"
+#include "simd.h"
+#include "trace.h"
+
+namespace {
+    // Rotation entries this close to 0 or 1 count as exact for the axis fast path
+    constexpr float AXIS_EPSILON = 1e-4f;
+
+    // Per-triangle work that no view changes, done once per frame
+    struct SharedTriangle {
+        Vec3 faceNormal;        // Model space, not normalized: culling only needs its sign
+        Vec3 normal;            // Unit shading normal, model space
+        float fixedIntensity;   // Under the fixed light
+    };
+
+    // A rotation that only swaps and flips axes: view axis i is sign[i]
+    // times model axis axis[i]
+    struct AxisSwizzle {
+        int axis[3];
+        float sign[3];
+    };
+
+    bool axisSwizzle(const Mat3& rotation, AxisSwizzle& out) {
+        for (int row = 0; row < 3; row++) {
+            int found = -1;
+            for (int col = 0; col < 3; col++) {
+                float value = std::fabs(rotation.m[row][col]);
+                if (value > 1.0f - AXIS_EPSILON && found < 0) {
+                    found = col;
+                } else if (value > AXIS_EPSILON) {
+                    return false;
+                }
+            }
+            if (found < 0) return false;
+            out.axis[row] = found;
+            out.sign[row] = rotation.m[row][found] > 0 ? 1.0f : -1.0f;
+        }
+        return true;
+    }
+
+    inline float component(const Vec3& v, int axis) {
+        return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+    }
+
+    // Rasterizes the triangles that face the view. `viewZ` is the model-space
+    // vector whose dot product with a model vector gives its view-space z;
+    // `toScreen` maps a triangle's model-space vertices to cells.
+    template <typename ToScreen>
+    void drawTriangles(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                       const Triangle* model, const SharedTriangle* shared, size_t count,
+                       const Vec3& viewZ, const Vec3& modelLight, bool fixedLight,
+                       ToScreen toScreen) {
+        TERMESH_STAT(COUNTER_SUBMITTED, count);
+        for (size_t t = 0; t < count; t++) {
+            // Same test as renderFrame(): the face normal must point at the
+            // viewer, down -z
+            if (viewZ.dot(shared[t].faceNormal) >= 0) {
+                TERMESH_STAT(COUNTER_CULLED, 1);
+                continue;
+            }
+
+            Vec3 projected[3];
+            toScreen(model[t].vertices, projected);
+            float intensity = fixedLight ? shared[t].fixedIntensity
+                                         : calculateLighting(shared[t].normal, modelLight);
+            float intensities[3] = {intensity, intensity, intensity};
+            rasterizeTriangle(buffer, zbuffer, projected, intensities);
+        }
+    }
+
+    void renderViewport(const Viewport& viewport, std::vector<std::string>& buffer,
+                        std::vector<float>& zbuffer, const Triangle* model,
+                        const SharedTriangle* shared, size_t count) {
+        clearBuffers(buffer, zbuffer);
+        const Mat3 rotation = viewport.camera.rotation();
+        const float (*m)[3] = rotation.m;
+
+        // The light taken into model space once, instead of every normal into
+        // view space
+        const Vec3& light = viewport.lightDir;
+        const Vec3 modelLight(m[0][0] * light.x + m[1][0] * light.y + m[2][0] * light.z,
+                              m[0][1] * light.x + m[1][1] * light.y + m[2][1] * light.z,
+                              m[0][2] * light.x + m[1][2] * light.y + m[2][2] * light.z);
+
+        // An orthographic view has the scale of a perspective one at the
+        // model's centre
+        const ProjectionParams params = projectionFor(viewport.cols, viewport.rows);
+        const float scaleX = params.screenWidth * params.scaleFactor / params.fov;
+        const float scaleY = params.screenHeight * params.scaleFactor / params.fov;
+        const float centreX = params.screenWidth / 2.0f, centreY = params.screenHeight / 2.0f;
+
+        AxisSwizzle swizzle;
+        if (viewport.projection == ViewProjection::Orthographic && axisSwizzle(rotation, swizzle)) {
+            // Looking down a model axis: vertices are picked and scaled, with
+            // no rotation and no divide
+            Vec3 viewZ(0, 0, 0);
+            (swizzle.axis[2] == 0 ? viewZ.x : swizzle.axis[2] == 1 ? viewZ.y : viewZ.z) = swizzle.sign[2];
+            const float kx = swizzle.sign[0] * scaleX, ky = -swizzle.sign[1] * scaleY;
+            drawTriangles(buffer, zbuffer, model, shared, count, viewZ, modelLight, viewport.fixedLight,
+                          [&](const Vec3 in[3], Vec3 out[3]) {
+                for (int i = 0; i < 3; i++) {
+                    out[i] = Vec3(component(in[i], swizzle.axis[0]) * kx + centreX,
+                                  component(in[i], swizzle.axis[1]) * ky + centreY,
+                                  component(in[i], swizzle.axis[2]) * swizzle.sign[2]);
+                }
+            });
+            return;
+        }
+
+        const Vec3 viewZ(m[2][0], m[2][1], m[2][2]);
+        if (viewport.projection == ViewProjection::Orthographic) {
+            drawTriangles(buffer, zbuffer, model, shared, count, viewZ, modelLight, viewport.fixedLight,
+                          [&](const Vec3 in[3], Vec3 out[3]) {
+                Vec3 transformed[3];
+                transformTriangle(rotation, in, transformed);
+                for (int i = 0; i < 3; i++) {
+                    out[i] = Vec3(transformed[i].x * scaleX + centreX,
+                                  -transformed[i].y * scaleY + centreY, transformed[i].z);
+                }
+            });
+        } else {
+            drawTriangles(buffer, zbuffer, model, shared, count, viewZ, modelLight, viewport.fixedLight,
+                          [&](const Vec3 in[3], Vec3 out[3]) {
+                Vec3 transformed[3];
+                transformTriangle(rotation, in, transformed);
+                for (int i = 0; i < 3; i++) {
+                    out[i] = project(transformed[i], params);
+                }
+            });
+        }
+    }
+} // anonymous namespace
+
+MultiView::MultiView(int width, int height) {
+    resize(width, height);
+}
+
+void MultiView::resize(int width, int height) {
+    cols = width > 0 ? width : 1;
+    rows = height > 0 ? height : 1;
+    buffer.assign(rows, std::string(cols, ' '));
+    trackMemory();
+}
+
+void MultiView::render(const std::vector<Triangle>& model) {
+    TERMESH_TRACE_SCOPE("MultiView::render");
+    const size_t count = model.size();
+    const bool anyFixed = std::any_of(viewports.begin(), viewports.end(),
+                                      [](const Viewport& viewport) { return viewport.fixedLight; });
+
+    // The shared pass
+    arena.reset();
+    SharedTriangle* shared = arena.allocate<SharedTriangle>(count);
+    for (size_t t = 0; t < count; t++) {
+        const Triangle& tri = model[t];
+        SharedTriangle& out = shared[t];
+        out.faceNormal = (tri.vertices[1] - tri.vertices[0]).cross(tri.vertices[2] - tri.vertices[0]);
+        out.normal = tri.normal.normalize();
+        out.fixedIntensity = anyFixed ? calculateLighting(out.normal, fixedLightDir) : 0.0f;
+    }
+
+    for (auto& line : buffer) {
+        line.assign(line.size(), ' ');
+    }
+    bool reallocated = views.size() != viewports.size();
+    if (reallocated) views.resize(viewports.size());
+
+    for (size_t v = 0; v < viewports.size(); v++) {
+        const Viewport& viewport = viewports[v];
+        if (viewport.cols <= 0 || viewport.rows <= 0) continue;
+
+        ViewBuffers& target = views[v];
+        if (frameWidth(target.buffer) != viewport.cols || frameHeight(target.buffer) != viewport.rows) {
+            target.buffer.assign(viewport.rows, std::string(viewport.cols, ' '));
+            target.zbuffer.assign((size_t)viewport.cols * viewport.rows, -1e10f);
+            reallocated = true;
+        }
+        renderViewport(viewport, target.buffer, target.zbuffer, model.data(), shared, count);
+
+        // Into its rectangle of the frame, clipped to the frame
+        const int firstX = std::max(0, viewport.x), endX = std::min(cols, viewport.x + viewport.cols);
+        const int firstY = std::max(0, viewport.y), endY = std::min(rows, viewport.y + viewport.rows);
+        for (int y = firstY; y < endY && firstX < endX; y++) {
+            const std::string& line = target.buffer[y - viewport.y];
+            std::copy(line.begin() + (firstX - viewport.x), line.begin() + (endX - viewport.x),
+                      buffer[y].begin() + firstX);
+        }
+    }
+    if (reallocated) trackMemory();
+}
+
+void MultiView::trackMemory() {
+    size_t bytes = frameMemoryBytes(buffer);
+    for (const ViewBuffers& view : views) bytes += frameMemoryBytes(view.buffer) + vectorBytes(view.zbuffer);
+    memory.set(bytes);
+}
+
+std::vector<Viewport> axisViewports(int width, int height) {
+    const Camera cameras[4] = {{0.6f, 0.8f, 0.0f}, {0.0f, 0.0f, 0.0f},
+                               {0.0f, HALF_PI, 0.0f}, {HALF_PI, 0.0f, 0.0f}};
+    const int leftCols = (width - 1) / 2, topRows = (height - 1) / 2;
+
+    std::vector<Viewport> viewports(4);
+    for (int i = 0; i < 4; i++) {
+        Viewport& viewport = viewports[i];
+        const bool right = i % 2 == 1, bottom = i >= 2;
+        viewport.x = right ? leftCols + 1 : 0;
+        viewport.cols = right ? width - leftCols - 1 : leftCols;
+        viewport.y = bottom ? topRows + 1 : 0;
+        viewport.rows = bottom ? height - topRows - 1 : topRows;
+        viewport.camera = cameras[i];
+        if (i > 0) {
+            // Lit from the model, so a face has the same shade in every axis view
+            viewport.projection = ViewProjection::Orthographic;
+            viewport.fixedLight = true;
+        }
+    }
+    return viewports;
+}
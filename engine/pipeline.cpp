@@ -0,0 +1,210 @@
+#include "pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include "projection.h"
+#include "rasterizer.h"
+#include "trace.h"
+
+namespace {
+    size_t chunkCount(size_t triangles) {
+        return (triangles + GEOMETRY_CHUNK_TRIANGLES - 1) / GEOMETRY_CHUNK_TRIANGLES;
+    }
+
+    int bandCount(int height) {
+        return (height + RASTER_BAND_ROWS - 1) / RASTER_BAND_ROWS;
+    }
+
+    // Takes this frame's screen-space storage from the scratch arena
+    void prepareScratch(ParallelScratch& scratch, size_t chunks) {
+        scratch.arena.reset();
+        scratch.triangles = scratch.arena.allocate<RenderScratch::ScreenTriangle>(chunks * GEOMETRY_CHUNK_TRIANGLES);
+        scratch.counts = scratch.arena.allocate<size_t>(chunks);
+    }
+
+    // Geometry job: one chunk of triangles to screen space
+    void projectChunk(const std::vector<Triangle>& model, size_t chunk,
+                      const Mat3& rotation, const Vec3& lightDir, const ProjectionParams& params,
+                      ParallelScratch& scratch) {
+        TERMESH_TRACE_SCOPE("projectChunk");
+        size_t begin = chunk * GEOMETRY_CHUNK_TRIANGLES;
+        size_t end = std::min(model.size(), begin + GEOMETRY_CHUNK_TRIANGLES);
+        scratch.counts[chunk] = projectTriangles(model.data() + begin, model.data() + end, rotation,
+                                                 lightDir, params, scratch.triangles + begin);
+    }
+
+    // Raster job: clears one band of rows and draws every chunk into it in order
+    void rasterBand(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                    const ParallelScratch& scratch, size_t chunks, int band, int sampleStep) {
+        TERMESH_TRACE_SCOPE("rasterBand");
+        int firstRow = band * RASTER_BAND_ROWS;
+        int endRow = std::min(frameHeight(buffer), firstRow + RASTER_BAND_ROWS);
+        clearRows(buffer, zbuffer, firstRow, endRow);
+        for (size_t c = 0; c < chunks; c++) {
+            const RenderScratch::ScreenTriangle* chunk = scratch.triangles + c * GEOMETRY_CHUNK_TRIANGLES;
+            for (size_t i = 0; i < scratch.counts[c]; i++) {
+                rasterizeTriangleRows(buffer, zbuffer, chunk[i].projected, chunk[i].intensities, sampleStep,
+                                      firstRow, endRow);
+            }
+        }
+    }
+} // anonymous namespace
+
+void renderFrameParallel(JobSystem& jobs,
+                         std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                         const std::vector<Triangle>& model, const Mat3& rotation,
+                         const Vec3& lightDir, ParallelScratch& scratch,
+                         int sampleStep, StageTimings* timings) {
+    TERMESH_TRACE_SCOPE("renderFrameParallel");
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    const size_t chunks = chunkCount(model.size());
+    prepareScratch(scratch, chunks);
+    const ProjectionParams params = projectionFor(frameWidth(buffer), frameHeight(buffer));
+
+    jobs.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            projectChunk(model, c, rotation, lightDir, params, scratch);
+        }
+    });
+    Clock::time_point projected = Clock::now();
+    jobs.parallelFor(bandCount(frameHeight(buffer)), 1, [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; band++) {
+            rasterBand(buffer, zbuffer, scratch, chunks, (int)band, sampleStep);
+        }
+    });
+    if (timings) {
+        timings->clear = 0.0;
+        timings->geometry = std::chrono::duration<double>(projected - start).count();
+        timings->raster = std::chrono::duration<double>(Clock::now() - projected).count();
+    }
+}
+
+FramePipeline::FramePipeline(JobSystem& jobs, int width, int height, int maxInFlight)
+    : jobs(jobs), cols(std::max(1, width)), rows(std::max(1, height)),
+      emptyMesh(std::make_shared<const std::vector<Triangle>>()) {
+    for (int i = 0; i < std::max(1, maxInFlight); i++) {
+        auto frame = std::make_unique<Frame>();
+        frame->pipeline = this;
+        frame->params = projectionFor(cols, rows);
+        frame->buffer.assign(rows, std::string(cols, ' '));
+        frame->zbuffer.assign((size_t)cols * rows, -1e10f);
+        slots.push_back(std::move(frame));
+    }
+    for (auto& nanos : busyNanos) nanos = 0;
+}
+
+FramePipeline::~FramePipeline() {
+    flush();
+}
+
+void FramePipeline::submit(MeshRef mesh, const Camera& camera, const Vec3& lightDir, FrameSink* sink) {
+    const size_t sequence = submitted;
+    if (sequence >= slots.size()) {
+        // Wait for the frame that used the slot last. Every earlier frame was
+        // presented before its own slot was reused, so this one was presented
+        // by one of its own jobs or by the previous frame's, whose group was
+        // waited for already.
+        jobs.wait(slot(sequence).group);
+    }
+    if (sequence == 0) {
+        firstSubmit = Clock::now();
+        stolenAtStart = jobs.stats().stolen;
+    }
+
+    Frame& frame = slot(sequence);
+    frame.sequence = sequence;
+    frame.mesh = mesh ? std::move(mesh) : emptyMesh;
+    frame.rotation = camera.rotation();
+    frame.lightDir = lightDir;
+    frame.sink = sink;
+    submitted++;
+    peak = std::max(peak, inFlight());
+
+    frame.chunks = chunkCount(frame.mesh->size());
+    prepareScratch(frame.scratch, frame.chunks);
+    if (frame.chunks == 0) {
+        startRaster(frame);
+        return;
+    }
+
+    // Jobs capture two words, which std::function keeps inline: queuing them
+    // does not allocate
+    frame.geometryLeft = frame.chunks;
+    for (size_t c = 0; c < frame.chunks; c++) {
+        jobs.run(frame.group, [f = &frame, c] { f->pipeline->runGeometry(*f, c); });
+    }
+}
+
+void FramePipeline::runGeometry(Frame& frame, size_t chunk) {
+    Clock::time_point start = Clock::now();
+    projectChunk(*frame.mesh, chunk, frame.rotation, frame.lightDir, frame.params, frame.scratch);
+    addBusy(STAGE_GEOMETRY, start);
+    // The last chunk to finish starts the frame's raster stage
+    if (--frame.geometryLeft == 0) startRaster(frame);
+}
+
+void FramePipeline::startRaster(Frame& frame) {
+    const int bands = bandCount(rows);
+    frame.rasterLeft = bands;
+    for (int band = 0; band < bands; band++) {
+        jobs.run(frame.group, [f = &frame, band] { f->pipeline->runRaster(*f, band); });
+    }
+}
+
+void FramePipeline::runRaster(Frame& frame, int band) {
+    Clock::time_point start = Clock::now();
+    rasterBand(frame.buffer, frame.zbuffer, frame.scratch, frame.chunks, band, 1);
+    addBusy(STAGE_RASTER, start);
+    if (--frame.rasterLeft == 0) {
+        {
+            std::lock_guard<std::mutex> lock(presentMutex);
+            frame.rasterized = true;
+        }
+        presentReady();
+    }
+}
+
+void FramePipeline::presentReady() {
+    std::lock_guard<std::mutex> lock(presentMutex);
+    // A finished frame waits for every earlier one, so frames stay in order
+    while (true) {
+        Frame& frame = slot(presented.load());
+        if (!frame.rasterized || frame.sequence != presented.load()) return;
+
+        Clock::time_point start = Clock::now();
+        if (frame.sink) frame.sink->present(frame.buffer);
+        addBusy(STAGE_OUTPUT, start);
+        frame.rasterized = false;
+        frame.mesh.reset();
+        lastPresent = Clock::now();
+        // After this the slot may be reused: do not touch `frame` again
+        presented++;
+    }
+}
+
+void FramePipeline::addBusy(PipelineStage stage, Clock::time_point start) {
+    busyNanos[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void FramePipeline::flush() {
+    // Presentation runs inside the jobs, so once they are done every frame is out
+    for (size_t sequence = submitted - std::min(submitted, slots.size()); sequence < submitted; sequence++) {
+        jobs.wait(slot(sequence).group);
+    }
+}
+
+PipelineStats FramePipeline::stats() const {
+    PipelineStats result;
+    std::lock_guard<std::mutex> lock(presentMutex);
+    result.frames = presented.load();
+    if (result.frames > 0) {
+        result.wallSeconds = std::chrono::duration<double>(lastPresent - firstSubmit).count();
+    }
+    for (int stage = 0; stage < PIPELINE_STAGE_COUNT; stage++) {
+        result.busySeconds[stage] = busyNanos[stage].load() * 1e-9;
+    }
+    // The submitting thread runs jobs whenever it waits
+    result.threads = jobs.size() + 1;
+    result.stolen = jobs.stats().stolen - stolenAtStart;
+    return result;
+}
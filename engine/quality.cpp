@@ -0,0 +1,187 @@
+#include "quality.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "lighting.h"
+#include "projection.h"
+#include "rasterizer.h"
+#include "render_stats.h"
+#include "simd.h"
+#include "trace.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // 21 bits per axis is plenty for a model spanning 30 units
+    uint64_t cellKey(const Vec3& v, float cellSize) {
+        auto axis = [cellSize](float c) {
+            return (uint64_t)((int64_t)std::floor(c / cellSize) & 0x1FFFFF);
+        };
+        return (axis(v.x) << 42) | (axis(v.y) << 21) | axis(v.z);
+    }
+
+    struct Cluster {
+        Vec3 sum;
+        int count = 0;
+    };
+} // anonymous namespace
+
+std::vector<Triangle> decimateModel(const std::vector<Triangle>& model, float cellSize) {
+    if (cellSize <= 0.0f) return model;
+
+    std::unordered_map<uint64_t, uint32_t> clusterOf;
+    std::vector<Cluster> clusters;
+    std::vector<uint32_t> corners(model.size() * 3);
+    for (size_t t = 0; t < model.size(); t++) {
+        for (int i = 0; i < 3; i++) {
+            const Vec3& v = model[t].vertices[i];
+            auto inserted = clusterOf.emplace(cellKey(v, cellSize), (uint32_t)clusters.size());
+            if (inserted.second) clusters.emplace_back();
+            Cluster& cluster = clusters[inserted.first->second];
+            cluster.sum = cluster.sum + v;
+            cluster.count++;
+            corners[t * 3 + i] = inserted.first->second;
+        }
+    }
+
+    std::vector<Triangle> result;
+    std::unordered_set<uint64_t> seen;
+    for (size_t t = 0; t < model.size(); t++) {
+        uint32_t a = corners[t * 3], b = corners[t * 3 + 1], c = corners[t * 3 + 2];
+        if (a == b || b == c || a == c) continue;
+
+        // Two triangles over the same clusters would draw the same pixels
+        uint32_t ids[3] = {a, b, c};
+        std::sort(ids, ids + 3);
+        uint64_t key = ((uint64_t)ids[0] << 42) ^ ((uint64_t)ids[1] << 21) ^ ids[2];
+        if (!seen.insert(key).second) continue;
+
+        Triangle tri;
+        for (int i = 0; i < 3; i++) {
+            const Cluster& cluster = clusters[corners[t * 3 + i]];
+            tri.vertices[i] = cluster.sum * (1.0f / cluster.count);
+        }
+        tri.normal = model[t].normal;
+        result.push_back(tri);
+    }
+    return result;
+}
+
+void LodChain::build(const std::vector<Triangle>& model) {
+    levels.clear();
+    for (int lod = 1; lod < LOD_LEVEL_COUNT; lod++) {
+        levels.push_back(decimateModel(model, LOD_CELL_SIZES[lod]));
+    }
+    size_t bytes = 0;
+    for (const auto& level : levels) bytes += vectorBytes(level);
+    memory.set(bytes);
+}
+
+const std::vector<Triangle>& LodChain::select(const std::vector<Triangle>& full, int lod) const {
+    if (lod <= 0 || levels.empty()) return full;
+    return levels[std::min(lod, (int)levels.size()) - 1];
+}
+
+size_t projectTriangles(const Triangle* begin, const Triangle* end,
+                        const Mat3& rotation, const Vec3& lightDir,
+                        const ProjectionParams& params, RenderScratch::ScreenTriangle* out) {
+    // The same per-triangle work as renderFrame()
+    const Vec3 viewDir(0, 0, -1);
+    size_t count = 0;
+    for (const Triangle* tri = begin; tri != end; ++tri) {
+        Vec3 transformed[3];
+        transformTriangle(rotation, tri->vertices, transformed);
+
+        Vec3 faceNormal = (transformed[1] - transformed[0]).cross(transformed[2] - transformed[0]).normalize();
+        if (faceNormal.dot(viewDir) <= 0) continue;
+
+        RenderScratch::ScreenTriangle& screen = out[count++];
+        for (int i = 0; i < 3; i++) {
+            screen.projected[i] = project(transformed[i], params);
+        }
+        // STL gives one normal per face, so every vertex is lit alike
+        float intensity = calculateLighting((rotation * tri->normal).normalize(), lightDir);
+        screen.intensities[0] = screen.intensities[1] = screen.intensities[2] = intensity;
+    }
+    TERMESH_STAT(COUNTER_SUBMITTED, end - begin);
+    TERMESH_STAT(COUNTER_CULLED, (end - begin) - count);
+    return count;
+}
+
+void renderFrameTimed(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                      const std::vector<Triangle>& model, const Mat3& rotation,
+                      const Vec3& lightDir, const QualitySettings& quality,
+                      RenderScratch& scratch, StageTimings& timings) {
+    TERMESH_TRACE_SCOPE("renderFrameTimed");
+    Clock::time_point start = Clock::now();
+    {
+        TERMESH_TRACE_SCOPE("clear");
+        clearBuffers(buffer, zbuffer);
+    }
+    timings.clear = secondsSince(start);
+
+    // Geometry, kept apart from rasterization so the two stages can be timed
+    // separately
+    start = Clock::now();
+    {
+        TERMESH_TRACE_SCOPE("geometry");
+        scratch.arena.reset();
+        scratch.triangles = scratch.arena.allocate<RenderScratch::ScreenTriangle>(model.size());
+        scratch.count = projectTriangles(model.data(), model.data() + model.size(), rotation, lightDir,
+                                         projectionFor(frameWidth(buffer), frameHeight(buffer)),
+                                         scratch.triangles);
+    }
+    timings.geometry = secondsSince(start);
+
+    start = Clock::now();
+    {
+        TERMESH_TRACE_SCOPE("raster");
+        for (size_t i = 0; i < scratch.count; i++) {
+            const RenderScratch::ScreenTriangle& screen = scratch.triangles[i];
+            rasterizeTriangle(buffer, zbuffer, screen.projected, screen.intensities, quality.sampleStep);
+        }
+    }
+    timings.raster = secondsSince(start);
+}
+
+AdaptiveQuality::AdaptiveQuality(double budgetSeconds) : budgetSeconds(budgetSeconds) {}
+
+void AdaptiveQuality::setBudget(double seconds) {
+    budgetSeconds = seconds;
+    changeLevel(0);
+}
+
+void AdaptiveQuality::changeLevel(int level) {
+    current = std::max(0, std::min(QUALITY_LEVEL_COUNT - 1, level));
+    // The old average says nothing about the new level
+    measured = false;
+    average = 0.0;
+    framesOver = 0;
+    framesUnder = 0;
+}
+
+bool AdaptiveQuality::update(double frameSeconds) {
+    average = measured ? average + QUALITY_SMOOTHING * (frameSeconds - average) : frameSeconds;
+    measured = true;
+    if (budgetSeconds <= 0.0) return false;
+
+    framesOver = average > budgetSeconds ? framesOver + 1 : 0;
+    framesUnder = average < budgetSeconds * QUALITY_UPGRADE_RATIO ? framesUnder + 1 : 0;
+
+    if (framesOver >= QUALITY_DOWNGRADE_FRAMES && current < QUALITY_LEVEL_COUNT - 1) {
+        changeLevel(current + 1);
+        return true;
+    }
+    if (framesUnder >= QUALITY_UPGRADE_FRAMES && current > 0) {
+        changeLevel(current - 1);
+        return true;
+    }
+    return false;
+}
@@ -1,16 +1,222 @@
 #include "rasterizer.h"
 #include <algorithm>
 #include <cmath>
+#include "render_stats.h"
+#include "simd.h"
+
+namespace {
+    // What shadePixel() found at a cell
+    enum PixelResult { PIXEL_OUTSIDE, PIXEL_PASSED, PIXEL_FAILED };
+
+    // Shades one cell if it is inside the triangle and in front
+    inline PixelResult shadePixel(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                           const Vec3 projected[3], const float intensities[3],
+                           const Vec3& v0, const Vec3& v1, float denom, int width, int x, int y) {
+        Vec3 p(x, y, 0);
+        Vec3 v2 = p - projected[0];
+        
+        // Calculate barycentric coordinates
+        float u = (v2.x * v1.y - v1.x * v2.y) / denom;
+        float v = (v0.x * v2.y - v2.x * v0.y) / denom;
+        float w = 1.0f - u - v;
+        
+        // Check if point is inside triangle
+        if (u >= 0 && v >= 0 && w >= 0) {
+            // Interpolate depth
+            float z = w * projected[0].z + u * projected[1].z + v * projected[2].z;
+            
+            int idx = y * width + x;
+            if (z > zbuffer[idx]) {
+                zbuffer[idx] = z;
+                
+                // Interpolate intensity
+                float intensity = w * intensities[0] + u * intensities[1] + v * intensities[2];
+                int shadeIdx = std::min(SHADE_LEVELS - 1, (int)(intensity * SHADE_LEVELS));
+                
+                buffer[y][x] = SHADE_CHARS[shadeIdx];
+                return PIXEL_PASSED;
+            }
+            return PIXEL_FAILED;
+        }
+        return PIXEL_OUTSIDE;
+    }
+
+#ifdef __wasm_simd128__
+    // Four cells of a row at a time, with shadePixel()'s arithmetic lane by
+    // lane so the result is identical. Returns the first x left for the
+    // scalar loop (fewer than four cells remain).
+    int rasterizeRowSimd(std::string& row, float* depth, const Vec3 projected[3],
+                         const float intensities[3], const Vec3& v0, const Vec3& v1,
+                         float denom, int y, int minX, int maxX, uint64_t depthResults[3]) {
+        const v128_t lanes = wasm_f32x4_make(0.0f, 1.0f, 2.0f, 3.0f);
+        const v128_t zero = wasm_f32x4_splat(0.0f);
+        const v128_t one = wasm_f32x4_splat(1.0f);
+        const v128_t p0x = wasm_f32x4_splat(projected[0].x);
+        const v128_t v0x = wasm_f32x4_splat(v0.x), v0y = wasm_f32x4_splat(v0.y);
+        const v128_t v1x = wasm_f32x4_splat(v1.x), v1y = wasm_f32x4_splat(v1.y);
+        const v128_t d = wasm_f32x4_splat(denom);
+        const v128_t v2y = wasm_f32x4_splat((float)y - projected[0].y);
+        const v128_t z0 = wasm_f32x4_splat(projected[0].z);
+        const v128_t z1 = wasm_f32x4_splat(projected[1].z);
+        const v128_t z2 = wasm_f32x4_splat(projected[2].z);
+        const v128_t i0 = wasm_f32x4_splat(intensities[0]);
+        const v128_t i1 = wasm_f32x4_splat(intensities[1]);
+        const v128_t i2 = wasm_f32x4_splat(intensities[2]);
+        const v128_t levels = wasm_f32x4_splat((float)SHADE_LEVELS);
+        const v128_t maxShade = wasm_i32x4_splat(SHADE_LEVELS - 1);
+
+        int x = minX;
+        for (; x + 3 <= maxX; x += 4) {
+            v128_t v2x = wasm_f32x4_sub(wasm_f32x4_add(wasm_f32x4_splat((float)x), lanes), p0x);
+            v128_t u = wasm_f32x4_div(wasm_f32x4_sub(wasm_f32x4_mul(v2x, v1y), wasm_f32x4_mul(v1x, v2y)), d);
+            v128_t v = wasm_f32x4_div(wasm_f32x4_sub(wasm_f32x4_mul(v0x, v2y), wasm_f32x4_mul(v2x, v0y)), d);
+            v128_t w = wasm_f32x4_sub(wasm_f32x4_sub(one, u), v);
+            v128_t inside = wasm_v128_and(wasm_v128_and(wasm_f32x4_ge(u, zero), wasm_f32x4_ge(v, zero)),
+                                          wasm_f32x4_ge(w, zero));
+            if (!wasm_v128_any_true(inside)) continue;
+
+            v128_t z = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(w, z0), wasm_f32x4_mul(u, z1)),
+                                      wasm_f32x4_mul(v, z2));
+            v128_t old = wasm_v128_load(depth + x);
+            v128_t pass = wasm_v128_and(inside, wasm_f32x4_gt(z, old));
+            int mask = wasm_i32x4_bitmask(pass);
+#ifdef TERMESH_STATS
+            depthResults[PIXEL_PASSED] += __builtin_popcount(mask);
+            depthResults[PIXEL_FAILED] += __builtin_popcount(wasm_i32x4_bitmask(inside) & ~mask);
+#else
+            (void)depthResults;
+#endif
+            if (mask == 0) continue;
+            wasm_v128_store(depth + x, wasm_v128_bitselect(z, old, pass));
+
+            v128_t intensity = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(w, i0), wasm_f32x4_mul(u, i1)),
+                                              wasm_f32x4_mul(v, i2));
+            v128_t shade = wasm_i32x4_min(wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_mul(intensity, levels)), maxShade);
+            if (mask & 1) row[x] = SHADE_CHARS[wasm_i32x4_extract_lane(shade, 0)];
+            if (mask & 2) row[x + 1] = SHADE_CHARS[wasm_i32x4_extract_lane(shade, 1)];
+            if (mask & 4) row[x + 2] = SHADE_CHARS[wasm_i32x4_extract_lane(shade, 2)];
+            if (mask & 8) row[x + 3] = SHADE_CHARS[wasm_i32x4_extract_lane(shade, 3)];
+        }
+        return x;
+    }
+#endif
+
+    // Coarse path of rasterizeTriangle(): one barycentric sample per block
+    void rasterizeBlocks(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                         const Vec3 projected[3], const float intensities[3], int step,
+                         int minX, int maxX, int minY, int maxY, float denom,
+                         int firstRow, int endRow) {
+        const int width = frameWidth(buffer);
+        Vec3 v0 = projected[1] - projected[0];
+        Vec3 v1 = projected[2] - projected[0];
+        float centre = (step - 1) * 0.5f;
+
+        // Blocks sit on a fixed grid so neighbouring triangles tile exactly.
+        // A block cut by a band edge fills only the rows inside the band.
+        int gridY = std::max(0, (int)std::min({projected[0].y, projected[1].y, projected[2].y}));
+#ifdef TERMESH_STATS
+        uint64_t samples = 0, passes = 0, fails = 0;
+#endif
+        for (int by = gridY - gridY % step; by <= maxY; by += step) {
+            if (by + step <= minY) continue;
+            for (int bx = minX - minX % step; bx <= maxX; bx += step) {
+#ifdef TERMESH_STATS
+                samples++;
+#endif
+                Vec3 v2 = Vec3(bx + centre, by + centre, 0) - projected[0];
+                float u = (v2.x * v1.y - v1.x * v2.y) / denom;
+                float v = (v0.x * v2.y - v2.x * v0.y) / denom;
+                float w = 1.0f - u - v;
+                if (u < 0 || v < 0 || w < 0) continue;
+
+                float z = w * projected[0].z + u * projected[1].z + v * projected[2].z;
+                float intensity = w * intensities[0] + u * intensities[1] + v * intensities[2];
+                char shade = SHADE_CHARS[std::min(SHADE_LEVELS - 1, (int)(intensity * SHADE_LEVELS))];
+
+                int endY = std::min(by + step, endRow);
+                int endX = std::min(bx + step, width);
+                for (int y = std::max(by, firstRow); y < endY; y++) {
+                    for (int x = bx; x < endX; x++) {
+                        int idx = y * width + x;
+                        if (z > zbuffer[idx]) {
+                            zbuffer[idx] = z;
+                            buffer[y][x] = shade;
+#ifdef TERMESH_STATS
+                            passes++;
+                        } else {
+                            fails++;
+#endif
+                        }
+                    }
+                }
+            }
+        }
+#ifdef TERMESH_STATS
+        TERMESH_STAT(COUNTER_CELLS_TESTED, samples);
+        TERMESH_STAT(COUNTER_DEPTH_PASSES, passes);
+        TERMESH_STAT(COUNTER_DEPTH_FAILS, fails);
+#endif
+    }
+
+#ifdef TERMESH_STATS
+    // Counts the triangle as clipped, degenerate or rasterized. Bands of one
+    // frame each see the triangle, so only the band holding its top row (on
+    // the frame) counts it.
+    void countTriangle(const Vec3 projected[3], float denom, int width, int height,
+                       int firstRow, int endRow) {
+        float top = std::min({projected[0].y, projected[1].y, projected[2].y});
+        int topRow = std::max(0, std::min(height - 1, (int)top));
+        if (topRow < firstRow || topRow >= endRow) return;
+
+        float left = std::min({projected[0].x, projected[1].x, projected[2].x});
+        float right = std::max({projected[0].x, projected[1].x, projected[2].x});
+        float bottom = std::max({projected[0].y, projected[1].y, projected[2].y});
+        if ((int)right < 0 || (int)left > width - 1 || (int)bottom < 0 || (int)top > height - 1) {
+            TERMESH_STAT(COUNTER_CLIPPED, 1);
+        } else if (std::abs(denom) < 0.001f) {
+            TERMESH_STAT(COUNTER_DEGENERATE, 1);
+        } else {
+            TERMESH_STAT(COUNTER_RASTERIZED, 1);
+        }
+    }
+#endif
+} // anonymous namespace
 
 void rasterizeTriangle(std::vector<std::string>& buffer, 
                       std::vector<float>& zbuffer,
                       const Vec3 projected[3], 
-                      const float intensities[3]) {
+                      const float intensities[3],
+                      int sampleStep) {
+    rasterizeTriangleRows(buffer, zbuffer, projected, intensities, sampleStep, 0, frameHeight(buffer));
+}
+
+void rasterizeTriangleRows(std::vector<std::string>& buffer,
+                           std::vector<float>& zbuffer,
+                           const Vec3 projected[3],
+                           const float intensities[3],
+                           int sampleStep,
+                           int firstRow,
+                           int endRow) {
+    const int width = frameWidth(buffer);
+    endRow = std::min(endRow, frameHeight(buffer));
+#ifdef TERMESH_STATS
+    {
+        Vec3 e0 = projected[1] - projected[0];
+        Vec3 e1 = projected[2] - projected[0];
+        countTriangle(projected, e0.x * e1.y - e1.x * e0.y, width, frameHeight(buffer), firstRow, endRow);
+    }
+#endif
+    
     // Find bounding box
     int minX = std::max(0, (int)std::min({projected[0].x, projected[1].x, projected[2].x}));
-    int maxX = std::min(SCREEN_WIDTH - 1, (int)std::max({projected[0].x, projected[1].x, projected[2].x}));
-    int minY = std::max(0, (int)std::min({projected[0].y, projected[1].y, projected[2].y}));
-    int maxY = std::min(SCREEN_HEIGHT - 1, (int)std::max({projected[0].y, projected[1].y, projected[2].y}));
+    int maxX = std::min(width - 1, (int)std::max({projected[0].x, projected[1].x, projected[2].x}));
+    int minY = std::max(firstRow, (int)std::min({projected[0].y, projected[1].y, projected[2].y}));
+    int maxY = (int)std::max({projected[0].y, projected[1].y, projected[2].y});
+    // A sampled block fills rows past the triangle's last one, which may lie
+    // in the next band
+    if (sampleStep > 1 && maxY >= 0) maxY += sampleStep - 1 - maxY % sampleStep;
+    maxY = std::min(endRow - 1, maxY);
+    if (minY > maxY) return;
     
     // Calculate edge vectors for barycentric coordinates
     Vec3 v0 = projected[1] - projected[0];
@@ -18,41 +224,50 @@ void rasterizeTriangle(std::vector<std::string>& buffer,
     float denom = v0.x * v1.y - v1.x * v0.y;
     if (std::abs(denom) < 0.001f) return; // Degenerate triangle
     
+    if (sampleStep > 1) {
+        rasterizeBlocks(buffer, zbuffer, projected, intensities, sampleStep,
+                        minX, maxX, minY, maxY, denom, firstRow, endRow);
+        return;
+    }
+    
     // Rasterize triangle
+    uint64_t depthResults[3] = {};
     for (int y = minY; y <= maxY; y++) {
-        for (int x = minX; x <= maxX; x++) {
-            Vec3 p(x, y, 0);
-            Vec3 v2 = p - projected[0];
-            
-            // Calculate barycentric coordinates
-            float u = (v2.x * v1.y - v1.x * v2.y) / denom;
-            float v = (v0.x * v2.y - v2.x * v0.y) / denom;
-            float w = 1.0f - u - v;
-            
-            // Check if point is inside triangle
-            if (u >= 0 && v >= 0 && w >= 0) {
-                // Interpolate depth
-                float z = w * projected[0].z + u * projected[1].z + v * projected[2].z;
-                
-                int idx = y * SCREEN_WIDTH + x;
-                if (z > zbuffer[idx]) {
-                    zbuffer[idx] = z;
-                    
-                    // Interpolate intensity
-                    float intensity = w * intensities[0] + u * intensities[1] + v * intensities[2];
-                    int shadeIdx = std::min(SHADE_LEVELS - 1, (int)(intensity * SHADE_LEVELS));
-                    
-                    buffer[y][x] = SHADE_CHARS[shadeIdx];
-                }
-            }
+        int x = minX;
+#ifdef __wasm_simd128__
+        x = rasterizeRowSimd(buffer[y], &zbuffer[y * width], projected, intensities,
+                             v0, v1, denom, y, minX, maxX, depthResults);
+#endif
+        for (; x <= maxX; x++) {
+#ifdef TERMESH_STATS
+            depthResults[shadePixel(buffer, zbuffer, projected, intensities, v0, v1, denom, width, x, y)]++;
+#else
+            shadePixel(buffer, zbuffer, projected, intensities, v0, v1, denom, width, x, y);
+#endif
         }
     }
+#ifdef TERMESH_STATS
+    TERMESH_STAT(COUNTER_CELLS_TESTED, (uint64_t)(maxY - minY + 1) * std::max(0, maxX - minX + 1));
+    TERMESH_STAT(COUNTER_DEPTH_PASSES, depthResults[PIXEL_PASSED]);
+    TERMESH_STAT(COUNTER_DEPTH_FAILS, depthResults[PIXEL_FAILED]);
+#else
+    (void)depthResults;
+#endif
 }
 
 void clearBuffers(std::vector<std::string>& buffer, std::vector<float>& zbuffer) {
     for (auto& line : buffer) {
-        line.assign(SCREEN_WIDTH, ' '); // Efficiently reset the string
+        line.assign(line.size(), ' '); // Efficiently reset the string
+    }
+    fillFloats(zbuffer.data(), zbuffer.size(), -1e10f);
+}
+
+void clearRows(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+               int firstRow, int endRow) {
+    const int width = frameWidth(buffer);
+    for (int y = firstRow; y < endRow; y++) {
+        buffer[y].assign(buffer[y].size(), ' ');
     }
-    std::fill(zbuffer.begin(), zbuffer.end(), -1e10f);
+    fillFloats(zbuffer.data() + (size_t)firstRow * width, (size_t)(endRow - firstRow) * width, -1e10f);
 }
 
@@ -0,0 +1,115 @@
+#include "render_context.h"
+#include "pipeline.h"
+#include "rasterizer.h"
+#include "renderer.h"
+#include "trace.h"
+#include <chrono>
+#include <utility>
+
+#ifdef TERMESH_STATS
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Totals a render's counts come out of: a parallel render's work is
+    // spread over the job system's threads
+    RenderCounters counterTotals(bool parallel) {
+        return parallel ? allRenderCounters() : threadRenderCounters();
+    }
+} // anonymous namespace
+#endif
+
+const std::vector<Triangle> RenderContext::empty;
+
+RenderContext::RenderContext(int width, int height) : cols(0), rows(0) {
+    resize(width, height);
+}
+
+void RenderContext::resize(int width, int height) {
+    cols = width > 0 ? width : 1;
+    rows = height > 0 ? height : 1;
+    buffer.assign(rows, std::string(cols, ' '));
+    zbuffer.assign((size_t)cols * rows, -1e10f);
+    memory.set(frameMemoryBytes(buffer) + vectorBytes(zbuffer));
+}
+
+void RenderContext::setMesh(MeshRef mesh) {
+    model = std::move(mesh);
+}
+
+void RenderContext::render() {
+    TERMESH_TRACE_SCOPE("RenderContext::render");
+#ifdef TERMESH_STATS
+    const bool parallel = jobSystem != nullptr;
+    RenderCounters before = counterTotals(parallel);
+    Clock::time_point start = Clock::now();
+    frameStats.timings = StageTimings();
+#endif
+    if (jobSystem) {
+        renderFrameParallel(*jobSystem, buffer, zbuffer, mesh(), camera.rotation(), lightDir,
+                            parallelScratch);
+    } else {
+#ifdef TERMESH_STATS
+        // renderFrame()'s frame, with each stage timed
+        renderFrameTimed(buffer, zbuffer, mesh(), camera.rotation(), lightDir, QUALITY_LEVELS[0], scratch,
+                         frameStats.timings);
+#else
+        clearBuffers(buffer, zbuffer);
+        renderFrame(buffer, zbuffer, mesh(), camera.rotation(), lightDir);
+#endif
+    }
+#ifdef TERMESH_STATS
+    endStats(before, parallel, secondsSince(start));
+#endif
+    if (statsOverlay) drawStatsOverlay(buffer, frameStats);
+}
+
+void RenderContext::render(const std::vector<Triangle>& lod, const QualitySettings& quality) {
+    TERMESH_TRACE_SCOPE("RenderContext::render");
+#ifdef TERMESH_STATS
+    const bool parallel = jobSystem != nullptr;
+    RenderCounters before = counterTotals(parallel);
+#endif
+    if (jobSystem) {
+        renderFrameParallel(*jobSystem, buffer, zbuffer, lod, camera.rotation(), lightDir, parallelScratch,
+                            quality.sampleStep, &stageTimings);
+    } else {
+        renderFrameTimed(buffer, zbuffer, lod, camera.rotation(), lightDir, quality, scratch, stageTimings);
+    }
+#ifdef TERMESH_STATS
+    frameStats.timings = stageTimings;
+    endStats(before, parallel, stageTimings.total());
+#endif
+    if (statsOverlay) drawStatsOverlay(buffer, frameStats);
+}
+
+void RenderContext::renderSlice(const SliceIndex& index, float position, bool capped) {
+    TERMESH_TRACE_SCOPE("renderSlice");
+    clearBuffers(buffer, zbuffer);
+    ::renderSlice(buffer, zbuffer, mesh(), index, camera.rotation(), lightDir, position, capped,
+                  sliceScratch);
+}
+
+size_t RenderContext::present() {
+    if (!out) return 0;
+    TERMESH_TRACE_SCOPE("present");
+#ifdef TERMESH_STATS
+    Clock::time_point start = Clock::now();
+    size_t bytes = out->present(buffer);
+    frameStats.outputSeconds = secondsSince(start);
+    return bytes;
+#else
+    return out->present(buffer);
+#endif
+}
+
+#ifdef TERMESH_STATS
+void RenderContext::endStats(const RenderCounters& before, bool parallel, double seconds) {
+    frameStats.counters = counterTotals(parallel) - before;
+    frameStats.cellsCovered = coveredCells(zbuffer);
+    frameStats.frameSeconds = seconds;
+}
+#endif
@@ -0,0 +1,545 @@
+#include "render_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <future>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "log.h"
+#include "model.h"
+#include "slicer.h"
+#include "stl_stream.h"
+
+// A request waiting for its reply, owned by its connection's thread
+struct RenderServer::Pending {
+    RenderRequest request;
+    std::promise<std::string> reply;
+};
+
+namespace {
+    // How often run() checks for stop() while no one connects
+    constexpr int ACCEPT_POLL_MS = 100;
+
+    const char* MODE_NAMES[] = {"shaded", "slice", "cap"};
+
+    // Reads one line, without its newline, from `fd` through `buffer`
+    bool readLine(int fd, std::string& buffer, std::string& line) {
+        size_t newline;
+        while ((newline = buffer.find('\n')) == std::string::npos) {
+            char chunk[4096];
+            ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            buffer.append(chunk, got);
+        }
+        line.assign(buffer, 0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+    // Reads exactly `count` bytes, starting with what `buffer` already holds
+    bool readBytes(int fd, std::string& buffer, size_t count, std::vector<uint8_t>& out) {
+        out.resize(count);
+        size_t have = std::min(count, buffer.size());
+        std::memcpy(out.data(), buffer.data(), have);
+        buffer.erase(0, have);
+        while (have < count) {
+            ssize_t got = ::recv(fd, out.data() + have, count - have, 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            have += got;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            // No SIGPIPE when the other side has gone: the write just fails
+            ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            bytes += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const std::string& text) {
+        return writeAll(fd, text.data(), text.size());
+    }
+
+    bool socketAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    int connectTo(const std::string& path) {
+        sockaddr_un address;
+        if (!socketAddress(path, address)) return -1;
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Cache key of a request's model. Files are keyed by path, size and
+    // modification time, so an edited file is parsed again; inline models
+    // by a hash of their bytes.
+    std::string modelKey(const RenderRequest& request) {
+        char key[64];
+        if (!request.bytes.empty()) {
+            uint64_t hash = 1469598103934665603ull;     // FNV-1a
+            for (uint8_t byte : request.bytes) hash = (hash ^ byte) * 1099511628211ull;
+            std::snprintf(key, sizeof(key), "bytes:%016llx:%zu", (unsigned long long)hash, request.bytes.size());
+            return key;
+        }
+        struct stat info;
+        if (::stat(request.path.c_str(), &info) != 0) return "path:" + request.path;
+        std::snprintf(key, sizeof(key), ":%lld:%lld.%09ld", (long long)info.st_size,
+                      (long long)info.st_mtim.tv_sec, (long)info.st_mtim.tv_nsec);
+        return "path:" + request.path + key;
+    }
+
+    // Parses and normalizes a request's model
+    bool loadMesh(const RenderRequest& request, std::vector<Triangle>& mesh, std::string& error) {
+        float scale = 0.0f;
+        if (!request.bytes.empty()) {
+            StlStream stream;
+            stream.begin(request.bytes.size());
+            if (!stream.feed(request.bytes.data(), request.bytes.size(), mesh) || !stream.finish(mesh, scale)) {
+                error = "not an STL file, or no triangles";
+                return false;
+            }
+        } else {
+            if (!readSTL(request.path, mesh)) {
+                error = "cannot open " + request.path;
+                return false;
+            }
+            if (mesh.empty()) {
+                error = "no triangles in " + request.path;
+                return false;
+            }
+            normalizeModel(mesh, scale);
+        }
+        if (!std::isfinite(scale)) {
+            error = "degenerate model";
+            return false;
+        }
+        return true;
+    }
+
+    std::string errorReply(const std::string& message) {
+        return "ERR " + message + "\n";
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // anonymous namespace
+
+std::string encodeRequest(const RenderRequest& request) {
+    char header[160];
+    std::snprintf(header, sizeof(header), "RENDER %.9g %.9g %.9g %dx%d %s ",
+                  request.camera.angleX, request.camera.angleY, request.camera.angleZ,
+                  request.cols, request.rows, MODE_NAMES[(int)request.mode]);
+    if (!request.bytes.empty()) {
+        return header + std::string("BYTES ") + std::to_string(request.bytes.size());
+    }
+    return header + std::string("PATH ") + request.path;
+}
+
+bool parseRequest(const std::string& line, RenderRequest& request, size_t& byteCount, std::string& error) {
+    char modeName[16], source[16];
+    int consumed = 0;
+    Camera& camera = request.camera;
+    if (std::sscanf(line.c_str(), "RENDER %f %f %f %dx%d %15s %15s %n", &camera.angleX, &camera.angleY,
+                    &camera.angleZ, &request.cols, &request.rows, modeName, source, &consumed) != 7 ||
+        consumed == 0) {
+        error = "malformed request";
+        return false;
+    }
+    if (!std::isfinite(camera.angleX) || !std::isfinite(camera.angleY) || !std::isfinite(camera.angleZ)) {
+        error = "bad orientation";
+        return false;
+    }
+    if (request.cols <= 0 || request.rows <= 0 || (long long)request.cols * request.rows > SERVER_MAX_CELLS) {
+        error = "bad frame size";
+        return false;
+    }
+
+    int mode = 0;
+    while (mode < 3 && std::strcmp(modeName, MODE_NAMES[mode]) != 0) mode++;
+    if (mode == 3) {
+        error = std::string("unknown mode ") + modeName;
+        return false;
+    }
+    request.mode = (RenderMode)mode;
+
+    std::string rest = line.substr(consumed);
+    byteCount = 0;
+    if (std::strcmp(source, "PATH") == 0 && !rest.empty()) {
+        request.path = rest;
+        return true;
+    }
+    if (std::strcmp(source, "BYTES") == 0) {
+        char* end;
+        unsigned long long count = std::strtoull(rest.c_str(), &end, 10);
+        if (end != rest.c_str() && *end == '\0' && count > 0 && count <= SERVER_MAX_MODEL_BYTES) {
+            byteCount = (size_t)count;
+            return true;
+        }
+    }
+    error = "expected PATH <path> or BYTES <n>";
+    return false;
+}
+
+RenderServer::RenderServer(const ServerOptions& options) : options(options), cache(options.cacheBytes) {
+    pool.reset(new ThreadPool(options.threads));
+    for (int i = 0; i < pool->size(); i++) {
+        contexts.emplace_back(new RenderContext());
+    }
+}
+
+RenderServer::~RenderServer() {
+    stop();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+    }
+    // Wakes connection threads blocked reading; a thread waiting on a reply
+    // gets it first, since the workers are still running
+    for (auto& connection : connections) ::shutdown(connection->fd, SHUT_RDWR);
+    reapConnections(true);
+}
+
+bool RenderServer::listen(const std::string& path) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+        logError("Socket path too long: %s", path.c_str());
+        return false;
+    }
+    // A socket file nobody answers on is left over from an earlier run
+    int existing = connectTo(path);
+    if (existing >= 0) {
+        ::close(existing);
+        logError("A server is already listening on %s", path.c_str());
+        return false;
+    }
+    ::unlink(path.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        logError("Cannot listen on %s: %s", path.c_str(), std::strerror(errno));
+        if (listenFd >= 0) ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    socketPath = path;
+    return true;
+}
+
+void RenderServer::run() {
+    while (!stopping && listenFd >= 0) {
+        pollfd ready{listenFd, POLLIN, 0};
+        if (::poll(&ready, 1, ACCEPT_POLL_MS) <= 0) continue;
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        reapConnections(false);
+        connections.emplace_back(new Connection());
+        Connection& connection = *connections.back();
+        connection.fd = fd;
+        connection.thread = std::thread(&RenderServer::serveConnection, this, std::ref(connection));
+    }
+}
+
+void RenderServer::reapConnections(bool all) {
+    for (auto it = connections.begin(); it != connections.end();) {
+        Connection& connection = **it;
+        if (!all && !connection.done) {
+            ++it;
+            continue;
+        }
+        connection.thread.join();
+        ::close(connection.fd);
+        it = connections.erase(it);
+    }
+}
+
+void RenderServer::serveConnection(Connection& connection) {
+    std::string buffer, line, error;
+    while (!stopping && readLine(connection.fd, buffer, line)) {
+        if (line == "STATS") {
+            ServerStats s = stats();
+            char text[256];
+            std::snprintf(text, sizeof(text),
+                          "STATS requests=%zu errors=%zu batches=%zu largest_batch=%zu loads=%zu "
+                          "meshes=%zu cache_bytes=%zu hits=%zu misses=%zu evictions=%zu\n",
+                          s.requests, s.errors, s.batches, s.largestBatch, s.loads, s.meshes,
+                          s.cacheBytes, s.cache.hits, s.cache.misses, s.cache.evictions);
+            if (!writeAll(connection.fd, text)) break;
+            continue;
+        }
+
+        RenderRequest request;
+        size_t byteCount = 0;
+        std::string reply;
+        if (!parseRequest(line, request, byteCount, error)) {
+            // Model bytes may follow that cannot be told from the next request
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                counters.requests++;
+                counters.errors++;
+            }
+            writeAll(connection.fd, errorReply(error));
+            break;
+        } else if (byteCount > 0 && !readBytes(connection.fd, buffer, byteCount, request.bytes)) {
+            break;
+        } else {
+            reply = handle(request);
+        }
+        if (!writeAll(connection.fd, reply)) break;
+    }
+    // The client sees the end of the connection now; the fd is closed when
+    // the thread is reaped
+    ::shutdown(connection.fd, SHUT_RDWR);
+    connection.done = true;
+}
+
+std::string RenderServer::handle(RenderRequest& request) {
+    Pending pending;
+    pending.request = std::move(request);
+    std::future<std::string> reply = pending.reply.get_future();
+    std::string key = modelKey(pending.request);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        waiting[key].push_back(&pending);
+        // The first request for a model hands it to a worker; later ones
+        // join its queue
+        if (scheduled.insert(key).second) {
+            pool->submit([this, key](int worker) { serveModel(key, worker); });
+        }
+    }
+    return reply.get();
+}
+
+MeshRef RenderServer::meshFor(const std::string& key, const RenderRequest& request, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        MeshRef mesh = cache.lookup(key);
+        if (mesh) return mesh;
+    }
+    auto mesh = std::make_shared<std::vector<Triangle>>();
+    if (!loadMesh(request, *mesh, error)) return nullptr;
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    counters.loads++;
+    cache.store(key, mesh);
+    return mesh;
+}
+
+void RenderServer::serveModel(const std::string& key, int worker) {
+    RenderContext& context = *contexts[worker];
+    std::vector<Pending*> batch;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            auto it = waiting.find(key);
+            if (it == waiting.end() || it->second.empty()) {
+                waiting.erase(key);
+                scheduled.erase(key);
+                return;
+            }
+            batch.swap(it->second);
+        }
+
+        std::string error;
+        MeshRef mesh = meshFor(key, batch.front()->request, error);
+        {
+            // Counted before any reply goes out, so STATS after a reply includes it
+            std::lock_guard<std::mutex> lock(statsMutex);
+            counters.requests += batch.size();
+            counters.errors += mesh ? 0 : batch.size();
+            counters.batches++;
+            counters.largestBatch = std::max(counters.largestBatch, batch.size());
+        }
+
+        SliceIndex sliceIndex;
+        for (Pending* pending : batch) {
+            const RenderRequest& request = pending->request;
+            if (!mesh) {
+                pending->reply.set_value(errorReply(error));
+                continue;
+            }
+            if (context.width() != request.cols || context.height() != request.rows) {
+                context.resize(request.cols, request.rows);
+            }
+            context.setMesh(mesh);
+            context.camera = request.camera;
+            if (request.mode == RenderMode::Shaded) {
+                context.render();
+            } else {
+                // Built once per batch; cut through the middle of the model
+                if (sliceIndex.empty()) sliceIndex.build(*mesh, SliceAxis::Z);
+                float middle = (sliceIndex.minExtent() + sliceIndex.maxExtent()) * 0.5f;
+                context.renderSlice(sliceIndex, middle, request.mode == RenderMode::Cap);
+            }
+
+            std::string reply = "OK " + std::to_string(request.cols) + " " + std::to_string(request.rows) + "\n";
+            reply.reserve(reply.size() + (size_t)(request.cols + 1) * request.rows);
+            for (const auto& row : context.frame()) {
+                reply += row;
+                reply += '\n';
+            }
+            pending->reply.set_value(std::move(reply));
+        }
+        context.setMesh(nullptr);
+        batch.clear();
+    }
+}
+
+ServerStats RenderServer::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    ServerStats result = counters;
+    result.meshes = cache.meshes();
+    result.cacheBytes = cache.bytes();
+    result.cache = cache.stats;
+    return result;
+}
+
+RenderClient::~RenderClient() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool RenderClient::connect(const std::string& socketPath) {
+    if (fd >= 0) ::close(fd);
+    buffer.clear();
+    fd = connectTo(socketPath);
+    return fd >= 0;
+}
+
+bool RenderClient::readLine(std::string& line) {
+    return ::readLine(fd, buffer, line);
+}
+
+bool RenderClient::render(const RenderRequest& request, std::vector<std::string>& frame, std::string& error) {
+    std::string header = encodeRequest(request) + "\n";
+    if (fd < 0 || !writeAll(fd, header) || !writeAll(fd, request.bytes.data(), request.bytes.size())) {
+        error = "cannot send request";
+        return false;
+    }
+    std::string line;
+    if (!readLine(line)) {
+        error = "connection closed";
+        return false;
+    }
+    int cols = 0, rows = 0;
+    if (std::sscanf(line.c_str(), "OK %d %d", &cols, &rows) != 2) {
+        error = line.compare(0, 4, "ERR ") == 0 ? line.substr(4) : "bad reply: " + line;
+        return false;
+    }
+    frame.resize(rows);
+    for (auto& row : frame) {
+        if (!readLine(row)) {
+            error = "connection closed";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderClient::stats(std::string& line) {
+    return fd >= 0 && writeAll(fd, "STATS\n", 6) && readLine(line);
+}
+
+LoadStats runLoadGenerator(const LoadOptions& options) {
+    LoadStats result;
+    if (options.models.empty()) return result;
+
+    // One request per model to copy from; paths are made absolute, since the
+    // server may run in another directory
+    std::vector<RenderRequest> templates(options.models.size());
+    for (size_t m = 0; m < options.models.size(); m++) {
+        RenderRequest& request = templates[m];
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(options.models[m], error);
+        request.path = error ? options.models[m] : absolute.string();
+        request.cols = options.cols;
+        request.rows = options.rows;
+        request.mode = options.mode;
+        if (options.sendBytes) {
+            std::FILE* file = std::fopen(request.path.c_str(), "rb");
+            if (!file) continue;
+            char chunk[64 * 1024];
+            size_t got;
+            while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+                request.bytes.insert(request.bytes.end(), chunk, chunk + got);
+            }
+            std::fclose(file);
+        }
+    }
+
+    const int connections = std::max(1, options.connections);
+    std::atomic<int> next{0};
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<size_t> failures(connections, 0);
+    std::vector<std::string> errors(connections);
+    std::vector<std::thread> clients;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < connections; c++) {
+        clients.emplace_back([&, c] {
+            std::vector<RenderRequest> requests = templates;
+            RenderClient client;
+            bool connected = client.connect(options.socketPath);
+            std::vector<std::string> frame;
+            std::string error;
+            for (int i = next++; i < options.requests; i = next++) {
+                RenderRequest& request = requests[i % requests.size()];
+                request.camera = Camera{i * 0.05f, i * 0.065f, i * 0.035f};
+                auto sent = std::chrono::steady_clock::now();
+                if (connected && client.render(request, frame, error)) {
+                    latencies[c].push_back(secondsSince(sent) * 1000.0);
+                    continue;
+                }
+                failures[c]++;
+                if (errors[c].empty()) errors[c] = connected ? error : "cannot connect to " + options.socketPath;
+            }
+        });
+    }
+    for (auto& client : clients) client.join();
+    result.seconds = secondsSince(start);
+
+    std::vector<double> all;
+    for (int c = 0; c < connections; c++) {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        result.failures += failures[c];
+        if (result.firstError.empty()) result.firstError = errors[c];
+    }
+    result.requests = all.size();
+    if (!all.empty()) {
+        std::sort(all.begin(), all.end());
+        // Nearest rank
+        auto percentile = [&](double p) { return all[(size_t)std::ceil(p * all.size()) - 1]; };
+        result.p50Ms = percentile(0.50);
+        result.p99Ms = percentile(0.99);
+        result.maxMs = all.back();
+    }
+    return result;
+}
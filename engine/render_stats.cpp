@@ -0,0 +1,120 @@
+#include "render_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+const char* const RENDER_COUNTER_NAMES[RENDER_COUNTER_COUNT] = {
+    "submitted", "culled", "clipped", "degenerate", "rasterized", "tested", "passed", "failed",
+};
+
+namespace {
+    // One thread's totals. Only the owning thread writes them, so adding is
+    // a plain load and store; they are atomic so other threads may read them.
+    struct CounterBlock {
+        std::atomic<uint64_t> values[RENDER_COUNTER_COUNT];
+
+        CounterBlock() {
+            for (auto& value : values) value.store(0, std::memory_order_relaxed);
+        }
+
+        void addTo(RenderCounters& totals) const {
+            for (int i = 0; i < RENDER_COUNTER_COUNT; i++) {
+                totals.values[i] += values[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    // Blocks of the running threads, and the totals of those that have exited
+    std::mutex registryMutex;
+    std::vector<const CounterBlock*>& registry() {
+        static std::vector<const CounterBlock*> blocks;
+        return blocks;
+    }
+    RenderCounters retired;
+
+    // Registers the thread's block on first use and retires it at exit
+    struct ThreadCounters {
+        CounterBlock block;
+
+        ThreadCounters() {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry().push_back(&block);
+        }
+
+        ~ThreadCounters() {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            block.addTo(retired);
+            auto& blocks = registry();
+            blocks.erase(std::find(blocks.begin(), blocks.end(), &block));
+        }
+    };
+
+    thread_local ThreadCounters threadCounters;
+
+    double ms(double seconds) {
+        return seconds * 1000.0;
+    }
+} // anonymous namespace
+
+bool statsCounting() {
+#ifdef TERMESH_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void addRenderCounter(RenderCounter counter, uint64_t count) {
+    std::atomic<uint64_t>& value = threadCounters.block.values[counter];
+    value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+RenderCounters threadRenderCounters() {
+    RenderCounters totals;
+    threadCounters.block.addTo(totals);
+    return totals;
+}
+
+RenderCounters allRenderCounters() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    RenderCounters totals = retired;
+    for (const CounterBlock* block : registry()) block->addTo(totals);
+    return totals;
+}
+
+uint64_t coveredCells(const std::vector<float>& zbuffer) {
+    uint64_t covered = 0;
+    for (float z : zbuffer) covered += z > -1e10f;
+    return covered;
+}
+
+std::vector<std::string> statsLines(const FrameStats& stats) {
+    if (!statsCounting()) {
+        return {"stats: not counted in this build (make STATS=1)", "", ""};
+    }
+    const RenderCounters& c = stats.counters;
+    char lines[STATS_OVERLAY_ROWS][160];
+    std::snprintf(lines[0], sizeof(lines[0]),
+                  " tris %llu  culled %llu  clipped %llu  degenerate %llu  rasterized %llu ",
+                  (unsigned long long)c[COUNTER_SUBMITTED], (unsigned long long)c[COUNTER_CULLED],
+                  (unsigned long long)c[COUNTER_CLIPPED], (unsigned long long)c[COUNTER_DEGENERATE],
+                  (unsigned long long)c[COUNTER_RASTERIZED]);
+    std::snprintf(lines[1], sizeof(lines[1]),
+                  " cells tested %llu  depth pass %llu  fail %llu  covered %llu  overdraw %.2fx ",
+                  (unsigned long long)c[COUNTER_CELLS_TESTED], (unsigned long long)c[COUNTER_DEPTH_PASSES],
+                  (unsigned long long)c[COUNTER_DEPTH_FAILS], (unsigned long long)stats.cellsCovered,
+                  stats.overdraw());
+    std::snprintf(lines[2], sizeof(lines[2]),
+                  " ms: clear %.2f  geometry %.2f  raster %.2f  frame %.2f  output %.2f ",
+                  ms(stats.timings.clear), ms(stats.timings.geometry), ms(stats.timings.raster),
+                  ms(stats.frameSeconds), ms(stats.outputSeconds));
+    return {lines[0], lines[1], lines[2]};
+}
+
+void drawStatsOverlay(std::vector<std::string>& frame, const FrameStats& stats) {
+    std::vector<std::string> lines = statsLines(stats);
+    for (size_t y = 0; y < lines.size() && y < frame.size(); y++) {
+        frame[y].replace(0, std::min(lines[y].size(), frame[y].size()), lines[y], 0, frame[y].size());
+    }
+}
@@ -0,0 +1,115 @@
+#include "render_thread.h"
+#include <chrono>
+#include "trace.h"
+
+void FrameExchange::publish(const std::vector<std::string>& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Row strings keep their capacity, so after the first frames this is a
+    // plain copy with no allocation
+    if (front.size() != frame.size()) front.resize(frame.size());
+    for (size_t y = 0; y < frame.size(); y++) {
+        front[y].assign(frame[y]);
+    }
+    if (fresh) dropCount++;
+    fresh = true;
+    publishCount++;
+}
+
+bool FrameExchange::acquire(std::vector<std::string>& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!fresh) return false;
+    frame.swap(front);
+    fresh = false;
+    acquireCount++;
+    return true;
+}
+
+bool FrameExchange::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fresh;
+}
+
+size_t FrameExchange::published() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return publishCount;
+}
+
+size_t FrameExchange::acquired() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return acquireCount;
+}
+
+size_t FrameExchange::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropCount;
+}
+
+RenderThread::RenderThread(Step step, int fps, Idle idle)
+    : step(std::move(step)), idleWork(std::move(idle)), framesPerSecond(fps) {
+    thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+}
+
+void RenderThread::wake() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = true;
+    }
+    wakeup.notify_one();
+}
+
+void RenderThread::setFps(int fps) {
+    framesPerSecond = fps;
+    wake();
+}
+
+bool RenderThread::idle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sleeping && !woken;
+}
+
+void RenderThread::run() {
+    setTraceThreadName("render thread");
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point next = Clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        woken = false;
+        lock.unlock();
+        bool rendered = step();
+        lock.lock();
+
+        if (rendered) {
+            frameCount++;
+            int fps = framesPerSecond;
+            if (fps <= 0) continue;
+            // Absolute deadlines so render time does not drift the frame
+            // rate; stopping cuts the wait short
+            next += std::chrono::microseconds(1000000 / fps);
+            if (next < Clock::now()) next = Clock::now();
+            if (idleWork && !stopping) {
+                lock.unlock();
+                idleWork(std::chrono::duration<double>(next - Clock::now()).count());
+                lock.lock();
+            }
+            wakeup.wait_until(lock, next, [this] { return stopping; });
+        } else {
+            // Wakes that arrived while the step ran are not lost: `woken`
+            // is only cleared before calling it
+            if (woken) continue;
+            sleeping = true;
+            wakeup.wait(lock, [this] { return woken || stopping; });
+            sleeping = false;
+            next = Clock::now();
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#include "scheduler.h"
+
+bool FrameScheduler::tick() {
+    stats.ticks++;
+    return wantsTicks();
+}
+
+void FrameScheduler::captured() {
+    dirty = DIRTY_NONE;
+    capturing = true;
+}
+
+void FrameScheduler::rendered() {
+    stats.rendered++;
+    if (!capturing) dirty = DIRTY_NONE;
+    capturing = false;
+    if (!wantsTicks()) stats.suspensions++;
+}
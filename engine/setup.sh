@@ -16,19 +16,59 @@ fi
 # Create build directory
 mkdir -p build
 
-# Output names
+# Output names: single-threaded and threads builds (the page uses the latter
+# when it is cross-origin isolated, i.e. SharedArrayBuffer is available),
+# each with and without WebAssembly SIMD
 OUT=build/stl_viewer.js
+OUT_SIMD=build/stl_viewer_simd.js
+OUT_THREADS=build/stl_viewer_threads.js
+OUT_THREADS_SIMD=build/stl_viewer_threads_simd.js
 
-# Compile with Emscripten
-echo "Compiling with Emscripten..."
-emcc -o $OUT main.cpp renderer.cpp model.cpp projection.cpp lighting.cpp rasterizer.cpp \
-     -std=c++17 \
-     -I./include \
-     -s INVOKE_RUN=0 \
-     -s 'EXPORTED_RUNTIME_METHODS=["callMain", "FS"]' \
-     -s ALLOW_MEMORY_GROWTH=1 \
+SOURCES="main.cpp renderer.cpp model.cpp projection.cpp lighting.cpp rasterizer.cpp slicer.cpp display.cpp framestream.cpp font.cpp canvas.cpp frame_cache.cpp scheduler.cpp quality.cpp render_thread.cpp stl_stream.cpp render_context.cpp jobs.cpp pipeline.cpp arena.cpp log.cpp multiview.cpp render_stats.cpp trace.cpp memory_stats.cpp"
+
+COMMON_FLAGS=(
+     -std=c++17
+     -I./include
+     -s INVOKE_RUN=0
+     -s 'EXPORTED_FUNCTIONS=["_main", "_termesh_frame_data", "_termesh_frame_stride", "_termesh_frame_width", "_termesh_frame_height", "_termesh_load_model", "_termesh_play", "_termesh_unload_model", "_termesh_set_view", "_termesh_set_render_mode", "_termesh_set_output", "_termesh_render_frame", "_termesh_start_loop", "_termesh_stop_loop", "_termesh_rotate_view", "_termesh_set_light", "_termesh_set_auto_rotate", "_termesh_set_visible", "_termesh_set_frame_budget", "_termesh_quality_stats", "_termesh_frames_rendered", "_termesh_frames_presented", "_termesh_threaded", "_termesh_simd", "_termesh_stream_begin", "_termesh_stream_buffer", "_termesh_stream_chunk", "_termesh_stream_end", "_termesh_set_size", "_termesh_trace_start", "_termesh_trace_stop", "_termesh_trace_json", "_termesh_set_memory_budget", "_termesh_memory_stats"]'
+     -s 'EXPORTED_RUNTIME_METHODS=["callMain", "cwrap", "FS", "HEAPU8", "HEAPF32"]'
+     -s ALLOW_MEMORY_GROWTH=1
      -O2
+)
+
+# Threads build: renders on a pthread, with the frame split across job
+# workers on the remaining cores. The pool holds one worker per core, so every
+# thread exists before main() returns. Node is a target too, for
+# tests/node/render_thread.test.cjs.
+THREAD_FLAGS=(
+     -pthread
+     -DTERMESH_THREADS
+     -s 'PTHREAD_POOL_SIZE=(typeof navigator!="undefined"&&navigator.hardwareConcurrency)||4'
+     -s ENVIRONMENT=web,worker,node
+)
+
+# -msimd128 switches the kernels in simd.h and the rasterizer to their
+# wasm_simd128.h versions; frames are identical to the scalar build
+SIMD_FLAGS=(-msimd128)
+
+build() {
+    local out=$1
+    shift
+    echo "Compiling $out..."
+    emcc -o "$out" $SOURCES "${COMMON_FLAGS[@]}" "$@"
+}
 
-echo "✅ Build complete: $OUT"
+echo "Compiling with Emscripten..."
+build $OUT
+build $OUT_SIMD "${SIMD_FLAGS[@]}"
+build $OUT_THREADS "${THREAD_FLAGS[@]}"
+build $OUT_THREADS_SIMD "${THREAD_FLAGS[@]}" "${SIMD_FLAGS[@]}"
+
+echo "✅ Build complete: $OUT, $OUT_SIMD, $OUT_THREADS, $OUT_THREADS_SIMD"
 echo "The generated files are in build/ directory"
-echo "Copy them to ../src/ for the web interface"
+echo "Copy them to ../src/ for the web interface (index.*, index-simd.*, index-threads.*, index-threads-simd.*)"
+
+# Size and startup of each build against the last run, so regressions show up
+if command -v node &> /dev/null; then
+    node tests/node/wasm_metrics.cjs
+fi
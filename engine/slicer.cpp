@@ -0,0 +1,354 @@
+#include "slicer.h"
+#include "projection.h"
+#include "lighting.h"
+#include "rasterizer.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace {
+    // Contour pixels within this depth of the surface are treated as visible
+    constexpr float CONTOUR_DEPTH_BIAS = 0.5f;
+
+    float axisValue(const Vec3& v, SliceAxis axis) {
+        switch (axis) {
+            case SliceAxis::X: return v.x;
+            case SliceAxis::Y: return v.y;
+            default: return v.z;
+        }
+    }
+
+    Vec3 axisVector(SliceAxis axis) {
+        switch (axis) {
+            case SliceAxis::X: return Vec3(1, 0, 0);
+            case SliceAxis::Y: return Vec3(0, 1, 0);
+            default: return Vec3(0, 0, 1);
+        }
+    }
+
+    // Point where the edge between a vertex below and a vertex above the plane
+    // crosses it. Always interpolates from the lower vertex so that the two
+    // triangles sharing an edge produce bit-identical points.
+    Vec3 crossing(const Vec3& below, float dBelow, const Vec3& above, float dAbove) {
+        float t = dBelow / (dBelow - dAbove);
+        return below + (above - below) * t;
+    }
+
+    // Transforms, culls, lights and rasterizes one triangle (same steps as renderFrame)
+    void drawPiece(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                   const Vec3 vertices[3], const Vec3& normal,
+                   const Mat3& rotation, const Vec3& lightDir) {
+        Vec3 transformed[3];
+        for (int i = 0; i < 3; i++) {
+            transformed[i] = rotation * vertices[i];
+        }
+
+        Vec3 faceNormal = (transformed[1] - transformed[0]).cross(transformed[2] - transformed[0]).normalize();
+        if (faceNormal.dot(Vec3(0, 0, -1)) <= 0) return;
+
+        float intensity = calculateLighting((rotation * normal).normalize(), lightDir);
+        const ProjectionParams params = projectionFor(frameWidth(buffer), frameHeight(buffer));
+        Vec3 projected[3];
+        float intensities[3];
+        for (int i = 0; i < 3; i++) {
+            projected[i] = project(transformed[i], params);
+            intensities[i] = intensity;
+        }
+        rasterizeTriangle(buffer, zbuffer, projected, intensities);
+    }
+
+    // Renders the part of a straddling triangle that lies below the plane
+    void drawClipped(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                     const Triangle& tri, SliceAxis axis, float position,
+                     const Mat3& rotation, const Vec3& lightDir) {
+        // Sutherland-Hodgman against a single plane: at most 4 output vertices
+        Vec3 poly[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++) {
+            const Vec3& cur = tri.vertices[i];
+            const Vec3& next = tri.vertices[(i + 1) % 3];
+            float dCur = axisValue(cur, axis) - position;
+            float dNext = axisValue(next, axis) - position;
+
+            if (dCur <= 0) poly[count++] = cur;
+            if ((dCur <= 0) != (dNext <= 0)) {
+                poly[count++] = dCur <= 0 ? crossing(cur, dCur, next, dNext)
+                                          : crossing(next, dNext, cur, dCur);
+            }
+        }
+
+        for (int i = 1; i + 1 < count; i++) {
+            Vec3 piece[3] = {poly[0], poly[i], poly[i + 1]};
+            drawPiece(buffer, zbuffer, piece, tri.normal, rotation, lightDir);
+        }
+    }
+
+    float edgeFunction(const Vec3& a, const Vec3& b, float px, float py) {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+
+    // Tie-break for pixels exactly on an edge. Antisymmetric in the edge
+    // direction, so a pixel on an edge shared by two triangles is counted once.
+    bool ownsEdge(const Vec3& a, const Vec3& b) {
+        float dy = b.y - a.y;
+        return dy > 0 || (dy == 0 && b.x < a.x);
+    }
+
+    bool covers(float w, const Vec3& a, const Vec3& b) {
+        return w > 0 || (w == 0 && ownsEdge(a, b));
+    }
+
+    // Flips stencil parity for every pixel covered by a screen-space triangle
+    void toggleTriangle(std::vector<uint8_t>& parity, std::vector<float>& depth,
+                        int width, int height, Vec3 p0, Vec3 p1, Vec3 p2) {
+        float area = edgeFunction(p0, p1, p2.x, p2.y);
+        if (std::abs(area) < 1e-6f) return;
+        if (area < 0) {
+            std::swap(p1, p2);
+            area = -area;
+        }
+
+        int minX = std::max(0, (int)std::floor(std::min({p0.x, p1.x, p2.x})));
+        int maxX = std::min(width - 1, (int)std::ceil(std::max({p0.x, p1.x, p2.x})));
+        int minY = std::max(0, (int)std::floor(std::min({p0.y, p1.y, p2.y})));
+        int maxY = std::min(height - 1, (int)std::ceil(std::max({p0.y, p1.y, p2.y})));
+
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                float w0 = edgeFunction(p1, p2, (float)x, (float)y);
+                float w1 = edgeFunction(p2, p0, (float)x, (float)y);
+                float w2 = edgeFunction(p0, p1, (float)x, (float)y);
+                if (covers(w0, p1, p2) && covers(w1, p2, p0) && covers(w2, p0, p1)) {
+                    int idx = y * width + x;
+                    parity[idx] ^= 1;
+                    // All fan triangles lie in the slicing plane, so any of them gives the depth
+                    depth[idx] = (w0 * p0.z + w1 * p1.z + w2 * p2.z) / area;
+                }
+            }
+        }
+    }
+
+    // Fills the cut face with an even-odd stencil over a fan of the contour
+    // segments, which handles holes and concave sections without building loops.
+    void fillCap(std::vector<std::string>& buffer, std::vector<float>& zbuffer,
+                 SliceScratch& scratch, SliceAxis axis,
+                 const Mat3& rotation, const Vec3& lightDir) {
+        if (scratch.segments.empty()) return;
+
+        const int width = frameWidth(buffer), height = frameHeight(buffer);
+        const ProjectionParams params = projectionFor(width, height);
+        scratch.parity.assign((size_t)width * height, 0);
+        scratch.capDepth.resize((size_t)width * height);
+
+        Vec3 anchor = project(rotation * scratch.segments[0].a, params);
+        for (const auto& seg : scratch.segments) {
+            toggleTriangle(scratch.parity, scratch.capDepth, width, height, anchor,
+                           project(rotation * seg.a, params), project(rotation * seg.b, params));
+        }
+
+        // The cap faces the removed (positive) side of the plane
+        float intensity = calculateLighting((rotation * axisVector(axis)).normalize(), lightDir);
+        int shadeIdx = std::min(SHADE_LEVELS - 1, (int)(intensity * SHADE_LEVELS));
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int idx = y * width + x;
+                if (scratch.parity[idx] && scratch.capDepth[idx] > zbuffer[idx]) {
+                    zbuffer[idx] = scratch.capDepth[idx];
+                    buffer[y][x] = SHADE_CHARS[shadeIdx];
+                }
+            }
+        }
+    }
+
+    void drawContour(std::vector<std::string>& buffer, const std::vector<float>& zbuffer,
+                     const std::vector<SliceSegment>& segments,
+                     const Mat3& rotation, bool depthTest) {
+        const int width = frameWidth(buffer), height = frameHeight(buffer);
+        const ProjectionParams params = projectionFor(width, height);
+        for (const auto& seg : segments) {
+            Vec3 a = project(rotation * seg.a, params);
+            Vec3 b = project(rotation * seg.b, params);
+
+            int steps = (int)std::ceil(std::max(std::abs(b.x - a.x), std::abs(b.y - a.y)));
+            for (int s = 0; s <= steps; s++) {
+                float t = steps > 0 ? (float)s / steps : 0.0f;
+                int x = (int)std::lround(a.x + (b.x - a.x) * t);
+                int y = (int)std::lround(a.y + (b.y - a.y) * t);
+                if (x < 0 || x >= width || y < 0 || y >= height) continue;
+
+                float z = a.z + (b.z - a.z) * t;
+                if (!depthTest || z >= zbuffer[y * width + x] - CONTOUR_DEPTH_BIAS) {
+                    buffer[y][x] = SLICE_CONTOUR_CHAR;
+                }
+            }
+        }
+    }
+} // anonymous namespace
+
+void SliceIndex::build(const std::vector<Triangle>& triangles, SliceAxis axis) {
+    sliceAxis = axis;
+    nodes.clear();
+    nodeByMin.clear();
+    nodeByMax.clear();
+
+    const size_t count = triangles.size();
+    low.resize(count);
+    high.resize(count);
+    rangeMin = 1e10f;
+    rangeMax = -1e10f;
+
+    for (size_t i = 0; i < count; i++) {
+        float a = axisValue(triangles[i].vertices[0], axis);
+        float b = axisValue(triangles[i].vertices[1], axis);
+        float c = axisValue(triangles[i].vertices[2], axis);
+        low[i] = std::min({a, b, c});
+        high[i] = std::max({a, b, c});
+        rangeMin = std::min(rangeMin, low[i]);
+        rangeMax = std::max(rangeMax, high[i]);
+    }
+
+    byHigh.resize(count);
+    std::iota(byHigh.begin(), byHigh.end(), 0u);
+    if (count == 0) {
+        rangeMin = rangeMax = 0.0f;
+        memory.set(0);
+        return;
+    }
+
+    std::vector<uint32_t> ids = byHigh;
+    std::sort(byHigh.begin(), byHigh.end(),
+              [this](uint32_t a, uint32_t b) { return high[a] < high[b]; });
+
+    nodeByMin.reserve(count);
+    nodeByMax.reserve(count);
+    buildNode(ids);
+    memory.set(vectorBytes(low) + vectorBytes(high) + vectorBytes(nodes) + vectorBytes(nodeByMin) +
+               vectorBytes(nodeByMax) + vectorBytes(byHigh));
+}
+
+int32_t SliceIndex::buildNode(std::vector<uint32_t>& ids) {
+    if (ids.empty()) return -1;
+
+    // Center on the median midpoint: the median triangle always stays in this
+    // node and each side gets at most half of the rest, so depth is O(log n)
+    size_t mid = ids.size() / 2;
+    std::nth_element(ids.begin(), ids.begin() + mid, ids.end(),
+                     [this](uint32_t a, uint32_t b) { return low[a] + high[a] < low[b] + high[b]; });
+    float center = 0.5f * (low[ids[mid]] + high[ids[mid]]);
+
+    std::vector<uint32_t> leftIds, rightIds;
+    uint32_t begin = (uint32_t)nodeByMin.size();
+    for (uint32_t id : ids) {
+        if (high[id] < center) {
+            leftIds.push_back(id);
+        } else if (low[id] > center) {
+            rightIds.push_back(id);
+        } else {
+            nodeByMin.push_back(id);
+        }
+    }
+    uint32_t end = (uint32_t)nodeByMin.size();
+    std::vector<uint32_t>().swap(ids); // Release before recursing
+
+    nodeByMax.insert(nodeByMax.end(), nodeByMin.begin() + begin, nodeByMin.end());
+    std::sort(nodeByMin.begin() + begin, nodeByMin.end(),
+              [this](uint32_t a, uint32_t b) { return low[a] < low[b]; });
+    std::sort(nodeByMax.begin() + begin, nodeByMax.end(),
+              [this](uint32_t a, uint32_t b) { return high[a] > high[b]; });
+
+    int32_t self = (int32_t)nodes.size();
+    nodes.push_back({center, begin, end, -1, -1});
+
+    int32_t left = buildNode(leftIds);
+    nodes[self].left = left;
+    int32_t right = buildNode(rightIds);
+    nodes[self].right = right;
+    return self;
+}
+
+void SliceIndex::query(float position, std::vector<uint32_t>& out) const {
+    out.clear();
+    int32_t node = nodes.empty() ? -1 : 0;
+
+    while (node >= 0) {
+        const Node& n = nodes[node];
+        if (position < n.center) {
+            // Every triangle here ends past the center, so only the start matters
+            for (uint32_t i = n.begin; i < n.end && low[nodeByMin[i]] <= position; i++) {
+                out.push_back(nodeByMin[i]);
+            }
+            node = n.left;
+        } else {
+            for (uint32_t i = n.begin; i < n.end && high[nodeByMax[i]] >= position; i++) {
+                out.push_back(nodeByMax[i]);
+            }
+            node = n.right;
+        }
+    }
+}
+
+size_t SliceIndex::countBelow(float position) const {
+    auto it = std::lower_bound(byHigh.begin(), byHigh.end(), position,
+                               [this](uint32_t id, float p) { return high[id] < p; });
+    return (size_t)(it - byHigh.begin());
+}
+
+void sliceMesh(const std::vector<Triangle>& triangles, const SliceIndex& index,
+               float position, std::vector<uint32_t>& candidates,
+               std::vector<SliceSegment>& segments) {
+    segments.clear();
+    index.query(position, candidates);
+
+    for (uint32_t id : candidates) {
+        const Triangle& tri = triangles[id];
+        float d[3];
+        for (int i = 0; i < 3; i++) {
+            d[i] = axisValue(tri.vertices[i], index.axis()) - position;
+        }
+
+        Vec3 points[2];
+        int count = 0;
+        for (int i = 0; i < 3 && count < 2; i++) {
+            int j = (i + 1) % 3;
+            if ((d[i] < 0) == (d[j] < 0)) continue;
+            points[count++] = d[i] < 0 ? crossing(tri.vertices[i], d[i], tri.vertices[j], d[j])
+                                       : crossing(tri.vertices[j], d[j], tri.vertices[i], d[i]);
+        }
+
+        if (count == 2) {
+            segments.push_back({points[0], points[1]});
+        }
+    }
+}
+
+void renderSlice(std::vector<std::string>& buffer,
+                 std::vector<float>& zbuffer,
+                 const std::vector<Triangle>& model,
+                 const SliceIndex& index,
+                 const Mat3& rotation,
+                 const Vec3& lightDir,
+                 float position,
+                 bool capped,
+                 SliceScratch& scratch) {
+    sliceMesh(model, index, position, scratch.candidates, scratch.segments);
+
+    if (capped) {
+        // Triangles entirely below the plane are a prefix of the sorted list
+        const std::vector<uint32_t>& below = index.below();
+        size_t belowCount = index.countBelow(position);
+        for (size_t i = 0; i < belowCount; i++) {
+            const Triangle& tri = model[below[i]];
+            drawPiece(buffer, zbuffer, tri.vertices, tri.normal, rotation, lightDir);
+        }
+
+        // Straddling triangles are exactly the ones the contour query returned
+        for (uint32_t id : scratch.candidates) {
+            drawClipped(buffer, zbuffer, model[id], index.axis(), position, rotation, lightDir);
+        }
+
+        fillCap(buffer, zbuffer, scratch, index.axis(), rotation, lightDir);
+    }
+
+    drawContour(buffer, zbuffer, scratch.segments, rotation, capped);
+}
@@ -0,0 +1,197 @@
+#include "stl_stream.h"
+#include <algorithm>
+#include <cstring>
+#include "log.h"
+#include "memory_stats.h"
+#include "trace.h"
+
+namespace {
+    // Refit the preview once the bounds outgrow the current fit by this much
+    constexpr float REFIT_GROWTH = 1.1f;
+    // ...or once the bounds' center drifts by this fraction of the fitted size
+    constexpr float REFIT_SHIFT = 0.05f;
+} // anonymous namespace
+
+void StlStream::begin(size_t totalBytes, size_t budgetBytes) {
+    pending.clear();
+    raw.clear();
+    total = totalBytes;
+    memoryBudget = budgetBytes;
+    received = 0;
+    expected = 0;
+    headerDone = false;
+    isAscii = false;
+    failed = false;
+    minBounds = Vec3(1e10f, 1e10f, 1e10f);
+    maxBounds = Vec3(-1e10f, -1e10f, -1e10f);
+    center = Vec3();
+    fitScale = 1.0f;
+    fittedDim = 0.0f;
+    refitCount = 0;
+    trackScratch();
+}
+
+bool StlStream::feed(const uint8_t* data, size_t size, std::vector<Triangle>& model) {
+    if (failed) return false;
+    TERMESH_TRACE_SCOPE("StlStream::feed");
+    bool ok = consume(data, size, model);
+    trackScratch();
+    return ok;
+}
+
+bool StlStream::consume(const uint8_t* data, size_t size, std::vector<Triangle>& model) {
+    received += size;
+
+    if (isAscii) {
+        if (!fitsBudget(std::max(total, received), true)) return false;
+        pending.insert(pending.end(), data, data + size);
+        return true;
+    }
+
+    if (!headerDone) {
+        size_t take = std::min(STL_HEADER_SIZE - pending.size(), size);
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending.size() < STL_HEADER_SIZE) return true;
+
+        headerDone = true;
+        // The total is only a hint: a compressed download reports its
+        // compressed size. A binary file taken for ASCII here is recognised
+        // by finish() from the bytes that actually arrived.
+        if (isAsciiStl(pending.data(), pending.size(), total)) {
+            isAscii = true;
+            if (!fitsBudget(std::max(total, received), true)) return false;
+            // Text of a known size is held once, without growth slack
+            pending.reserve(total);
+            pending.insert(pending.end(), data, data + size);
+            return true;
+        }
+
+        // The count is known now, even when the file size was not
+        uint32_t count = 0;
+        std::memcpy(&count, pending.data() + 80, sizeof(uint32_t));
+        if (!fitsBudget(STL_HEADER_SIZE + static_cast<size_t>(count) * STL_RECORD_SIZE, false)) return false;
+        expected = count;
+        raw.reserve(expected);
+        model.clear();
+        model.reserve(expected);
+        pending.clear();
+    }
+
+    // Complete a record split across the previous chunk boundary
+    if (!pending.empty()) {
+        size_t take = std::min(STL_RECORD_SIZE - pending.size(), size);
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending.size() < STL_RECORD_SIZE) return true;
+        append(pending.data(), 1, model);
+        pending.clear();
+    }
+
+    size_t records = size / STL_RECORD_SIZE;
+    append(data, records, model);
+    size_t used = records * STL_RECORD_SIZE;
+    if (raw.size() < expected) {
+        pending.assign(data + used, data + size);
+    }
+    return true;
+}
+
+void StlStream::append(const uint8_t* records, size_t count, std::vector<Triangle>& model) {
+    // Bytes past the promised record count are trailing padding
+    count = std::min(count, expected - raw.size());
+    if (count == 0) return;
+
+    size_t first = raw.size();
+    parseStlRecords(records, count, raw);
+    for (size_t i = first; i < raw.size(); i++) {
+        for (const Vec3& v : raw[i].vertices) {
+            minBounds.x = std::min(minBounds.x, v.x);
+            minBounds.y = std::min(minBounds.y, v.y);
+            minBounds.z = std::min(minBounds.z, v.z);
+            maxBounds.x = std::max(maxBounds.x, v.x);
+            maxBounds.y = std::max(maxBounds.y, v.y);
+            maxBounds.z = std::max(maxBounds.z, v.z);
+        }
+    }
+
+    Vec3 size = maxBounds - minBounds;
+    float dim = std::max({size.x, size.y, size.z});
+    Vec3 drift = (minBounds + maxBounds) * 0.5f - center;
+    bool refit = fittedDim <= 0.0f || dim > fittedDim * REFIT_GROWTH ||
+                 drift.length() > fittedDim * REFIT_SHIFT;
+    if (refit) {
+        if (first > 0) refitCount++;
+        fit();
+        first = 0;
+    }
+
+    // Transform only the new triangles unless the fit changed
+    model.resize(raw.size());
+    for (size_t i = first; i < raw.size(); i++) {
+        model[i].normal = raw[i].normal;
+        for (int j = 0; j < 3; j++) {
+            model[i].vertices[j] = (raw[i].vertices[j] - center) * fitScale;
+        }
+    }
+}
+
+void StlStream::fit() {
+    Vec3 size = maxBounds - minBounds;
+    fittedDim = std::max({size.x, size.y, size.z});
+    center = (minBounds + maxBounds) * 0.5f;
+    fitScale = fittedDim > 0.0f ? 30.0f / fittedDim : 1.0f;
+}
+
+bool StlStream::finish(std::vector<Triangle>& model, float& scale) {
+    if (failed) return false;
+    TERMESH_TRACE_SCOPE("StlStream::finish");
+
+    // A tiny ASCII file may end before a full binary header arrived
+    if (!headerDone && isAsciiStl(pending.data(), pending.size(), received)) isAscii = true;
+
+    if (isAscii && !isAsciiStl(pending.data(), pending.size(), received)) {
+        // Binary after all, with a "solid" header: its size fits its count
+        uint32_t count = 0;
+        std::memcpy(&count, pending.data() + 80, sizeof(uint32_t));
+        expected = count;
+        raw.clear();
+        raw.reserve(expected);
+        parseStlRecords(pending.data() + STL_HEADER_SIZE, expected, raw);
+    } else if (isAscii) {
+        raw.clear();
+        parseAsciiStl(reinterpret_cast<const char*>(pending.data()), pending.size(), raw);
+    } else if (!headerDone || raw.size() < expected) {
+        logError("Error: STL stream ended after %zu of %zu triangles", raw.size(), expected);
+        failed = true;
+        return false;
+    }
+    pending.clear();
+    pending.shrink_to_fit();
+
+    if (raw.empty()) {
+        logError("Error: STL stream contained no triangles");
+        failed = true;
+        trackScratch();
+        return false;
+    }
+
+    model = std::move(raw);
+    raw = std::vector<Triangle>();
+    trackScratch();
+    normalizeModel(model, scale);
+    logInfo("Streamed %zu triangles (%zu bytes, %zu refits)", model.size(), received, refitCount);
+    return true;
+}
+
+bool StlStream::fitsBudget(size_t fileBytes, bool ascii) {
+    if (fitsMemoryBudget(estimateLoad(fileBytes, ascii, true), memoryBudget)) return true;
+    failed = true;
+    return false;
+}
+
+void StlStream::trackScratch() {
+    scratch.set(vectorBytes(pending) + vectorBytes(raw));
+}
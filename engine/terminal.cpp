@@ -0,0 +1,153 @@
+#include "terminal.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+    void appendNumber(std::string& out, int value) {
+        char digits[12];
+        int len = 0;
+        do {
+            digits[len++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (len > 0) out += digits[--len];
+    }
+
+    // CUP: rows and columns are 1-based on the terminal
+    void appendCursor(std::string& out, int row, int col) {
+        out += "\x1b[";
+        appendNumber(out, row + 1);
+        out += ';';
+        appendNumber(out, col + 1);
+        out += 'H';
+    }
+} // anonymous namespace
+
+size_t encodeTerminalPatch(const DisplayBuffer& front,
+                           const std::vector<std::string>& back,
+                           std::string& out) {
+    size_t glyphs = 0;
+    int cursorRow = -1, cursorCol = -1;
+
+    int height = std::min(front.height(), (int)back.size());
+    for (int y = 0; y < height; y++) {
+        const char* prev = front.row(y);
+        const std::string& line = back[y];
+        int width = std::min(front.width(), (int)line.size());
+
+        int x = 0;
+        while (x < width) {
+            if (prev[x] == line[x]) {
+                x++;
+                continue;
+            }
+
+            // Extend the run over further changes, absorbing short unchanged gaps
+            int last = x;
+            int scan = x + 1;
+            while (scan < width) {
+                if (prev[scan] != line[scan]) {
+                    last = scan++;
+                    continue;
+                }
+                int gapEnd = scan;
+                while (gapEnd < width && prev[gapEnd] == line[gapEnd]) gapEnd++;
+                if (gapEnd == width || gapEnd - scan >= TERMINAL_MAX_GAP) break;
+                scan = gapEnd;
+            }
+
+            if (cursorRow != y || cursorCol != x) {
+                appendCursor(out, y, x);
+            }
+            out.append(line.data() + x, last - x + 1);
+            glyphs += last - x + 1;
+
+            cursorRow = y;
+            cursorCol = last + 1;
+            x = last + 1;
+        }
+    }
+    return glyphs;
+}
+
+bool terminalSize(int fd, int& width, int& height) {
+    winsize ws{};
+    if (!isatty(fd) || ioctl(fd, TIOCGWINSZ, &ws) != 0 || ws.ws_col == 0 || ws.ws_row == 0) {
+        return false;
+    }
+    width = ws.ws_col;
+    height = ws.ws_row;
+    return true;
+}
+
+TerminalOutput::TerminalOutput(int width, int height, int fd)
+    : fd(fd), cols(width), rows(height), front(width, height),
+      scaled(height, std::string(width, ' ')) {
+    // Worst case: every cell rewritten plus a cursor move per row
+    out.reserve((size_t)rows * (cols + 16) + 32);
+}
+
+TerminalOutput::~TerminalOutput() {
+    if (!started) return;
+    // Park the cursor below the frame and show it again
+    out.clear();
+    appendCursor(out, rows, 0);
+    out += "\x1b[?25h";
+    writeAll(out);
+}
+
+size_t TerminalOutput::present(const std::vector<std::string>& buffer) {
+    const std::vector<std::string>& frame = fit(buffer);
+
+    out.clear();
+    if (!started) {
+        // Hide the cursor and clear, which matches the blank front buffer
+        out += "\x1b[?25l\x1b[2J";
+        started = true;
+    }
+
+    encodeTerminalPatch(front, frame, out);
+    front.update(frame);
+    frameCount++;
+
+    if (!out.empty()) {
+        writeAll(out);
+        byteCount += out.size();
+    }
+    return out.size();
+}
+
+const std::vector<std::string>& TerminalOutput::fit(const std::vector<std::string>& buffer) {
+    int srcHeight = (int)buffer.size();
+    int srcWidth = srcHeight > 0 ? (int)buffer[0].size() : 0;
+    if (srcWidth == cols && srcHeight == rows) return buffer;
+
+    // Nearest-neighbour resample into the persistent scaled buffer
+    for (int y = 0; y < rows; y++) {
+        std::string& line = scaled[y];
+        if (srcHeight == 0 || srcWidth == 0) {
+            line.assign(cols, ' ');
+            continue;
+        }
+        const std::string& src = buffer[(size_t)y * srcHeight / rows];
+        for (int x = 0; x < cols; x++) {
+            line[x] = src[(size_t)x * srcWidth / cols];
+        }
+    }
+    return scaled;
+}
+
+void TerminalOutput::writeAll(const std::string& data) {
+    // One write() per frame; the loop only matters for partial writes and EINTR
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n = ::write(fd, data.data() + offset, data.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        offset += (size_t)n;
+    }
+}
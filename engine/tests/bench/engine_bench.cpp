@@ -0,0 +1,126 @@
+// Engine benchmark suite: times each stage of a frame and whole frames over
+// a set of models at several frame sizes, writes the results as JSON and
+// compares them with a saved baseline. `make bench` runs it on models/:
+//
+//   engine_bench [--out FILE] [--baseline FILE] [--warmup N] [--repetitions N]
+//                [--cpu N] [--sizes WxH,WxH...] (model.stl | dir | @list)...
+//
+// --cpu -1 leaves the run unpinned. Measurements that got slower than the
+// baseline (see BenchComparison::slower()) are marked and counted; the exit
+// code is 1 only if the benchmark itself failed: an unknown option, a model
+// that could not be read, or nothing measured.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "log.h"
+#include "thumbnails.h"
+
+namespace {
+    bool parseSizes(const std::string& text, std::vector<BenchResolution>& sizes) {
+        sizes.clear();
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos) end = text.size();
+            BenchResolution size;
+            if (std::sscanf(text.substr(start, end - start).c_str(), "%dx%d", &size.cols, &size.rows) != 2 ||
+                size.cols <= 0 || size.rows <= 0) {
+                return false;
+            }
+            sizes.push_back(size);
+            start = end + 1;
+        }
+        return !sizes.empty();
+    }
+
+    int usage() {
+        logError("Usage: engine_bench [--out FILE] [--baseline FILE] [--warmup N] [--repetitions N] "
+                 "[--cpu N] [--sizes WxH,...] (model.stl | dir | @list)...");
+        return 1;
+    }
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    const char* outPath = nullptr;
+    const char* baselinePath = nullptr;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--cpu" && i + 1 < argc) {
+            options.cpu = std::atoi(argv[++i]);
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            if (!parseSizes(argv[++i], options.resolutions)) {
+                logError("Bad --sizes %s (expected WxH,WxH...)", argv[i]);
+                return 1;
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            logError("Unknown option %s", arg.c_str());
+            return usage();
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    std::vector<ThumbnailFailure> unreadable;
+    collectStlFiles(inputs, options.models, unreadable);
+    for (const auto& failure : unreadable) logError("%s: %s", failure.path.c_str(), failure.reason.c_str());
+    if (options.models.empty()) return usage();
+
+    BenchReport report = runBenchmarks(options);
+    if (options.cpu >= 0 && report.cpu < 0) {
+        logError("Could not pin to CPU %d; timings may be noisier", options.cpu);
+    }
+    for (const auto& path : report.failures) logError("%s: could not be read", path.c_str());
+
+    std::vector<BenchResult> baseline;
+    bool compared = baselinePath && loadBenchJson(baselinePath, baseline);
+    if (baselinePath && !compared) logInfo("No baseline at %s; saving results only", baselinePath);
+
+    logInfo("%-20s %9s  %-14s %10s %10s %10s %12s%s", "model", "size", "stage", "median ms", "p90 ms",
+            "p99 ms", "Mtri/s", compared ? "  vs baseline" : "");
+    int regressions = 0;
+    for (const BenchComparison& comparison : compareBench(report.results, baseline)) {
+        const BenchResult& r = comparison.current;
+        char size[32] = "-";
+        if (r.cols > 0) std::snprintf(size, sizeof(size), "%dx%d", r.cols, r.rows);
+        char change[32] = "";
+        if (comparison.compared) {
+            regressions += comparison.slower();
+            std::snprintf(change, sizeof(change), "  %+.1f%%%s", comparison.change() * 100.0,
+                          comparison.slower() ? " SLOWER" : "");
+        }
+        logInfo("%-20s %9s  %-14s %10.3f %10.3f %10.3f %12.2f%s", r.model.c_str(), size,
+                BENCH_STAGE_NAMES[r.stage], r.medianMs, r.p90Ms, r.p99Ms, r.trianglesPerSecond() / 1e6,
+                change);
+    }
+    logInfo("%zu measurements, each %d warmup + %d timed samples of %d runs, %s", report.results.size(),
+            report.warmup, report.repetitions, BENCH_SAMPLE_RUNS,
+            report.cpu >= 0 ? "pinned to one CPU" : "unpinned");
+    if (compared) {
+        logInfo("%d slower than the baseline by more than %.0f%% in every sample", regressions,
+                BENCH_REGRESSION_PERCENT);
+    }
+
+    if (outPath) {
+        if (!saveBenchJson(outPath, report)) {
+            logError("Failed to write %s", outPath);
+            return 1;
+        }
+        logInfo("Results written to %s", outPath);
+    }
+    // A run that measured nothing, or left models out, did not pass
+    if (report.results.empty() || !report.failures.empty() || !unreadable.empty()) return 1;
+    return 0;
+}
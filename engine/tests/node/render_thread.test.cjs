@@ -0,0 +1,92 @@
+// Shows that the threads build keeps rendering while the thread that
+// presents frames is blocked. Build with ./setup.sh, then run:
+//
+//   node tests/node/render_thread.test.cjs [build/stl_viewer_threads.js] [model.stl]
+//
+// Run against build/stl_viewer.js it fails, as it should: there the blocked
+// thread is the one that renders.
+
+const fs = require("fs");
+const path = require("path");
+
+const engineDir = path.resolve(__dirname, "..", "..");
+const script = path.resolve(process.argv[2] || path.join(engineDir, "build", "stl_viewer_threads.js"));
+const model = path.resolve(process.argv[3] || path.join(engineDir, "..", "models", "donut.stl"));
+
+const BLOCK_MS = 500;
+const FPS = 30;
+
+function sleep(ms) {
+    return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+// Keeps the calling thread busy without yielding to the event loop
+function block(ms) {
+    const end = Date.now() + ms;
+    while (Date.now() < end) {}
+}
+
+function check(condition, message) {
+    console.log(`${condition ? "✓" : "✗"} ${message}`);
+    if (!condition) process.exitCode = 1;
+}
+
+async function main() {
+    if (!fs.existsSync(script)) {
+        console.error(`Missing ${script}: run ./setup.sh first`);
+        process.exit(1);
+    }
+
+    const ready = new Promise((resolve) => {
+        globalThis.Module = {
+            print: () => {},
+            printErr: (text) => console.error(text),
+            onRuntimeInitialized: resolve,
+        };
+    });
+    require(script);
+    await ready;
+
+    const api = {
+        threaded: Module.cwrap("termesh_threaded", "number", []),
+        loadModel: Module.cwrap("termesh_load_model", "number", ["string"]),
+        startLoop: Module.cwrap("termesh_start_loop", null, ["number"]),
+        stopLoop: Module.cwrap("termesh_stop_loop", null, []),
+        rendered: Module.cwrap("termesh_frames_rendered", "number", []),
+        presented: Module.cwrap("termesh_frames_presented", "number", []),
+    };
+
+    Module.callMain([]);
+    Module.FS.writeFile("/model.stl", fs.readFileSync(model));
+    check(api.loadModel("/model.stl") === 1, `loaded ${path.basename(model)}`);
+    check(api.threaded() === 1, "engine renders on its own thread");
+
+    api.startLoop(FPS);
+    await sleep(300);
+    check(api.presented() > 0, "frames reach the presenter");
+
+    // The presenter (this thread) is stuck: no browser frames run, so
+    // nothing is presented, but the render thread carries on
+    const rendered = api.rendered();
+    const presented = api.presented();
+    block(BLOCK_MS);
+    const renderedWhileBlocked = api.rendered() - rendered;
+    const presentedWhileBlocked = api.presented() - presented;
+    console.log(`  while blocked for ${BLOCK_MS} ms: ${renderedWhileBlocked} rendered, ${presentedWhileBlocked} presented`);
+    check(presentedWhileBlocked === 0, "nothing presented while the presenter is blocked");
+    check(renderedWhileBlocked >= (BLOCK_MS / 1000) * FPS * 0.5, "render thread kept rendering");
+
+    // Once free, the presenter picks up the latest completed frame
+    const before = api.presented();
+    await sleep(200);
+    check(api.presented() > before, "presenter resumes with the newest frame");
+
+    api.stopLoop();
+    // The pthread pool keeps Node alive
+    process.exit(process.exitCode || 0);
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
@@ -0,0 +1,105 @@
+// Compares the scalar and SIMD WebAssembly builds on every model in models/.
+// Build with ./setup.sh, then run:
+//
+//   node tests/node/simd_benchmark.cjs [frames]
+//
+// Each build runs in its own Node process, since an Emscripten module owns
+// the global `Module`. Frames are rendered synchronously through the engine
+// API with the frame cache off, so every frame is rasterized.
+
+const fs = require("fs");
+const path = require("path");
+const { execFileSync } = require("child_process");
+
+const engineDir = path.resolve(__dirname, "..", "..");
+const modelsDir = path.join(engineDir, "..", "models");
+const BUILDS = {
+    scalar: path.join(engineDir, "build", "stl_viewer.js"),
+    simd: path.join(engineDir, "build", "stl_viewer_simd.js"),
+};
+const WARMUP_FRAMES = 10;
+
+// Child: renders `frames` frames of each model, prints ms/frame as JSON
+async function runChild(script, frames, models) {
+    const ready = new Promise((resolve) => {
+        globalThis.Module = { print: () => {}, printErr: () => {}, onRuntimeInitialized: resolve };
+    });
+    require(script);
+    await ready;
+
+    const api = {
+        simd: Module.cwrap("termesh_simd", "number", []),
+        loadModel: Module.cwrap("termesh_load_model", "number", ["string"]),
+        setView: Module.cwrap("termesh_set_view", null, ["number", "number", "number"]),
+        renderFrame: Module.cwrap("termesh_render_frame", null, []),
+        stopLoop: Module.cwrap("termesh_stop_loop", null, []),
+    };
+    Module.callMain(["--cache-mb", "0"]);
+
+    const results = { simd: api.simd() === 1, models: {} };
+    for (const model of models) {
+        Module.FS.writeFile("/model.stl", fs.readFileSync(model));
+        if (!api.loadModel("/model.stl")) continue;
+        api.stopLoop();
+
+        const render = (i) => {
+            api.setView(i * 0.05, i * 0.065, i * 0.035);
+            api.renderFrame();
+        };
+        for (let i = 0; i < WARMUP_FRAMES; i++) render(i);
+        const start = performance.now();
+        for (let i = 0; i < frames; i++) render(i);
+        results.models[path.basename(model)] = (performance.now() - start) / frames;
+    }
+    process.stdout.write(JSON.stringify(results));
+    process.exit(0);
+}
+
+function main() {
+    const frames = Number(process.argv[2]) || 200;
+    const models = fs.readdirSync(modelsDir)
+        .filter((name) => name.endsWith(".stl"))
+        .sort()
+        .map((name) => path.join(modelsDir, name));
+
+    const results = {};
+    for (const [name, script] of Object.entries(BUILDS)) {
+        if (!fs.existsSync(script)) {
+            console.error(`Missing ${script}: run ./setup.sh first`);
+            process.exit(1);
+        }
+        const output = execFileSync(process.execPath, [__filename, "--child", script, String(frames), ...models]);
+        results[name] = JSON.parse(output);
+    }
+    if (!results.simd.simd) {
+        console.error("warning: the SIMD build reports no SIMD support (built without -msimd128?)");
+    }
+
+    console.log(`${frames} frames per model, ms/frame\n`);
+    console.log(`${"model".padEnd(18)}${"scalar".padStart(10)}${"simd".padStart(10)}${"speedup".padStart(10)}`);
+    let scalarTotal = 0;
+    let simdTotal = 0;
+    for (const model of Object.keys(results.scalar.models)) {
+        const scalar = results.scalar.models[model];
+        const simd = results.simd.models[model];
+        scalarTotal += scalar;
+        simdTotal += simd;
+        console.log(
+            `${model.padEnd(18)}${scalar.toFixed(3).padStart(10)}${simd.toFixed(3).padStart(10)}` +
+                `${(scalar / simd).toFixed(2).padStart(9)}x`,
+        );
+    }
+    console.log(
+        `${"total".padEnd(18)}${scalarTotal.toFixed(3).padStart(10)}${simdTotal.toFixed(3).padStart(10)}` +
+            `${(scalarTotal / simdTotal).toFixed(2).padStart(9)}x`,
+    );
+}
+
+if (process.argv[2] === "--child") {
+    runChild(process.argv[3], Number(process.argv[4]), process.argv.slice(5)).catch((err) => {
+        console.error(err);
+        process.exit(1);
+    });
+} else {
+    main();
+}
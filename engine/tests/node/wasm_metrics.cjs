@@ -0,0 +1,97 @@
+// Reports the .wasm size and startup time of each WebAssembly build and
+// compares them with the previous run. ./setup.sh runs it after building;
+// to run it by hand:
+//
+//   node tests/node/wasm_metrics.cjs [runs]
+//
+// Startup is the time from require() to onRuntimeInitialized: compiling and
+// instantiating the module plus its static initializers. Each measurement
+// runs in a fresh Node process, since an Emscripten module owns the global
+// `Module`, and the fastest of `runs` is kept. Results are saved to
+// build/wasm-metrics.json as the baseline for the next run.
+
+const fs = require("fs");
+const path = require("path");
+const { execFileSync } = require("child_process");
+
+const engineDir = path.resolve(__dirname, "..", "..");
+const BASELINE = path.join(engineDir, "build", "wasm-metrics.json");
+const BUILDS = {
+    scalar: path.join(engineDir, "build", "stl_viewer.js"),
+    simd: path.join(engineDir, "build", "stl_viewer_simd.js"),
+    threads: path.join(engineDir, "build", "stl_viewer_threads.js"),
+    "threads-simd": path.join(engineDir, "build", "stl_viewer_threads_simd.js"),
+};
+// Size growth, in percent, reported as a regression
+const SIZE_TOLERANCE = 1;
+
+// Child: loads `script` and prints the milliseconds until the runtime is ready
+async function runChild(script) {
+    const start = performance.now();
+    const ready = new Promise((resolve) => {
+        globalThis.Module = { print: () => {}, printErr: () => {}, onRuntimeInitialized: resolve };
+    });
+    require(script);
+    await ready;
+    process.stdout.write(JSON.stringify({ startupMs: performance.now() - start }));
+    process.exit(0);
+}
+
+function measure(script, runs) {
+    let best = Infinity;
+    for (let i = 0; i < runs; i++) {
+        const output = execFileSync(process.execPath, [__filename, "--child", script]);
+        best = Math.min(best, JSON.parse(output).startupMs);
+    }
+    return best;
+}
+
+function change(now, before) {
+    if (before === undefined) return "";
+    const percent = ((now - before) / before) * 100;
+    return `${percent >= 0 ? "+" : ""}${percent.toFixed(1)}%`;
+}
+
+function main() {
+    const runs = Number(process.argv[2]) || 3;
+    const baseline = fs.existsSync(BASELINE) ? JSON.parse(fs.readFileSync(BASELINE, "utf8")) : {};
+
+    const results = {};
+    for (const [name, script] of Object.entries(BUILDS)) {
+        const wasm = script.replace(/\.js$/, ".wasm");
+        if (!fs.existsSync(script) || !fs.existsSync(wasm)) continue;
+        results[name] = { wasmBytes: fs.statSync(wasm).size, startupMs: measure(script, runs) };
+    }
+    if (Object.keys(results).length === 0) {
+        console.error("No WASM builds in build/: run ./setup.sh first");
+        process.exit(1);
+    }
+
+    console.log(`${"build".padEnd(14)}${"wasm bytes".padStart(12)}${"change".padStart(9)}` +
+                `${"startup ms".padStart(12)}${"change".padStart(9)}`);
+    const regressions = [];
+    for (const [name, now] of Object.entries(results)) {
+        const before = baseline[name] || {};
+        console.log(
+            `${name.padEnd(14)}${String(now.wasmBytes).padStart(12)}` +
+                `${change(now.wasmBytes, before.wasmBytes).padStart(9)}` +
+                `${now.startupMs.toFixed(1).padStart(12)}${change(now.startupMs, before.startupMs).padStart(9)}`,
+        );
+        if (before.wasmBytes && now.wasmBytes > before.wasmBytes * (1 + SIZE_TOLERANCE / 100)) {
+            regressions.push(`${name}: ${before.wasmBytes} -> ${now.wasmBytes} bytes`);
+        }
+    }
+    // Startup time is too noisy to judge a single run by; size is not
+    for (const regression of regressions) console.error(`warning: .wasm grew, ${regression}`);
+
+    fs.writeFileSync(BASELINE, JSON.stringify(results, null, 2) + "\n");
+}
+
+if (process.argv[2] === "--child") {
+    runChild(process.argv[3]).catch((err) => {
+        console.error(err);
+        process.exit(1);
+    });
+} else {
+    main();
+}
@@ -0,0 +1,117 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "animation.h"
+#include "font.h"
+#include "rasterizer.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    std::vector<std::string> blankFrame(int width, int height) {
+        return std::vector<std::string>(height, std::string(width, ' '));
+    }
+}
+
+void testFontGlyphs() {
+    const uint8_t* blank = fontGlyph(' ');
+    const uint8_t* bar = fontGlyph('|');
+    const uint8_t* at = fontGlyph('@');
+    int blankBits = 0, atBits = 0;
+    for (int y = 0; y < FONT_GLYPH_HEIGHT; y++) {
+        blankBits += blank[y];
+        ASSERT_EQ((int)bar[y], 0x04);       // Centre column, every row
+        for (int x = 0; x < FONT_GLYPH_WIDTH; x++) atBits += (at[y] >> x) & 1;
+    }
+    ASSERT_EQ(blankBits, 0);
+    ASSERT_TRUE(atBits > 15);
+
+    // Outside the printable range draws nothing
+    const uint8_t* control = fontGlyph('\t');
+    for (int y = 0; y < FONT_GLYPH_HEIGHT; y++) ASSERT_EQ((int)control[y], 0);
+}
+
+void testChangedCells() {
+    std::vector<std::string> a = blankFrame(30, 10);
+    std::vector<std::string> b = a;
+
+    CellRect none = changedCells(a, b);
+    ASSERT_EQ(none.left, 0);
+    ASSERT_EQ(none.right, 0);
+    ASSERT_EQ(none.top, 0);
+    ASSERT_EQ(none.bottom, 0);
+
+    b[2][20] = '#';
+    b[6][4] = '.';
+    CellRect rect = changedCells(a, b);
+    ASSERT_EQ(rect.left, 4);
+    ASSERT_EQ(rect.right, 20);
+    ASSERT_EQ(rect.top, 2);
+    ASSERT_EQ(rect.bottom, 6);
+}
+
+void testDrawGlyphs() {
+    std::vector<std::string> frame = blankFrame(4, 2);
+    frame[1][2] = '@';
+    frame[1][3] = '.';
+
+    std::vector<uint8_t> pixels;
+    drawGlyphs(frame, CellRect{2, 1, 3, 1}, pixels);
+    int pitch = 2 * FONT_CELL_WIDTH;
+    ASSERT_EQ(pixels.size(), (size_t)(pitch * FONT_CELL_HEIGHT));
+
+    // Brightest shade in the first cell, dimmest in the second, gaps blank
+    int bright = 0, dim = 0;
+    for (int y = 0; y < FONT_CELL_HEIGHT; y++) {
+        for (int x = 0; x < pitch; x++) {
+            uint8_t p = pixels[y * pitch + x];
+            if (x < FONT_CELL_WIDTH) ASSERT_TRUE(p == 0 || p == ANIMATION_COLORS - 1);
+            else ASSERT_TRUE(p == 0 || p == 1);
+            bright += p == ANIMATION_COLORS - 1;
+            dim += p == 1;
+        }
+    }
+    ASSERT_TRUE(bright > 0);
+    ASSERT_TRUE(dim > 0);
+    for (int x = 0; x < pitch; x++) ASSERT_EQ((int)pixels[x], 0);
+}
+
+void testExportWritesGif() {
+    const std::string filename = "/tmp/test_animation.gif";
+    AnimationOptions options;
+    options.frames = 6;
+    options.threads = 3;
+    AnimationStats stats;
+    ASSERT_TRUE(exportAnimationGif(makeTriangle(), Vec3(0.0f, 0.0f, -1.0f), filename, options, &stats));
+    ASSERT_EQ(stats.threads, 3);
+    ASSERT_EQ(stats.width, SCREEN_WIDTH * FONT_CELL_WIDTH);
+    ASSERT_EQ(stats.height, SCREEN_HEIGHT * FONT_CELL_HEIGHT);
+
+    std::ifstream file(filename, std::ios::binary);
+    std::vector<uint8_t> gif((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(gif.size(), stats.bytes);
+    ASSERT_TRUE(gif.size() > 100);
+    ASSERT_TRUE(std::string(gif.begin(), gif.begin() + 6) == "GIF89a");
+    ASSERT_EQ((int)gif.back(), 0x3B);
+
+    // One graphic control extension per frame
+    int frames = 0;
+    for (size_t i = 0; i + 1 < gif.size(); i++) {
+        if (gif[i] == 0x21 && gif[i + 1] == 0xF9 && gif[i + 2] == 4) frames++;
+    }
+    ASSERT_TRUE(frames >= options.frames);
+    std::remove(filename.c_str());
+
+    ASSERT_FALSE(exportAnimationGif(makeTriangle(), Vec3(0.0f, 0.0f, -1.0f), "/nonexistent/dir/out.gif", options));
+}
+
+int main() {
+    std::cout << "Running animation export tests..." << std::endl;
+    RUN_TEST(testFontGlyphs);
+    RUN_TEST(testChangedCells);
+    RUN_TEST(testDrawGlyphs);
+    RUN_TEST(testExportWritesGif);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
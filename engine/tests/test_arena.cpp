@@ -0,0 +1,160 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "arena.h"
+#include "alloc_counter.h"
+#include "canvas.h"
+#include "pipeline.h"
+#include "renderer.h"
+#include "terminal.h"
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    // Heap allocations made while running `frames` frames of `step`
+    template <typename Step>
+    size_t allocationsOver(int frames, Step step) {
+        size_t before = heapAllocations();
+        for (int f = 0; f < frames; f++) step(f);
+        return heapAllocations() - before;
+    }
+
+    // Keeps new-expressions from being optimized away
+    int* volatile escaped = nullptr;
+
+    constexpr int WARMUP_FRAMES = 30;
+    constexpr int STEADY_FRAMES = 30;
+
+    // The same orientations every cycle, so warm-up sees every frame's needs
+    Camera cameraFor(int frame) {
+        int step = frame % WARMUP_FRAMES;
+        return Camera{step * 0.21f, step * 0.37f, step * 0.05f};
+    }
+}
+
+void testArenaAlignmentAndReset() {
+    FrameArena arena(256);
+    char* byte = arena.allocate<char>(3);
+    double* values = arena.allocate<double>(4);
+    ASSERT_TRUE(byte != nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(values) % alignof(double), (uintptr_t)0);
+    void* wide = arena.allocate(10, 64);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(wide) % 64, (uintptr_t)0);
+    ASSERT_EQ(arena.used(), (size_t)(3 + 4 * sizeof(double) + 10));
+
+    // A reset hands the same memory out again
+    arena.reset();
+    ASSERT_EQ(arena.used(), (size_t)0);
+    ASSERT_TRUE(arena.allocate<char>(3) == byte);
+}
+
+void testArenaGrowsThenSettles() {
+    FrameArena arena(1024);
+    // More than one block's worth in one frame
+    for (int i = 0; i < 10; i++) arena.allocate(700, 8);
+    ASSERT_TRUE(arena.blockCount() > 1);
+    size_t capacity = arena.capacity();
+    ASSERT_TRUE(capacity >= 7000);
+
+    // The next reset merges the blocks, after which the same frame fits
+    arena.reset();
+    ASSERT_EQ(arena.blockCount(), (size_t)1);
+    ASSERT_EQ(arena.capacity(), capacity);
+    size_t before = heapAllocations();
+    for (int frame = 0; frame < 5; frame++) {
+        arena.reset();
+        for (int i = 0; i < 10; i++) arena.allocate(700, 8);
+    }
+    ASSERT_EQ(heapAllocations() - before, (size_t)0);
+    ASSERT_EQ(arena.blockCount(), (size_t)1);
+
+    // Requests bigger than a block get a block of their own
+    char* big = arena.allocate<char>(100000);
+    big[99999] = 1;
+    ASSERT_TRUE(arena.capacity() >= capacity + 100000);
+}
+
+void testCounterSeesAllocations() {
+    ASSERT_TRUE(allocationCounting());
+    size_t before = heapAllocations();
+    std::vector<int>* values = new std::vector<int>(100);
+    delete values;
+    ASSERT_EQ(heapAllocations() - before, (size_t)2);
+
+    static size_t hooked = 0;
+    static size_t hookedBytes = 0;
+    AllocationHook previous = setAllocationHook([](size_t bytes) {
+        hooked++;
+        hookedBytes += bytes;
+    });
+    escaped = new int(7);
+    setAllocationHook(previous);
+    delete escaped;
+    ASSERT_EQ(hooked, (size_t)1);
+    ASSERT_EQ(hookedBytes, sizeof(int));
+}
+
+void testSteadyStateFramesDoNotAllocate() {
+    MeshRef sphere = normalizedMesh(makeSphere(30, 60));
+    JobSystem jobs(2);
+
+    RenderContext serial, parallel, reduced;
+    serial.setMesh(sphere);
+    parallel.setMesh(sphere);
+    parallel.setJobs(&jobs);
+    reduced.setMesh(sphere);
+    LodChain lods;
+    lods.build(*sphere);
+
+    SliceIndex index;
+    index.build(*sphere, SliceAxis::Y);
+    RenderContext sliced;
+    sliced.setMesh(sphere);
+    auto slicePosition = [&](int frame) {
+        return index.minExtent() + (index.maxExtent() - index.minExtent()) * (frame % WARMUP_FRAMES) / WARMUP_FRAMES;
+    };
+
+    // Every sink on the same frames, the terminal one writing to /dev/null
+    int devNull = open("/dev/null", O_WRONLY);
+    ASSERT_TRUE(devNull >= 0);
+    TerminalOutput terminal(SCREEN_WIDTH, SCREEN_HEIGHT, devNull);
+    TextSink text(SCREEN_WIDTH, SCREEN_HEIGHT, [](const DisplayBuffer&) {});
+    CanvasSink canvas(SCREEN_WIDTH, SCREEN_HEIGHT, [](const CanvasBuffer&, const PixelRect&) {});
+    TextSink piped(SCREEN_WIDTH, SCREEN_HEIGHT, [](const DisplayBuffer&) {});
+    FramePipeline pipeline(jobs, SCREEN_WIDTH, SCREEN_HEIGHT, 2);
+
+    auto frame = [&](int f) {
+        Camera camera = cameraFor(f);
+        serial.camera = parallel.camera = reduced.camera = sliced.camera = camera;
+        serial.render();
+        parallel.render();
+        const QualitySettings& quality = QUALITY_LEVELS[f % QUALITY_LEVEL_COUNT];
+        reduced.render(lods.select(*sphere, quality.lod), quality);
+        sliced.renderSlice(index, slicePosition(f), f % 2 == 0);
+
+        terminal.present(serial.frame());
+        text.present(parallel.frame());
+        canvas.present(reduced.frame());
+        pipeline.submit(sphere, camera, defaultLightDir(), &piped);
+    };
+
+    allocationsOver(WARMUP_FRAMES * 2, frame);
+    pipeline.flush();
+    size_t steady = allocationsOver(STEADY_FRAMES, frame);
+    pipeline.flush();
+    close(devNull);
+
+    ASSERT_EQ(steady, (size_t)0);
+    ASSERT_TRUE(piped.display().stats.frames > 0);
+}
+
+int main() {
+    std::cout << "Running arena tests..." << std::endl;
+    RUN_TEST(testArenaAlignmentAndReset);
+    RUN_TEST(testArenaGrowsThenSettles);
+    RUN_TEST(testCounterSeesAllocations);
+    RUN_TEST(testSteadyStateFramesDoNotAllocate);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,122 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "bench.h"
+#include "model.h"
+
+namespace {
+    BenchResult makeResult(const std::string& model, int cols, BenchStage stage, double medianMs) {
+        BenchResult result;
+        result.model = model;
+        result.triangles = 1000;
+        result.cols = cols;
+        result.rows = cols / 3;
+        result.stage = stage;
+        result.medianMs = result.p90Ms = result.p99Ms = result.meanMs = medianMs;
+        result.minMs = medianMs * 0.9;
+        result.maxMs = medianMs * 1.1;
+        return result;
+    }
+}
+
+void testSummarizeSamples() {
+    std::vector<double> samples = {5, 1, 4, 2, 3, 10, 6, 7, 9, 8};
+    BenchResult result;
+    summarizeSamples(samples, result);
+    ASSERT_EQ(result.medianMs, 5.0);
+    ASSERT_EQ(result.p90Ms, 9.0);
+    ASSERT_EQ(result.p99Ms, 10.0);
+    ASSERT_EQ(result.minMs, 1.0);
+    ASSERT_EQ(result.maxMs, 10.0);
+    ASSERT_FLOAT_EQ(result.meanMs, 5.5, 1e-9);
+
+    std::vector<double> one = {2.5};
+    summarizeSamples(one, result);
+    ASSERT_EQ(result.medianMs, 2.5);
+    ASSERT_EQ(result.p99Ms, 2.5);
+
+    result.triangles = 1000;
+    result.medianMs = 2.0;
+    ASSERT_FLOAT_EQ(result.trianglesPerSecond(), 500000.0, 1e-6);
+}
+
+void testJsonRoundTripAndComparison() {
+    BenchReport report;
+    report.cpu = 0;
+    report.warmup = 2;
+    report.repetitions = 10;
+    report.results.push_back(makeResult("odd \"name\\\".stl", 0, BENCH_LOAD, 1.25));
+    report.results.push_back(makeResult("donut.stl", 240, BENCH_RASTER, 0.5));
+    report.results.push_back(makeResult("donut.stl", 240, BENCH_FRAME, 2.0));
+    report.failures.push_back("missing.stl");
+
+    std::string path = "/tmp/termesh_bench_test.json";
+    ASSERT_TRUE(saveBenchJson(path, report));
+    std::vector<BenchResult> loaded;
+    ASSERT_TRUE(loadBenchJson(path, loaded));
+    ASSERT_EQ(loaded.size(), (size_t)3);
+    ASSERT_TRUE(loaded[0].model == "odd \"name\\\".stl");
+    ASSERT_TRUE(loaded[1].stage == BENCH_RASTER);
+    ASSERT_EQ(loaded[1].cols, 240);
+    ASSERT_EQ(loaded[1].rows, 80);
+    ASSERT_EQ(loaded[1].triangles, (size_t)1000);
+    ASSERT_FLOAT_EQ(loaded[2].medianMs, 2.0, 1e-6);
+    ASSERT_FLOAT_EQ(loaded[2].maxMs, 2.2, 1e-6);
+    ASSERT_FALSE(loadBenchJson("/tmp/termesh_bench_missing.json", loaded));
+
+    // Matched by model, size and stage
+    std::vector<BenchResult> current = {
+        makeResult("donut.stl", 240, BENCH_RASTER, 0.7),     // 40% slower, no overlap
+        makeResult("donut.stl", 240, BENCH_FRAME, 2.3),      // 15% slower, overlapping samples
+        makeResult("donut.stl", 80, BENCH_FRAME, 1.0),       // Not in the baseline
+    };
+    std::vector<BenchComparison> comparisons = compareBench(current, report.results);
+    ASSERT_EQ(comparisons.size(), (size_t)3);
+    ASSERT_TRUE(comparisons[0].compared);
+    ASSERT_FLOAT_EQ(comparisons[0].change(), 0.4, 1e-9);
+    ASSERT_TRUE(comparisons[0].slower());
+    ASSERT_FLOAT_EQ(comparisons[1].change(), 0.15, 1e-9);
+    ASSERT_FALSE(comparisons[1].slower());
+    ASSERT_FALSE(comparisons[2].compared);
+    ASSERT_FALSE(comparisons[2].slower());
+}
+
+void testRunsEveryStage() {
+    std::string path = "/tmp/termesh_bench_cube.stl";
+    writeStl(path, makeCube(1.0f));
+
+    BenchOptions options;
+    options.models = {path, "/tmp/termesh_bench_missing.stl"};
+    options.resolutions = {{40, 12}, {60, 20}};
+    options.warmup = 0;
+    options.repetitions = 2;
+    options.cpu = -1;
+    BenchReport report = runBenchmarks(options);
+
+    ASSERT_EQ(report.failures.size(), (size_t)1);
+    ASSERT_EQ(report.cpu, -1);
+    // Load and normalize once, the four render stages per size
+    ASSERT_EQ(report.results.size(), (size_t)(2 + 4 * 2));
+    int perStage[BENCH_STAGE_COUNT] = {};
+    for (const BenchResult& result : report.results) {
+        perStage[result.stage]++;
+        ASSERT_TRUE(result.model == "termesh_bench_cube.stl");
+        ASSERT_EQ(result.triangles, (size_t)12);
+        ASSERT_TRUE(result.minMs <= result.medianMs && result.medianMs <= result.maxMs);
+        ASSERT_TRUE(result.maxMs > 0.0);
+        bool framed = result.stage != BENCH_LOAD && result.stage != BENCH_NORMALIZE;
+        ASSERT_EQ(result.cols > 0, framed);
+    }
+    ASSERT_EQ(perStage[BENCH_LOAD], 1);
+    ASSERT_EQ(perStage[BENCH_RASTER], 2);
+    ASSERT_EQ(perStage[BENCH_FRAME], 2);
+}
+
+int main() {
+    std::cout << "Running benchmark suite tests..." << std::endl;
+    RUN_TEST(testSummarizeSamples);
+    RUN_TEST(testJsonRoundTripAndComparison);
+    RUN_TEST(testRunsEveryStage);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,124 @@
+#include "test_framework.h"
+#include "canvas.h"
+#include "renderer.h"
+#include <cstring>
+
+namespace {
+    const int COLS = 20;
+    const int ROWS = 6;
+
+    std::vector<std::string> blankFrame() {
+        return std::vector<std::string>(ROWS, std::string(COLS, ' '));
+    }
+
+    uint32_t pixelAt(const CanvasBuffer& canvas, int x, int y) {
+        uint32_t p;
+        std::memcpy(&p, canvas.data() + ((size_t)y * canvas.width() + x) * 4, 4);
+        return p;
+    }
+
+    // Foreground pixels inside one cell
+    int litPixels(const CanvasBuffer& canvas, int col, int row) {
+        int lit = 0;
+        for (int y = 0; y < FONT_CELL_HEIGHT; y++) {
+            for (int x = 0; x < FONT_CELL_WIDTH; x++) {
+                lit += pixelAt(canvas, col * FONT_CELL_WIDTH + x, row * FONT_CELL_HEIGHT + y) == CANVAS_FOREGROUND;
+            }
+        }
+        return lit;
+    }
+}
+
+void testStartsBlank() {
+    CanvasBuffer canvas(COLS, ROWS);
+    ASSERT_EQ(canvas.width(), COLS * FONT_CELL_WIDTH);
+    ASSERT_EQ(canvas.height(), ROWS * FONT_CELL_HEIGHT);
+    ASSERT_EQ(pixelAt(canvas, 0, 0), CANVAS_BACKGROUND);
+    ASSERT_EQ(pixelAt(canvas, canvas.width() - 1, canvas.height() - 1), CANVAS_BACKGROUND);
+
+    // Bytes are R, G, B, A as putImageData expects
+    ASSERT_EQ((int)canvas.data()[3], 0xFF);
+    ASSERT_EQ((int)canvas.data()[0], 0x00);
+}
+
+void testBlitsGlyphShape() {
+    DisplayBuffer display(COLS, ROWS);
+    CanvasBuffer canvas(COLS, ROWS);
+    std::vector<std::string> frame = blankFrame();
+    frame[2][3] = '|';
+    display.update(frame);
+    canvas.blit(display);
+
+    // '|' is the centre column of the glyph, full height
+    int x = 3 * FONT_CELL_WIDTH + 2;
+    for (int gy = 0; gy < FONT_GLYPH_HEIGHT; gy++) {
+        ASSERT_EQ(pixelAt(canvas, x, 2 * FONT_CELL_HEIGHT + FONT_GLYPH_TOP + gy), CANVAS_FOREGROUND);
+    }
+    ASSERT_EQ(litPixels(canvas, 3, 2), FONT_GLYPH_HEIGHT);
+    ASSERT_EQ(litPixels(canvas, 4, 2), 0);
+}
+
+void testOnlyDirtyCellsAreBlitted() {
+    DisplayBuffer display(COLS, ROWS);
+    CanvasBuffer canvas(COLS, ROWS);
+    std::vector<std::string> frame = blankFrame();
+    display.update(frame);
+    PixelRect first = canvas.blit(display);
+    ASSERT_EQ(first.width, canvas.width());
+    ASSERT_EQ(canvas.cellsBlitted(), (size_t)(COLS * ROWS));
+
+    frame[1][5] = '@';
+    frame[4][9] = '#';
+    display.update(frame);
+    PixelRect rect = canvas.blit(display);
+    ASSERT_EQ(rect.x, 5 * FONT_CELL_WIDTH);
+    ASSERT_EQ(rect.y, 1 * FONT_CELL_HEIGHT);
+    ASSERT_EQ(rect.width, 5 * FONT_CELL_WIDTH);
+    ASSERT_EQ(rect.height, 4 * FONT_CELL_HEIGHT);
+    ASSERT_EQ(canvas.cellsBlitted(), (size_t)(COLS * ROWS + 2));
+    ASSERT_TRUE(litPixels(canvas, 5, 1) > 0);
+    ASSERT_TRUE(litPixels(canvas, 9, 4) > 0);
+
+    // Unchanged frame: nothing to blit
+    display.update(frame);
+    PixelRect none = canvas.blit(display);
+    ASSERT_EQ(none.width, 0);
+    ASSERT_EQ(canvas.cellsBlitted(), (size_t)(COLS * ROWS + 2));
+
+    // Erased cells go back to background
+    frame[1][5] = ' ';
+    display.update(frame);
+    canvas.blit(display);
+    ASSERT_EQ(litPixels(canvas, 5, 1), 0);
+}
+
+void testCanvasSinkSkipsUnchangedFrames() {
+    int presented = 0;
+    PixelRect last{0, 0, 0, 0};
+    CanvasSink sink(SCREEN_WIDTH, SCREEN_HEIGHT, [&](const CanvasBuffer&, const PixelRect& changed) {
+        presented++;
+        last = changed;
+    });
+    std::vector<std::string> frame(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    frame[10][10] = '#';
+
+    ASSERT_TRUE(sink.present(frame) > 0);
+    size_t afterFirst = sink.canvas().cellsBlitted();
+    ASSERT_EQ(sink.present(frame), (size_t)0);
+    ASSERT_EQ(sink.canvas().cellsBlitted(), afterFirst);
+    ASSERT_EQ(sink.display().stats.skipped, (size_t)1);
+    ASSERT_EQ(presented, 1);
+    ASSERT_TRUE(last.width > 0 && last.height > 0);
+    ASSERT_TRUE(litPixels(sink.canvas(), 10, 10) > 0);
+}
+
+int main() {
+    std::cout << "Running canvas tests..." << std::endl;
+    RUN_TEST(testStartsBlank);
+    RUN_TEST(testBlitsGlyphShape);
+    RUN_TEST(testOnlyDirtyCellsAreBlitted);
+    RUN_TEST(testCanvasSinkSkipsUnchangedFrames);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
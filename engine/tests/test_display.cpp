@@ -0,0 +1,83 @@
+#include "test_framework.h"
+#include "display.h"
+#include "rasterizer.h"
+#include <cstring>
+
+void testFirstUpdateIsFull() {
+    DisplayBuffer display;
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+
+    ASSERT_EQ(display.update(buffer), (size_t)SCREEN_HEIGHT);
+    for (const auto& span : display.dirty()) {
+        ASSERT_EQ(span.first, 0);
+        ASSERT_EQ(span.last, SCREEN_WIDTH - 1);
+    }
+}
+
+void testUnchangedFrameIsSkipped() {
+    DisplayBuffer display;
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, '.'));
+
+    display.update(buffer);
+    ASSERT_EQ(display.update(buffer), (size_t)0);
+    ASSERT_TRUE(display.dirty().empty());
+    ASSERT_EQ(display.stats.frames, (size_t)2);
+    ASSERT_EQ(display.stats.skipped, (size_t)1);
+}
+
+void testDirtySpan() {
+    DisplayBuffer display;
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    display.update(buffer);
+
+    buffer[5][10] = '@';
+    buffer[5][20] = '#';
+    buffer[70][0] = ':';
+
+    ASSERT_EQ(display.update(buffer), (size_t)2);
+    const auto& spans = display.dirty();
+    ASSERT_EQ(spans[0].row, 5);
+    ASSERT_EQ(spans[0].first, 10);
+    ASSERT_EQ(spans[0].last, 20);
+    ASSERT_EQ(spans[1].row, 70);
+    ASSERT_EQ(spans[1].first, 0);
+    ASSERT_EQ(spans[1].last, 0);
+
+    // The stored copy follows the frame
+    ASSERT_TRUE(display.row(5)[10] == '@');
+    ASSERT_TRUE(display.row(5)[20] == '#');
+}
+
+void testRowsAreNewlineTerminated() {
+    DisplayBuffer display;
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, '='));
+    display.update(buffer);
+
+    ASSERT_EQ(display.stride(), SCREEN_WIDTH + 1);
+    for (int y = 0; y < display.height(); y++) {
+        ASSERT_TRUE(display.row(y)[SCREEN_WIDTH] == '\n');
+        ASSERT_TRUE(std::memcmp(display.row(y), buffer[y].data(), SCREEN_WIDTH) == 0);
+    }
+}
+
+void testInvalidate() {
+    DisplayBuffer display;
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    display.update(buffer);
+
+    display.invalidate();
+    ASSERT_EQ(display.update(buffer), (size_t)SCREEN_HEIGHT);
+    ASSERT_EQ(display.update(buffer), (size_t)0);
+}
+
+int main() {
+    std::cout << "Running display tests..." << std::endl;
+    RUN_TEST(testFirstUpdateIsFull);
+    RUN_TEST(testUnchangedFrameIsSkipped);
+    RUN_TEST(testDirtySpan);
+    RUN_TEST(testRowsAreNewlineTerminated);
+    RUN_TEST(testInvalidate);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
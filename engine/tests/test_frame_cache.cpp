@@ -0,0 +1,142 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "frame_cache.h"
+#include "rasterizer.h"
+#include "renderer.h"
+
+namespace {
+    std::vector<std::string> makeFrame(char fill, int width = 16, int height = 4) {
+        std::vector<std::string> frame(height, std::string(width, ' '));
+        frame[1][3] = fill;
+        return frame;
+    }
+}
+
+void testOrientationKey() {
+    Mat3 a = rotationX(0.3f) * rotationY(1.1f) * rotationZ(-0.4f);
+    Mat3 nearA = rotationX(0.3001f) * rotationY(1.1f) * rotationZ(-0.4f);
+    Mat3 b = rotationX(0.5f) * rotationY(1.1f) * rotationZ(-0.4f);
+
+    ASSERT_EQ(FrameCache::orientationKey(a, 128), FrameCache::orientationKey(nearA, 128));
+    ASSERT_TRUE(FrameCache::orientationKey(a, 128) != FrameCache::orientationKey(b, 128));
+
+    // A full turn is the same orientation, even though the quaternion flips sign
+    Mat3 turned = rotationY(0.7f + 2.0f * 3.14159265f);
+    ASSERT_EQ(FrameCache::orientationKey(rotationY(0.7f), 64), FrameCache::orientationKey(turned, 64));
+}
+
+void testStoreAndLookup() {
+    FrameCache cache(1 << 20);
+    std::vector<std::string> buffer;
+    ASSERT_FALSE(cache.lookup(42, buffer));
+    ASSERT_EQ(cache.stats.misses, (size_t)1);
+
+    cache.store(42, makeFrame('#'));
+    ASSERT_TRUE(cache.contains(42));
+    ASSERT_TRUE(cache.lookup(42, buffer));
+    ASSERT_TRUE(buffer == makeFrame('#'));
+    ASSERT_EQ(cache.stats.hits, (size_t)1);
+    ASSERT_EQ(cache.bytes(), (size_t)64);
+
+    // Storing again replaces the frame without growing
+    cache.store(42, makeFrame('@'));
+    ASSERT_TRUE(cache.lookup(42, buffer));
+    ASSERT_TRUE(buffer == makeFrame('@'));
+    ASSERT_EQ(cache.bytes(), (size_t)64);
+
+    cache.clear();
+    ASSERT_EQ(cache.frames(), (size_t)0);
+    ASSERT_FALSE(cache.contains(42));
+}
+
+void testEvictsLeastRecentlyUsed() {
+    FrameCache cache(3 * 64);
+    std::vector<std::string> buffer;
+    cache.store(1, makeFrame('a'));
+    cache.store(2, makeFrame('b'));
+    cache.store(3, makeFrame('c'));
+    ASSERT_TRUE(cache.lookup(1, buffer));   // 2 is now the oldest
+
+    cache.store(4, makeFrame('d'));
+    ASSERT_EQ(cache.frames(), (size_t)3);
+    ASSERT_TRUE(cache.bytes() <= cache.capacity());
+    ASSERT_FALSE(cache.contains(2));
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_TRUE(cache.contains(4));
+    ASSERT_EQ(cache.stats.evictions, (size_t)1);
+
+    // Frames bigger than the cap are skipped
+    FrameCache tiny(10);
+    tiny.store(1, makeFrame('x'));
+    ASSERT_EQ(tiny.frames(), (size_t)0);
+}
+
+void testPrecomputeMatchesPlayback() {
+    std::vector<Triangle> model = makeTriangle();
+    Vec3 light = Vec3(0.0f, 0.0f, -1.0f);
+    FrameCache cache;
+    TurntablePrecompute precompute;
+    precompute.restart(0.0f, 0.0f, 0.0f, 0.02f);
+
+    int rendered = precompute.run(model, light, cache, 10.0, 20);
+    ASSERT_EQ(rendered, 20);
+    ASSERT_EQ(precompute.framesAhead(), 20);
+    ASSERT_EQ(precompute.run(model, light, cache, 10.0, 20), 0);
+
+    // Playback steps the angles the same way and finds every frame, identical
+    // to rendering it directly
+    std::vector<std::string> cached, direct(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+    for (int i = 0; i < 20; i++) {
+        Mat3 rotation = rotationX(x) * rotationY(y) * rotationZ(z);
+        ASSERT_TRUE(cache.lookup(cache.keyFor(rotation), cached));
+        clearBuffers(direct, zbuffer);
+        renderFrame(direct, zbuffer, model, rotation, light);
+        ASSERT_TRUE(cached == direct);
+        precompute.advance();
+        x += 0.02f;
+        y += 0.02f * 1.3f;
+        z += 0.02f * 0.7f;
+    }
+    ASSERT_EQ(precompute.framesAhead(), 0);
+
+    // No time budget, no work
+    ASSERT_EQ(precompute.run(model, light, cache, 0.0, 20), 0);
+}
+
+void testStepDroppedAfterRestart() {
+    std::vector<Triangle> model = makeTriangle();
+    Vec3 light = Vec3(0.0f, 0.0f, -1.0f);
+    FrameCache cache;
+    TurntablePrecompute precompute;
+    precompute.restart(0.0f, 0.0f, 0.0f, 0.02f);
+
+    TurntablePrecompute::Step step;
+    ASSERT_TRUE(precompute.nextStep(cache, step, 20));
+    ASSERT_TRUE(step.render);
+    precompute.renderStep(model, light, step);
+    ASSERT_TRUE(precompute.finishStep(step, cache));
+    ASSERT_TRUE(cache.contains(step.key));
+    ASSERT_EQ(precompute.framesAhead(), 1);
+
+    // The view jumped while the frame rendered: it is not stored
+    ASSERT_TRUE(precompute.nextStep(cache, step, 20));
+    precompute.renderStep(model, light, step);
+    precompute.restart(1.0f, 0.0f, 0.0f, 0.02f);
+    ASSERT_FALSE(precompute.finishStep(step, cache));
+    ASSERT_FALSE(cache.contains(step.key));
+    ASSERT_EQ(precompute.framesAhead(), 0);
+}
+
+int main() {
+    std::cout << "Running frame cache tests..." << std::endl;
+    RUN_TEST(testOrientationKey);
+    RUN_TEST(testStoreAndLookup);
+    RUN_TEST(testEvictsLeastRecentlyUsed);
+    RUN_TEST(testPrecomputeMatchesPlayback);
+    RUN_TEST(testStepDroppedAfterRestart);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,123 @@
+#include "test_framework.h"
+#include "framestream.h"
+#include <cstdio>
+
+namespace {
+    const int WIDTH = 40;
+    const int HEIGHT = 12;
+
+    // A blob that moves across a mostly blank frame
+    std::vector<std::string> makeFrame(int n) {
+        std::vector<std::string> frame(HEIGHT, std::string(WIDTH, ' '));
+        for (int y = 3; y < 8; y++) {
+            for (int x = 0; x < 6; x++) {
+                frame[y][(n + x) % WIDTH] = " .:-=+*#%@"[(x + y + n) % 10];
+            }
+        }
+        frame[HEIGHT - 1] = std::string(WIDTH, '=');
+        return frame;
+    }
+}
+
+void testRoundTrip() {
+    FrameStreamRecorder recorder(WIDTH, HEIGHT, 30, 8);
+    for (int i = 0; i < 50; i++) recorder.addFrame(makeFrame(i));
+    ASSERT_EQ(recorder.frames(), 50);
+
+    FrameStreamPlayer player;
+    ASSERT_TRUE(player.load(recorder.finish()));
+    ASSERT_EQ(player.frames(), 50);
+    ASSERT_EQ(player.width(), WIDTH);
+    ASSERT_EQ(player.height(), HEIGHT);
+    ASSERT_EQ(player.fps(), 30);
+
+    std::vector<std::string> buffer;
+    for (int i = 0; i < 50; i++) {
+        ASSERT_TRUE(player.next(buffer));
+        ASSERT_TRUE(buffer == makeFrame(i));
+    }
+
+    // Playback loops
+    ASSERT_TRUE(player.next(buffer));
+    ASSERT_TRUE(buffer == makeFrame(0));
+}
+
+void testSeek() {
+    FrameStreamRecorder recorder(WIDTH, HEIGHT, 30, 8);
+    for (int i = 0; i < 40; i++) recorder.addFrame(makeFrame(i));
+
+    FrameStreamPlayer player;
+    ASSERT_TRUE(player.load(recorder.finish()));
+
+    std::vector<std::string> buffer;
+    ASSERT_TRUE(player.seek(29, buffer));
+    ASSERT_EQ(player.position(), 29);
+    ASSERT_TRUE(player.next(buffer));
+    ASSERT_TRUE(buffer == makeFrame(29));
+
+    // Seeking backwards restarts from an earlier keyframe
+    ASSERT_TRUE(player.seek(3, buffer));
+    ASSERT_TRUE(player.next(buffer));
+    ASSERT_TRUE(buffer == makeFrame(3));
+    ASSERT_TRUE(player.next(buffer));
+    ASSERT_TRUE(buffer == makeFrame(4));
+
+    ASSERT_FALSE(player.seek(40, buffer));
+    ASSERT_FALSE(player.seek(-1, buffer));
+}
+
+void testDeltasAreCompact() {
+    FrameStreamRecorder recorder(WIDTH, HEIGHT, 30, 100);
+    recorder.addFrame(makeFrame(0));
+    size_t afterKeyframe = recorder.size();
+    recorder.addFrame(makeFrame(0));
+    size_t unchanged = recorder.size() - afterKeyframe;
+
+    // Frame header plus a single skip of all rows
+    ASSERT_EQ(unchanged, (size_t)6);
+    ASSERT_TRUE(afterKeyframe < (size_t)(WIDTH * HEIGHT) / 2);
+}
+
+void testRejectsCorruptData() {
+    FrameStreamPlayer player;
+    ASSERT_FALSE(player.load({}));
+    ASSERT_FALSE(player.load({'N', 'O', 'P', 'E', 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}));
+
+    FrameStreamRecorder recorder(WIDTH, HEIGHT, 30);
+    recorder.addFrame(makeFrame(0));
+    std::vector<uint8_t> truncated = recorder.finish();
+    truncated.resize(truncated.size() - 3);
+    ASSERT_FALSE(player.load(truncated));
+}
+
+void testSaveAndLoadFile() {
+    const std::string filename = "/tmp/test_framestream.tmfs";
+    FrameStreamRecorder recorder(WIDTH, HEIGHT, 24);
+    for (int i = 0; i < 10; i++) recorder.addFrame(makeFrame(i));
+    ASSERT_TRUE(recorder.save(filename));
+
+    FrameStreamPlayer player;
+    ASSERT_TRUE(player.loadFile(filename));
+    ASSERT_EQ(player.frames(), 10);
+    ASSERT_EQ(player.fps(), 24);
+
+    std::vector<std::string> buffer;
+    ASSERT_TRUE(player.seek(7, buffer));
+    ASSERT_TRUE(player.next(buffer));
+    ASSERT_TRUE(buffer == makeFrame(7));
+    std::remove(filename.c_str());
+
+    ASSERT_FALSE(player.loadFile("/tmp/nonexistent_stream.tmfs"));
+}
+
+int main() {
+    std::cout << "Running frame stream tests..." << std::endl;
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testSeek);
+    RUN_TEST(testDeltasAreCompact);
+    RUN_TEST(testRejectsCorruptData);
+    RUN_TEST(testSaveAndLoadFile);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,158 @@
+#include "test_framework.h"
+#include "gif.h"
+#include <cstring>
+
+namespace {
+    // Reference GIF LZW decoder, written from the spec rather than the encoder
+    std::vector<uint8_t> lzwDecode(const std::vector<uint8_t>& data, int minCodeSize) {
+        const int clearCode = 1 << minCodeSize;
+        const int endCode = clearCode + 1;
+        std::vector<std::vector<uint8_t>> dict;
+        std::vector<uint8_t> out;
+        int codeSize = minCodeSize + 1;
+        int previous = -1;
+
+        auto reset = [&]() {
+            dict.clear();
+            for (int i = 0; i < clearCode + 2; i++) dict.push_back({(uint8_t)i});
+            codeSize = minCodeSize + 1;
+            previous = -1;
+        };
+        reset();
+
+        size_t bit = 0;
+        while (bit + codeSize <= data.size() * 8) {
+            int code = 0;
+            for (int i = 0; i < codeSize; i++, bit++) {
+                if (data[bit / 8] & (1 << (bit % 8))) code |= 1 << i;
+            }
+            if (code == clearCode) { reset(); continue; }
+            if (code == endCode) break;
+
+            std::vector<uint8_t> entry;
+            if (code < (int)dict.size()) {
+                entry = dict[code];
+            } else if (code == (int)dict.size() && previous >= 0) {
+                entry = dict[previous];
+                entry.push_back(dict[previous][0]);
+            } else {
+                return {}; // Invalid code
+            }
+            out.insert(out.end(), entry.begin(), entry.end());
+
+            if (previous >= 0 && dict.size() < 4096) {
+                std::vector<uint8_t> added = dict[previous];
+                added.push_back(entry[0]);
+                dict.push_back(added);
+                if ((int)dict.size() == (1 << codeSize) && codeSize < GIF_MAX_CODE_BITS) codeSize++;
+            }
+            previous = code;
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> pattern(size_t count, int colors, unsigned seed) {
+        std::vector<uint8_t> pixels(count);
+        for (size_t i = 0; i < count; i++) {
+            seed = seed * 1103515245u + 12345u;
+            // Mostly runs with some noise, like glyph rows
+            pixels[i] = (seed >> 16) % 7 == 0 ? (uint8_t)((seed >> 8) % colors) : (uint8_t)((i / 13) % colors);
+        }
+        return pixels;
+    }
+}
+
+void testLzwRoundTrip() {
+    for (int minCodeSize : {2, 4, 8}) {
+        std::vector<uint8_t> pixels = pattern(50000, 1 << minCodeSize, 7u + minCodeSize);
+        std::vector<uint8_t> data;
+        lzwEncode(pixels.data(), pixels.size(), minCodeSize, data);
+        ASSERT_TRUE(lzwDecode(data, minCodeSize) == pixels);
+    }
+}
+
+void testLzwFillsTable() {
+    // Long noisy input forces the 12-bit limit and a dictionary reset
+    std::vector<uint8_t> pixels = pattern(400000, 4, 99u);
+    std::vector<uint8_t> data;
+    lzwEncode(pixels.data(), pixels.size(), 2, data);
+    ASSERT_TRUE(data.size() < pixels.size() / 2);
+    ASSERT_TRUE(lzwDecode(data, 2) == pixels);
+
+    std::vector<uint8_t> single{3};
+    data.clear();
+    lzwEncode(single.data(), 1, 2, data);
+    ASSERT_TRUE(lzwDecode(data, 2) == single);
+}
+
+void testFileStructure() {
+    const uint8_t palette[2][3] = {{0, 0, 0}, {255, 255, 255}};
+    std::vector<uint8_t> gif;
+    gifHeader(gif, 12, 8, palette, 2);
+
+    ASSERT_TRUE(std::memcmp(gif.data(), "GIF89a", 6) == 0);
+    ASSERT_EQ(gif[6] | (gif[7] << 8), 12);
+    ASSERT_EQ(gif[8] | (gif[9] << 8), 8);
+    ASSERT_EQ((int)gif[10], 0x91);          // Palette padded to 4 entries
+    ASSERT_EQ((int)gif[13 + 3], 255);       // Second colour
+    ASSERT_EQ((int)gif[13 + 12], 0x21);     // Loop extension follows the palette
+    ASSERT_TRUE(std::memcmp(&gif[13 + 15], "NETSCAPE2.0", 11) == 0);
+
+    size_t frameAt = gif.size();
+    std::vector<uint8_t> pixels = pattern(4 * 3, 4, 1u);
+    gifFrame(gif, 2, 1, 4, 3, pixels.data(), 2, 5);
+    gif.push_back(GIF_TRAILER);
+
+    const uint8_t* f = &gif[frameAt];
+    ASSERT_EQ((int)f[0], 0x21);
+    ASSERT_EQ((int)f[1], 0xF9);
+    ASSERT_EQ(f[4] | (f[5] << 8), 5);       // Delay
+    ASSERT_EQ((int)f[8], 0x2C);
+    ASSERT_EQ(f[9] | (f[10] << 8), 2);      // Left
+    ASSERT_EQ(f[11] | (f[12] << 8), 1);     // Top
+    ASSERT_EQ(f[13] | (f[14] << 8), 4);     // Width
+    ASSERT_EQ(f[15] | (f[16] << 8), 3);     // Height
+    ASSERT_EQ((int)f[18], 2);               // Minimum code size
+
+    // Reassemble the sub-blocks and decode them
+    std::vector<uint8_t> data;
+    size_t p = frameAt + 19;
+    while (gif[p] != 0) {
+        data.insert(data.end(), gif.begin() + p + 1, gif.begin() + p + 1 + gif[p]);
+        p += gif[p] + 1;
+    }
+    ASSERT_TRUE(lzwDecode(data, 2) == pixels);
+    ASSERT_EQ(p + 2, gif.size());
+    ASSERT_EQ((int)gif.back(), (int)GIF_TRAILER);
+}
+
+void testLargeFrameUsesSubBlocks() {
+    const uint8_t palette[4][3] = {};
+    std::vector<uint8_t> gif;
+    gifHeader(gif, 300, 300, palette, 4);
+    size_t frameAt = gif.size();
+    std::vector<uint8_t> pixels = pattern(300 * 300, 4, 5u);
+    gifFrame(gif, 0, 0, 300, 300, pixels.data(), 2, 3);
+
+    size_t p = frameAt + 19;
+    int blocks = 0;
+    std::vector<uint8_t> data;
+    while (gif[p] != 0) {
+        data.insert(data.end(), gif.begin() + p + 1, gif.begin() + p + 1 + gif[p]);
+        p += gif[p] + 1;
+        blocks++;
+    }
+    ASSERT_TRUE(blocks > 1);
+    ASSERT_TRUE(lzwDecode(data, 2) == pixels);
+}
+
+int main() {
+    std::cout << "Running GIF tests..." << std::endl;
+    RUN_TEST(testLzwRoundTrip);
+    RUN_TEST(testLzwFillsTable);
+    RUN_TEST(testFileStructure);
+    RUN_TEST(testLargeFrameUsesSubBlocks);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,88 @@
+#include "test_framework.h"
+#include "jobs.h"
+#include <atomic>
+#include <chrono>
+#include <set>
+
+void testParallelForCoversRange() {
+    JobSystem jobs(4);
+    ASSERT_EQ(jobs.size(), 4);
+
+    std::vector<int> visits(1000, 0);
+    std::atomic<size_t> calls(0);
+    std::atomic<size_t> largest(0);
+    jobs.parallelFor(visits.size(), 64, [&](size_t begin, size_t end) {
+        if (end - begin > largest) largest = end - begin;
+        for (size_t i = begin; i < end; i++) visits[i]++;
+        calls++;
+    });
+    for (int v : visits) ASSERT_EQ(v, 1);
+    ASSERT_EQ(calls.load(), (size_t)16);
+    ASSERT_EQ(largest.load(), (size_t)64);
+
+    // Empty ranges return straight away
+    jobs.parallelFor(0, 8, [&](size_t, size_t) { calls++; });
+    ASSERT_EQ(calls.load(), (size_t)16);
+}
+
+void testIdleWorkersSteal() {
+    JobSystem jobs(4);
+    JobSystem::Group group;
+    std::atomic<bool> spawned(false);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    // One job fans out into its worker's own queue; the others must steal
+    jobs.run(group, [&] {
+        for (int i = 0; i < 64; i++) {
+            jobs.run(group, [&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            });
+        }
+        spawned = true;
+    });
+    while (!spawned) std::this_thread::yield();
+    jobs.wait(group);
+
+    ASSERT_TRUE(group.done());
+    ASSERT_TRUE(threads.size() > 1);
+    JobStats stats = jobs.stats();
+    ASSERT_TRUE(stats.stolen > 0);
+    ASSERT_EQ(stats.executed, (size_t)65);
+}
+
+void testNestedWaits() {
+    // Fewer workers than outer jobs, each waiting on inner jobs: waiting
+    // threads run queued jobs, so this cannot deadlock
+    JobSystem jobs(2);
+    std::atomic<int> total(0);
+    jobs.parallelFor(16, 1, [&](size_t, size_t) {
+        jobs.parallelFor(10, 3, [&](size_t begin, size_t end) {
+            total += (int)(end - begin);
+        });
+    });
+    ASSERT_EQ(total.load(), 160);
+}
+
+void testDefaultSize() {
+    JobSystem jobs;
+    ASSERT_EQ(jobs.size(), std::max(0, (int)std::thread::hardware_concurrency() - 1));
+
+    // With no workers on a single core, the waiting thread runs every job
+    std::atomic<int> total(0);
+    jobs.parallelFor(100, 7, [&](size_t begin, size_t end) { total += (int)(end - begin); });
+    ASSERT_EQ(total.load(), 100);
+}
+
+int main() {
+    std::cout << "Running job system tests..." << std::endl;
+    RUN_TEST(testParallelForCoversRange);
+    RUN_TEST(testIdleWorkersSteal);
+    RUN_TEST(testNestedWaits);
+    RUN_TEST(testDefaultSize);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,223 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "memory_stats.h"
+#include "frame_cache.h"
+#include "quality.h"
+#include "render_context.h"
+#include "slicer.h"
+#include "stl_stream.h"
+#include <memory>
+#include <thread>
+
+namespace {
+    size_t current(MemoryTag tag) {
+        return memoryUsage(tag).current;
+    }
+
+    size_t peak(MemoryTag tag) {
+        return memoryUsage(tag).peak;
+    }
+}
+
+void testAccountsAndPeaks() {
+    const size_t before = current(MEMORY_CACHES);
+    resetMemoryPeaks();
+    {
+        MemoryAccount a(MEMORY_CACHES);
+        a.set(1000);
+        a.set(400);
+        ASSERT_EQ(current(MEMORY_CACHES), before + 400);
+        ASSERT_EQ(peak(MEMORY_CACHES), before + 1000);
+
+        // A copy holds the same bytes again; a move hands them over
+        MemoryAccount copy(a);
+        ASSERT_EQ(current(MEMORY_CACHES), before + 800);
+        MemoryAccount moved(std::move(copy));
+        ASSERT_EQ(moved.bytes(), (size_t)400);
+        ASSERT_EQ(copy.bytes(), (size_t)0);
+        ASSERT_EQ(current(MEMORY_CACHES), before + 800);
+
+        MemoryAccount other(MEMORY_MESH);
+        other.set(50);
+        other = a;
+        ASSERT_EQ(current(MEMORY_CACHES), before + 1200);
+        ASSERT_EQ(peak(MEMORY_CACHES), before + 1200);
+    }
+    ASSERT_EQ(current(MEMORY_CACHES), before);
+    resetMemoryPeaks();
+    ASSERT_EQ(peak(MEMORY_CACHES), before);
+
+    // Threads add to one total
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            MemoryAccount account(MEMORY_CACHES);
+            for (size_t i = 1; i <= 1000; i++) account.set(i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT_EQ(current(MEMORY_CACHES), before);
+    ASSERT_TRUE(peak(MEMORY_CACHES) >= before + 1000 && peak(MEMORY_CACHES) <= before + 4000);
+
+    ASSERT_EQ(memoryReport().size(), (size_t)MEMORY_TAG_COUNT + 1);
+    ASSERT_TRUE(memoryReport()[0].compare(0, 4, "mesh") == 0);
+#ifdef __linux__
+    ASSERT_TRUE(processMemoryBytes() > 0);
+#endif
+}
+
+void testOwnersAccount() {
+    const size_t frames = current(MEMORY_FRAMEBUFFERS);
+    {
+        RenderContext view(100, 40);
+        ASSERT_TRUE(current(MEMORY_FRAMEBUFFERS) >= frames + 100 * 40 * (1 + sizeof(float)));
+        view.resize(200, 60);
+        ASSERT_TRUE(current(MEMORY_FRAMEBUFFERS) >= frames + 200 * 60 * (1 + sizeof(float)));
+    }
+    ASSERT_EQ(current(MEMORY_FRAMEBUFFERS), frames);
+
+    const size_t scratch = current(MEMORY_RENDER_SCRATCH);
+    {
+        FrameArena arena(1024);
+        arena.allocate(3000);
+        ASSERT_EQ(current(MEMORY_RENDER_SCRATCH), scratch + arena.capacity());
+    }
+    ASSERT_EQ(current(MEMORY_RENDER_SCRATCH), scratch);
+
+    const size_t caches = current(MEMORY_CACHES);
+    FrameCache cache;
+    cache.store(1, std::vector<std::string>(10, std::string(20, '#')));
+    ASSERT_EQ(current(MEMORY_CACHES), caches + cache.bytes());
+    cache.clear();
+    ASSERT_EQ(current(MEMORY_CACHES), caches);
+
+    std::vector<uint8_t> bytes = stlBytes(makeSphere(10, 20));
+    std::vector<Triangle> model;
+    float scale;
+    StlStream stream;
+    stream.begin(bytes.size());
+    const size_t acceleration = current(MEMORY_ACCELERATION);
+    {
+        ASSERT_TRUE(stream.feed(bytes.data(), bytes.size(), model));
+        ASSERT_TRUE(stream.finish(model, scale));
+        SliceIndex index;
+        index.build(model, SliceAxis::Z);
+        const size_t indexBytes = current(MEMORY_ACCELERATION) - acceleration;
+        ASSERT_TRUE(indexBytes >= model.size() * 3 * sizeof(uint32_t));
+        SliceIndex copy = index;
+        ASSERT_EQ(current(MEMORY_ACCELERATION), acceleration + 2 * indexBytes);
+        index = SliceIndex();
+        ASSERT_EQ(current(MEMORY_ACCELERATION), acceleration + indexBytes);
+
+        LodChain lods;
+        lods.build(model);
+        ASSERT_TRUE(current(MEMORY_ACCELERATION) > acceleration + indexBytes);
+        lods.clear();
+        ASSERT_EQ(current(MEMORY_ACCELERATION), acceleration + indexBytes);
+    }
+    ASSERT_EQ(current(MEMORY_ACCELERATION), acceleration);
+}
+
+void testParseScratch() {
+    std::vector<uint8_t> bytes = stlBytes(makeSphere(10, 20));
+    const size_t before = current(MEMORY_PARSE_SCRATCH);
+    resetMemoryPeaks();
+
+    // A stream holds the raw triangles until it finishes
+    std::vector<Triangle> model;
+    float scale;
+    StlStream stream;
+    stream.begin(bytes.size());
+    ASSERT_TRUE(stream.feed(bytes.data(), bytes.size() / 2, model));
+    ASSERT_TRUE(current(MEMORY_PARSE_SCRATCH) >= before + 400 * sizeof(Triangle));
+    ASSERT_TRUE(stream.feed(bytes.data() + bytes.size() / 2, bytes.size() - bytes.size() / 2, model));
+    ASSERT_TRUE(stream.finish(model, scale));
+    ASSERT_EQ(current(MEMORY_PARSE_SCRATCH), before);
+
+    // A file read keeps its block only while it reads
+    const std::string path = "/tmp/termesh_memory_test.stl";
+    writeFile(path, bytes);
+    resetMemoryPeaks();
+    std::vector<Triangle> loaded;
+    ASSERT_TRUE(readSTL(path, loaded));
+    ASSERT_EQ(loaded.size(), (size_t)400);
+    ASSERT_EQ(peak(MEMORY_PARSE_SCRATCH), before + STL_RECORDS_PER_READ * STL_RECORD_SIZE);
+    ASSERT_EQ(current(MEMORY_PARSE_SCRATCH), before);
+}
+
+void testLoadEstimateAndBudget() {
+    std::vector<uint8_t> bytes = stlBytes(makeSphere(100, 200));
+    const std::string path = "/tmp/termesh_memory_estimate.stl";
+    writeFile(path, bytes);
+
+    LoadEstimate estimate = estimateLoad(bytes.size(), false);
+    ASSERT_EQ(estimate.triangles, (size_t)40000);
+    ASSERT_EQ(estimate.meshBytes, 40000 * sizeof(Triangle));
+    ASSERT_EQ(estimateLoad(bytes.size(), false, true).scratchBytes, estimate.meshBytes + STL_RECORD_SIZE);
+    ASSERT_EQ(estimateLoad(ASCII_FACET_MIN_BYTES * 10, true).triangles, (size_t)10);
+    ASSERT_EQ(estimateLoad(10, false).triangles, (size_t)0);
+
+    // Loading it the way the viewer does stays within the estimate
+    const MemoryTag TAGS[] = {MEMORY_MESH, MEMORY_ACCELERATION, MEMORY_RENDER_SCRATCH};
+    size_t before[3];
+    for (int i = 0; i < 3; i++) before[i] = current(TAGS[i]);
+    resetMemoryPeaks();
+    {
+        MemoryAccount mesh(MEMORY_MESH);
+        auto model = std::make_shared<std::vector<Triangle>>(loadSTL(path));
+        mesh.set(vectorBytes(*model));
+        float scale;
+        normalizeModel(*model, scale);
+        SliceIndex index;
+        index.build(*model, SliceAxis::Z);
+        LodChain lods;
+        lods.build(*model);
+        RenderContext view(120, 40);
+        view.setMesh(model);
+        view.render(*model, QUALITY_LEVELS[0]);
+        view.renderSlice(index, 0.0f, true);
+    }
+    size_t used = 0;
+    for (int i = 0; i < 3; i++) used += peak(TAGS[i]) - before[i];
+    ASSERT_TRUE(peak(MEMORY_MESH) - before[0] == estimate.meshBytes);
+    ASSERT_TRUE(used <= estimate.total());
+    ASSERT_TRUE(used * 4 > estimate.total());
+
+    // The budget counts what stays beside the new model
+    ASSERT_TRUE(fitsMemoryBudget(estimate, 0));
+    ASSERT_TRUE(modelFitsMemoryBudget(path, estimate.total() + (4 << 20)));
+    ASSERT_FALSE(modelFitsMemoryBudget(path, estimate.total() / 2));
+    {
+        MemoryAccount buffers(MEMORY_FRAMEBUFFERS);
+        buffers.set(8 << 20);
+        ASSERT_FALSE(modelFitsMemoryBudget(path, estimate.total() + (4 << 20)));
+    }
+    ASSERT_TRUE(modelFitsMemoryBudget("/nonexistent/model.stl", 1));
+
+    // A stream of unknown size is checked once its header gives the count
+    std::vector<Triangle> model;
+    StlStream stream;
+    stream.begin(0, estimate.total() / 2);
+    ASSERT_FALSE(stream.feed(bytes.data(), 1000, model));
+    ASSERT_TRUE(model.empty());
+    stream.begin(0, estimate.total() + (4 << 20));
+    ASSERT_TRUE(stream.feed(bytes.data(), 1000, model));
+
+    // ASCII text is checked as it arrives
+    std::string text = "solid big\n" + std::string(ASCII_FACET_MIN_BYTES * 1000, ' ');
+    stream.begin(0, estimateLoad(ASCII_FACET_MIN_BYTES * 500, true).total());
+    const uint8_t* chars = reinterpret_cast<const uint8_t*>(text.data());
+    ASSERT_TRUE(stream.feed(chars, text.size() / 4, model));
+    ASSERT_FALSE(stream.feed(chars + text.size() / 4, text.size() - text.size() / 4, model));
+}
+
+int main() {
+    std::cout << "Running memory stats tests..." << std::endl;
+    RUN_TEST(testAccountsAndPeaks);
+    RUN_TEST(testOwnersAccount);
+    RUN_TEST(testParseScratch);
+    RUN_TEST(testLoadEstimateAndBudget);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
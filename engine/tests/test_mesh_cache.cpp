@@ -0,0 +1,73 @@
+#include "test_framework.h"
+#include "mesh_cache.h"
+
+namespace {
+    MeshRef makeMesh(size_t triangles) {
+        return std::make_shared<const std::vector<Triangle>>(triangles);
+    }
+}
+
+void testStoreAndLookup() {
+    MeshCache cache(1 << 20);
+    ASSERT_TRUE(cache.lookup("a") == nullptr);
+    ASSERT_EQ(cache.stats.misses, (size_t)1);
+
+    MeshRef mesh = makeMesh(10);
+    cache.store("a", mesh);
+    ASSERT_TRUE(cache.lookup("a") == mesh);
+    ASSERT_EQ(cache.stats.hits, (size_t)1);
+    ASSERT_EQ(cache.bytes(), 10 * sizeof(Triangle));
+
+    // Storing again replaces the mesh without growing
+    MeshRef other = makeMesh(10);
+    cache.store("a", other);
+    ASSERT_TRUE(cache.lookup("a") == other);
+    ASSERT_EQ(cache.meshes(), (size_t)1);
+    ASSERT_EQ(cache.bytes(), 10 * sizeof(Triangle));
+
+    cache.clear();
+    ASSERT_EQ(cache.meshes(), (size_t)0);
+    ASSERT_EQ(cache.bytes(), (size_t)0);
+}
+
+void testEvictsLeastRecentlyUsed() {
+    MeshCache cache(30 * sizeof(Triangle));
+    cache.store("a", makeMesh(10));
+    cache.store("b", makeMesh(10));
+    cache.store("c", makeMesh(10));
+    ASSERT_TRUE(cache.lookup("a") != nullptr);  // b is now the oldest
+
+    cache.store("d", makeMesh(10));
+    ASSERT_EQ(cache.stats.evictions, (size_t)1);
+    ASSERT_TRUE(cache.lookup("b") == nullptr);
+    ASSERT_TRUE(cache.lookup("a") != nullptr);
+    ASSERT_TRUE(cache.lookup("c") != nullptr);
+    ASSERT_TRUE(cache.bytes() <= cache.capacity());
+
+    // Too large for the whole cap: not stored, nothing evicted
+    cache.store("huge", makeMesh(31));
+    ASSERT_TRUE(cache.lookup("huge") == nullptr);
+    ASSERT_EQ(cache.meshes(), (size_t)3);
+}
+
+void testEvictedMeshStaysAlive() {
+    MeshCache cache(10 * sizeof(Triangle));
+    cache.store("a", makeMesh(10));
+    MeshRef held = cache.lookup("a");
+
+    // A render still holding the mesh keeps it, while the cache lets it go
+    cache.store("b", makeMesh(10));
+    ASSERT_TRUE(cache.lookup("a") == nullptr);
+    ASSERT_EQ(held->size(), (size_t)10);
+    ASSERT_EQ(held.use_count(), 1L);
+}
+
+int main() {
+    std::cout << "Running mesh cache tests..." << std::endl;
+    RUN_TEST(testStoreAndLookup);
+    RUN_TEST(testEvictsLeastRecentlyUsed);
+    RUN_TEST(testEvictedMeshStaysAlive);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -29,12 +29,11 @@ void createSimpleASCIISTL(const std::string& filename) {
     file.close();
 }
 
-void createSimpleBinarySTL(const std::string& filename) {
+void createSimpleBinarySTL(const std::string& filename, const std::string& headerStr = "Binary STL") {
     std::ofstream file(filename, std::ios::binary);
     
     // Write 80-byte header
     char header[80] = {0};
-    std::string headerStr = "Binary STL";
     std::copy(headerStr.begin(), headerStr.end(), header);
     file.write(header, 80);
     
@@ -104,6 +103,46 @@ void testLoadBinarySTL() {
     ASSERT_VEC3_EQ(tri1.vertices[2], Vec3(0.0f, 1.0f, 0.0f), 1e-5f);
 }
 
+void testLoadSolidHeaderBinarySTL() {
+    // Some exporters start binary headers with "solid"; the size gives them away
+    const std::string filename = "/tmp/test_solid_binary.stl";
+    createSimpleBinarySTL(filename, "solid exported by a CAD tool");
+    
+    std::vector<Triangle> triangles = loadSTL(filename);
+    
+    ASSERT_TRUE(triangles.size() == 2);
+    ASSERT_VEC3_EQ(triangles[1].normal, Vec3(0.0f, 0.0f, -1.0f), 1e-5f);
+    ASSERT_VEC3_EQ(triangles[1].vertices[2], Vec3(1.0f, 0.0f, 1.0f), 1e-5f);
+    
+    // Text is still ASCII whatever its length
+    createSimpleASCIISTL(filename);
+    ASSERT_TRUE(loadSTL(filename).size() == 2);
+}
+
+void testParseAsciiSpan() {
+    // CRLF lines, then a facet cut off by the end of the span; the text after
+    // the span must not be read
+    const std::string text =
+        "solid s\r\n"
+        "  facet normal 0 0 1\r\n    outer loop\r\n"
+        "      vertex 0 0 0\r\n      vertex 1 0 0\r\n      vertex 0 1 0\r\n"
+        "    endloop\r\n  endfacet\r\n"
+        "  facet normal 0 0 -1\r\n    outer loop\r\n      vertex 2 2 2\r\n"
+        "      vertex 3 3 3\r\n      vertex 4 4 4\r\n    endloop\r\n  endfacet\r\n";
+    const size_t cut = text.find("vertex 3 3 3") + 9;
+
+    std::vector<Triangle> triangles;
+    parseAsciiStl(text.data(), cut, triangles);
+    ASSERT_EQ(triangles.size(), (size_t)1);
+    ASSERT_VEC3_EQ(triangles[0].normal, Vec3(0.0f, 0.0f, 1.0f), 1e-5f);
+    ASSERT_VEC3_EQ(triangles[0].vertices[2], Vec3(0.0f, 1.0f, 0.0f), 1e-5f);
+
+    triangles.clear();
+    parseAsciiStl(text.data(), text.size(), triangles);
+    ASSERT_EQ(triangles.size(), (size_t)2);
+    ASSERT_VEC3_EQ(triangles[1].vertices[1], Vec3(3.0f, 3.0f, 3.0f), 1e-5f);
+}
+
 void testLoadSTLNonexistent() {
     std::vector<Triangle> triangles = loadSTL("/tmp/nonexistent_file.stl");
     ASSERT_TRUE(triangles.empty());
@@ -151,6 +190,8 @@ int main() {
     std::cout << "Running model loading tests..." << std::endl;
     RUN_TEST(testLoadASCIISTL);
     RUN_TEST(testLoadBinarySTL);
+    RUN_TEST(testLoadSolidHeaderBinarySTL);
+    RUN_TEST(testParseAsciiSpan);
     RUN_TEST(testLoadSTLNonexistent);
     RUN_TEST(testNormalizeModel);
     RUN_TEST(testNormalizeModelEmpty);
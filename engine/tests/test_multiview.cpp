@@ -0,0 +1,193 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "multiview.h"
+#include "alloc_counter.h"
+#include "renderer.h"
+#include <cmath>
+
+namespace {
+    // The viewport's rectangle of a multi-view frame
+    std::vector<std::string> region(const MultiView& view, const Viewport& viewport) {
+        std::vector<std::string> cells;
+        for (int y = 0; y < viewport.rows; y++) {
+            cells.push_back(view.frame()[viewport.y + y].substr(viewport.x, viewport.cols));
+        }
+        return cells;
+    }
+
+    int differingCells(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+        int count = 0;
+        for (size_t y = 0; y < a.size() && y < b.size(); y++) {
+            for (size_t x = 0; x < a[y].size() && x < b[y].size(); x++) {
+                if (a[y][x] != b[y][x]) count++;
+            }
+        }
+        return count;
+    }
+
+    int shadedCells(const std::vector<std::string>& frame) {
+        int count = 0;
+        for (const auto& line : frame) {
+            for (char c : line) {
+                if (c != ' ') count++;
+            }
+        }
+        return count;
+    }
+}
+
+void testPerspectiveViewportsMatchRenderFrame() {
+    std::vector<Triangle> sphere = normalized(makeSphere(20, 40));
+    MultiView view(150, 40);
+    Viewport a, b;
+    a.cols = b.cols = 70;
+    a.rows = b.rows = 36;
+    a.x = 2;
+    a.y = 1;
+    b.x = 75;
+    b.y = 3;
+    a.camera = Camera{0.4f, 0.7f, 0.1f};
+    b.camera = Camera{-1.2f, 2.5f, 0.3f};
+    b.lightDir = Vec3(-0.3f, 0.2f, -0.9f).normalize();
+    view.viewports = {a, b};
+    view.render(sphere);
+
+    for (const Viewport& viewport : view.viewports) {
+        std::vector<std::string> expected(viewport.rows, std::string(viewport.cols, ' '));
+        std::vector<float> zbuffer;
+        zbuffer.resize((size_t)viewport.cols * viewport.rows);
+        clearBuffers(expected, zbuffer);
+        renderFrame(expected, zbuffer, sphere, viewport.camera.rotation(), viewport.lightDir);
+        // Shading from model-space light and normals may round a cell on a
+        // shade boundary the other way, but no more
+        ASSERT_TRUE(shadedCells(expected) > 300);
+        ASSERT_TRUE(differingCells(region(view, viewport), expected) <= 3);
+    }
+
+    // Nothing is drawn outside the viewports
+    ASSERT_TRUE(view.frame()[0] == std::string(150, ' '));
+    ASSERT_EQ(view.frame()[20][72], ' ');
+}
+
+void testAxisFastPathMatchesGeneralPath() {
+    std::vector<Triangle> cube = makeCube(10.0f);
+    MultiView view(60, 24);
+    Viewport axis;
+    axis.cols = 60;
+    axis.rows = 24;
+    axis.projection = ViewProjection::Orthographic;
+    axis.camera = Camera{0.0f, HALF_PI, 0.0f};
+    view.viewports = {axis};
+    view.render(cube);
+    std::vector<std::string> fast = view.frame();
+
+    // A hair off the axis takes the general path and draws the same cells,
+    // bar a few on the cube's edges
+    view.viewports[0].camera.angleY += 0.001f;
+    view.render(cube);
+    ASSERT_TRUE(shadedCells(fast) > 100);
+    ASSERT_TRUE(differingCells(fast, view.frame()) <= 6);
+
+    // Orthographic: moving the model along the view axis changes nothing
+    std::vector<Triangle> moved = cube;
+    for (auto& tri : moved) {
+        for (auto& v : tri.vertices) v.x += 20.0f;     // Model x is view depth when turned side-on
+    }
+    view.viewports[0].camera.angleY = HALF_PI;
+    view.render(moved);
+    ASSERT_TRUE(view.frame() == fast);
+
+    // The square face spans the scale a perspective view has at the centre:
+    // 20 units * 60 * 0.8 / 50 columns
+    int widest = 0;
+    for (const auto& line : fast) {
+        size_t first = line.find_first_not_of(' '), last = line.find_last_not_of(' ');
+        if (first != std::string::npos) widest = std::max(widest, (int)(last - first + 1));
+    }
+    ASSERT_TRUE(std::abs(widest - 19) <= 1);
+}
+
+void testFixedLightIsSharedByEveryView() {
+    std::vector<Triangle> sphere = normalized(makeSphere(20, 40));
+    MultiView view(80, 30);
+    view.fixedLightDir = Vec3(0.2f, 0.9f, -0.4f).normalize();
+
+    // A fixed light in model space is a view light turned with the camera
+    Viewport fixed;
+    fixed.cols = 80;
+    fixed.rows = 30;
+    fixed.camera = Camera{0.9f, -0.4f, 1.3f};
+    fixed.fixedLight = true;
+    view.viewports = {fixed};
+    view.render(sphere);
+    std::vector<std::string> shared = view.frame();
+
+    Viewport turning = fixed;
+    turning.fixedLight = false;
+    turning.lightDir = fixed.camera.rotation() * view.fixedLightDir;
+    view.viewports = {turning};
+    view.render(sphere);
+    ASSERT_TRUE(shadedCells(shared) > 300);
+    ASSERT_TRUE(differingCells(shared, view.frame()) <= 3);
+
+    // Seen from opposite sides, the lit side of the sphere stays lit
+    view.viewports = {fixed, fixed};
+    view.viewports[0].cols = view.viewports[1].cols = 40;
+    view.viewports[1].x = 40;
+    view.viewports[1].camera = Camera{0.0f, 2 * HALF_PI, 0.0f};
+    view.viewports[0].camera = Camera{0.0f, 0.0f, 0.0f};
+    view.render(sphere);
+    const std::vector<std::string>& frame = view.frame();
+    // The light comes from +y: the top rows are brighter than the bottom ones
+    // in both halves
+    for (int half = 0; half < 2; half++) {
+        int top = 0, bottom = 0;
+        for (int x = half * 40; x < half * 40 + 40; x++) {
+            for (int y = 0; y < 15; y++) top += (int)(std::string(SHADE_CHARS).find(frame[y][x]));
+            for (int y = 15; y < 30; y++) bottom += (int)(std::string(SHADE_CHARS).find(frame[y][x]));
+        }
+        ASSERT_TRUE(top > bottom);
+    }
+}
+
+void testAxisLayoutAndSteadyState() {
+    std::vector<Triangle> sphere = normalized(makeSphere(20, 40));
+    MultiView view(121, 41);
+    view.viewports = axisViewports(121, 41);
+    ASSERT_EQ(view.viewports.size(), (size_t)4);
+
+    // Four disjoint rectangles with a blank column and row between them
+    const Viewport* v = view.viewports.data();
+    ASSERT_EQ(v[0].cols + 1 + v[1].cols, 121);
+    ASSERT_EQ(v[0].rows + 1 + v[2].rows, 41);
+    ASSERT_EQ(v[1].x, v[0].cols + 1);
+    ASSERT_EQ(v[2].y, v[0].rows + 1);
+    ASSERT_TRUE(v[0].projection == ViewProjection::Perspective);
+    ASSERT_TRUE(v[3].projection == ViewProjection::Orthographic);
+
+    view.render(sphere);
+    for (const Viewport& viewport : view.viewports) {
+        ASSERT_TRUE(shadedCells(region(view, viewport)) > 50);
+    }
+    ASSERT_EQ(view.frame()[v[0].rows][10], ' ');
+    ASSERT_EQ(view.frame()[10][v[0].cols], ' ');
+
+    // Once the scratch memory has grown, frames do not allocate
+    size_t before = heapAllocations();
+    for (int frame = 0; frame < 10; frame++) {
+        view.viewports[0].camera.angleY += 0.1f;
+        view.render(sphere);
+    }
+    ASSERT_EQ(heapAllocations() - before, (size_t)0);
+}
+
+int main() {
+    std::cout << "Running multi-view tests..." << std::endl;
+    RUN_TEST(testPerspectiveViewportsMatchRenderFrame);
+    RUN_TEST(testAxisFastPathMatchesGeneralPath);
+    RUN_TEST(testFixedLightIsSharedByEveryView);
+    RUN_TEST(testAxisLayoutAndSteadyState);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
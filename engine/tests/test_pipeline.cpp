@@ -0,0 +1,137 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "pipeline.h"
+#include "renderer.h"
+
+namespace {
+    std::vector<std::string> renderSerial(const std::vector<Triangle>& model, const Camera& camera,
+                                          int width, int height) {
+        std::vector<std::string> buffer(height, std::string(width, ' '));
+        std::vector<float> zbuffer((size_t)width * height);
+        clearBuffers(buffer, zbuffer);
+        renderFrame(buffer, zbuffer, model, camera.rotation(), defaultLightDir());
+        return buffer;
+    }
+
+    // Keeps every presented frame
+    class RecordingSink : public FrameSink {
+    public:
+        std::vector<std::vector<std::string>> frames;
+        size_t present(const std::vector<std::string>& frame) override {
+            frames.push_back(frame);
+            return 0;
+        }
+    };
+}
+
+void testParallelMatchesRenderFrame() {
+    MeshRef sphere = normalizedMesh(makeSphere(40, 80));
+    ASSERT_TRUE(sphere->size() > 2 * GEOMETRY_CHUNK_TRIANGLES);
+    JobSystem jobs(3);
+    ParallelScratch scratch;
+
+    // Including heights that are not a whole number of bands
+    const int sizes[][2] = {{240, 80}, {100, 30}, {37, 5}};
+    for (const auto& size : sizes) {
+        Camera camera{0.3f, 1.1f, 0.2f};
+        std::vector<std::string> buffer(size[1], std::string(size[0], 'x'));
+        std::vector<float> zbuffer((size_t)size[0] * size[1], 0.0f);
+        renderFrameParallel(jobs, buffer, zbuffer, *sphere, camera.rotation(), defaultLightDir(), scratch);
+        ASSERT_TRUE(buffer == renderSerial(*sphere, camera, size[0], size[1]));
+    }
+
+    // A context with jobs renders the same frames as one without
+    RenderContext serial, parallel;
+    serial.setMesh(sphere);
+    parallel.setMesh(sphere);
+    parallel.setJobs(&jobs);
+    for (int f = 0; f < 5; f++) {
+        serial.camera = parallel.camera = Camera{f * 0.4f, f * 0.3f, 0.0f};
+        serial.render();
+        parallel.render();
+        ASSERT_TRUE(parallel.frame() == serial.frame());
+    }
+
+    // Reduced quality too, block sampling across band edges included, timed
+    // across the workers
+    for (const QualitySettings& quality : QUALITY_LEVELS) {
+        serial.render(*sphere, quality);
+        parallel.render(*sphere, quality);
+        ASSERT_TRUE(parallel.frame() == serial.frame());
+        ASSERT_TRUE(parallel.timings().geometry > 0.0 && parallel.timings().raster > 0.0);
+    }
+}
+
+void testFramesPresentedInOrder() {
+    MeshRef sphere = normalizedMesh(makeSphere(40, 80));
+    JobSystem jobs(4);
+    RecordingSink sink;
+    const int FRAMES = 24;
+    {
+        FramePipeline pipeline(jobs, 120, 40, 3);
+        ASSERT_EQ(pipeline.maxInFlight(), 3);
+        for (int f = 0; f < FRAMES; f++) {
+            pipeline.submit(sphere, Camera{f * 0.1f, f * 0.25f, 0.0f}, defaultLightDir(), &sink);
+            ASSERT_TRUE(pipeline.inFlight() <= 3);
+        }
+        pipeline.flush();
+        ASSERT_EQ(pipeline.inFlight(), 0);
+        ASSERT_TRUE(pipeline.peakInFlight() <= 3);
+
+        PipelineStats stats = pipeline.stats();
+        ASSERT_EQ(stats.frames, (size_t)FRAMES);
+        ASSERT_EQ(stats.threads, 5);
+        ASSERT_TRUE(stats.fps() > 0.0);
+        for (int stage = 0; stage < PIPELINE_STAGE_COUNT; stage++) {
+            double utilisation = stats.utilisation((PipelineStage)stage);
+            ASSERT_TRUE(utilisation >= 0.0 && utilisation <= 1.0);
+        }
+        ASSERT_TRUE(stats.busySeconds[STAGE_GEOMETRY] > 0.0);
+        ASSERT_TRUE(stats.busySeconds[STAGE_RASTER] > 0.0);
+    }
+
+    ASSERT_EQ(sink.frames.size(), (size_t)FRAMES);
+    for (int f = 0; f < FRAMES; f++) {
+        ASSERT_TRUE(sink.frames[f] == renderSerial(*sphere, Camera{f * 0.1f, f * 0.25f, 0.0f}, 120, 40));
+    }
+}
+
+void testSingleFrameInFlight() {
+    MeshRef sphere = normalizedMesh(makeSphere(40, 80));
+    JobSystem jobs(2);
+    RecordingSink sink;
+    FramePipeline pipeline(jobs, 60, 20, 0);
+    ASSERT_EQ(pipeline.maxInFlight(), 1);
+    for (int f = 0; f < 6; f++) {
+        pipeline.submit(sphere, Camera{0.0f, f * 0.5f, 0.0f}, defaultLightDir(), &sink);
+    }
+    pipeline.flush();
+    ASSERT_EQ(pipeline.peakInFlight(), 1);
+    ASSERT_EQ(sink.frames.size(), (size_t)6);
+    ASSERT_TRUE(sink.frames[5] == renderSerial(*sphere, Camera{0.0f, 2.5f, 0.0f}, 60, 20));
+}
+
+void testEmptyMesh() {
+    JobSystem jobs(2);
+    RecordingSink sink;
+    FramePipeline pipeline(jobs, 10, 4);
+    pipeline.submit(nullptr, Camera{}, defaultLightDir(), &sink);
+    pipeline.submit(std::make_shared<const std::vector<Triangle>>(), Camera{}, defaultLightDir(), &sink);
+    // No sink: rendered and counted, but shown nowhere
+    pipeline.submit(normalizedMesh(makeSphere(40, 80)), Camera{}, defaultLightDir(), nullptr);
+    pipeline.flush();
+    ASSERT_EQ(sink.frames.size(), (size_t)2);
+    ASSERT_TRUE(sink.frames[0] == std::vector<std::string>(4, std::string(10, ' ')));
+    ASSERT_EQ(pipeline.stats().frames, (size_t)3);
+}
+
+int main() {
+    std::cout << "Running pipeline tests..." << std::endl;
+    RUN_TEST(testParallelMatchesRenderFrame);
+    RUN_TEST(testFramesPresentedInOrder);
+    RUN_TEST(testSingleFrameInFlight);
+    RUN_TEST(testEmptyMesh);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,151 @@
+#include "test_framework.h"
+#include "quality.h"
+#include "rasterizer.h"
+#include "renderer.h"
+
+namespace {
+    // A flat grid of n x n quads (2 triangles each) spanning [-10, 10]
+    std::vector<Triangle> makeGrid(int n) {
+        std::vector<Triangle> grid;
+        float cell = 20.0f / n;
+        for (int y = 0; y < n; y++) {
+            for (int x = 0; x < n; x++) {
+                Vec3 a(-10 + x * cell, -10 + y * cell, 0);
+                Vec3 b = a + Vec3(cell, 0, 0);
+                Vec3 c = a + Vec3(0, cell, 0);
+                Vec3 d = a + Vec3(cell, cell, 0);
+                Triangle t1, t2;
+                t1.vertices[0] = a; t1.vertices[1] = c; t1.vertices[2] = b;
+                t2.vertices[0] = b; t2.vertices[1] = c; t2.vertices[2] = d;
+                t1.normal = t2.normal = Vec3(0, 0, -1);
+                grid.push_back(t1);
+                grid.push_back(t2);
+            }
+        }
+        return grid;
+    }
+
+    std::vector<std::string> emptyFrame() {
+        return std::vector<std::string>(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    }
+
+    size_t coveredCells(const std::vector<std::string>& frame) {
+        size_t covered = 0;
+        for (const auto& row : frame) {
+            for (char c : row) covered += c != ' ';
+        }
+        return covered;
+    }
+}
+
+void testFullQualityMatchesRenderFrame() {
+    std::vector<Triangle> model = makeGrid(8);
+    Mat3 rotation = rotationX(0.4f) * rotationY(0.3f);
+    Vec3 light = Vec3(0.5f, -0.7f, -0.5f).normalize();
+
+    std::vector<std::string> expected = emptyFrame(), actual = emptyFrame();
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    clearBuffers(expected, zbuffer);
+    renderFrame(expected, zbuffer, model, rotation, light);
+
+    RenderScratch scratch;
+    StageTimings timings;
+    renderFrameTimed(actual, zbuffer, model, rotation, light, QUALITY_LEVELS[0], scratch, timings);
+    ASSERT_TRUE(actual == expected);
+    ASSERT_EQ(scratch.count, model.size());
+    ASSERT_TRUE(timings.total() >= 0.0);
+}
+
+void testDecimation() {
+    std::vector<Triangle> grid = makeGrid(40);     // 0.5 unit cells
+    ASSERT_EQ(decimateModel(grid, 0.0f).size(), grid.size());
+
+    std::vector<Triangle> coarse = decimateModel(grid, 2.0f);
+    ASSERT_TRUE(coarse.size() < grid.size() / 4);
+    ASSERT_TRUE(coarse.size() > 0);
+
+    // A triangle inside one cell collapses entirely
+    Triangle tiny;
+    tiny.vertices[0] = Vec3(0.1f, 0.1f, 0.1f);
+    tiny.vertices[1] = Vec3(0.2f, 0.1f, 0.1f);
+    tiny.vertices[2] = Vec3(0.1f, 0.2f, 0.1f);
+    ASSERT_EQ(decimateModel({tiny}, 1.0f).size(), (size_t)0);
+
+    LodChain lods;
+    ASSERT_TRUE(&lods.select(grid, 2) == &grid);
+    lods.build(grid);
+    ASSERT_TRUE(&lods.select(grid, 0) == &grid);
+    ASSERT_TRUE(lods.select(grid, 1).size() <= grid.size());
+    ASSERT_TRUE(lods.select(grid, LOD_LEVEL_COUNT - 1).size() <= lods.select(grid, 1).size());
+}
+
+void testBlockSampling() {
+    std::vector<Triangle> model = makeGrid(4);
+    Mat3 rotation = rotationY(0.2f);
+    Vec3 light = Vec3(0.0f, 0.0f, -1.0f);
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    RenderScratch scratch;
+    StageTimings timings;
+
+    std::vector<std::string> fine = emptyFrame(), blocky = emptyFrame();
+    renderFrameTimed(fine, zbuffer, model, rotation, light, QUALITY_LEVELS[0], scratch, timings);
+    QualitySettings coarse = {0, 2};
+    renderFrameTimed(blocky, zbuffer, model, rotation, light, coarse, scratch, timings);
+
+    // Every aligned 2x2 block is uniform
+    for (int y = 0; y + 1 < SCREEN_HEIGHT; y += 2) {
+        for (int x = 0; x + 1 < SCREEN_WIDTH; x += 2) {
+            char c = blocky[y][x];
+            ASSERT_TRUE(blocky[y][x + 1] == c && blocky[y + 1][x] == c && blocky[y + 1][x + 1] == c);
+        }
+    }
+
+    // ...and the silhouette stays within a block of the full-resolution one
+    size_t fineCells = coveredCells(fine), blockyCells = coveredCells(blocky);
+    ASSERT_TRUE(blockyCells > fineCells * 8 / 10);
+    ASSERT_TRUE(blockyCells < fineCells * 12 / 10);
+}
+
+void testAdaptiveHysteresis() {
+    AdaptiveQuality quality(0.010);
+    ASSERT_EQ(quality.level(), 0);
+
+    // Sustained overload drops one level at a time, not on a single spike
+    ASSERT_FALSE(quality.update(0.030));
+    ASSERT_FALSE(quality.update(0.030));
+    ASSERT_TRUE(quality.update(0.030));
+    ASSERT_EQ(quality.level(), 1);
+
+    // Inside the dead band nothing changes, however long it lasts
+    for (int i = 0; i < 200; i++) {
+        ASSERT_FALSE(quality.update(i % 2 ? 0.009 : 0.006));
+    }
+    ASSERT_EQ(quality.level(), 1);
+
+    // Plenty of headroom for long enough steps back up, once the smoothed
+    // time has settled
+    int frames = 1;
+    while (!quality.update(0.002) && frames < 100) frames++;
+    ASSERT_EQ(quality.level(), 0);
+    ASSERT_TRUE(frames >= QUALITY_UPGRADE_FRAMES);
+    ASSERT_TRUE(frames < QUALITY_UPGRADE_FRAMES + 10);
+
+    // Never beyond the cheapest level
+    for (int i = 0; i < 100; i++) quality.update(1.0);
+    ASSERT_EQ(quality.level(), QUALITY_LEVEL_COUNT - 1);
+
+    quality.setBudget(0.020);
+    ASSERT_EQ(quality.level(), 0);
+    ASSERT_TRUE(quality.settings().sampleStep == 1 && quality.settings().lod == 0);
+}
+
+int main() {
+    std::cout << "Running quality tests..." << std::endl;
+    RUN_TEST(testFullQualityMatchesRenderFrame);
+    RUN_TEST(testDecimation);
+    RUN_TEST(testBlockSampling);
+    RUN_TEST(testAdaptiveHysteresis);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
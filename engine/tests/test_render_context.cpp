@@ -0,0 +1,132 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "render_context.h"
+#include "renderer.h"
+#include <thread>
+
+namespace {
+    size_t coveredCells(const std::vector<std::string>& frame) {
+        size_t covered = 0;
+        for (const auto& row : frame) {
+            for (char c : row) covered += c != ' ';
+        }
+        return covered;
+    }
+}
+
+void testMatchesRenderFrame() {
+    MeshRef cube = normalizedMesh(makeCube());
+    RenderContext context;
+    context.setMesh(cube);
+    context.camera = Camera{0.4f, 0.7f, 0.1f};
+    context.render();
+
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    clearBuffers(buffer, zbuffer);
+    renderFrame(buffer, zbuffer, *cube, context.camera.rotation(), defaultLightDir());
+
+    ASSERT_TRUE(context.frame() == buffer);
+    ASSERT_TRUE(coveredCells(context.frame()) > 0);
+
+    // Level 0 of the timed path is the same frame
+    context.render(*cube, QUALITY_LEVELS[0]);
+    ASSERT_TRUE(context.frame() == buffer);
+}
+
+void testRuntimeSize() {
+    RenderContext context(100, 30);
+    context.setMesh(normalizedMesh(makeCube()));
+    context.camera = Camera{0.4f, 0.7f, 0.1f};
+    context.render();
+    ASSERT_EQ(context.frame().size(), (size_t)30);
+    ASSERT_EQ(context.frame()[0].size(), (size_t)100);
+    size_t small = coveredCells(context.frame());
+    ASSERT_TRUE(small > 0);
+
+    // The projection follows the frame: twice the size, about four times the area
+    context.resize(200, 60);
+    context.render();
+    ASSERT_EQ(context.frame().size(), (size_t)60);
+    ASSERT_EQ(context.frame()[59].size(), (size_t)200);
+    size_t large = coveredCells(context.frame());
+    ASSERT_TRUE(large > small * 3 && large < small * 5);
+
+    // No mesh renders an empty frame
+    RenderContext empty(10, 5);
+    empty.render();
+    ASSERT_EQ(coveredCells(empty.frame()), (size_t)0);
+}
+
+void testConcurrentContexts() {
+    MeshRef cube = normalizedMesh(makeCube());
+    const int THREADS = 4;
+    const int FRAMES = 50;
+
+    // Each context renders a different orientation sequence of the shared mesh
+    auto renderSequence = [&](int id, std::vector<std::vector<std::string>>& out) {
+        RenderContext context(80 + id * 10, 24 + id);
+        context.setMesh(cube);
+        for (int f = 0; f < FRAMES; f++) {
+            context.camera = Camera{f * 0.05f, id * 0.3f + f * 0.02f, 0.1f};
+            context.render();
+            out.push_back(context.frame());
+        }
+    };
+
+    std::vector<std::vector<std::vector<std::string>>> serial(THREADS), parallel(THREADS);
+    for (int id = 0; id < THREADS; id++) renderSequence(id, serial[id]);
+
+    std::vector<std::thread> workers;
+    for (int id = 0; id < THREADS; id++) {
+        workers.emplace_back(renderSequence, id, std::ref(parallel[id]));
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (int id = 0; id < THREADS; id++) {
+        ASSERT_TRUE(parallel[id] == serial[id]);
+    }
+}
+
+void testSink() {
+    RenderContext context(40, 12);
+    context.setMesh(normalizedMesh(makeCube()));
+
+    // Without a sink frames stay in the context
+    context.render();
+    ASSERT_EQ(context.present(), (size_t)0);
+
+    int presented = 0;
+    size_t rows = 0;
+    TextSink sink(40, 12, [&](const DisplayBuffer& display) {
+        presented++;
+        rows += display.dirty().size();
+    });
+    context.setSink(&sink);
+    ASSERT_TRUE(context.sink() == &sink);
+
+    ASSERT_TRUE(context.present() > 0);
+    ASSERT_EQ(presented, 1);
+    ASSERT_EQ(rows, (size_t)12);
+
+    // An unchanged frame never reaches the presenter
+    ASSERT_EQ(context.present(), (size_t)0);
+    ASSERT_EQ(presented, 1);
+
+    context.camera.angleY += 0.3f;
+    context.render();
+    ASSERT_TRUE(context.present() > 0);
+    ASSERT_EQ(presented, 2);
+    ASSERT_TRUE(sink.display().stats.skipped == 1);
+}
+
+int main() {
+    std::cout << "Running render context tests..." << std::endl;
+    RUN_TEST(testMatchesRenderFrame);
+    RUN_TEST(testRuntimeSize);
+    RUN_TEST(testConcurrentContexts);
+    RUN_TEST(testSink);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
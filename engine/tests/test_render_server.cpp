@@ -0,0 +1,226 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "render_server.h"
+#include "model.h"
+#include "slicer.h"
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    // `count` x `count` small cubes side by side
+    std::vector<Triangle> makeGrid(int count) {
+        std::vector<Triangle> grid;
+        for (int y = 0; y < count; y++) {
+            for (int x = 0; x < count; x++) {
+                for (Triangle tri : makeCube(0.4f)) {
+                    for (auto& v : tri.vertices) v = v + Vec3((float)x, (float)y, 0.0f);
+                    grid.push_back(tri);
+                }
+            }
+        }
+        return grid;
+    }
+
+    std::string socketPath() {
+        return "/tmp/termesh_test_" + std::to_string(getpid()) + ".sock";
+    }
+
+    // A server running on its own thread for the length of a test
+    struct RunningServer {
+        RenderServer server;
+        std::thread thread;
+
+        explicit RunningServer(const ServerOptions& options) : server(options) {
+            if (server.listen(socketPath())) thread = std::thread([this] { server.run(); });
+        }
+        ~RunningServer() {
+            server.stop();
+            if (thread.joinable()) thread.join();
+        }
+    };
+
+    // The frame a RenderContext renders of the normalized model
+    std::vector<std::string> expectedFrame(std::vector<Triangle> model, const RenderRequest& request) {
+        float scale;
+        normalizeModel(model, scale);
+        RenderContext context(request.cols, request.rows);
+        context.setMesh(std::make_shared<const std::vector<Triangle>>(model));
+        context.camera = request.camera;
+        if (request.mode == RenderMode::Shaded) {
+            context.render();
+        } else {
+            SliceIndex index;
+            index.build(model, SliceAxis::Z);
+            context.renderSlice(index, (index.minExtent() + index.maxExtent()) * 0.5f,
+                                request.mode == RenderMode::Cap);
+        }
+        return context.frame();
+    }
+}
+
+void testRequestRoundTrip() {
+    RenderRequest request;
+    request.path = "/models/with spaces/part.stl";
+    request.camera = Camera{0.1f, -2.5f, 3.0f};
+    request.cols = 100;
+    request.rows = 30;
+    request.mode = RenderMode::Cap;
+
+    RenderRequest parsed;
+    size_t byteCount = 99;
+    std::string error;
+    ASSERT_TRUE(parseRequest(encodeRequest(request), parsed, byteCount, error));
+    ASSERT_TRUE(parsed.path == request.path);
+    ASSERT_EQ(byteCount, (size_t)0);
+    ASSERT_EQ(parsed.camera.angleY, -2.5f);
+    ASSERT_EQ(parsed.cols, 100);
+    ASSERT_EQ(parsed.rows, 30);
+    ASSERT_TRUE(parsed.mode == RenderMode::Cap);
+
+    request.bytes.assign(1234, 0);
+    ASSERT_TRUE(parseRequest(encodeRequest(request), parsed, byteCount, error));
+    ASSERT_EQ(byteCount, (size_t)1234);
+
+    ASSERT_FALSE(parseRequest("RENDER 0 0 0 80x24 shaded", parsed, byteCount, error));
+    ASSERT_FALSE(parseRequest("RENDER 0 0 0 80x24 wireframe PATH a.stl", parsed, byteCount, error));
+    ASSERT_FALSE(parseRequest("RENDER 0 0 0 0x24 shaded PATH a.stl", parsed, byteCount, error));
+    ASSERT_FALSE(parseRequest("RENDER 0 0 0 4000x4000 shaded PATH a.stl", parsed, byteCount, error));
+    ASSERT_FALSE(parseRequest("RENDER 0 0 0 80x24 shaded BYTES 0", parsed, byteCount, error));
+    ASSERT_FALSE(parseRequest("RENDER nan 0 0 80x24 shaded PATH a.stl", parsed, byteCount, error));
+}
+
+void testRendersLikeRenderContext() {
+    std::vector<Triangle> cube = makeCube(3.0f);
+    std::string path = "/tmp/termesh_server_cube.stl";
+    writeFile(path, stlBytes(cube));
+
+    ServerOptions options;
+    options.threads = 2;
+    RunningServer running(options);
+    RenderClient client;
+    ASSERT_TRUE(client.connect(socketPath()));
+
+    RenderRequest request;
+    request.path = path;
+    request.camera = Camera{0.4f, 0.7f, 0.1f};
+    request.cols = 70;
+    request.rows = 22;
+    std::vector<std::string> frame;
+    std::string error;
+    ASSERT_TRUE(client.render(request, frame, error));
+    ASSERT_TRUE(frame == expectedFrame(cube, request));
+
+    // The same model sent inline, cut through the middle
+    request.bytes = stlBytes(cube);
+    request.mode = RenderMode::Slice;
+    ASSERT_TRUE(client.render(request, frame, error));
+    ASSERT_TRUE(frame == expectedFrame(cube, request));
+
+    // A model that cannot be loaded fails that request only
+    request.bytes.clear();
+    request.path = "/tmp/termesh_server_missing.stl";
+    ASSERT_FALSE(client.render(request, frame, error));
+    ASSERT_TRUE(error.find("cannot open") != std::string::npos);
+    request.path = path;
+    request.mode = RenderMode::Shaded;
+    ASSERT_TRUE(client.render(request, frame, error));
+
+    ServerStats stats = running.server.stats();
+    ASSERT_EQ(stats.requests, (size_t)4);
+    ASSERT_EQ(stats.errors, (size_t)1);
+    ASSERT_EQ(stats.loads, (size_t)2);          // The file once, the inline copy once
+    ASSERT_EQ(stats.cache.hits, (size_t)1);
+}
+
+void testConcurrentRequestsAreBatched() {
+    // Large enough that requests queue up while the first one is served
+    std::string path = "/tmp/termesh_server_large.stl";
+    writeFile(path, stlBytes(makeGrid(40)));
+
+    // Without a cache a model is parsed once per batch, never per request
+    ServerOptions options;
+    options.threads = 1;
+    options.cacheBytes = 0;
+    RunningServer running(options);
+
+    const int CLIENTS = 8, REQUESTS = 5;
+    std::vector<std::thread> clients;
+    std::atomic<int> failures{0};
+    for (int c = 0; c < CLIENTS; c++) {
+        clients.emplace_back([&, c] {
+            RenderClient client;
+            if (!client.connect(socketPath())) {
+                failures++;
+                return;
+            }
+            RenderRequest request;
+            request.path = path;
+            std::vector<std::string> frame;
+            std::string error;
+            for (int i = 0; i < REQUESTS; i++) {
+                request.camera = Camera{c * 0.3f, i * 0.2f, 0.0f};
+                if (!client.render(request, frame, error) || frame.size() != (size_t)SCREEN_HEIGHT) failures++;
+            }
+        });
+    }
+    for (auto& client : clients) client.join();
+    ASSERT_EQ(failures.load(), 0);
+
+    ServerStats stats = running.server.stats();
+    ASSERT_EQ(stats.requests, (size_t)(CLIENTS * REQUESTS));
+    ASSERT_EQ(stats.loads, stats.batches);
+    ASSERT_TRUE(stats.largestBatch > 1);
+    ASSERT_TRUE(stats.batches < stats.requests);
+}
+
+void testLoadGeneratorAndErrors() {
+    std::string path = "/tmp/termesh_server_cube.stl";
+    writeFile(path, stlBytes(makeCube(1.0f)));
+    RunningServer running(ServerOptions{});
+
+    LoadOptions load;
+    load.socketPath = socketPath();
+    load.models = {path};
+    load.connections = 4;
+    load.requests = 60;
+    load.sendBytes = true;
+    LoadStats stats = runLoadGenerator(load);
+    ASSERT_EQ(stats.requests, (size_t)60);
+    ASSERT_EQ(stats.failures, (size_t)0);
+    ASSERT_TRUE(stats.p50Ms > 0.0 && stats.p50Ms <= stats.p99Ms && stats.p99Ms <= stats.maxMs);
+    ASSERT_TRUE(stats.requestsPerSecond() > 0.0);
+
+    std::string line;
+    RenderClient client;
+    ASSERT_TRUE(client.connect(socketPath()));
+    ASSERT_TRUE(client.stats(line));
+    ASSERT_TRUE(line.find("requests=60 ") != std::string::npos);
+    ASSERT_TRUE(line.find("loads=1 ") != std::string::npos);
+
+    // A malformed request is answered, then the connection is closed
+    std::vector<std::string> frame;
+    std::string error;
+    RenderRequest bad;
+    bad.path = path;
+    bad.cols = 0;
+    ASSERT_FALSE(client.render(bad, frame, error));
+    ASSERT_TRUE(error == "bad frame size");
+    ASSERT_FALSE(client.stats(line));
+
+    // Nothing listening: every request fails, none hangs
+    load.socketPath = "/tmp/termesh_test_nobody.sock";
+    stats = runLoadGenerator(load);
+    ASSERT_EQ(stats.requests, (size_t)0);
+    ASSERT_EQ(stats.failures, (size_t)60);
+}
+
+int main() {
+    std::cout << "Running render server tests..." << std::endl;
+    RUN_TEST(testRequestRoundTrip);
+    RUN_TEST(testRendersLikeRenderContext);
+    RUN_TEST(testConcurrentRequestsAreBatched);
+    RUN_TEST(testLoadGeneratorAndErrors);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
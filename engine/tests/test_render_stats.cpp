@@ -0,0 +1,158 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "render_stats.h"
+#include "jobs.h"
+#include "rasterizer.h"
+#include "render_context.h"
+#include <memory>
+#include <thread>
+
+// Linked against the engine built with TERMESH_STATS (see the Makefile)
+
+namespace {
+    bool sameCounters(const RenderCounters& a, const RenderCounters& b) {
+        for (int i = 0; i < RENDER_COUNTER_COUNT; i++) {
+            if (a.values[i] != b.values[i]) return false;
+        }
+        return true;
+    }
+}
+
+void testFrameCountersAddUp() {
+    ASSERT_TRUE(statsCounting());
+    std::vector<Triangle> sphere = normalized(makeSphere(20, 40));
+    RenderContext view(120, 40);
+    view.setMesh(std::make_shared<const std::vector<Triangle>>(sphere));
+    view.camera = Camera{0.4f, 0.7f, 0.1f};
+    view.render();
+
+    const FrameStats& stats = view.stats();
+    const RenderCounters& c = stats.counters;
+    ASSERT_EQ(c[COUNTER_SUBMITTED], (uint64_t)sphere.size());
+    // Every triangle is culled or meets the rasterizer exactly once; about
+    // half of a sphere faces away
+    ASSERT_EQ(c[COUNTER_CULLED] + c[COUNTER_CLIPPED] + c[COUNTER_DEGENERATE] + c[COUNTER_RASTERIZED],
+              (uint64_t)sphere.size());
+    ASSERT_TRUE(c[COUNTER_CULLED] > sphere.size() / 3 && c[COUNTER_CULLED] < sphere.size() * 2 / 3);
+    ASSERT_EQ(c[COUNTER_CLIPPED], (uint64_t)0);
+
+    // Each covered cell was written at least once, and every write or
+    // rejection followed a coverage test
+    ASSERT_TRUE(stats.cellsCovered > 500);
+    ASSERT_TRUE(c[COUNTER_DEPTH_PASSES] >= stats.cellsCovered);
+    ASSERT_TRUE(c[COUNTER_CELLS_TESTED] >= c[COUNTER_DEPTH_PASSES] + c[COUNTER_DEPTH_FAILS]);
+    ASSERT_TRUE(stats.overdraw() >= 1.0 && stats.overdraw() < 2.0);
+    ASSERT_TRUE(stats.frameSeconds > 0.0);
+    ASSERT_TRUE(stats.timings.raster > 0.0);
+
+    // The same frame again counts the same, not a running total
+    RenderCounters first = c;
+    view.render();
+    ASSERT_TRUE(sameCounters(first, view.stats().counters));
+
+    // Block sampling tests one cell per block
+    view.render(sphere, QUALITY_LEVELS[2]);
+    ASSERT_TRUE(view.stats().counters[COUNTER_CELLS_TESTED] * 2 < first[COUNTER_CELLS_TESTED]);
+    ASSERT_EQ(view.stats().counters[COUNTER_SUBMITTED], (uint64_t)sphere.size());
+}
+
+void testParallelCountsMatchSerial() {
+    std::vector<Triangle> sphere = normalized(makeSphere(20, 40));
+    // Off-centre, so some triangles leave the frame
+    for (auto& tri : sphere) {
+        for (auto& v : tri.vertices) v.x += 30.0f;
+    }
+    auto mesh = std::make_shared<const std::vector<Triangle>>(sphere);
+    RenderContext serial(100, 45), parallel(100, 45);
+    serial.setMesh(mesh);
+    parallel.setMesh(mesh);
+    JobSystem jobs(3);
+    parallel.setJobs(&jobs);
+    serial.camera = parallel.camera = Camera{-0.3f, 1.1f, 0.2f};
+
+    serial.render();
+    parallel.render();
+    ASSERT_TRUE(serial.frame() == parallel.frame());
+    // Bands each see every triangle, but only one of them classifies it
+    ASSERT_TRUE(serial.stats().counters[COUNTER_CLIPPED] > 0);
+    ASSERT_TRUE(sameCounters(serial.stats().counters, parallel.stats().counters));
+    ASSERT_EQ(serial.stats().cellsCovered, parallel.stats().cellsCovered);
+}
+
+void testRasterizerClassification() {
+    std::vector<std::string> buffer(20, std::string(40, ' '));
+    std::vector<float> zbuffer(40 * 20);
+    clearBuffers(buffer, zbuffer);
+    const float intensities[3] = {1.0f, 1.0f, 1.0f};
+
+    RenderCounters before = threadRenderCounters();
+    Vec3 offFrame[3] = {{50, 2, 0}, {60, 2, 0}, {55, 8, 0}};
+    Vec3 sliver[3] = {{2, 2, 0}, {10, 10, 0}, {6, 6, 0}};
+    Vec3 square[3] = {{0, 0, 1}, {10, 0, 1}, {0, 10, 1}};
+    rasterizeTriangle(buffer, zbuffer, offFrame, intensities);
+    rasterizeTriangle(buffer, zbuffer, sliver, intensities);
+    rasterizeTriangle(buffer, zbuffer, square, intensities);
+    RenderCounters c = threadRenderCounters() - before;
+    ASSERT_EQ(c[COUNTER_CLIPPED], (uint64_t)1);
+    ASSERT_EQ(c[COUNTER_DEGENERATE], (uint64_t)1);
+    ASSERT_EQ(c[COUNTER_RASTERIZED], (uint64_t)1);
+    ASSERT_EQ(c[COUNTER_CELLS_TESTED], (uint64_t)(11 * 11));
+    // Up to 66 cells, less any on the hypotenuse that round outside
+    const uint64_t covered = c[COUNTER_DEPTH_PASSES];
+    ASSERT_TRUE(covered > 55 && covered <= 66);
+    ASSERT_EQ(c[COUNTER_DEPTH_FAILS], (uint64_t)0);
+
+    // Drawn again behind itself, in two bands: every covered cell fails, and
+    // the triangle is counted by one band only
+    Vec3 behind[3] = {{0, 0, 0}, {10, 0, 0}, {0, 10, 0}};
+    before = threadRenderCounters();
+    rasterizeTriangleRows(buffer, zbuffer, behind, intensities, 1, 0, 4);
+    rasterizeTriangleRows(buffer, zbuffer, behind, intensities, 1, 4, 20);
+    c = threadRenderCounters() - before;
+    ASSERT_EQ(c[COUNTER_RASTERIZED], (uint64_t)1);
+    ASSERT_EQ(c[COUNTER_CELLS_TESTED], (uint64_t)(11 * 11));
+    ASSERT_EQ(c[COUNTER_DEPTH_PASSES], (uint64_t)0);
+    ASSERT_EQ(c[COUNTER_DEPTH_FAILS], covered);
+}
+
+void testOverlayAndThreadTotals() {
+    FrameStats stats;
+    stats.counters[COUNTER_SUBMITTED] = 1600;
+    stats.counters[COUNTER_DEPTH_PASSES] = 300;
+    stats.cellsCovered = 200;
+    ASSERT_FLOAT_EQ(stats.overdraw(), 1.5, 1e-9);
+
+    std::vector<std::string> lines = statsLines(stats);
+    ASSERT_EQ(lines.size(), (size_t)STATS_OVERLAY_ROWS);
+    ASSERT_TRUE(lines[0].find("tris 1600") != std::string::npos);
+    ASSERT_TRUE(lines[1].find("overdraw 1.50x") != std::string::npos);
+
+    // Written over the top rows, cut to the frame's width
+    std::vector<std::string> frame(4, std::string(30, '#'));
+    drawStatsOverlay(frame, stats);
+    ASSERT_TRUE(frame[0] == lines[0].substr(0, 30));
+    ASSERT_TRUE(frame[2].size() == 30);
+    ASSERT_TRUE(frame[3] == std::string(30, '#'));
+    std::vector<std::string> small(1, std::string(200, '#'));
+    drawStatsOverlay(small, stats);
+    ASSERT_EQ(small.size(), (size_t)1);
+    ASSERT_TRUE(small[0].compare(0, lines[0].size(), lines[0]) == 0);
+    ASSERT_EQ(small[0][199], '#');
+
+    // Counts of a thread that has exited stay in the process totals
+    RenderCounters before = allRenderCounters();
+    std::thread worker([] { addRenderCounter(COUNTER_CULLED, 5); });
+    worker.join();
+    ASSERT_EQ((allRenderCounters() - before)[COUNTER_CULLED], (uint64_t)5);
+}
+
+int main() {
+    std::cout << "Running render stats tests..." << std::endl;
+    RUN_TEST(testFrameCountersAddUp);
+    RUN_TEST(testParallelCountsMatchSerial);
+    RUN_TEST(testRasterizerClassification);
+    RUN_TEST(testOverlayAndThreadTotals);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
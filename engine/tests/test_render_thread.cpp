@@ -0,0 +1,118 @@
+#include "test_framework.h"
+#include "render_thread.h"
+#include <atomic>
+#include <chrono>
+
+namespace {
+    std::vector<std::string> makeFrame(int number) {
+        return std::vector<std::string>(4, std::string(8, (char)('a' + number % 26)));
+    }
+
+    // Polls until `done` holds or a second passes
+    template <typename Condition>
+    bool waitFor(Condition done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+void testExchangeKeepsLatestFrame() {
+    FrameExchange exchange;
+    std::vector<std::string> frame;
+    ASSERT_FALSE(exchange.acquire(frame));
+    ASSERT_FALSE(exchange.pending());
+
+    exchange.publish(makeFrame(0));
+    exchange.publish(makeFrame(1));
+    ASSERT_TRUE(exchange.pending());
+    ASSERT_TRUE(exchange.acquire(frame));
+    ASSERT_TRUE(frame == makeFrame(1));
+    ASSERT_EQ(exchange.dropped(), (size_t)1);
+
+    // Nothing new: the presenter keeps what it has
+    ASSERT_FALSE(exchange.acquire(frame));
+    ASSERT_TRUE(frame == makeFrame(1));
+    ASSERT_EQ(exchange.published(), (size_t)2);
+    ASSERT_EQ(exchange.acquired(), (size_t)1);
+}
+
+void testRendersWhilePresenterIsBlocked() {
+    FrameExchange exchange;
+    std::atomic<int> next{0};
+    RenderThread thread([&] {
+        exchange.publish(makeFrame(next++));
+        return true;
+    }, 200);
+
+    // The presenting thread is busy and takes nothing, yet frames keep coming
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(thread.frames() >= 5);
+    ASSERT_EQ(exchange.acquired(), (size_t)0);
+
+    // When it gets round to it, it sees the newest complete frame
+    std::vector<std::string> frame;
+    ASSERT_TRUE(waitFor([&] { return exchange.pending(); }));
+    ASSERT_TRUE(exchange.acquire(frame));
+    ASSERT_EQ(frame.size(), (size_t)4);
+    ASSERT_TRUE(exchange.dropped() >= 4);
+}
+
+void testIdlesUntilWoken() {
+    std::atomic<int> work{1};
+    std::atomic<int> rendered{0};
+    RenderThread thread([&] {
+        if (work == 0) return false;
+        work--;
+        rendered++;
+        return true;
+    }, 0);
+
+    ASSERT_TRUE(waitFor([&] { return thread.idle(); }));
+    ASSERT_EQ(rendered.load(), 1);
+
+    work = 2;
+    thread.wake();
+    ASSERT_FALSE(thread.idle());
+    ASSERT_TRUE(waitFor([&] { return rendered == 3 && thread.idle(); }));
+    ASSERT_EQ(thread.frames(), (size_t)3);
+}
+
+void testIdleWorkBetweenFrames() {
+    std::atomic<int> calls{0};
+    std::atomic<bool> inPeriod{true};
+    RenderThread thread([] { return true; }, 50, [&](double seconds) {
+        // At most the 20 ms period is left once a frame is done
+        if (seconds < 0.0 || seconds > 0.02) inPeriod = false;
+        calls++;
+    });
+    ASSERT_TRUE(waitFor([&] { return calls >= 3; }));
+    ASSERT_TRUE(inPeriod.load());
+    ASSERT_TRUE(thread.frames() >= (size_t)calls.load());
+}
+
+void testStopsPromptly() {
+    auto start = std::chrono::steady_clock::now();
+    {
+        // One frame a second: the destructor must not wait out the period
+        RenderThread thread([] { return true; }, 1);
+        ASSERT_TRUE(waitFor([&] { return thread.frames() >= 1; }));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_TRUE(seconds < 0.5);
+}
+
+int main() {
+    std::cout << "Running render thread tests..." << std::endl;
+    RUN_TEST(testExchangeKeepsLatestFrame);
+    RUN_TEST(testRendersWhilePresenterIsBlocked);
+    RUN_TEST(testIdlesUntilWoken);
+    RUN_TEST(testIdleWorkBetweenFrames);
+    RUN_TEST(testStopsPromptly);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,90 @@
+#include "test_framework.h"
+#include "scheduler.h"
+
+void testFirstFrameThenIdle() {
+    FrameScheduler scheduler;
+    // Nothing has been drawn, so the first tick renders
+    ASSERT_TRUE(scheduler.wantsTicks());
+    ASSERT_TRUE(scheduler.tick());
+    scheduler.rendered();
+
+    // A static view then needs no more frames
+    ASSERT_FALSE(scheduler.wantsTicks());
+    ASSERT_FALSE(scheduler.tick());
+    ASSERT_EQ(scheduler.stats.ticks, (size_t)2);
+    ASSERT_EQ(scheduler.stats.rendered, (size_t)1);
+    ASSERT_EQ(scheduler.stats.suspensions, (size_t)1);
+}
+
+void testInvalidateWakes() {
+    FrameScheduler scheduler;
+    scheduler.tick();
+    scheduler.rendered();
+
+    scheduler.invalidate(DIRTY_ORIENTATION);
+    scheduler.invalidate(DIRTY_LIGHT);
+    ASSERT_EQ(scheduler.dirtyFlags(), (unsigned)(DIRTY_ORIENTATION | DIRTY_LIGHT));
+    ASSERT_TRUE(scheduler.tick());
+    scheduler.rendered();
+    ASSERT_EQ(scheduler.dirtyFlags(), (unsigned)DIRTY_NONE);
+    ASSERT_FALSE(scheduler.wantsTicks());
+}
+
+void testAnimationRendersEveryTick() {
+    FrameScheduler scheduler;
+    scheduler.setAnimating(true);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(scheduler.tick());
+        scheduler.rendered();
+    }
+    ASSERT_EQ(scheduler.stats.suspensions, (size_t)0);
+
+    scheduler.setAnimating(false);
+    ASSERT_FALSE(scheduler.wantsTicks());
+}
+
+void testHiddenOutputKeepsChanges() {
+    FrameScheduler scheduler;
+    scheduler.setAnimating(true);
+    scheduler.setVisible(false);
+    ASSERT_FALSE(scheduler.wantsTicks());
+    ASSERT_FALSE(scheduler.tick());
+
+    // Changes made while hidden are drawn once the output shows again
+    scheduler.setAnimating(false);
+    scheduler.invalidate(DIRTY_MODE);
+    ASSERT_FALSE(scheduler.wantsTicks());
+    scheduler.setVisible(true);
+    ASSERT_TRUE(scheduler.tick());
+    scheduler.rendered();
+    ASSERT_FALSE(scheduler.wantsTicks());
+}
+
+void testChangesWhileRendering() {
+    FrameScheduler scheduler;
+    ASSERT_TRUE(scheduler.tick());
+    scheduler.captured();
+    ASSERT_FALSE(scheduler.wantsTicks());
+
+    // A change made after the state was read is drawn by the next frame
+    scheduler.invalidate(DIRTY_ORIENTATION);
+    scheduler.rendered();
+    ASSERT_EQ(scheduler.dirtyFlags(), (unsigned)DIRTY_ORIENTATION);
+    ASSERT_TRUE(scheduler.tick());
+    scheduler.captured();
+    scheduler.rendered();
+    ASSERT_FALSE(scheduler.wantsTicks());
+    ASSERT_EQ(scheduler.stats.rendered, (size_t)2);
+}
+
+int main() {
+    std::cout << "Running scheduler tests..." << std::endl;
+    RUN_TEST(testFirstFrameThenIdle);
+    RUN_TEST(testInvalidateWakes);
+    RUN_TEST(testAnimationRendersEveryTick);
+    RUN_TEST(testHiddenOutputKeepsChanges);
+    RUN_TEST(testChangesWhileRendering);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
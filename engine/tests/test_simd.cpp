@@ -0,0 +1,53 @@
+#include "test_framework.h"
+#include "simd.h"
+#include "lighting.h"
+#include <vector>
+
+// The kernels must match the scalar code bit for bit in either build, so
+// these compare with ==, not a tolerance
+
+void testTransformTriangle() {
+    Mat3 rotation = rotationX(0.37f) * rotationY(-1.2f) * rotationZ(2.9f);
+    Vec3 in[3] = {Vec3(1.5f, -2.25f, 7.0f), Vec3(-13.0f, 0.1f, 0.0f), Vec3(0.0f, 14.9f, -3.3f)};
+    Vec3 out[3];
+    transformTriangle(rotation, in, out);
+    for (int i = 0; i < 3; i++) {
+        Vec3 expected = rotation * in[i];
+        ASSERT_TRUE(out[i].x == expected.x && out[i].y == expected.y && out[i].z == expected.z);
+    }
+}
+
+void testLightTriangle() {
+    Vec3 light = Vec3(0.5f, -0.7f, -0.5f).normalize();
+    Vec3 normals[3] = {Vec3(0, 0, -1), Vec3(0.6f, -0.8f, 0.0f), Vec3(0, 0, 1)};
+    float out[3];
+    lightTriangle(normals, light, out);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(out[i] == calculateLighting(normals[i], light));
+    }
+
+    // Facing away from the light leaves only the ambient term
+    ASSERT_FLOAT_EQ(out[2], 0.2f, 1e-6f);
+}
+
+void testFillFloats() {
+    // Lengths around the vector width exercise the scalar tail
+    for (size_t count : {0, 1, 3, 4, 5, 8, 19}) {
+        std::vector<float> data(count + 1, 7.0f);
+        fillFloats(data.data(), count, -1e10f);
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_TRUE(data[i] == -1e10f);
+        }
+        ASSERT_TRUE(data[count] == 7.0f);
+    }
+}
+
+int main() {
+    std::cout << "Running SIMD kernel tests (" << (SIMD_ENABLED ? "SIMD" : "scalar") << ")..." << std::endl;
+    RUN_TEST(testTransformTriangle);
+    RUN_TEST(testLightTriangle);
+    RUN_TEST(testFillFloats);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
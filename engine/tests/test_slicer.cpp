@@ -0,0 +1,160 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "slicer.h"
+#include "rasterizer.h"
+#include "math3d.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Deterministic scatter of small triangles for comparing against brute force
+    std::vector<Triangle> makeScatter(int count) {
+        std::vector<Triangle> tris;
+        unsigned seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1103515245u + 12345u;
+            return (float)((seed >> 8) % 10000) / 10000.0f;
+        };
+        for (int i = 0; i < count; i++) {
+            Vec3 base(next() * 30 - 15, next() * 30 - 15, next() * 30 - 15);
+            Triangle tri;
+            for (int j = 0; j < 3; j++) {
+                tri.vertices[j] = base + Vec3(next() * 4, next() * 4, next() * 4);
+            }
+            tri.normal = Vec3(0, 0, 1);
+            tris.push_back(tri);
+        }
+        return tris;
+    }
+}
+
+void testSliceIndexMatchesBruteForce() {
+    std::vector<Triangle> tris = makeScatter(500);
+    SliceIndex index;
+    index.build(tris, SliceAxis::Z);
+
+    std::vector<uint32_t> found;
+    for (float pos = -16.0f; pos <= 20.0f; pos += 0.37f) {
+        index.query(pos, found);
+        std::sort(found.begin(), found.end());
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < tris.size(); i++) {
+            float lo = std::min({tris[i].vertices[0].z, tris[i].vertices[1].z, tris[i].vertices[2].z});
+            float hi = std::max({tris[i].vertices[0].z, tris[i].vertices[1].z, tris[i].vertices[2].z});
+            if (lo <= pos && pos <= hi) expected.push_back(i);
+        }
+        ASSERT_TRUE(found == expected);
+    }
+}
+
+void testSliceIndexCountBelow() {
+    std::vector<Triangle> tris = makeScatter(200);
+    SliceIndex index;
+    index.build(tris, SliceAxis::Y);
+
+    float pos = 2.5f;
+    size_t below = index.countBelow(pos);
+    size_t expected = 0;
+    for (const auto& tri : tris) {
+        if (std::max({tri.vertices[0].y, tri.vertices[1].y, tri.vertices[2].y}) < pos) expected++;
+    }
+    ASSERT_EQ(below, expected);
+    for (size_t i = 0; i < below; i++) {
+        const Triangle& tri = tris[index.below()[i]];
+        ASSERT_TRUE(std::max({tri.vertices[0].y, tri.vertices[1].y, tri.vertices[2].y}) < pos);
+    }
+}
+
+void testSliceIndexEmpty() {
+    std::vector<Triangle> empty;
+    SliceIndex index;
+    index.build(empty, SliceAxis::Z);
+
+    std::vector<uint32_t> found = {1, 2, 3};
+    index.query(0.0f, found);
+    ASSERT_TRUE(found.empty());
+    ASSERT_TRUE(index.countBelow(0.0f) == 0);
+}
+
+void testSliceMeshCube() {
+    std::vector<Triangle> cube = makeCube(10.0f);
+    SliceIndex index;
+    index.build(cube, SliceAxis::Z);
+    ASSERT_FLOAT_EQ(index.minExtent(), -10.0f, 1e-5f);
+    ASSERT_FLOAT_EQ(index.maxExtent(), 10.0f, 1e-5f);
+
+    std::vector<uint32_t> candidates;
+    std::vector<SliceSegment> segments;
+    sliceMesh(cube, index, 0.0f, candidates, segments);
+
+    // Each of the four side faces contributes two segments
+    ASSERT_EQ(segments.size(), (size_t)8);
+    for (const auto& seg : segments) {
+        ASSERT_FLOAT_EQ(seg.a.z, 0.0f, 1e-5f);
+        ASSERT_FLOAT_EQ(seg.b.z, 0.0f, 1e-5f);
+        float edgeA = std::max(std::abs(seg.a.x), std::abs(seg.a.y));
+        float edgeB = std::max(std::abs(seg.b.x), std::abs(seg.b.y));
+        ASSERT_FLOAT_EQ(edgeA, 10.0f, 1e-4f);
+        ASSERT_FLOAT_EQ(edgeB, 10.0f, 1e-4f);
+    }
+
+    // Outside the mesh there is nothing to cut
+    sliceMesh(cube, index, 11.0f, candidates, segments);
+    ASSERT_TRUE(segments.empty());
+}
+
+void testRenderSliceContourOnly() {
+    std::vector<Triangle> cube = makeCube(10.0f);
+    SliceIndex index;
+    index.build(cube, SliceAxis::Z);
+
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    clearBuffers(buffer, zbuffer);
+
+    SliceScratch scratch;
+    renderSlice(buffer, zbuffer, cube, index, Mat3(), Vec3(0, 0, -1), 0.0f, false, scratch);
+
+    int contour = 0;
+    for (const auto& line : buffer) {
+        for (char c : line) {
+            ASSERT_TRUE(c == ' ' || c == SLICE_CONTOUR_CHAR);
+            if (c == SLICE_CONTOUR_CHAR) contour++;
+        }
+    }
+    ASSERT_TRUE(contour > 0);
+    // The inside of the square contour stays empty
+    ASSERT_TRUE(buffer[SCREEN_HEIGHT / 2][SCREEN_WIDTH / 2] == ' ');
+}
+
+void testRenderSliceCapped() {
+    std::vector<Triangle> cube = makeCube(10.0f);
+    SliceIndex index;
+    index.build(cube, SliceAxis::Z);
+
+    std::vector<std::string> buffer(SCREEN_HEIGHT, std::string(SCREEN_WIDTH, ' '));
+    std::vector<float> zbuffer(SCREEN_WIDTH * SCREEN_HEIGHT);
+    clearBuffers(buffer, zbuffer);
+
+    SliceScratch scratch;
+    renderSlice(buffer, zbuffer, cube, index, Mat3(), Vec3(0, 0, -1), 0.0f, true, scratch);
+
+    // The cap closes the section, so the center is filled
+    char center = buffer[SCREEN_HEIGHT / 2][SCREEN_WIDTH / 2];
+    ASSERT_TRUE(center != ' ');
+    ASSERT_TRUE(center != SLICE_CONTOUR_CHAR);
+}
+
+int main() {
+    std::cout << "Running slicer tests..." << std::endl;
+    RUN_TEST(testSliceIndexMatchesBruteForce);
+    RUN_TEST(testSliceIndexCountBelow);
+    RUN_TEST(testSliceIndexEmpty);
+    RUN_TEST(testSliceMeshCube);
+    RUN_TEST(testRenderSliceContourOnly);
+    RUN_TEST(testRenderSliceCapped);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,200 @@
+#include "test_framework.h"
+#include "stl_stream.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    // A binary STL of `count` triangles spreading out along +x, so later
+    // triangles keep growing the bounds
+    std::vector<uint8_t> makeBinaryStl(uint32_t count) {
+        std::vector<uint8_t> bytes(STL_HEADER_SIZE + count * STL_RECORD_SIZE, 0);
+        std::memcpy(bytes.data() + 80, &count, sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++) {
+            float values[12] = {0, 0, 1,
+                                (float)i, 0, 0,
+                                (float)i + 1, 0, 0,
+                                (float)i, 1, (float)(i % 3)};
+            std::memcpy(bytes.data() + STL_HEADER_SIZE + i * STL_RECORD_SIZE, values, sizeof(values));
+        }
+        return bytes;
+    }
+
+    // Feeds `bytes` to a fresh stream in chunks of `chunk` bytes
+    bool streamInChunks(const std::vector<uint8_t>& bytes, size_t chunk,
+                        std::vector<Triangle>& model, float& scale) {
+        StlStream stream;
+        stream.begin(bytes.size());
+        for (size_t offset = 0; offset < bytes.size(); offset += chunk) {
+            size_t size = std::min(chunk, bytes.size() - offset);
+            if (!stream.feed(bytes.data() + offset, size, model)) return false;
+        }
+        return stream.finish(model, scale);
+    }
+
+    bool sameModel(const std::vector<Triangle>& a, const std::vector<Triangle>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (int j = 0; j < 3; j++) {
+                if (std::memcmp(&a[i].vertices[j], &b[i].vertices[j], sizeof(Vec3)) != 0) return false;
+            }
+            if (std::memcmp(&a[i].normal, &b[i].normal, sizeof(Vec3)) != 0) return false;
+        }
+        return true;
+    }
+}
+
+void testChunkBoundariesMatchLoadSTL() {
+    std::vector<uint8_t> bytes = makeBinaryStl(40);
+    const std::string path = "/tmp/termesh_stream_test.stl";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    std::vector<Triangle> expected = loadSTL(path);
+    float expectedScale;
+    normalizeModel(expected, expectedScale);
+    ASSERT_EQ(expected.size(), (size_t)40);
+
+    // Splits inside the header, inside records and exactly on record edges
+    for (size_t chunk : {1, 7, 49, 50, 51, 84, 4096}) {
+        std::vector<Triangle> model;
+        float scale = 0;
+        ASSERT_TRUE(streamInChunks(bytes, chunk, model, scale));
+        ASSERT_TRUE(sameModel(model, expected));
+        ASSERT_FLOAT_EQ(scale, expectedScale, 1e-6f);
+    }
+}
+
+void testProgressivePreview() {
+    std::vector<uint8_t> bytes = makeBinaryStl(100);
+    StlStream stream;
+    stream.begin(bytes.size());
+    std::vector<Triangle> model;
+
+    // Header plus ten and a half records: ten triangles are ready to draw
+    ASSERT_TRUE(stream.feed(bytes.data(), STL_HEADER_SIZE + 10 * STL_RECORD_SIZE + 25, model));
+    ASSERT_EQ(stream.expectedTriangles(), (size_t)100);
+    ASSERT_EQ(model.size(), (size_t)10);
+
+    // The provisional fit keeps what has arrived inside the view
+    for (const Triangle& tri : model) {
+        for (const Vec3& v : tri.vertices) {
+            ASSERT_TRUE(std::fabs(v.x) <= 15.0f + 1e-4f);
+        }
+    }
+
+    size_t fed = STL_HEADER_SIZE + 10 * STL_RECORD_SIZE + 25;
+    ASSERT_TRUE(stream.feed(bytes.data() + fed, bytes.size() - fed, model));
+    ASSERT_EQ(model.size(), (size_t)100);
+    // The bounds grew ten-fold, so earlier triangles were refitted
+    ASSERT_TRUE(stream.refits() > 0);
+    for (const Triangle& tri : model) {
+        for (const Vec3& v : tri.vertices) {
+            ASSERT_TRUE(std::fabs(v.x) <= 15.0f + 1e-4f);
+        }
+    }
+
+    float scale;
+    ASSERT_TRUE(stream.finish(model, scale));
+    ASSERT_EQ(model.size(), (size_t)100);
+    ASSERT_FLOAT_EQ(scale, 30.0f / 100.0f, 1e-6f);
+}
+
+void testAsciiStream() {
+    std::string text =
+        "solid tri\n"
+        "  facet normal 0 0 1\n"
+        "    outer loop\n"
+        "      vertex 0 0 0\n"
+        "      vertex 2 0 0\n"
+        "      vertex 0 2 0\n"
+        "    endloop\n"
+        "  endfacet\n"
+        "endsolid tri\n";
+    StlStream stream;
+    stream.begin(text.size());
+    std::vector<Triangle> model;
+    for (size_t i = 0; i < text.size(); i += 10) {
+        size_t size = std::min<size_t>(10, text.size() - i);
+        ASSERT_TRUE(stream.feed(reinterpret_cast<const uint8_t*>(text.data()) + i, size, model));
+    }
+    // ASCII has no fixed record size: nothing until the stream ends
+    ASSERT_TRUE(stream.ascii());
+    ASSERT_TRUE(model.empty());
+
+    float scale;
+    ASSERT_TRUE(stream.finish(model, scale));
+    ASSERT_EQ(model.size(), (size_t)1);
+    ASSERT_FLOAT_EQ(scale, 15.0f, 1e-6f);
+}
+
+void testTruncatedStream() {
+    std::vector<uint8_t> bytes = makeBinaryStl(10);
+
+    // A total smaller than the file (a compressed size) is only a hint
+    StlStream sized;
+    sized.begin(STL_HEADER_SIZE + 5 * STL_RECORD_SIZE);
+    std::vector<Triangle> model;
+    ASSERT_TRUE(sized.feed(bytes.data(), bytes.size(), model));
+    ASSERT_EQ(model.size(), (size_t)10);
+
+    // Size unknown: the preview shows what arrived, finish() reports the gap
+    StlStream unsized;
+    unsized.begin();
+    ASSERT_TRUE(unsized.feed(bytes.data(), STL_HEADER_SIZE + 5 * STL_RECORD_SIZE + 10, model));
+    ASSERT_EQ(model.size(), (size_t)5);
+    float scale;
+    ASSERT_FALSE(unsized.finish(model, scale));
+
+    // Bytes past the promised count are ignored
+    std::vector<uint8_t> padded = bytes;
+    padded.resize(bytes.size() + 30, 0xff);
+    StlStream trailing;
+    trailing.begin();
+    std::vector<Triangle> full;
+    ASSERT_TRUE(trailing.feed(padded.data(), padded.size(), full));
+    ASSERT_TRUE(trailing.finish(full, scale));
+    ASSERT_EQ(full.size(), (size_t)10);
+}
+
+void testSolidHeaderBinary() {
+    std::vector<uint8_t> bytes = makeBinaryStl(10);
+    std::memcpy(bytes.data(), "solid binary", 12);
+    std::vector<Triangle> expected, model;
+    float expectedScale, scale;
+    ASSERT_TRUE(streamInChunks(makeBinaryStl(10), 64, expected, expectedScale));
+
+    // The true size tells it apart up front, so the preview draws
+    StlStream exact;
+    exact.begin(bytes.size());
+    ASSERT_TRUE(exact.feed(bytes.data(), bytes.size() / 2, model));
+    ASSERT_FALSE(exact.ascii());
+    ASSERT_FALSE(model.empty());
+    ASSERT_TRUE(exact.feed(bytes.data() + bytes.size() / 2, bytes.size() - bytes.size() / 2, model));
+    ASSERT_TRUE(exact.finish(model, scale));
+    ASSERT_TRUE(sameModel(model, expected));
+
+    // With no size, or a compressed one, the bytes that arrived decide
+    const size_t totals[] = {0, bytes.size() / 3};
+    for (size_t total : totals) {
+        StlStream stream;
+        stream.begin(total);
+        model.clear();
+        ASSERT_TRUE(stream.feed(bytes.data(), bytes.size(), model));
+        ASSERT_TRUE(stream.finish(model, scale));
+        ASSERT_TRUE(sameModel(model, expected));
+        ASSERT_FLOAT_EQ(scale, expectedScale, 1e-6f);
+    }
+}
+
+int main() {
+    std::cout << "Running STL stream tests..." << std::endl;
+    RUN_TEST(testChunkBoundariesMatchLoadSTL);
+    RUN_TEST(testProgressivePreview);
+    RUN_TEST(testAsciiStream);
+    RUN_TEST(testTruncatedStream);
+    RUN_TEST(testSolidHeaderBinary);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,121 @@
+#include "test_framework.h"
+#include "terminal.h"
+#include <unistd.h>
+
+namespace {
+    std::vector<std::string> blankFrame(int width, int height) {
+        return std::vector<std::string>(height, std::string(width, ' '));
+    }
+}
+
+void testEncodeUnchanged() {
+    DisplayBuffer front(20, 5);
+    std::vector<std::string> back = blankFrame(20, 5);
+
+    std::string out;
+    ASSERT_EQ(encodeTerminalPatch(front, back, out), (size_t)0);
+    ASSERT_TRUE(out.empty());
+}
+
+void testEncodeSingleCell() {
+    DisplayBuffer front(20, 10);
+    std::vector<std::string> back = blankFrame(20, 10);
+    back[5][10] = '@';
+
+    std::string out;
+    ASSERT_EQ(encodeTerminalPatch(front, back, out), (size_t)1);
+    ASSERT_TRUE(out == "\x1b[6;11H@");
+}
+
+void testEncodeShortGapIsRewritten() {
+    DisplayBuffer front(40, 3);
+    std::vector<std::string> back = blankFrame(40, 3);
+    back[0][2] = '#';
+    back[0][5] = '#';
+
+    std::string out;
+    encodeTerminalPatch(front, back, out);
+    // One cursor move, then the run including the unchanged gap
+    ASSERT_TRUE(out == "\x1b[1;3H#  #");
+}
+
+void testEncodeLongGapMovesCursor() {
+    DisplayBuffer front(40, 3);
+    std::vector<std::string> back = blankFrame(40, 3);
+    back[1][0] = '.';
+    back[1][30] = ':';
+
+    std::string out;
+    ASSERT_EQ(encodeTerminalPatch(front, back, out), (size_t)2);
+    ASSERT_TRUE(out == "\x1b[2;1H.\x1b[2;31H:");
+}
+
+void testEncodeAgainstFront() {
+    DisplayBuffer front(10, 2);
+    std::vector<std::string> back = blankFrame(10, 2);
+    back[0] = "abcdefghij";
+    front.update(back);
+
+    back[0][9] = 'X';
+    std::string out;
+    encodeTerminalPatch(front, back, out);
+    ASSERT_TRUE(out == "\x1b[1;10HX");
+}
+
+void testPresentWritesOnlyChanges() {
+    int fds[2];
+    ASSERT_TRUE(pipe(fds) == 0);
+
+    size_t first, second, third;
+    {
+        TerminalOutput terminal(20, 4, fds[1]);
+        std::vector<std::string> frame = blankFrame(20, 4);
+        frame[2][3] = '%';
+
+        first = terminal.present(frame);
+        second = terminal.present(frame);
+        frame[2][3] = ' ';
+        third = terminal.present(frame);
+        ASSERT_EQ(terminal.frames(), (size_t)3);
+    }
+    close(fds[1]);
+
+    std::string written;
+    char chunk[256];
+    ssize_t n;
+    while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) written.append(chunk, n);
+    close(fds[0]);
+
+    ASSERT_TRUE(written.compare(0, 10, "\x1b[?25l\x1b[2J") == 0);
+    ASSERT_TRUE(first > 0);
+    ASSERT_EQ(second, (size_t)0);
+    ASSERT_TRUE(third > 0 && third < first);
+}
+
+void testPresentResamplesLargerFrames() {
+    int fds[2];
+    ASSERT_TRUE(pipe(fds) == 0);
+    {
+        TerminalOutput terminal(12, 4, fds[1]);
+        std::vector<std::string> frame(8, std::string(24, '@'));
+        size_t bytes = terminal.present(frame);
+        // Clear + one cursor move per row + 12 glyphs per row
+        ASSERT_TRUE(bytes >= 4 * 12);
+    }
+    close(fds[1]);
+    close(fds[0]);
+}
+
+int main() {
+    std::cout << "Running terminal tests..." << std::endl;
+    RUN_TEST(testEncodeUnchanged);
+    RUN_TEST(testEncodeSingleCell);
+    RUN_TEST(testEncodeShortGapIsRewritten);
+    RUN_TEST(testEncodeLongGapMovesCursor);
+    RUN_TEST(testEncodeAgainstFront);
+    RUN_TEST(testPresentWritesOnlyChanges);
+    RUN_TEST(testPresentResamplesLargerFrames);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
@@ -0,0 +1,47 @@
+#include "test_framework.h"
+#include "thread_pool.h"
+#include <atomic>
+
+void testParallelForVisitsEveryIndex() {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4);
+
+    std::vector<int> visits(1000, 0);
+    std::atomic<int> badWorker(0);
+    pool.parallelFor(visits.size(), [&](size_t i, int worker) {
+        visits[i]++;
+        if (worker < 0 || worker >= 4) badWorker++;
+    });
+
+    for (int v : visits) ASSERT_EQ(v, 1);
+    ASSERT_EQ(badWorker.load(), 0);
+
+    // Empty ranges return straight away
+    pool.parallelFor(0, [&](size_t, int) { badWorker++; });
+    ASSERT_EQ(badWorker.load(), 0);
+}
+
+void testSubmitAndWait() {
+    ThreadPool pool(3);
+    std::atomic<int> done(0);
+    for (int i = 0; i < 50; i++) {
+        pool.submit([&](int) { done++; });
+    }
+    pool.wait();
+    ASSERT_EQ(done.load(), 50);
+}
+
+void testDefaultSize() {
+    ThreadPool pool;
+    ASSERT_TRUE(pool.size() >= 1);
+}
+
+int main() {
+    std::cout << "Running thread pool tests..." << std::endl;
+    RUN_TEST(testParallelForVisitsEveryIndex);
+    RUN_TEST(testSubmitAndWait);
+    RUN_TEST(testDefaultSize);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
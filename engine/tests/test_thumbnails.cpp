@@ -0,0 +1,179 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "thumbnails.h"
+#include "model.h"
+#include "render_context.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+    namespace fs = std::filesystem;
+
+    void writeText(const std::string& path, const char* text) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        std::fputs(text, file);
+        std::fclose(file);
+    }
+
+    std::vector<std::string> readLines(const std::string& path) {
+        std::vector<std::string> lines;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return lines;
+        std::string line;
+        int c;
+        while ((c = std::fgetc(file)) != EOF) {
+            if (c == '\n') {
+                lines.push_back(line);
+                line.clear();
+            } else {
+                line += (char)c;
+            }
+        }
+        std::fclose(file);
+        return lines;
+    }
+
+    // A fresh, empty directory under /tmp
+    std::string scratchDir(const char* name) {
+        std::string dir = std::string("/tmp/termesh_thumbnails_") + name;
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        return dir;
+    }
+}
+
+void testCollectStlFiles() {
+    std::string dir = scratchDir("collect");
+    writeStl(dir + "/b.stl", makeCube(1.0f));
+    writeStl(dir + "/a.STL", makeCube(1.0f));
+    writeText(dir + "/notes.txt", "not a model\n");
+    fs::create_directories(dir + "/sub.stl");
+    writeText(dir + "/list.txt", "/models/x.stl\r\n\n/models/y.stl\n");
+
+    std::vector<std::string> paths;
+    std::vector<ThumbnailFailure> failures;
+    collectStlFiles({dir, "@" + dir + "/list.txt", "single.stl", "@" + dir + "/missing.txt"}, paths, failures);
+
+    // Directory entries sorted, then the list, then the plain file
+    ASSERT_EQ(paths.size(), (size_t)5);
+    ASSERT_TRUE(paths[0] == dir + "/a.STL");
+    ASSERT_TRUE(paths[1] == dir + "/b.stl");
+    ASSERT_TRUE(paths[2] == "/models/x.stl");
+    ASSERT_TRUE(paths[3] == "/models/y.stl");
+    ASSERT_TRUE(paths[4] == "single.stl");
+    ASSERT_EQ(failures.size(), (size_t)1);
+    ASSERT_TRUE(failures[0].path == dir + "/missing.txt");
+
+    ASSERT_TRUE(thumbnailName("/models/part.stl", 0, 1) == "part.txt");
+    ASSERT_TRUE(thumbnailName("part.stl", 3, 4) == std::string("part.") + THUMBNAIL_VIEWS[3].name + ".txt");
+}
+
+void testMatchesRenderContext() {
+    std::string dir = scratchDir("render");
+    std::vector<Triangle> cube = makeCube(5.0f);
+    writeStl(dir + "/cube.stl", cube);
+
+    ThumbnailOptions options;
+    options.outputDir = dir + "/out";
+    options.views = THUMBNAIL_VIEW_COUNT;
+    options.threads = 2;
+    options.cols = 60;
+    options.rows = 20;
+    ThumbnailStats stats = renderThumbnails({dir + "/cube.stl"}, options);
+    ASSERT_EQ(stats.models, (size_t)1);
+    ASSERT_EQ(stats.triangles, (size_t)12);
+    ASSERT_EQ(stats.files, (size_t)THUMBNAIL_VIEW_COUNT);
+    ASSERT_TRUE(stats.failures.empty());
+
+    // Each file is the frame a context renders of the normalized model
+    float scale;
+    normalizeModel(cube, scale);
+    RenderContext context(60, 20);
+    context.setMesh(std::make_shared<const std::vector<Triangle>>(cube));
+    for (int v = 0; v < THUMBNAIL_VIEW_COUNT; v++) {
+        const ThumbnailView& view = THUMBNAIL_VIEWS[v];
+        context.camera = Camera{view.angleX, view.angleY, view.angleZ};
+        context.render();
+        std::vector<std::string> lines = readLines(options.outputDir + "/" + thumbnailName("cube.stl", v, options.views));
+        ASSERT_TRUE(lines == context.frame());
+    }
+}
+
+void testFailuresDoNotStopBatch() {
+    std::string dir = scratchDir("failures");
+    writeStl(dir + "/good.stl", makeCube(1.0f));
+    writeText(dir + "/empty.stl", "");
+    fs::create_directories(dir + "/other");
+    writeStl(dir + "/other/good.stl", makeCube(2.0f));
+    writeStl(dir + "/last.stl", makeCube(3.0f));
+
+    ThumbnailOptions options;
+    options.outputDir = dir + "/out";
+    options.threads = 3;
+    std::vector<std::string> paths = {dir + "/good.stl", dir + "/missing.stl", dir + "/empty.stl",
+                                      dir + "/other/good.stl", dir + "/last.stl"};
+    ThumbnailStats stats = renderThumbnails(paths, options);
+
+    ASSERT_EQ(stats.models, (size_t)2);
+    ASSERT_EQ(stats.files, (size_t)2);
+    ASSERT_EQ(stats.triangles, (size_t)24);
+    ASSERT_TRUE(fs::exists(options.outputDir + "/good.txt"));
+    ASSERT_TRUE(fs::exists(options.outputDir + "/last.txt"));
+
+    // Reported in input order; a clashing name never overwrites the first
+    ASSERT_EQ(stats.failures.size(), (size_t)3);
+    ASSERT_TRUE(stats.failures[0].path == paths[1]);
+    ASSERT_TRUE(stats.failures[1].path == paths[2]);
+    ASSERT_TRUE(stats.failures[2].path == paths[3]);
+
+    // An output directory that cannot be created fails every model, quietly
+    writeText(dir + "/blocked", "a file, not a directory\n");
+    options.outputDir = dir + "/blocked";
+    stats = renderThumbnails({dir + "/good.stl"}, options);
+    ASSERT_EQ(stats.models, (size_t)0);
+    ASSERT_EQ(stats.failures.size(), (size_t)1);
+}
+
+void testMemoryBudget() {
+    std::string dir = scratchDir("memory");
+    std::vector<std::string> paths;
+    size_t largest = 0, total = 0;
+    for (int i = 0; i < 8; i++) {
+        std::string path = dir + "/part" + std::to_string(i) + ".stl";
+        writeStl(path, makeCube(1.0f + i), 1 + i * 20);
+        size_t charge = (size_t)fs::file_size(path) * 2;
+        largest = std::max(largest, charge);
+        total += charge;
+        paths.push_back(path);
+    }
+
+    // A budget below every model runs them one at a time, each still rendered
+    ThumbnailOptions options;
+    options.outputDir = dir + "/out";
+    options.threads = 4;
+    options.memoryBytes = 1;
+    ThumbnailStats stats = renderThumbnails(paths, options);
+    ASSERT_EQ(stats.models, paths.size());
+    ASSERT_EQ(stats.threads, 4);
+    ASSERT_EQ(stats.peakBytes, largest);
+    ASSERT_TRUE(stats.modelsPerSecond() > 0.0);
+    ASSERT_TRUE(stats.trianglesPerSecond() > stats.modelsPerSecond());
+
+    // A generous budget never holds more than every model together
+    options.memoryBytes = THUMBNAIL_MEMORY_BYTES;
+    stats = renderThumbnails(paths, options);
+    ASSERT_EQ(stats.models, paths.size());
+    ASSERT_TRUE(stats.peakBytes >= largest && stats.peakBytes <= total);
+}
+
+int main() {
+    std::cout << "Running thumbnail tests..." << std::endl;
+    RUN_TEST(testCollectStlFiles);
+    RUN_TEST(testMatchesRenderContext);
+    RUN_TEST(testFailuresDoNotStopBatch);
+    RUN_TEST(testMemoryBudget);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
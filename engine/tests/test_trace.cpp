@@ -0,0 +1,149 @@
+#include "test_framework.h"
+#include "test_meshes.h"
+#include "trace.h"
+#include "alloc_counter.h"
+#include "model.h"
+#include "render_context.h"
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+namespace {
+    size_t occurrences(const std::string& text, const std::string& part) {
+        size_t count = 0;
+        for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) count++;
+        return count;
+    }
+
+    size_t spansNamed(const std::string& json, const std::string& name) {
+        return occurrences(json, "{\"name\":\"" + name + "\",\"cat\":\"termesh\",\"ph\":\"X\"");
+    }
+
+    // The number after `"key":` in the first event named `name`
+    double field(const std::string& json, const std::string& name, const std::string& key) {
+        size_t event = json.find("{\"name\":\"" + name + "\"");
+        size_t at = json.find("\"" + key + "\":", event);
+        return std::atof(json.c_str() + at + key.size() + 3);
+    }
+}
+
+void testScopedSpans() {
+    clearTrace();
+    setTracing(false);
+    {
+        TERMESH_TRACE_SCOPE("off");
+    }
+    ASSERT_EQ(spansNamed(traceJson(), "off"), (size_t)0);
+
+    setTracing(true);
+    {
+        TERMESH_TRACE_SCOPE("outer");
+        for (int i = 0; i < 3; i++) {
+            TERMESH_TRACE_SCOPE("inner");
+        }
+    }
+    setTracing(false);
+    std::string json = traceJson();
+    ASSERT_TRUE(json.compare(0, 15, "{\"displayTimeUn") == 0);
+    ASSERT_EQ(spansNamed(json, "outer"), (size_t)1);
+    ASSERT_EQ(spansNamed(json, "inner"), (size_t)3);
+    // The outer span encloses the inner ones
+    ASSERT_TRUE(field(json, "inner", "ts") >= field(json, "outer", "ts"));
+    ASSERT_TRUE(field(json, "outer", "dur") >= field(json, "inner", "dur"));
+
+    clearTrace();
+    ASSERT_EQ(spansNamed(traceJson(), "outer"), (size_t)0);
+}
+
+void testRingKeepsNewestSpans() {
+    clearTrace();
+    setTracing(true);
+    for (size_t i = 0; i < TRACE_RING_EVENTS; i++) {
+        TERMESH_TRACE_SCOPE("old");
+    }
+    // Once the ring exists, recording does not allocate
+    size_t before = heapAllocations();
+    for (size_t i = 0; i < 100; i++) {
+        TERMESH_TRACE_SCOPE("new");
+    }
+    ASSERT_EQ(heapAllocations() - before, (size_t)0);
+    setTracing(false);
+
+    std::string json = traceJson();
+    ASSERT_EQ(spansNamed(json, "new"), (size_t)100);
+    // The oldest slot is left out as it may be in the middle of a write
+    ASSERT_EQ(spansNamed(json, "old"), TRACE_RING_EVENTS - 101);
+    clearTrace();
+}
+
+void testThreadsAndConcurrentExport() {
+    clearTrace();
+    setTracing(true);
+    // A thread that has exited keeps its spans and name
+    std::thread finished([] {
+        setTraceThreadName("finished");
+        TERMESH_TRACE_SCOPE("worker span");
+    });
+    finished.join();
+
+    // Exports while another thread records stay consistent
+    std::atomic<bool> stop{false};
+    std::atomic<int> recorded{0};
+    std::thread busy([&] {
+        while (!stop.load()) {
+            TERMESH_TRACE_SCOPE("busy");
+            recorded++;
+        }
+    });
+    while (recorded.load() < 1000) std::this_thread::yield();
+    for (int i = 0; i < 20; i++) {
+        std::string json = traceJson();
+        ASSERT_EQ(occurrences(json, "{"), occurrences(json, "}"));
+        ASSERT_EQ(occurrences(json, "\"name\":\"\""), (size_t)0);
+    }
+    stop = true;
+    busy.join();
+    setTracing(false);
+
+    std::string json = traceJson();
+    ASSERT_EQ(spansNamed(json, "worker span"), (size_t)1);
+    ASSERT_TRUE(json.find("\"args\":{\"name\":\"finished\"}") != std::string::npos);
+    ASSERT_TRUE(spansNamed(json, "busy") > 0);
+    clearTrace();
+}
+
+void testEngineSpans() {
+    std::string path = "/tmp/termesh_trace_test.json";
+    clearTrace();
+    setTracing(true);
+    std::vector<Triangle> cube = makeCube(10.0f);
+    float scale;
+    normalizeModel(cube, scale);
+    RenderContext view(60, 20);
+    view.setMesh(std::make_shared<const std::vector<Triangle>>(cube));
+    view.render();
+    view.render(cube, QualitySettings{0, 2});
+    setTracing(false);
+    ASSERT_TRUE(saveTrace(path));
+
+    std::string json = traceJson();
+    ASSERT_EQ(spansNamed(json, "normalizeModel"), (size_t)1);
+    ASSERT_EQ(spansNamed(json, "RenderContext::render"), (size_t)2);
+    ASSERT_EQ(spansNamed(json, "renderFrame"), (size_t)1);
+    ASSERT_EQ(spansNamed(json, "geometry"), (size_t)1);
+    ASSERT_EQ(spansNamed(json, "raster"), (size_t)1);
+    ASSERT_FALSE(saveTrace("/nonexistent/trace.json"));
+    clearTrace();
+}
+
+int main() {
+    std::cout << "Running trace tests..." << std::endl;
+    RUN_TEST(testScopedSpans);
+    RUN_TEST(testRingKeepsNewestSpans);
+    RUN_TEST(testThreadsAndConcurrentExport);
+    RUN_TEST(testEngineSpans);
+
+    TestFramework::instance().printSummary();
+    return TestFramework::instance().getExitCode();
+}
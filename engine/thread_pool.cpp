@@ -0,0 +1,71 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include "trace.h"
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return tasks.empty() && active == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, int)>& fn) {
+    if (count == 0) return;
+
+    std::atomic<size_t> next(0);
+    size_t runners = std::min(count, workers.size());
+    for (size_t r = 0; r < runners; r++) {
+        submit([&next, &fn, count](int worker) {
+            for (size_t i = next++; i < count; i = next++) {
+                fn(i, worker);
+            }
+        });
+    }
+    wait();
+}
+
+void ThreadPool::workerLoop(int worker) {
+    setTraceThreadName("pool worker");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return; // Stopping and drained
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        active++;
+
+        lock.unlock();
+        task(worker);
+        lock.lock();
+
+        active--;
+        if (tasks.empty() && active == 0) allDone.notify_all();
+    }
+}
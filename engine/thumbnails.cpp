@@ -0,0 +1,227 @@
+#include "thumbnails.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "model.h"
+#include "render_context.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+const ThumbnailView THUMBNAIL_VIEWS[THUMBNAIL_VIEW_COUNT] = {
+    {"iso", 0.6f, 0.8f, 0.0f},
+    {"front", 0.0f, 0.0f, 0.0f},
+    {"side", 0.0f, 1.5708f, 0.0f},
+    {"top", 1.5708f, 0.0f, 0.0f},
+};
+
+namespace {
+    // Bytes of models in memory, shared by the workers. A reservation waits
+    // until it fits, or until nothing else is reserved so that a model over
+    // the whole budget still gets its turn.
+    class MemoryBudget {
+    public:
+        explicit MemoryBudget(size_t limit) : limit(limit) {}
+
+        void acquire(size_t bytes) {
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&] { return used == 0 || used + bytes <= limit; });
+            used += bytes;
+            peak = std::max(peak, used);
+        }
+
+        void release(size_t bytes) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                used -= bytes;
+            }
+            released.notify_all();
+        }
+
+        size_t peakBytes() const { return peak; }
+
+    private:
+        size_t limit;
+        size_t used = 0;
+        size_t peak = 0;
+        std::mutex mutex;
+        std::condition_variable released;
+    };
+
+    bool isStl(const fs::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return ext == ".stl";
+    }
+
+    // Paths listed in a text file, one per line; blank lines are skipped
+    bool readList(const std::string& listPath, std::vector<std::string>& paths) {
+        std::FILE* file = std::fopen(listPath.c_str(), "r");
+        if (!file) return false;
+        char line[4096];
+        while (std::fgets(line, sizeof(line), file)) {
+            std::string path = line;
+            while (!path.empty() && (path.back() == '\n' || path.back() == '\r')) path.pop_back();
+            if (!path.empty()) paths.push_back(path);
+        }
+        std::fclose(file);
+        return true;
+    }
+
+    // The file's bytes plus, at most, as much again in decoded triangles
+    size_t memoryCharge(const std::string& path) {
+        std::error_code error;
+        uintmax_t size = fs::file_size(path, error);
+        return error ? 0 : (size_t)size * 2;
+    }
+
+    bool writeFrame(const std::string& filename, const std::vector<std::string>& frame) {
+        std::FILE* file = std::fopen(filename.c_str(), "wb");
+        if (!file) return false;
+        bool written = true;
+        for (const auto& row : frame) {
+            written = written && std::fwrite(row.data(), 1, row.size(), file) == row.size() &&
+                      std::fputc('\n', file) != EOF;
+        }
+        return std::fclose(file) == 0 && written;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // anonymous namespace
+
+void collectStlFiles(const std::vector<std::string>& inputs, std::vector<std::string>& paths,
+                     std::vector<ThumbnailFailure>& failures) {
+    for (const auto& input : inputs) {
+        if (input.size() > 1 && input[0] == '@') {
+            if (!readList(input.substr(1), paths)) {
+                failures.push_back({input.substr(1), "cannot read file list"});
+            }
+            continue;
+        }
+
+        std::error_code error;
+        if (!fs::is_directory(input, error)) {
+            paths.push_back(input);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (fs::directory_iterator it(input, error), end; !error && it != end; it.increment(error)) {
+            if (isStl(it->path()) && !it->is_directory(error)) found.push_back(it->path().string());
+        }
+        if (error) {
+            failures.push_back({input, "cannot list directory"});
+            continue;
+        }
+        std::sort(found.begin(), found.end());
+        paths.insert(paths.end(), found.begin(), found.end());
+    }
+}
+
+std::string thumbnailName(const std::string& path, int view, int views) {
+    std::string name = fs::path(path).stem().string();
+    if (views > 1) name += std::string(".") + THUMBNAIL_VIEWS[view].name;
+    return name + ".txt";
+}
+
+ThumbnailStats renderThumbnails(const std::vector<std::string>& paths, const ThumbnailOptions& options) {
+    const int views = std::max(1, std::min(options.views, THUMBNAIL_VIEW_COUNT));
+    const auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(options.threads);
+    MemoryBudget budget(options.memoryBytes);
+
+    std::error_code error;
+    fs::create_directories(options.outputDir, error);
+
+    // Models whose output names clash with an earlier model's are skipped,
+    // rather than overwriting its previews
+    std::vector<std::string> reasons(paths.size());
+    std::unordered_map<std::string, size_t> owners;
+    for (size_t i = 0; i < paths.size(); i++) {
+        auto inserted = owners.emplace(thumbnailName(paths[i], 0, 1), i);
+        if (!inserted.second) reasons[i] = "same output name as " + paths[inserted.first->second];
+    }
+
+    // Per worker: a context whose buffers are reused model after model, and
+    // counters summed at the end
+    struct Worker {
+        std::unique_ptr<RenderContext> context;
+        size_t models = 0, triangles = 0, files = 0;
+        double loadSeconds = 0.0, renderSeconds = 0.0;
+    };
+    std::vector<Worker> workers(pool.size());
+    for (auto& worker : workers) {
+        worker.context.reset(new RenderContext(options.cols, options.rows));
+    }
+
+    pool.parallelFor(paths.size(), [&](size_t i, int index) {
+        if (!reasons[i].empty()) return;
+        const std::string& path = paths[i];
+        Worker& worker = workers[index];
+        const size_t charge = memoryCharge(path);
+        budget.acquire(charge);
+
+        auto loadStart = std::chrono::steady_clock::now();
+        auto triangles = std::make_shared<std::vector<Triangle>>();
+        float scale = 0.0f;
+        if (!readSTL(path, *triangles)) {
+            reasons[i] = "cannot open";
+        } else if (triangles->empty()) {
+            reasons[i] = "no triangles";
+        } else {
+            normalizeModel(*triangles, scale);
+            if (!std::isfinite(scale)) reasons[i] = "degenerate model";
+        }
+        worker.loadSeconds += secondsSince(loadStart);
+
+        if (reasons[i].empty()) {
+            auto renderStart = std::chrono::steady_clock::now();
+            RenderContext& context = *worker.context;
+            context.setMesh(triangles);
+            for (int v = 0; v < views && reasons[i].empty(); v++) {
+                const ThumbnailView& view = THUMBNAIL_VIEWS[v];
+                context.camera = Camera{view.angleX, view.angleY, view.angleZ};
+                context.render();
+                std::string filename = (fs::path(options.outputDir) / thumbnailName(path, v, views)).string();
+                if (writeFrame(filename, context.frame())) {
+                    worker.files++;
+                } else {
+                    reasons[i] = "cannot write " + filename;
+                }
+            }
+            context.setMesh(nullptr);
+            if (reasons[i].empty()) {
+                worker.models++;
+                worker.triangles += triangles->size();
+            }
+            worker.renderSeconds += secondsSince(renderStart);
+        }
+
+        triangles.reset();
+        budget.release(charge);
+    });
+
+    ThumbnailStats stats;
+    stats.threads = pool.size();
+    for (const auto& worker : workers) {
+        stats.models += worker.models;
+        stats.triangles += worker.triangles;
+        stats.files += worker.files;
+        stats.loadSeconds += worker.loadSeconds;
+        stats.renderSeconds += worker.renderSeconds;
+    }
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!reasons[i].empty()) stats.failures.push_back({paths[i], reasons[i]});
+    }
+    stats.peakBytes = budget.peakBytes();
+    stats.seconds = secondsSince(start);
+    return stats;
+}
@@ -0,0 +1,202 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> traceEnabled{false};
+
+namespace {
+    // One span. Fields are atomic so the exporter may read a slot while its
+    // thread overwrites it; it then drops the slot (see copyRing()).
+    struct TraceEvent {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start{0}, end{0};
+    };
+
+    // A thread's spans. Only the owning thread writes events and `written`.
+    struct TraceRing {
+        TraceEvent events[TRACE_RING_EVENTS];
+        std::atomic<uint64_t> written{0};   // Spans recorded since the thread started
+        std::atomic<uint64_t> first{0};     // Oldest span not cleared
+        std::atomic<const char*> threadName{nullptr};
+        int tid = 0;
+        bool retired = false;               // Its thread has exited (registry lock)
+    };
+
+    struct Span {
+        const char* name;
+        uint64_t start, end;
+    };
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point origin = Clock::now();
+
+    // Rings of running threads and the last TRACE_RETIRED_THREADS that exited
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<TraceRing>>& registry() {
+        static std::vector<std::unique_ptr<TraceRing>> rings;
+        return rings;
+    }
+    int nextTid = 1;
+
+    // Creates the thread's ring on its first span and retires it at exit
+    struct ThreadRing {
+        TraceRing* ring = nullptr;
+        const char* name = nullptr;         // Given before the first span
+
+        TraceRing& get() {
+            if (!ring) {
+                std::unique_ptr<TraceRing> created(new TraceRing());
+                created->threadName.store(name, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(registryMutex);
+                created->tid = nextTid++;
+                ring = created.get();
+                registry().push_back(std::move(created));
+            }
+            return *ring;
+        }
+
+        ~ThreadRing() {
+            if (!ring) return;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            ring->retired = true;
+            // Free the oldest retired rings beyond the limit
+            auto& rings = registry();
+            int retired = 0;
+            for (auto it = rings.end(); it != rings.begin();) {
+                --it;
+                if (!(*it)->retired) continue;
+                if (++retired > TRACE_RETIRED_THREADS) it = rings.erase(it);
+            }
+        }
+    };
+
+    thread_local ThreadRing threadRing;
+
+    // The ring's spans that were not overwritten while they were copied. The
+    // oldest slot may be part way through being overwritten by the next
+    // span, so a ring gives at most TRACE_RING_EVENTS - 1 spans.
+    void copyRing(const TraceRing& ring, std::vector<Span>& spans) {
+        uint64_t end = ring.written.load(std::memory_order_acquire);
+        uint64_t begin = std::max(ring.first.load(std::memory_order_relaxed),
+                                  end >= TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS + 1 : 0);
+        size_t copied = spans.size();
+        for (uint64_t i = begin; i < end; i++) {
+            const TraceEvent& event = ring.events[i % TRACE_RING_EVENTS];
+            spans.push_back({event.name.load(std::memory_order_relaxed),
+                             event.start.load(std::memory_order_relaxed),
+                             event.end.load(std::memory_order_relaxed)});
+        }
+        // Span n is written over span n - TRACE_RING_EVENTS, so spans up to
+        // `now` - TRACE_RING_EVENTS may have changed under the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = ring.written.load(std::memory_order_relaxed);
+        if (now >= TRACE_RING_EVENTS && now - TRACE_RING_EVENTS >= begin) {
+            size_t stale = (size_t)std::min(end, now - TRACE_RING_EVENTS + 1) - (size_t)begin;
+            spans.erase(spans.begin() + copied, spans.begin() + copied + stale);
+        }
+    }
+
+    void appendEscaped(std::string& out, const char* text) {
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') out += '\\';
+            if ((unsigned char)*c >= 0x20) out += *c;
+        }
+    }
+
+    // Trace-event times are microseconds
+    void appendMicros(std::string& out, uint64_t ns) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.3f", ns / 1000.0);
+        out += number;
+    }
+} // anonymous namespace
+
+void setTracing(bool on) {
+    traceEnabled.store(on, std::memory_order_relaxed);
+}
+
+void clearTrace() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& ring : registry()) {
+        ring->first.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+uint64_t traceNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count() + 1;
+}
+
+void recordTraceSpan(const char* name, uint64_t start, uint64_t end) {
+    TraceRing& ring = threadRing.get();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+    TraceEvent& event = ring.events[index % TRACE_RING_EVENTS];
+    // Seqlock writer: an exporter that reads any of the stores below sees,
+    // after its acquire fence, `written` at `index` at least, and drops the
+    // span this one replaces. The release store of `written` alone does not
+    // order these later stores.
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const char* name) {
+    // Threads that never record a span get no ring
+    threadRing.name = name;
+    if (threadRing.ring) threadRing.ring->threadName.store(name, std::memory_order_relaxed);
+}
+
+std::string traceJson() {
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    auto beginEvent = [&]() {
+        json += firstEvent ? "\n" : ",\n";
+        firstEvent = false;
+    };
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<Span> spans;
+    for (const auto& ring : registry()) {
+        char tid[16];
+        std::snprintf(tid, sizeof(tid), "%d", ring->tid);
+        const char* threadName = ring->threadName.load(std::memory_order_relaxed);
+        if (threadName) {
+            beginEvent();
+            json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+            json += tid;
+            json += ",\"args\":{\"name\":\"";
+            appendEscaped(json, threadName);
+            json += "\"}}";
+        }
+
+        spans.clear();
+        copyRing(*ring, spans);
+        for (const Span& span : spans) {
+            beginEvent();
+            json += "{\"name\":\"";
+            appendEscaped(json, span.name);
+            json += "\",\"cat\":\"termesh\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            json += tid;
+            json += ",\"ts\":";
+            appendMicros(json, span.start);
+            json += ",\"dur\":";
+            appendMicros(json, span.end - span.start);
+            json += "}";
+        }
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+bool saveTrace(const std::string& path) {
+    std::string json = traceJson();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && written;
+}
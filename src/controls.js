@@ -0,0 +1,97 @@
+import { motionModeSelect, autoRotateSelected } from "./dom-utils.js";
+import { getEngine } from "./wasm-module.js";
+
+// Radians the model turns per pixel dragged and per arrow key press
+const DRAG_RADIANS_PER_PIXEL = 0.01;
+const KEY_RADIANS = 0.1;
+
+const outputContainer = document.querySelector(".output-container");
+
+let dragPointer = null;
+let lastX = 0;
+let lastY = 0;
+
+// The engine only renders when something changes, so every input is just a
+// call into it; nothing here runs per frame
+export function applyAutoRotate() {
+    const engine = getEngine();
+    if (engine) engine.setAutoRotate(autoRotateSelected() ? 1 : 0);
+}
+
+function startDrag(event) {
+    const engine = getEngine();
+    if (!engine || dragPointer !== null) return;
+    dragPointer = event.pointerId;
+    lastX = event.clientX;
+    lastY = event.clientY;
+    outputContainer.setPointerCapture(event.pointerId);
+    outputContainer.classList.add("dragging");
+    outputContainer.focus();
+    // Auto-rotation pauses while the user holds the model
+    engine.setAutoRotate(0);
+}
+
+function drag(event) {
+    const engine = getEngine();
+    if (!engine || event.pointerId !== dragPointer) return;
+    const dx = event.clientX - lastX;
+    const dy = event.clientY - lastY;
+    lastX = event.clientX;
+    lastY = event.clientY;
+    // Horizontal drags turn about the vertical axis and vice versa
+    engine.rotateView(dy * DRAG_RADIANS_PER_PIXEL, dx * DRAG_RADIANS_PER_PIXEL, 0);
+}
+
+function endDrag(event) {
+    if (event.pointerId !== dragPointer) return;
+    dragPointer = null;
+    outputContainer.classList.remove("dragging");
+    applyAutoRotate();
+}
+
+function handleKey(event) {
+    const engine = getEngine();
+    if (!engine) return;
+    switch (event.key) {
+        case "ArrowLeft":
+            engine.rotateView(0, -KEY_RADIANS, 0);
+            break;
+        case "ArrowRight":
+            engine.rotateView(0, KEY_RADIANS, 0);
+            break;
+        case "ArrowUp":
+            engine.rotateView(-KEY_RADIANS, 0, 0);
+            break;
+        case "ArrowDown":
+            engine.rotateView(KEY_RADIANS, 0, 0);
+            break;
+        case " ":
+            motionModeSelect.value = autoRotateSelected() ? "manual" : "auto";
+            applyAutoRotate();
+            break;
+        case "Home":
+            engine.setView(0, 0, 0);
+            break;
+        default:
+            return;
+    }
+    event.preventDefault();
+}
+
+// Hidden tabs render nothing; the engine catches up when shown again
+function handleVisibility() {
+    const engine = getEngine();
+    if (engine) engine.setVisible(document.hidden ? 0 : 1);
+}
+
+export function initializeControls() {
+    if (outputContainer) {
+        outputContainer.addEventListener("pointerdown", startDrag);
+        outputContainer.addEventListener("pointermove", drag);
+        outputContainer.addEventListener("pointerup", endDrag);
+        outputContainer.addEventListener("pointercancel", endDrag);
+        outputContainer.addEventListener("keydown", handleKey);
+    }
+    if (motionModeSelect) motionModeSelect.addEventListener("change", applyAutoRotate);
+    document.addEventListener("visibilitychange", handleVisibility);
+}
@@ -0,0 +1,182 @@
+import { displayElement, canvasElement } from "./dom-utils.js";
+
+// Presenters for frames coming out of the engine. In text mode each framebuffer
+// row gets its own DOM node, so a frame only touches the rows that changed.
+// Rows are decoded in place from the engine's persistent glyph buffer in the
+// WASM heap. In canvas mode the engine draws the glyphs itself and only the
+// changed rectangle of its RGBA buffer is copied to the canvas.
+
+export const displayStats = {
+    frames: 0, // Frames presented (unchanged frames never reach JS)
+    rows: 0, // Rows patched
+    bytes: 0, // Bytes decoded from the heap
+    fullFrameBytes: 0, // Bytes a whole-frame textContent update would have needed
+    ms: 0, // Main-thread time spent presenting
+};
+
+const STATS_LOG_INTERVAL = 300;
+
+const decoder = new TextDecoder();
+
+// The threads build runs on a SharedArrayBuffer heap. TextDecoder and
+// ImageData refuse views of shared memory, so its frames are copied out
+// first: one row at a time for text, the changed rectangle for the canvas.
+function isShared(heap) {
+    return typeof SharedArrayBuffer !== "undefined" && heap.buffer instanceof SharedArrayBuffer;
+}
+
+function decodeRow(view, shared) {
+    return decoder.decode(shared ? view.slice() : view);
+}
+
+let rowElements = [];
+
+// Views into the heap, one per row. Growing the WASM heap replaces its
+// ArrayBuffer and detaches every view made over the old one, so they are
+// rebuilt whenever the buffer or the frame location changes.
+let viewBuffer = null;
+let viewData = 0;
+let viewStride = 0;
+let rowViews = [];
+
+function ensureViews(heap, data, stride, width, height) {
+    if (viewBuffer === heap.buffer && viewData === data && viewStride === stride && rowViews.length === height) {
+        return;
+    }
+    rowViews = [];
+    for (let y = 0; y < height; y++) {
+        const start = data + y * stride;
+        rowViews.push(heap.subarray(start, start + width));
+    }
+    viewBuffer = heap.buffer;
+    viewData = data;
+    viewStride = stride;
+}
+
+// (Re)creates the row nodes if the display was cleared or resized.
+// Returns true when the rows were rebuilt.
+function ensureRows(height) {
+    if (rowElements.length === height && rowElements[0].parentNode === displayElement) {
+        return false;
+    }
+
+    const fragment = document.createDocumentFragment();
+    rowElements = [];
+    for (let i = 0; i < height; i++) {
+        const row = document.createElement("div");
+        row.className = "display-row";
+        rowElements.push(row);
+        fragment.appendChild(row);
+    }
+    displayElement.replaceChildren(fragment);
+    return true;
+}
+
+// `spans` points at `count` DirtySpan records (row, first, last) in HEAP32
+export function presentFrame(heap, heap32, data, stride, width, height, spans, count) {
+    const start = performance.now();
+
+    ensureViews(heap, data, stride, width, height);
+    const shared = isShared(heap);
+
+    let patched = 0;
+    if (ensureRows(height)) {
+        // Fresh nodes: the whole frame is in the heap, so fill every row
+        for (let y = 0; y < height; y++) {
+            rowElements[y].textContent = decodeRow(rowViews[y], shared);
+        }
+        patched = height;
+    } else {
+        const base = spans >> 2;
+        for (let i = 0; i < count; i++) {
+            const y = heap32[base + i * 3];
+            rowElements[y].textContent = decodeRow(rowViews[y], shared);
+        }
+        patched = count;
+    }
+
+    displayStats.frames++;
+    displayStats.rows += patched;
+    displayStats.bytes += patched * width;
+    displayStats.fullFrameBytes += height * stride;
+    displayStats.ms += performance.now() - start;
+
+    if (displayStats.frames % STATS_LOG_INTERVAL === 0) {
+        console.debug(formatDisplayStats());
+    }
+}
+
+// ImageData over the engine's RGBA buffer. Like the row views, it has to be
+// recreated when the heap grows.
+let imageBuffer = null;
+let imageData = 0;
+let image = null;
+let canvasContext = null;
+
+// `pixels` points at width * height RGBA pixels in HEAPU8; (x, y, w, h) is the
+// part that changed since the previous frame
+export function presentCanvas(heap, pixels, width, height, x, y, w, h) {
+    const start = performance.now();
+
+    let full = false;
+    if (!canvasContext || canvasElement.width !== width || canvasElement.height !== height) {
+        canvasElement.width = width;
+        canvasElement.height = height;
+        canvasContext = canvasElement.getContext("2d", { alpha: false });
+        canvasElement.hidden = false;
+        displayElement.hidden = true;
+        full = true;
+    }
+    const shared = isShared(heap);
+    if (imageBuffer !== heap.buffer || imageData !== pixels || !image || image.width !== width) {
+        image = shared
+            ? new ImageData(width, height)
+            : new ImageData(new Uint8ClampedArray(heap.buffer, pixels, width * height * 4), width, height);
+        imageBuffer = heap.buffer;
+        imageData = pixels;
+        full = true;
+    }
+    if (shared) {
+        copyRect(heap, pixels, width, image.data, full ? 0 : x, full ? 0 : y, full ? width : w, full ? height : h);
+    }
+
+    if (full) {
+        canvasContext.putImageData(image, 0, 0);
+    } else {
+        canvasContext.putImageData(image, 0, 0, x, y, w, h);
+    }
+
+    displayStats.frames++;
+    displayStats.bytes += (full ? width * height : w * h) * 4;
+    displayStats.fullFrameBytes += width * height * 4;
+    displayStats.ms += performance.now() - start;
+
+    if (displayStats.frames % STATS_LOG_INTERVAL === 0) {
+        console.debug(formatDisplayStats());
+    }
+}
+
+function copyRect(heap, pixels, width, target, x, y, w, h) {
+    for (let row = y; row < y + h; row++) {
+        const offset = (row * width + x) * 4;
+        target.set(heap.subarray(pixels + offset, pixels + offset + w * 4), offset);
+    }
+}
+
+// Shows the text display again; the canvas reappears with its next frame
+export function resetPresenters() {
+    canvasContext = null;
+    canvasElement.hidden = true;
+    displayElement.hidden = false;
+}
+
+export function formatDisplayStats() {
+    const frames = Math.max(1, displayStats.frames);
+    const bytes = displayStats.bytes / frames;
+    const fullBytes = displayStats.fullFrameBytes / frames;
+    return (
+        `display: ${frames} frames, ${(displayStats.rows / frames).toFixed(1)} rows/frame, ` +
+        `${bytes.toFixed(0)} B/frame (full frame ${fullBytes.toFixed(0)} B), ` +
+        `${(displayStats.ms / frames).toFixed(3)} ms/frame`
+    );
+}
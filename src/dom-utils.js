@@ -1,7 +1,13 @@
 export const fileInput = document.getElementById("fileInput");
 export const modelSelect = document.getElementById("modelSelect");
 export const loadButton = document.getElementById("loadButton");
+export const renderModeSelect = document.getElementById("renderMode");
+export const outputModeSelect = document.getElementById("outputMode");
+export const motionModeSelect = document.getElementById("motionMode");
+export const frameBudgetSelect = document.getElementById("frameBudget");
+export const qualityReadout = document.getElementById("qualityReadout");
 export const displayElement = document.getElementById("display"); 
+export const canvasElement = document.getElementById("displayCanvas");
 
 const statusElement = document.getElementById("status");
 
@@ -21,12 +27,43 @@ export function enableControls() {
     if (fileInput) fileInput.disabled = false;
     if (modelSelect) modelSelect.disabled = false;
     if (loadButton) loadButton.disabled = false;
+    if (renderModeSelect) renderModeSelect.disabled = false;
+    if (outputModeSelect) outputModeSelect.disabled = false;
+    if (motionModeSelect) motionModeSelect.disabled = false;
+    if (frameBudgetSelect) frameBudgetSelect.disabled = false;
 }
 
 export function disableControls() {
     if (fileInput) fileInput.disabled = true;
     if (modelSelect) modelSelect.disabled = true;
     if (loadButton) loadButton.disabled = true;
+    if (renderModeSelect) renderModeSelect.disabled = true;
+    if (outputModeSelect) outputModeSelect.disabled = true;
+    if (motionModeSelect) motionModeSelect.disabled = true;
+    if (frameBudgetSelect) frameBudgetSelect.disabled = true;
+}
+
+// Engine render mode for the selection: 0 solid, 1 contour, 2 capped
+export function selectedRenderMode() {
+    const mode = renderModeSelect ? renderModeSelect.value : "solid";
+    if (mode === "slice") return 1;
+    if (mode === "cap") return 2;
+    return 0;
+}
+
+// Whether frames should be presented as canvas pixels rather than text rows
+export function canvasOutputSelected() {
+    return (outputModeSelect ? outputModeSelect.value : "canvas") === "canvas";
+}
+
+// Whether the model turns by itself or only when dragged
+export function autoRotateSelected() {
+    return (motionModeSelect ? motionModeSelect.value : "auto") === "auto";
+}
+
+// Frame-time budget in milliseconds, 0 for full quality
+export function selectedFrameBudget() {
+    return frameBudgetSelect ? Number(frameBudgetSelect.value) : 0;
 }
 
 export async function adjustFontSize() {
@@ -35,6 +72,9 @@ export async function adjustFontSize() {
     const container = displayElement.parentElement;
     if (!container || !displayElement) return;
 
+    // The canvas scales itself with CSS; only the text display needs a font size
+    if (displayElement.hidden) return;
+
     const containerWidth = container.clientWidth;
     const containerHeight = container.clientHeight;
 
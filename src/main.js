@@ -2,27 +2,29 @@ import {
     fileInput,
     modelSelect,
     loadButton,
+    renderModeSelect,
+    outputModeSelect,
     displayElement,
+    selectedRenderMode,
+    canvasOutputSelected,
+    frameBudgetSelect,
+    qualityReadout,
+    selectedFrameBudget,
     adjustFontSize,
     updateStatus,
     enableControls,
     disableControls,
 } from "./dom-utils.js";
-import { initializeWasmModule, processSTL } from "./wasm-module.js";
+import { initializeWasmModule, startEngine, getEngine, processSTL, processSTLStream, downloadTrace } from "./wasm-module.js";
+import { resetPresenters } from "./display.js";
+import { initializeControls, applyAutoRotate } from "./controls.js";
 
 let wasmReady = false;
-let hasRendered = false;
 
 async function loadPresetModel() {
     const modelPath = modelSelect.value;
     if (!modelPath) return;
     
-    if (hasRendered) {
-        sessionStorage.setItem('autoload', modelPath);
-        window.location.reload();
-        return;
-    }
-    
     const modelName = modelPath.split("/").pop();
     try {
         updateStatus(`Loading ${modelName}...`, true);
@@ -32,10 +34,17 @@ async function loadPresetModel() {
 
         const response = await fetch(modelPath);
         if (!response.ok) throw new Error(`Failed to load ${modelPath}`);
+        if (response.body && isStreamable(modelName)) {
+            // With a Content-Encoding the length is of the compressed body
+            const encoded = response.headers.has("Content-Encoding");
+            const total = encoded ? 0 : Number(response.headers.get("Content-Length")) || 0;
+            await renderStream(response.body, total, modelName);
+            return;
+        }
         const buffer = await response.arrayBuffer();
         await renderData(new Uint8Array(buffer), modelName);
-        hasRendered = true;
     } catch (err) {
+        resetPresenters();
         updateStatus(`Error: ${err.message}`, false);
         displayElement.textContent = `[ERROR] Could not load ${modelPath}\n${err.message}`;
         enableControls();
@@ -45,9 +54,15 @@ async function loadPresetModel() {
 function loadCustomModel(event) {
     const file = event.target.files[0];
     if (!file) return;
-    
-    if (hasRendered) {
-        window.location.reload();
+
+    if (file.stream && isStreamable(file.name)) {
+        disableControls();
+        renderStream(file.stream(), file.size, file.name).catch((err) => {
+            resetPresenters();
+            updateStatus(`Error reading file: ${err.message}`, false);
+            displayElement.textContent = `[ERROR] Could not read file\n${err.message}`;
+            enableControls();
+        });
         return;
     }
     
@@ -55,9 +70,9 @@ function loadCustomModel(event) {
     reader.onload = async (e) => {
         const buffer = e.target.result;
         await renderData(new Uint8Array(buffer), file.name);
-        hasRendered = true;
     };
     reader.onerror = () => {
+        resetPresenters();
         updateStatus(`Error reading file: ${reader.error}`, false);
         displayElement.textContent = `[ERROR] Could not read file\n${reader.error}`;
         enableControls();
@@ -68,7 +83,12 @@ function loadCustomModel(event) {
     reader.readAsArrayBuffer(file);
 }
 
-async function renderData(data, modelName) {
+// Frame streams are played back whole; STL models can render as they arrive
+function isStreamable(name) {
+    return !name.endsWith(".tmfs");
+}
+
+async function waitForWasm() {
     if (!wasmReady) {
         updateStatus(`Waiting for WASM initialization...`, true);
         displayElement.textContent = "> Waiting for WASM...\n> Please wait...";
@@ -84,6 +104,39 @@ async function renderData(data, modelName) {
             throw new Error("WASM initialization timeout");
         }
     }
+}
+
+// Renders a model while it downloads: the preview fills in chunk by chunk
+async function renderStream(stream, totalBytes, modelName) {
+    await waitForWasm();
+
+    updateStatus(`Streaming ${modelName}...`, true);
+    displayElement.textContent = "> Streaming...";
+    displayElement.style.fontSize = "";
+
+    try {
+        const start = performance.now();
+        let firstFrameMs = 0;
+        await processSTLStream(stream, totalBytes, modelName, (received, total, triangles) => {
+            if (!firstFrameMs && triangles > 0) firstFrameMs = performance.now() - start;
+            const progress = total ? `${Math.round((received / total) * 100)}%` : `${(received / 1024).toFixed(0)} KiB`;
+            updateStatus(`Streaming ${modelName}: ${progress}, ${triangles} triangles`, true);
+        });
+        const ms = performance.now() - start;
+        updateStatus(`Complete: ${modelName} (first frame ${firstFrameMs.toFixed(0)} ms, loaded in ${ms.toFixed(0)} ms)`, false);
+
+        await adjustFontSize();
+        enableControls();
+    } catch (err) {
+        resetPresenters();
+        updateStatus(`Render Error: ${err.message}`, false);
+        displayElement.textContent += `\n[ERROR] ${err.message}`;
+        enableControls();
+    }
+}
+
+async function renderData(data, modelName) {
+    await waitForWasm();
 
     updateStatus(`Rendering ${modelName}...`, true);
     displayElement.textContent = "> Processing...\n> Please wait...";
@@ -92,12 +145,15 @@ async function renderData(data, modelName) {
     await new Promise((resolve) => setTimeout(resolve, 10));
 
     try {
+        const start = performance.now();
         processSTL(data, modelName);
-        updateStatus(`Complete: ${modelName} (reload for new model)`, false);
+        const ms = performance.now() - start;
+        updateStatus(`Complete: ${modelName} (loaded in ${ms.toFixed(0)} ms)`, false);
 
         await adjustFontSize();
         enableControls();
     } catch (err) {
+        resetPresenters();
         updateStatus(`Render Error: ${err.message}`, false);
         displayElement.textContent += `\n[ERROR] ${err.message}`;
         enableControls();
@@ -123,14 +179,83 @@ const wasmCallbacks = {
     },
     onRuntimeInitialized: () => {
         console.log("Emscripten runtime is initialized.");
+        const engine = startEngine();
+        console.log(
+            `Rendering on ${engine.threaded() ? "a worker thread" : "the main thread"}` +
+                `${engine.simd() ? " with WebAssembly SIMD" : ""}.`,
+        );
+        engine.setRenderMode(selectedRenderMode());
+        engine.setOutput(canvasOutputSelected() ? 1 : 0);
+        applyAutoRotate();
+        engine.setFrameBudget(selectedFrameBudget());
+        engine.setMemoryBudget(MEMORY_BUDGET_MB);
         wasmReady = true;
         enableControls();
         adjustFontSize();
     },
 };
 
+// Mode and output changes apply to the running engine, no reload needed
+function changeRenderMode() {
+    const engine = getEngine();
+    if (engine) engine.setRenderMode(selectedRenderMode());
+}
+
+function changeOutput() {
+    const engine = getEngine();
+    if (!engine) return;
+    resetPresenters();
+    // The engine redraws into the new output on its next tick
+    engine.setOutput(canvasOutputSelected() ? 1 : 0);
+    adjustFontSize();
+}
+
+// Models estimated to need more than this are refused before they are
+// parsed, rather than growing the heap until the tab runs out of memory
+const MEMORY_BUDGET_MB = 1024;
+
+// How often the quality readout is refreshed while a budget is set
+const QUALITY_READOUT_INTERVAL_MS = 500;
+
+function changeFrameBudget() {
+    const engine = getEngine();
+    if (!engine) return;
+    engine.setFrameBudget(selectedFrameBudget());
+    updateQualityReadout();
+}
+
+function updateQualityReadout() {
+    const engine = getEngine();
+    if (!engine || !qualityReadout) return;
+    if (selectedFrameBudget() === 0) {
+        qualityReadout.textContent = "";
+        return;
+    }
+    const q = engine.qualityStats();
+    qualityReadout.textContent =
+        `Q${q.level} ${q.averageMs.toFixed(1)}/${q.budgetMs.toFixed(0)} MS ` +
+        `(GEO ${q.geometryMs.toFixed(1)} RAS ${q.rasterMs.toFixed(1)})`;
+}
+
 loadButton.addEventListener("click", loadPresetModel);
 fileInput.addEventListener("change", loadCustomModel);
+renderModeSelect.addEventListener("change", changeRenderMode);
+outputModeSelect.addEventListener("change", changeOutput);
+frameBudgetSelect.addEventListener("change", changeFrameBudget);
+setInterval(updateQualityReadout, QUALITY_READOUT_INTERVAL_MS);
+
+initializeControls();
+
+// Tracing from the devtools console: termeshTrace.start(), reproduce the
+// stall, then termeshTrace.save() downloads a trace for chrome://tracing
+window.termeshTrace = {
+    start: () => getEngine()?.traceStart(),
+    stop: () => getEngine()?.traceStop(),
+    save: (filename) => downloadTrace(filename),
+};
+
+// Memory per subsystem and the WASM heap, from the devtools console
+window.termeshMemory = () => getEngine()?.memoryStats();
 
 window.addEventListener("resize", adjustFontSize);
 
@@ -141,11 +266,3 @@ updateStatus("Loading WASM...", true);
 displayElement.textContent = "[Loading WASM module...]";
 initializeWasmModule(wasmCallbacks);
 
-window.addEventListener('load', async () => {
-    const autoload = sessionStorage.getItem('autoload');
-    if (autoload) {
-        sessionStorage.removeItem('autoload');
-        modelSelect.value = autoload;
-        setTimeout(() => loadPresetModel(), 500);
-    }
-});
\ No newline at end of file
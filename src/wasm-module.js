@@ -1,3 +1,5 @@
+import { presentFrame, presentCanvas, displayStats } from "./display.js";
+
 export function initializeWasmModule(o) {
     window.Module = {
         preRun: [() => console.log("Module preRun: Setting up filesystem.")],
@@ -6,27 +8,204 @@ export function initializeWasmModule(o) {
         printErr: o.onPrintErr || ((text) => console.error(text)),
         onRuntimeInitialized: o.onRuntimeInitialized || (() => console.log("Runtime initialized.")),
         noInitialRun: true,
+        presentFrame,
+        presentCanvas,
+        displayStats,
     };
     
+    // Best build first. The threads builds render off the main thread but
+    // need SharedArrayBuffer, which browsers only give cross-origin isolated
+    // pages (COOP/COEP headers); the SIMD builds need WebAssembly SIMD. A
+    // build that fails to load falls through to the next one.
+    const threads = window.crossOriginIsolated === true;
+    const simd = supportsSimd();
+    const candidates = [
+        threads && simd && "src/index-threads-simd.js",
+        threads && "src/index-threads.js",
+        simd && "src/index-simd.js",
+        SINGLE_THREADED_SCRIPT,
+    ].filter(Boolean);
+
+    const tryNext = (i) => loadScript(candidates[i], () => {
+        if (i + 1 < candidates.length) {
+            console.warn(`${candidates[i]} unavailable, trying ${candidates[i + 1]}.`);
+            tryNext(i + 1);
+        } else {
+            o.onPrintErr("Failed to load WASM script (index.js).");
+        }
+    });
+    tryNext(0);
+}
+
+const SINGLE_THREADED_SCRIPT = "src/index.js";
+
+// Smallest module using a v128 instruction; only SIMD-capable engines accept it
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+export function supportsSimd() {
+    try {
+        return WebAssembly.validate(SIMD_PROBE);
+    } catch {
+        return false;
+    }
+}
+
+function loadScript(src, onerror) {
     const script = document.createElement("script");
-    script.src = "src/index.js";
-    script.onerror = () => {
-        o.onPrintErr("Failed to load WASM script (index.js).");
-    };
+    script.src = src;
+    script.onerror = onerror;
     document.body.appendChild(script);
 }
 
+// Engine API exported by main.cpp, wrapped once the runtime is up
+let engine = null;
+
+// Starts the engine. It stays alive for the lifetime of the page; models are
+// swapped through the API instead of re-instantiating the module.
+export function startEngine() {
+    Module.callMain([]);
+    engine = {
+        loadModel: Module.cwrap("termesh_load_model", "number", ["string"]),
+        play: Module.cwrap("termesh_play", "number", ["string"]),
+        unloadModel: Module.cwrap("termesh_unload_model", null, []),
+        setView: Module.cwrap("termesh_set_view", null, ["number", "number", "number"]),
+        setRenderMode: Module.cwrap("termesh_set_render_mode", null, ["number"]),
+        setOutput: Module.cwrap("termesh_set_output", null, ["number"]),
+        setSize: Module.cwrap("termesh_set_size", null, ["number", "number"]),
+        renderFrame: Module.cwrap("termesh_render_frame", null, []),
+        startLoop: Module.cwrap("termesh_start_loop", null, ["number"]),
+        stopLoop: Module.cwrap("termesh_stop_loop", null, []),
+        rotateView: Module.cwrap("termesh_rotate_view", null, ["number", "number", "number"]),
+        setLight: Module.cwrap("termesh_set_light", null, ["number", "number", "number"]),
+        setAutoRotate: Module.cwrap("termesh_set_auto_rotate", null, ["number"]),
+        setVisible: Module.cwrap("termesh_set_visible", null, ["number"]),
+        setFrameBudget: Module.cwrap("termesh_set_frame_budget", null, ["number"]),
+        qualityStats: readQualityStats,
+        threaded: Module.cwrap("termesh_threaded", "number", []),
+        simd: Module.cwrap("termesh_simd", "number", []),
+        streamBegin: Module.cwrap("termesh_stream_begin", "number", ["number"]),
+        streamBuffer: Module.cwrap("termesh_stream_buffer", "number", ["number"]),
+        streamChunk: Module.cwrap("termesh_stream_chunk", "number", ["number"]),
+        streamEnd: Module.cwrap("termesh_stream_end", "number", []),
+        traceStart: Module.cwrap("termesh_trace_start", null, []),
+        traceStop: Module.cwrap("termesh_trace_stop", null, []),
+        traceJson: Module.cwrap("termesh_trace_json", "string", []),
+        setMemoryBudget: Module.cwrap("termesh_set_memory_budget", null, ["number"]),
+        memoryStats: readMemoryStats,
+    };
+    return engine;
+}
+
+// Saves the spans recorded since engine.traceStart() as a Chrome trace
+// (load it in chrome://tracing or ui.perfetto.dev)
+export function downloadTrace(filename = "termesh-trace.json") {
+    if (!engine) return;
+    const blob = new Blob([engine.traceJson()], { type: "application/json" });
+    const link = document.createElement("a");
+    link.href = URL.createObjectURL(blob);
+    link.download = filename;
+    link.click();
+    setTimeout(() => URL.revokeObjectURL(link.href), 0);
+}
+
+// termesh_quality_stats() returns six floats; read through HEAPF32 each time
+// since growing the heap replaces the view
+function readQualityStats() {
+    const base = Module._termesh_quality_stats() >> 2;
+    const f = Module.HEAPF32;
+    return {
+        level: f[base],
+        budgetMs: f[base + 1],
+        averageMs: f[base + 2],
+        clearMs: f[base + 3],
+        geometryMs: f[base + 4],
+        rasterMs: f[base + 5],
+    };
+}
+
+// Tags of termesh_memory_stats(), in the order of MemoryTag in memory_stats.h
+const MEMORY_TAGS = ["mesh", "acceleration", "framebuffers", "renderScratch", "parseScratch", "caches"];
+
+// termesh_memory_stats() returns the heap and budget, then the current and
+// peak of each tag, in MiB; read through HEAPF32 each time
+function readMemoryStats() {
+    const base = Module._termesh_memory_stats() >> 2;
+    const f = Module.HEAPF32;
+    const stats = { heapMb: f[base], budgetMb: f[base + 1], tags: {} };
+    MEMORY_TAGS.forEach((tag, i) => {
+        stats.tags[tag] = { currentMb: f[base + 2 + 2 * i], peakMb: f[base + 3 + 2 * i] };
+    });
+    return stats;
+}
+
+export function getEngine() {
+    return engine;
+}
+
 export function processSTL(data, filename) {
-    if (!window.Module || !window.Module.FS) {
+    if (!window.Module || !window.Module.FS || !engine) {
         console.error("Error: WASM Module or Filesystem not ready.");
         throw new Error("WASM Module not ready.");
     }
 
-    try {
+    // Loading schedules the first frame; auto-rotation carries on as set
+    let loaded;
+    if (filename.endsWith(".tmfs")) {
+        // Recorded frame stream: played back without the rasterizer
+        Module.FS.writeFile("/stream.tmfs", data);
+        loaded = engine.play("/stream.tmfs");
+    } else {
         Module.FS.writeFile("/model.stl", data);
-        Module.callMain();
+        loaded = engine.loadModel("/model.stl");
+        // The engine has its copy, or none; the file's bytes need not stay in the heap
+        Module.FS.unlink("/model.stl");
+        if (loaded < 0) {
+            throw new Error(`${filename} is too large for the memory budget`);
+        }
+    }
+    if (!loaded) {
+        throw new Error(`${filename} is not a valid model`);
+    }
+}
+
+// Feeds an STL model to the engine chunk by chunk as `stream` (a fetch body
+// or File.stream()) delivers it. Frames show the triangles parsed so far, so
+// the first one no longer waits for the whole file. `onProgress` receives
+// bytes read, the total (0 if unknown) and the triangles loaded so far.
+export async function processSTLStream(stream, totalBytes, filename, onProgress) {
+    if (!engine) {
+        throw new Error("WASM Module not ready.");
+    }
+
+    const reader = stream.getReader();
+    let received = 0;
+    if (!engine.streamBegin(totalBytes)) {
+        reader.cancel().catch(() => {});
+        throw new Error(`${filename} is too large for the memory budget`);
+    }
+    try {
+        for (;;) {
+            const { done, value } = await reader.read();
+            if (done) break;
+            // Copy after streamBuffer(): growing the heap replaces HEAPU8
+            const ptr = engine.streamBuffer(value.length);
+            Module.HEAPU8.set(value, ptr);
+            const triangles = engine.streamChunk(value.length);
+            if (triangles < 0) {
+                throw new Error(`${filename} is not a valid model`);
+            }
+            received += value.length;
+            if (onProgress) onProgress(received, totalBytes, triangles);
+        }
     } catch (err) {
-        console.error(`Error processing STL in WASM: ${err}`);
-        throw new Error(`WASM execution failed: ${err.message}`);
+        reader.cancel().catch(() => {});
+        engine.unloadModel();
+        throw err;
+    }
+
+    if (!engine.streamEnd()) {
+        throw new Error(`${filename} is not a valid model`);
     }
-}
\ No newline at end of file
+}